@@ -0,0 +1,377 @@
+/**
+ * @file afinador.cpp
+ * @brief Ajuste de los pesos del bot con un algoritmo genético en paralelo
+ *
+ * Uso: afinador [--poblacion N] [--partidas K] [--etapa E] [--generaciones G] [--piezas P]
+ *               [--corte C] [--sigma S] [--hilos H] [--semilla S] [--bolsa] [--control FICHERO]
+ *
+ * Cada candidato es un vector de Pesos (altura, huecos, rugosidad, filas) de
+ * norma 1: el evaluador es lineal y la mejor colocación no cambia al escalarlo.
+ * En cada generación todos los candidatos juegan las mismas K partidas (16 por
+ * defecto) sin pantalla, colocando cada pieza con mejorDestino y colocaPieza,
+ * hasta que la pieza nueva no cabe (game over) o colocan P piezas (500). Al
+ * colocar sin gravedad el nivel no influye, así que se juega sin VICTORIA
+ * (iniciarJuego con sinFin): la aptitud premia aguantar, no solo llegar. Las semillas
+ * cambian en cada generación para no ajustar los pesos a unas partidas
+ * concretas. La aptitud es la media de puntos más la media de filas quitadas.
+ *
+ * Las partidas se juegan por etapas de E (4) repartidas entre H hilos. Tras cada
+ * etapa, los candidatos cuya media va por debajo de C (0.5) veces la del mejor
+ * dejan de jugar: su aptitud es la de las partidas jugadas.
+ *
+ * La siguiente generación conserva los 2 mejores y completa la población (24)
+ * con hijos de padres elegidos por torneo de 3: mezcla al azar de los dos
+ * padres más ruido normal de desviación S (0.15), normalizada.
+ *
+ * Con --control la población se guarda al acabar cada generación (de forma
+ * atómica, como los puntos de control de instantanea.h); si el fichero existe al
+ * arrancar, se sigue desde él. Cada generación muestra:
+ *
+ *     generacion mejor media podados partidas partidas/s altura huecos rugosidad lineas
+ *
+ * y al terminar, los mejores pesos encontrados y las partidas por segundo.
+ */
+
+#include "bot.h"
+#include "instantanea.h"
+#include "pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/// Pesos de cada candidato
+const int RASGOS = 4;
+/// Candidatos que pasan sin cambios a la siguiente generación
+const int ELITE = 2;
+/// Candidatos de cada torneo de selección
+const int TORNEO = 3;
+
+/** @struct Candidato
+ *  @brief Vector de pesos y su resultado en la generación actual.
+ */
+struct Candidato {
+    double w[RASGOS]; ///< altura, huecos, rugosidad y lineas (norma 1)
+    double puntos; ///< Suma de puntos de las partidas jugadas
+    double lineas; ///< Suma de filas quitadas en las partidas jugadas
+    int partidas; ///< Partidas jugadas en esta generación
+    bool podado; ///< Ha dejado de jugar por ir muy por detrás
+};
+
+/** @struct OpcionesAfinador
+ *  @brief Opciones del ajuste.
+ */
+struct OpcionesAfinador {
+    int poblacion = 24; ///< Candidatos por generación
+    int partidas = 16; ///< Partidas por candidato y generación
+    int etapa = 4; ///< Partidas entre podas
+    int generaciones = 20; ///< Generaciones a evolucionar
+    int piezas = 500; ///< Límite de piezas por partida
+    double corte = 0.5; ///< Fracción de la media del mejor por debajo de la que se poda
+    double sigma = 0.15; ///< Desviación de la mutación
+    int hilos = int(thread::hardware_concurrency()); ///< Hilos del grupo
+    uint64_t semilla = 1; ///< Semilla del ajuste
+    ModoAzar modo = AZAR_PURO; ///< Forma de repartir las piezas
+    string control; ///< Fichero de la población (vacío: sin puntos de control)
+};
+
+/**
+ * @brief Aptitud de un candidato con las partidas jugadas.
+ * @param C Candidato
+ * @return double -> Media de puntos más media de filas
+ */
+static double aptitud(const Candidato &C) {
+    return C.partidas > 0 ? (C.puntos + C.lineas) / C.partidas : 0;
+}
+
+/**
+ * @brief Pasa un candidato a Pesos.
+ * @param C Candidato
+ * @return Pesos -> Pesos del evaluador
+ */
+static Pesos pesosDe(const Candidato &C) {
+    return Pesos{C.w[0], C.w[1], C.w[2], C.w[3]};
+}
+
+/**
+ * @brief Deja un vector de pesos con norma 1.
+ * @param w Pesos
+ */
+static void normaliza(double w[RASGOS]) {
+    double n = 0;
+    for (int i = 0; i < RASGOS; ++i) n += w[i] * w[i];
+    n = sqrt(n);
+    for (int i = 0; i < RASGOS; ++i) w[i] = n > 0 ? w[i] / n : 0.5;
+}
+
+/**
+ * @brief Número al azar uniforme en [0, 1).
+ * @param azar Estado del generador
+ * @return double -> Número
+ */
+static double uniforme(uint64_t &azar) {
+    return double(siguienteAzar(azar) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Número al azar con distribución normal estándar (Box-Muller).
+ * @param azar Estado del generador
+ * @return double -> Número
+ */
+static double normal(uint64_t &azar) {
+    double u = uniforme(azar), v = uniforme(azar);
+    return sqrt(-2.0 * log(1.0 - u)) * cos(6.283185307179586 * v);
+}
+
+/**
+ * @brief Juega una partida sin pantalla colocando cada pieza con unos pesos.
+ * @param G Memoria de la búsqueda de movimientos
+ * @param W Pesos
+ * @param semilla Semilla de la partida
+ * @param O Opciones
+ * @return EstadoJuego -> Estado final
+ */
+static EstadoJuego juegaPartida(GeneradorMovimientos &G, const Pesos &W, uint64_t semilla,
+                                const OpcionesAfinador &O) {
+    EstadoJuego E;
+    // Colocando sin gravedad el nivel no cambia nada: la partida no tiene
+    // VICTORIA, para que la aptitud mida lo que aguanta y no solo si llega
+    iniciarJuego(E, semilla, O.modo, 1, true);
+    while (E.fin == EN_JUEGO && E.piezas < O.piezas) {
+        int d = mejorDestino(G, E.T, E.P, W);
+        if (d < 0) break;
+        colocaPieza(E, G.destino[d].P);
+    }
+    return E;
+}
+
+/**
+ * @brief Guarda la población para poder seguir después.
+ * @param O Opciones
+ * @param P Población de la siguiente generación
+ * @param generacion Siguiente generación
+ * @param azar Estado del generador
+ * @param mejor Mejor candidato hasta ahora
+ * @param mejorAptitud Su aptitud
+ * @return bool -> true: se ha guardado
+ */
+static bool guardaPoblacion(const OpcionesAfinador &O, const vector<Candidato> &P, int generacion, uint64_t azar,
+                            const Candidato &mejor, double mejorAptitud) {
+    string s = "AFINADOR 1\n";
+    char linea[256];
+    snprintf(linea, sizeof(linea), "%d %llu %zu %.17g", generacion, (unsigned long long) azar, P.size(),
+             mejorAptitud);
+    s += linea;
+    for (int i = 0; i < RASGOS; ++i) {
+        snprintf(linea, sizeof(linea), " %.17g", mejor.w[i]);
+        s += linea;
+    }
+    s += "\n";
+    for (const Candidato &C : P) {
+        snprintf(linea, sizeof(linea), "%.17g %.17g %.17g %.17g\n", C.w[0], C.w[1], C.w[2], C.w[3]);
+        s += linea;
+    }
+    return escribeAtomico(O.control.c_str(), (const unsigned char *) s.data(), s.size());
+}
+
+/**
+ * @brief Carga una población guardada con guardaPoblacion.
+ * @param O Opciones
+ * @param P Población (se reemplaza)
+ * @param generacion Generación por la que seguir
+ * @param azar Estado del generador
+ * @param mejor Mejor candidato hasta ahora
+ * @param mejorAptitud Su aptitud
+ * @return bool -> true: se ha cargado; false: no existe o no es válido (no se toca nada)
+ */
+static bool cargaPoblacion(const OpcionesAfinador &O, vector<Candidato> &P, int &generacion, uint64_t &azar,
+                           Candidato &mejor, double &mejorAptitud) {
+    FILE *f = fopen(O.control.c_str(), "r");
+    if (!f) return false;
+    // Se lee todo en variables locales: un fichero a medias no deja nada a medias
+    int g;
+    unsigned long long a;
+    size_t n;
+    double apt;
+    Candidato m = {};
+    vector<Candidato> Q;
+    bool ok = fscanf(f, "AFINADOR 1 %d %llu %zu %lg %lg %lg %lg %lg", &g, &a, &n, &apt, &m.w[0], &m.w[1], &m.w[2],
+                     &m.w[3]) == 8 &&
+              n > 0 && n < 100000;
+    if (ok) {
+        Q.assign(n, Candidato());
+        for (Candidato &C : Q) {
+            ok = ok && fscanf(f, "%lg %lg %lg %lg", &C.w[0], &C.w[1], &C.w[2], &C.w[3]) == 4;
+        }
+    }
+    fclose(f);
+    if (!ok) return false;
+    P.swap(Q);
+    generacion = g;
+    azar = a;
+    mejor = m;
+    mejorAptitud = apt;
+    return true;
+}
+
+/**
+ * @brief Elige un padre por torneo.
+ * @param P Población ordenada de mejor a peor
+ * @param azar Estado del generador
+ * @return const Candidato& -> El mejor de TORNEO candidatos al azar
+ */
+static const Candidato &torneo(const vector<Candidato> &P, uint64_t &azar) {
+    size_t mejor = P.size();
+    for (int k = 0; k < TORNEO; ++k) {
+        size_t i = size_t(siguienteAzar(azar) % P.size());
+        if (i < mejor) mejor = i;
+    }
+    return P[mejor];
+}
+
+int main(int argc, char *argv[]) {
+    OpcionesAfinador O;
+    for (int i = 1; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--poblacion") == 0 && valor) O.poblacion = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--partidas") == 0 && valor) O.partidas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--etapa") == 0 && valor) O.etapa = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--generaciones") == 0 && valor) O.generaciones = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--piezas") == 0 && valor) O.piezas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--corte") == 0 && valor) O.corte = atof(argv[++i]);
+        else if (strcmp(argv[i], "--sigma") == 0 && valor) O.sigma = atof(argv[++i]);
+        else if (strcmp(argv[i], "--hilos") == 0 && valor) O.hilos = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) O.semilla = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--bolsa") == 0) O.modo = AZAR_BOLSA;
+        else if (strcmp(argv[i], "--control") == 0 && valor) O.control = argv[++i];
+        else {
+            cerr << "Uso: " << argv[0] << " [--poblacion N] [--partidas K] [--etapa E] [--generaciones G]"
+                 << " [--piezas P] [--corte C] [--sigma S] [--hilos H] [--semilla S] [--bolsa]"
+                 << " [--control FICHERO]" << endl;
+            return 1;
+        }
+    }
+    if (O.poblacion < ELITE + 1) O.poblacion = ELITE + 1;
+    if (O.partidas < 1) O.partidas = 1;
+    if (O.etapa < 1) O.etapa = 1;
+
+    vector<Candidato> P;
+    int generacion = 0;
+    uint64_t azar = O.semilla;
+    Candidato mejor = {};
+    double mejorAptitud = -1;
+    if (!O.control.empty() && cargaPoblacion(O, P, generacion, azar, mejor, mejorAptitud)) {
+        cerr << "Sigue desde la generacion " << generacion << " de " << O.control << endl;
+    } else {
+        // Los pesos por defecto y el resto al azar, con el signo que cabe esperar de cada rasgo
+        P.assign(size_t(O.poblacion), Candidato());
+        for (size_t c = 0; c < P.size(); ++c) {
+            double *w = P[c].w;
+            if (c == 0) {
+                w[0] = PESOS_DEFECTO.altura, w[1] = PESOS_DEFECTO.huecos;
+                w[2] = PESOS_DEFECTO.rugosidad, w[3] = PESOS_DEFECTO.lineas;
+            } else {
+                for (int i = 0; i < RASGOS; ++i) w[i] = uniforme(azar) * (i == RASGOS - 1 ? 1 : -1);
+            }
+            normaliza(w);
+        }
+        generacion = 0;
+    }
+
+    PoolTrabajo pool(O.hilos);
+    // Una memoria de búsqueda por hilo: se reutiliza en todas sus partidas
+    vector<unique_ptr<GeneradorMovimientos>> G;
+    for (int h = 0; h < pool.hilos(); ++h) G.emplace_back(new GeneradorMovimientos);
+
+    auto inicio = chrono::steady_clock::now();
+    long totalPartidas = 0;
+    for (; generacion < O.generaciones; ++generacion) {
+        auto t0 = chrono::steady_clock::now();
+        for (Candidato &C : P) C.puntos = C.lineas = C.partidas = 0, C.podado = false;
+        uint64_t base = O.semilla * 1000003ull + uint64_t(generacion) * uint64_t(O.partidas);
+        long partidas = 0;
+        int podados = 0;
+
+        for (int desde = 0; desde < O.partidas; desde += O.etapa) {
+            int hasta = min(desde + O.etapa, O.partidas);
+            // Cada partida guarda su resultado en su hueco: no hace falta cerrojo
+            vector<EstadoJuego> R(P.size() * size_t(O.etapa));
+            for (size_t c = 0; c < P.size(); ++c) {
+                if (P[c].podado) continue;
+                for (int j = desde; j < hasta; ++j) {
+                    pool.encolar([&, c, j] {
+                        R[c * size_t(O.etapa) + size_t(j - desde)] =
+                            juegaPartida(*G[size_t(PoolTrabajo::hiloActual())], pesosDe(P[c]), base + uint64_t(j), O);
+                    });
+                    partidas++;
+                }
+            }
+            pool.esperar();
+
+            double mejorMedia = 0;
+            for (size_t c = 0; c < P.size(); ++c) {
+                if (P[c].podado) continue;
+                for (int j = desde; j < hasta; ++j) {
+                    const EstadoJuego &E = R[c * size_t(O.etapa) + size_t(j - desde)];
+                    P[c].puntos += E.ptos;
+                    P[c].lineas += E.lineas;
+                    P[c].partidas++;
+                }
+                mejorMedia = max(mejorMedia, aptitud(P[c]));
+            }
+            if (hasta == O.partidas) break;
+            for (Candidato &C : P) {
+                if (!C.podado && aptitud(C) < O.corte * mejorMedia) {
+                    C.podado = true;
+                    podados++;
+                }
+            }
+        }
+        totalPartidas += partidas;
+
+        sort(P.begin(), P.end(), [](const Candidato &a, const Candidato &b) {
+            // Un candidato podado nunca supera a uno que ha jugado todas las partidas
+            if (a.podado != b.podado) return b.podado;
+            return aptitud(a) > aptitud(b);
+        });
+        double media = 0;
+        for (const Candidato &C : P) media += aptitud(C);
+        media /= double(P.size());
+        if (aptitud(P[0]) > mejorAptitud) {
+            mejorAptitud = aptitud(P[0]);
+            mejor = P[0];
+        }
+        double s = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        printf("%d %.1f %.1f %d %ld %.1f %.4f %.4f %.4f %.4f\n", generacion, aptitud(P[0]), media, podados, partidas,
+               double(partidas) / s, P[0].w[0], P[0].w[1], P[0].w[2], P[0].w[3]);
+        fflush(stdout);
+
+        vector<Candidato> hijos(P.begin(), P.begin() + ELITE);
+        while (hijos.size() < P.size()) {
+            const Candidato &a = torneo(P, azar), &b = torneo(P, azar);
+            Candidato h = {};
+            double mezcla = uniforme(azar);
+            for (int i = 0; i < RASGOS; ++i) h.w[i] = mezcla * a.w[i] + (1 - mezcla) * b.w[i] + O.sigma * normal(azar);
+            normaliza(h.w);
+            hijos.push_back(h);
+        }
+        P.swap(hijos);
+        if (!O.control.empty() && !guardaPoblacion(O, P, generacion + 1, azar, mejor, mejorAptitud)) {
+            cerr << "No se puede guardar la poblacion en " << O.control << endl;
+        }
+    }
+
+    double s = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    cerr << totalPartidas << " partidas en " << s << " s: " << double(totalPartidas) / s << " partidas/s" << endl;
+    printf("mejor %.1f: {%.6f, %.6f, %.6f, %.6f}\n", mejorAptitud, mejor.w[0], mejor.w[1], mejor.w[2], mejor.w[3]);
+    return 0;
+}
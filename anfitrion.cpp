@@ -0,0 +1,122 @@
+/**
+ * @file anfitrion.cpp
+ * @brief Miles de partidas simultáneas en un proceso a 33 ticks por segundo
+ *
+ * Uso: anfitrion [--sesiones N] [--memoria MB] [--hilos H] [--segundos S] [--teclas K]
+ *                [--semilla S] [--maximo]
+ *
+ * Abre N sesiones (10000 por defecto) en un presupuesto de MB megabytes (64) y
+ * las avanza con tickSesiones cada 30 ms, como el bucle original, repartidas en
+ * lotes entre H hilos (todos los núcleos por defecto; 0 es en el hilo
+ * principal). Cada sesión recibe una tecla al azar de media una vez cada K ticks
+ * (8), como un jugador que pulsa unas 4 teclas por segundo; cuando una partida
+ * termina se abre otra en su sitio. Cada segundo muestra:
+ *
+ *     segundos sesiones simuladas/tick tick_medio_us tick_max_us carga_% partidas
+ *
+ * donde carga es la fracción de los 30 ms que ocupa tickSesiones. Al terminar
+ * estima las sesiones que caben por núcleo a 33 Hz. Con --maximo los ticks se
+ * encadenan sin esperar, para medir el coste por sesión sin ruido del reloj.
+ */
+
+#include "sesiones.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace std;
+typedef chrono::steady_clock Reloj;
+
+/// Milisegundos por tick (33 Hz)
+const int TICK_MS = 30;
+
+int main(int argc, char *argv[]) {
+    long sesiones = 10000, memoria = 64, segundos = 10, teclas = 8;
+    int hilos = int(thread::hardware_concurrency());
+    uint64_t semilla = 1;
+    bool maximo = false;
+    for (int i = 1; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--sesiones") == 0 && valor) sesiones = atol(argv[++i]);
+        else if (strcmp(argv[i], "--memoria") == 0 && valor) memoria = atol(argv[++i]);
+        else if (strcmp(argv[i], "--hilos") == 0 && valor) hilos = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--segundos") == 0 && valor) segundos = atol(argv[++i]);
+        else if (strcmp(argv[i], "--teclas") == 0 && valor) teclas = atol(argv[++i]);
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) semilla = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--maximo") == 0) maximo = true;
+        else {
+            cerr << "Uso: " << argv[0] << " [--sesiones N] [--memoria MB] [--hilos H] [--segundos S]"
+                 << " [--teclas K] [--semilla S] [--maximo]" << endl;
+            return 1;
+        }
+    }
+    if (teclas < 1) teclas = 1;
+    if (hilos < 0) hilos = 0;
+
+    unique_ptr<Sesiones> S(new Sesiones);
+    size_t capacidad = iniciarSesiones(*S, size_t(memoria) << 20);
+    printf("%zu bytes por sesion, %zu sesiones en %ld MB\n", bytesPorSesion(), capacidad, memoria);
+    if (size_t(sesiones) > capacidad) {
+        cerr << "Solo caben " << capacidad << " sesiones en " << memoria << " MB" << endl;
+        return 1;
+    }
+    uint64_t siguienteSemilla = semilla;
+    for (long i = 0; i < sesiones; ++i) abreSesion(*S, siguienteSemilla++);
+
+    unique_ptr<PoolTrabajo> pool(hilos > 0 ? new PoolTrabajo(hilos) : nullptr);
+    uint64_t azar = semilla;
+    auto inicio = Reloj::now(), siguiente = inicio, informe = inicio + chrono::seconds(1);
+    double totalUs = 0, maxUs = 0, segundoUs = 0;
+    long ticks = 0, ticksSegundo = 0, simuladas = 0, partidas = 0;
+    while (Reloj::now() - inicio < chrono::seconds(segundos)) {
+        // Las teclas y las partidas nuevas son cosa del anfitrión: no cuentan en el tick
+        for (size_t i = 0; i < capacidad; ++i) {
+            if (S->proximo[i] == SIN_TICK) continue;
+            uint64_t x = siguienteAzar(azar);
+            if (x % uint64_t(teclas) == 0) ponAccion(*S, int(i), Accion(1 + (x >> 32) % (ACCIONES - 1)));
+        }
+
+        auto t0 = Reloj::now();
+        simuladas += tickSesiones(*S, pool.get());
+        double us = chrono::duration<double, micro>(Reloj::now() - t0).count();
+        totalUs += us;
+        segundoUs += us;
+        if (us > maxUs) maxUs = us;
+        ticks++;
+        ticksSegundo++;
+
+        for (size_t i = 0; i < capacidad; ++i) {
+            if (!(S->cambios[i] & CAMBIO_FIN)) continue;
+            cierraSesion(*S, int(i));
+            abreSesion(*S, siguienteSemilla++);
+            partidas++;
+        }
+
+        auto ahora = Reloj::now();
+        if (ahora >= informe) {
+            double medio = segundoUs / double(ticksSegundo);
+            printf("%ld %zu %.0f %.0f %.0f %.1f %ld\n",
+                   long(chrono::duration_cast<chrono::seconds>(ahora - inicio).count()), S->activas,
+                   double(simuladas) / double(ticksSegundo), medio, maxUs, 100.0 * medio / (TICK_MS * 1000.0),
+                   partidas);
+            fflush(stdout);
+            segundoUs = maxUs = 0;
+            ticksSegundo = simuladas = partidas = 0;
+            informe += chrono::seconds(1);
+        }
+        if (!maximo) {
+            siguiente += chrono::milliseconds(TICK_MS);
+            this_thread::sleep_until(siguiente);
+        }
+    }
+
+    double medio = totalUs / double(ticks);
+    int nucleos = hilos > 0 ? hilos : 1;
+    printf("tick medio %.0f us con %ld sesiones y %d hilos: %.0f sesiones por nucleo a 33 Hz\n", medio, sesiones,
+           nucleos, double(sesiones) * TICK_MS * 1000.0 / medio / nucleos);
+    return 0;
+}
@@ -0,0 +1,284 @@
+/**
+ * @file aperturas.cpp
+ * @brief Construye y mide libros de aperturas (libro.h)
+ *
+ * Uso: aperturas construir LIBRO [--niveles N] [--anchura W] [--hilos H]
+ *                                [--repeticiones DIR] [--piezas P]
+ *      aperturas medir LIBRO [--partidas K] [--piezas P] [--anchura W] [--bolsa] [--semilla S]
+ *
+ * construir recorre todas las posiciones de las N primeras piezas (3 por
+ * defecto): empieza con el tablero vacío y las 49 parejas de pieza actual y
+ * siguiente, elige la jugada de cada posición con buscaHaz sobre las dos piezas
+ * conocidas (anchura W) y sigue con los tableros a los que llegan esas jugadas y
+ * cada pieza siguiente posible. Las posiciones se reparten entre H hilos. Con
+ * --repeticiones añade además las P primeras colocaciones (12) de cada .rep del
+ * directorio; si una posición aparece con jugadas distintas, gana la más
+ * repetida, y las posiciones del recorrido completo tienen prioridad.
+ *
+ * medir juega K partidas (20) colocando P piezas (12) con el libro y, donde no
+ * tiene la posición, con buscaHaz; después repite las decisiones solo con
+ * buscaHaz. Muestra:
+ *
+ *     entradas aciertos% us_decision_libro us_decision_busqueda
+ */
+
+#include "haz.h"
+#include "libro.h"
+#include "repeticion.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/** @struct PosicionLibro
+ *  @brief Posición por resolver del recorrido completo.
+ */
+struct PosicionLibro {
+    Ocupacion T; ///< Tablero
+    int actual; ///< Pieza por colocar
+    int siguiente; ///< Pieza siguiente
+};
+
+/**
+ * @brief Resuelve un nivel del recorrido completo.
+ * @param pool Hilos
+ * @param B Buscador de cada hilo
+ * @param nivel Posiciones del nivel
+ * @param O Forma de la búsqueda
+ * @param jugadas Jugada de cada posición (0xFFFF: la pieza no cabe)
+ * @param hijos Tablero al que lleva cada jugada
+ */
+static void resuelveNivel(PoolTrabajo &pool, vector<unique_ptr<BuscadorHaz>> &B, const vector<PosicionLibro> &nivel,
+                          const OpcionesHaz &O, vector<uint16_t> &jugadas, vector<Ocupacion> &hijos) {
+    jugadas.assign(nivel.size(), 0xFFFF);
+    hijos.resize(nivel.size());
+    const size_t trozo = 64;
+    for (size_t desde = 0; desde < nivel.size(); desde += trozo) {
+        pool.encolar([&, desde] {
+            BuscadorHaz &H = *B[size_t(PoolTrabajo::hiloActual())];
+            for (size_t i = desde; i < nivel.size() && i < desde + trozo; ++i) {
+                const PosicionLibro &Q = nivel[i];
+                const Pieza P = {INICIO, Q.actual, 0};
+                ResultadoHaz R;
+                int d = buscaHaz(H, Q.T, P, &Q.siguiente, 1, PESOS_DEFECTO, O, R);
+                if (d < 0) continue;
+                jugadas[i] = codificaJugada(H.G[0]->destino[d].P);
+                hijos[i] = Q.T;
+                insertaPieza(hijos[i], H.G[0]->destino[d].P);
+                cuentaFila(hijos[i]);
+            }
+        });
+    }
+    pool.esperar();
+}
+
+/**
+ * @brief Posiciones del recorrido completo con sus jugadas.
+ * @param niveles Piezas desde el tablero vacío
+ * @param O Forma de la búsqueda
+ * @param hilos Hilos
+ * @param entradas Salida
+ */
+static void recorreAperturas(int niveles, const OpcionesHaz &O, int hilos, vector<EntradaLibro> &entradas) {
+    PoolTrabajo pool(hilos);
+    vector<unique_ptr<BuscadorHaz>> B;
+    for (int h = 0; h < pool.hilos(); ++h) {
+        B.emplace_back(new BuscadorHaz);
+        iniciarHaz(*B.back(), nullptr, nullptr);
+    }
+
+    vector<Ocupacion> tableros(1, Ocupacion{}); // Empieza con el tablero vacío
+    for (int n = 0; n < niveles && !tableros.empty(); ++n) {
+        vector<PosicionLibro> nivel;
+        for (const Ocupacion &T : tableros) {
+            for (int a = 0; a < TIPOS_PIEZA; ++a) {
+                for (int s = 0; s < TIPOS_PIEZA; ++s) nivel.push_back({T, a, s});
+            }
+        }
+        vector<uint16_t> jugadas;
+        vector<Ocupacion> hijos;
+        auto inicio = chrono::steady_clock::now();
+        resuelveNivel(pool, B, nivel, O, jugadas, hijos);
+        double s = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+        // Los tableros del nivel siguiente, sin repetir
+        vector<pair<uint64_t, size_t>> claves;
+        for (size_t i = 0; i < nivel.size(); ++i) {
+            if (jugadas[i] == 0xFFFF) continue;
+            entradas.push_back({claveLibro(nivel[i].T, nivel[i].actual, nivel[i].siguiente), jugadas[i]});
+            claves.push_back({claveTablero(hijos[i]), i});
+        }
+        sort(claves.begin(), claves.end());
+        tableros.clear();
+        for (size_t i = 0; i < claves.size(); ++i) {
+            if (i == 0 || claves[i].first != claves[i - 1].first) tableros.push_back(hijos[claves[i].second]);
+        }
+        cerr << "nivel " << n + 1 << ": " << nivel.size() << " posiciones en " << s << " s" << endl;
+    }
+}
+
+/**
+ * @brief Jugadas de las primeras piezas de las repeticiones de un directorio.
+ * @param directorio Directorio (se recorre con subdirectorios)
+ * @param piezas Colocaciones por repetición
+ * @param entradas Salida: la jugada más repetida de cada posición
+ * @return int -> Repeticiones leídas
+ */
+static int minaRepeticiones(const string &directorio, int piezas, vector<EntradaLibro> &entradas) {
+    unordered_map<uint64_t, vector<pair<uint16_t, int>>> votos;
+    int leidas = 0;
+    error_code ec;
+    for (filesystem::recursive_directory_iterator it(directorio, ec), fin; !ec && it != fin; it.increment(ec)) {
+        if (!it->is_regular_file(ec) || it->path().extension() != ".rep") continue;
+        vector<unsigned char> datos;
+        Repeticion R;
+        if (!cargaFichero(it->path().string().c_str(), datos) || !leeRepeticion(R, datos.data(), datos.size())) {
+            cerr << "No se pudo leer " << it->path().string() << endl;
+            continue;
+        }
+        leidas++;
+        unique_ptr<Reproductor> P(new Reproductor);
+        iniciarReproductor(*P, R);
+        EstadoJuego &E = P->E;
+        // La posición de bloqueo es la de la pieza en el frame en que se fija
+        uint64_t clave = claveLibro(E.T, E.P.tipo, verPieza(E.azar, 0));
+        while (E.fin == EN_JUEGO && E.piezas < piezas && P->frame < R.final.frames) {
+            const Pieza antes = E.P;
+            const int fijadas = E.piezas;
+            avanzaFrame(*P);
+            if (E.piezas == fijadas) continue;
+            uint16_t j = codificaJugada(antes);
+            vector<pair<uint16_t, int>> &v = votos[clave];
+            auto voto = find_if(v.begin(), v.end(), [j](const pair<uint16_t, int> &x) { return x.first == j; });
+            if (voto == v.end()) v.push_back({j, 1});
+            else voto->second++;
+            clave = claveLibro(E.T, E.P.tipo, verPieza(E.azar, 0));
+        }
+    }
+    for (const auto &v : votos) {
+        auto mejor = max_element(v.second.begin(), v.second.end(),
+                                 [](const pair<uint16_t, int> &a, const pair<uint16_t, int> &b) {
+                                     return a.second < b.second || (a.second == b.second && a.first > b.first);
+                                 });
+        entradas.push_back({v.first, mejor->first});
+    }
+    return leidas;
+}
+
+/**
+ * @brief Mide el libro en partidas nuevas.
+ * @param L Libro abierto
+ * @param partidas Partidas
+ * @param piezas Colocaciones por partida
+ * @param O Forma de la búsqueda
+ * @param modo Forma de repartir las piezas
+ * @param semilla Semilla de la primera partida
+ */
+static void mideLibro(const LibroAperturas &L, int partidas, int piezas, const OpcionesHaz &O, ModoAzar modo,
+                      uint64_t semilla) {
+    typedef chrono::steady_clock Reloj;
+    BuscadorHaz B;
+    iniciarHaz(B, nullptr, nullptr);
+    GeneradorMovimientos G;
+    vector<PosicionLibro> vistas;
+    long aciertos = 0;
+    double usLibro = 0;
+    for (int k = 0; k < partidas; ++k) {
+        EstadoJuego E;
+        iniciarJuego(E, semilla + uint64_t(k), modo, 1);
+        while (E.fin == EN_JUEGO && E.piezas < piezas) {
+            const int siguiente = verPieza(E.azar, 0);
+            vistas.push_back({E.T, E.P.tipo, siguiente});
+            Reloj::time_point t = Reloj::now();
+            int d = destinoLibro(L, G, E.T, E.P, siguiente);
+            Pieza destino;
+            if (d >= 0) {
+                destino = G.destino[d].P;
+                aciertos++;
+            } else {
+                ResultadoHaz R;
+                d = buscaHaz(B, E.T, E.P, &siguiente, 1, PESOS_DEFECTO, O, R);
+                if (d >= 0) destino = B.G[0]->destino[d].P;
+            }
+            usLibro += chrono::duration<double, micro>(Reloj::now() - t).count();
+            if (d < 0) break;
+            colocaPieza(E, destino);
+        }
+    }
+
+    // Las mismas decisiones, siempre buscando
+    Reloj::time_point t = Reloj::now();
+    for (const PosicionLibro &Q : vistas) {
+        ResultadoHaz R;
+        buscaHaz(B, Q.T, {INICIO, Q.actual, 0}, &Q.siguiente, 1, PESOS_DEFECTO, O, R);
+    }
+    double usBusqueda = chrono::duration<double, micro>(Reloj::now() - t).count();
+    size_t n = vistas.empty() ? 1 : vistas.size();
+    printf("%u %.1f %.2f %.2f\n", L.entradas, 100.0 * double(aciertos) / double(n), usLibro / double(n),
+           usBusqueda / double(n));
+}
+
+int main(int argc, char *argv[]) {
+    OpcionesHaz O = HAZ_DEFECTO;
+    O.profundidad = 2;
+    int niveles = 3, hilos = int(thread::hardware_concurrency()), partidas = 20, piezas = 12;
+    uint64_t semilla = 1;
+    ModoAzar modo = AZAR_PURO;
+    string repeticiones;
+    bool construir = argc >= 3 && strcmp(argv[1], "construir") == 0;
+    bool medir = argc >= 3 && strcmp(argv[1], "medir") == 0;
+    bool correcto = construir || medir;
+    for (int i = 3; i < argc && correcto; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--niveles") == 0 && valor) niveles = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--anchura") == 0 && valor) O.anchura = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hilos") == 0 && valor) hilos = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--repeticiones") == 0 && valor) repeticiones = argv[++i];
+        else if (strcmp(argv[i], "--partidas") == 0 && valor) partidas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--piezas") == 0 && valor) piezas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) semilla = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--bolsa") == 0) modo = AZAR_BOLSA;
+        else correcto = false;
+    }
+    if (!correcto) {
+        cerr << "Uso: " << argv[0] << " construir LIBRO [--niveles N] [--anchura W] [--hilos H]"
+             << " [--repeticiones DIR] [--piezas P]" << endl
+             << "     " << argv[0] << " medir LIBRO [--partidas K] [--piezas P] [--anchura W]"
+             << " [--bolsa] [--semilla S]" << endl;
+        return 1;
+    }
+    if (hilos < 1) hilos = 1;
+
+    if (construir) {
+        vector<EntradaLibro> entradas;
+        if (!repeticiones.empty()) {
+            int n = minaRepeticiones(repeticiones, piezas, entradas);
+            cerr << n << " repeticiones, " << entradas.size() << " posiciones" << endl;
+        }
+        // escribeLibro se queda con la última jugada de cada clave
+        recorreAperturas(niveles, O, hilos, entradas);
+        if (!escribeLibro(argv[2], entradas)) {
+            cerr << "No se pudo escribir " << argv[2] << endl;
+            return 1;
+        }
+        cerr << entradas.size() << " entradas en " << argv[2] << endl;
+        return 0;
+    }
+
+    LibroAperturas L = {};
+    if (!abreLibro(L, argv[2])) {
+        cerr << "No se pudo abrir " << argv[2] << endl;
+        return 1;
+    }
+    mideLibro(L, partidas, piezas, O, modo, semilla);
+    cierraLibro(L);
+    return 0;
+}
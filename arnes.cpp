@@ -0,0 +1,197 @@
+/**
+ * @file arnes.cpp
+ * @brief Arnés de autojuego Monte Carlo en paralelo
+ *
+ * Juega K partidas independientes sin pantalla con el bot, repartidas entre todos
+ * los núcleos con PoolTrabajo. Cada partida tiene su propio generador de piezas
+ * sembrado con semilla + índice, así que cualquier partida se puede repetir sola.
+ * Los resultados se escriben según terminan, una línea por partida:
+ *
+ *     partida semilla puntos nivel lineas piezas fin milisegundos
+ *
+ * Uso: arnes [--partidas K] [--hilos N] [--semilla S] [--max-frames F] [--bolsa] [--grabar DIR]
+ *            [--control DIR] [--cada F] [--silencio] [--escala]
+ *
+ * Con --escala repite las K partidas con 1, 2, ... N hilos y muestra partidas por
+ * segundo y aceleración respecto a un hilo. Con --bolsa las piezas salen en bolsas de 7.
+ * Con --grabar guarda la repetición de cada partida en DIR/<semilla>.rep. Con
+ * --control guarda cada F frames (10000 por defecto) y al terminar un punto de
+ * control en DIR/<semilla>.ctl: si el lote se corta, al relanzarlo cada partida
+ * sigue desde el suyo y las ya terminadas no se vuelven a jugar.
+ */
+
+#include "bot.h"
+#include "pool.h"
+#include "instantanea.h"
+#include "repeticion.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/** @struct ResultadoPartida
+ *  @brief Resumen de una partida jugada por el arnés.
+ */
+struct ResultadoPartida {
+    int ptos; ///< Puntos finales
+    int level; ///< Nivel alcanzado
+    int lineas; ///< Filas quitadas
+    int piezas; ///< Piezas fijadas
+    Fin fin; ///< Cómo terminó (EN_JUEGO si se agotaron los frames)
+    double ms; ///< Tiempo de reloj de la partida
+};
+
+/** @struct OpcionesArnes
+ *  @brief Opciones comunes a todas las partidas del lote.
+ */
+struct OpcionesArnes {
+    ModoAzar modo = AZAR_PURO; ///< Forma de repartir las piezas
+    long maxFrames = 1000000; ///< Límite de frames por si la partida no termina
+    string grabar; ///< Directorio donde grabar las repeticiones (vacío: no se graban)
+    string control; ///< Directorio de los puntos de control (vacío: sin puntos de control)
+    long cada = 10000; ///< Frames entre puntos de control
+};
+
+/**
+ * @brief Juega una partida completa con el bot.
+ * @post Con puntos de control, la reanuda desde el suyo si existe y lo guarda cada
+ *       O.cada frames y al terminar; una partida ya terminada no se vuelve a jugar.
+ *       Una partida reanudada no se graba, porque le faltan sus primeros frames.
+ * @param B Bot (memoria de búsqueda reutilizada entre partidas del mismo hilo)
+ * @param semilla Semilla de la partida
+ * @param O Opciones del lote
+ * @return ResultadoPartida -> Resumen de la partida
+ */
+static ResultadoPartida jugarPartida(Bot &B, uint64_t semilla, const OpcionesArnes &O) {
+    auto inicio = chrono::steady_clock::now();
+    string control = O.control.empty() ? string() : O.control + "/" + to_string(semilla) + ".ctl";
+    EstadoJuego E;
+    bool reanudada = !control.empty() && cargaPuntoControl(control.c_str(), E);
+    if (!reanudada) iniciarJuego(E, semilla, O.modo);
+    iniciarBot(B, PESOS_DEFECTO);
+
+    bool grabar = !O.grabar.empty() && !reanudada;
+    Grabacion G;
+    if (grabar) iniciarGrabacion(G, semilla, O.modo);
+    for (long f = 1; f <= O.maxFrames && E.fin == EN_JUEGO; ++f) {
+        Accion a = accionBot(B, E);
+        if (grabar) grabaFrame(G, E, a);
+        paso(E, a);
+        if (!control.empty() && f % O.cada == 0 && !guardaPuntoControl(control.c_str(), E)) {
+            cerr << "No se puede escribir " << control << endl;
+        }
+    }
+    if (!control.empty() && !guardaPuntoControl(control.c_str(), E)) cerr << "No se puede escribir " << control << endl;
+    if (grabar) {
+        string fichero = O.grabar + "/" + to_string(semilla) + ".rep";
+        if (!guardaGrabacion(G, E, fichero.c_str())) cerr << "No se puede escribir " << fichero << endl;
+    }
+    ResultadoPartida R;
+    R.ptos = E.ptos;
+    R.level = E.level;
+    R.lineas = E.lineas;
+    R.piezas = E.piezas;
+    R.fin = E.fin;
+    R.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+    return R;
+}
+
+/**
+ * @brief Juega K partidas en paralelo.
+ * @param partidas Número de partidas
+ * @param hilos Hilos del grupo
+ * @param semilla Semilla base: la partida i usa semilla + i
+ * @param O Opciones de las partidas
+ * @param mostrar true: escribe una línea por partida según terminan
+ * @return double -> Segundos de reloj de todo el lote
+ */
+static double lote(int partidas, int hilos, uint64_t semilla, const OpcionesArnes &O, bool mostrar) {
+    static const char *FINES[] = {"limite", "game_over", "victoria"};
+    mutex mSalida;
+    long ptosTotales = 0, lineasTotales = 0;
+
+    auto inicio = chrono::steady_clock::now();
+    {
+        PoolTrabajo pool(hilos);
+        // Un bot por hilo: su memoria de búsqueda se reutiliza en todas sus partidas
+        vector<unique_ptr<Bot>> bots;
+        for (int h = 0; h < pool.hilos(); ++h) bots.emplace_back(new Bot);
+
+        for (int i = 0; i < partidas; ++i) {
+            pool.encolar([&, i] {
+                uint64_t s = semilla + uint64_t(i);
+                ResultadoPartida R = jugarPartida(*bots[PoolTrabajo::hiloActual()], s, O);
+                lock_guard<mutex> l(mSalida);
+                ptosTotales += R.ptos;
+                lineasTotales += R.lineas;
+                if (mostrar) {
+                    printf("%d %llu %d %d %d %d %s %.3f\n", i, (unsigned long long) s, R.ptos, R.level,
+                           R.lineas, R.piezas, FINES[R.fin], R.ms);
+                }
+            });
+        }
+        pool.esperar();
+    }
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    if (mostrar) {
+        fflush(stdout);
+        cerr << partidas << " partidas con " << hilos << " hilos en " << segundos << " s: "
+             << partidas / segundos << " partidas/s, " << double(ptosTotales) / partidas << " puntos y "
+             << double(lineasTotales) / partidas << " lineas de media" << endl;
+    }
+    return segundos;
+}
+
+int main(int argc, char *argv[]) {
+    int partidas = 1000;
+    int hilos = int(thread::hardware_concurrency());
+    uint64_t semilla = 1;
+    bool silencio = false, escala = false;
+    OpcionesArnes O;
+
+    for (int i = 1; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--partidas") == 0 && valor) partidas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hilos") == 0 && valor) hilos = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) semilla = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--max-frames") == 0 && valor) O.maxFrames = atol(argv[++i]);
+        else if (strcmp(argv[i], "--grabar") == 0 && valor) O.grabar = argv[++i];
+        else if (strcmp(argv[i], "--control") == 0 && valor) O.control = argv[++i];
+        else if (strcmp(argv[i], "--cada") == 0 && valor) O.cada = atol(argv[++i]);
+        else if (strcmp(argv[i], "--bolsa") == 0) O.modo = AZAR_BOLSA;
+        else if (strcmp(argv[i], "--silencio") == 0) silencio = true;
+        else if (strcmp(argv[i], "--escala") == 0) escala = true;
+        else {
+            cerr << "Uso: " << argv[0] << " [--partidas K] [--hilos N] [--semilla S] [--max-frames F]"
+                 << " [--bolsa] [--grabar DIR] [--control DIR] [--cada F] [--silencio] [--escala]" << endl;
+            return 1;
+        }
+    }
+    if (partidas < 1) {
+        cerr << "Hace falta al menos una partida" << endl;
+        return 1;
+    }
+    if (hilos < 1) hilos = 1;
+    if (O.cada < 1) O.cada = 1;
+
+    if (!escala) {
+        lote(partidas, hilos, semilla, O, !silencio);
+        return 0;
+    }
+
+    double base = 0;
+    for (int h = 1; h <= hilos; ++h) {
+        double s = lote(partidas, h, semilla, O, false);
+        if (h == 1) base = s;
+        printf("hilos %d: %.1f partidas/s, aceleracion %.2f\n", h, partidas / s, base / s);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file azar.cpp
+ * @brief Generador de piezas reproducible
+ *
+ * @see azar.h
+ */
+
+#include "azar.h"
+
+/**
+ * @brief Genera las piezas de un bloque.
+ * @post A.tipos tiene las TIPOS_PIEZA piezas del bloque k según el modo
+ * @param A Generador
+ * @param k Índice del bloque
+ */
+static void cargaBloque(Aleatorizador &A, uint32_t k) {
+    // Cada bloque se siembra solo con (semilla, k): no depende de los anteriores
+    uint64_t estado = A.semilla ^ (uint64_t(k) * 0xD1B54A32D192ED03ull);
+    uint64_t a = siguienteAzar(estado), b = siguienteAzar(estado);
+    Xoshiro X = {{uint32_t(a), uint32_t(a >> 32), uint32_t(b), uint32_t(b >> 32)}};
+    if ((X.s[0] | X.s[1] | X.s[2] | X.s[3]) == 0) X.s[0] = 1;
+
+    if (A.modo == AZAR_BOLSA) {
+        // Fisher-Yates sobre los 7 tipos
+        for (int i = 0; i < TIPOS_PIEZA; ++i) A.tipos[i] = (unsigned char) i;
+        for (int i = TIPOS_PIEZA - 1; i > 0; --i) {
+            int j = int(acotadoXoshiro(X, uint32_t(i + 1)));
+            unsigned char t = A.tipos[i];
+            A.tipos[i] = A.tipos[j];
+            A.tipos[j] = t;
+        }
+    } else {
+        for (int i = 0; i < TIPOS_PIEZA; ++i) {
+            A.tipos[i] = (unsigned char) acotadoXoshiro(X, TIPOS_PIEZA);
+        }
+    }
+    A.bloque = k;
+}
+
+/**
+ * @brief Tipo de la pieza n de la partida.
+ * @post Solo depende de la semilla, del modo y de n
+ * @param A Generador (puede cargar otro bloque)
+ * @param n Índice de la pieza desde el inicio de la partida
+ * @return int -> Tipo de pieza
+ */
+int tipoPieza(Aleatorizador &A, uint32_t n) {
+    uint32_t k = n / TIPOS_PIEZA;
+    if (k != A.bloque) cargaBloque(A, k);
+    return A.tipos[n % TIPOS_PIEZA];
+}
+
+/**
+ * @brief Prepara el generador de una partida.
+ * @post La cola tiene las primeras vista piezas de la secuencia
+ * @param A Generador
+ * @param semilla Semilla de la partida
+ * @param modo Forma de repartir las piezas
+ * @param vista Piezas siguientes visibles (se ajusta a 1..CAPACIDAD_VISTA)
+ */
+void iniciarAzar(Aleatorizador &A, uint64_t semilla, ModoAzar modo, int vista) {
+    if (vista < 1) vista = 1;
+    if (vista > CAPACIDAD_VISTA) vista = CAPACIDAD_VISTA;
+    A.semilla = semilla;
+    A.modo = modo;
+    A.bloque = UINT32_MAX;
+    A.inicio = 0;
+    A.vista = vista;
+    for (A.generadas = 0; A.generadas < uint32_t(vista); ++A.generadas) {
+        A.cola[A.generadas] = (unsigned char) tipoPieza(A, A.generadas);
+    }
+}
+
+/**
+ * @brief Saca la primera pieza de la cola y genera una nueva al final.
+ * @param A Generador
+ * @return int -> Tipo de la pieza sacada
+ */
+int sacarPieza(Aleatorizador &A) {
+    int tipo = A.cola[A.inicio];
+    int fin = (A.inicio + A.vista) & (CAPACIDAD_VISTA - 1);
+    A.cola[fin] = (unsigned char) tipoPieza(A, A.generadas++);
+    A.inicio = (A.inicio + 1) & (CAPACIDAD_VISTA - 1);
+    return tipo;
+}
+
+/**
+ * @brief Coloca el generador en un punto de la secuencia sin generar las piezas anteriores.
+ * @pre A se ha iniciado con la semilla, el modo y la vista de la partida
+ * @post La cola tiene las piezas generadas - vista .. generadas - 1
+ * @param A Generador
+ * @param generadas Piezas generadas hasta ese punto (al menos A.vista)
+ */
+void situarAzar(Aleatorizador &A, uint32_t generadas) {
+    if (generadas < uint32_t(A.vista)) generadas = uint32_t(A.vista);
+    A.inicio = 0;
+    for (int i = 0; i < A.vista; ++i) {
+        A.cola[i] = (unsigned char) tipoPieza(A, generadas - uint32_t(A.vista) + uint32_t(i));
+    }
+    A.generadas = generadas;
+}
+
+/**
+ * @brief Crea una nueva pieza
+ * @post Saca la siguiente pieza del generador, en la posición INICIO y sin girar
+ * @param P Pieza a crear
+ * @param A Generador de la partida
+ */
+void pieza_nueva(Pieza &P, Aleatorizador &A) {
+    P.abs = INICIO;
+    P.tipo = sacarPieza(A);
+    P.rot = 0;
+}
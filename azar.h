@@ -0,0 +1,122 @@
+/**
+ * @file azar.h
+ * @brief Generador de piezas reproducible
+ *
+ * Las piezas salen de un xoshiro128** sembrado con la semilla de la partida. La
+ * secuencia se genera por bloques de TIPOS_PIEZA piezas y cada bloque k se
+ * siembra a partir de (semilla, k), así que la pieza n depende solo de la
+ * semilla, del modo y de n: basta con el contador de piezas para volver a
+ * cualquier punto de la partida.
+ *
+ * Hay dos modos:
+ * - AZAR_PURO: cada pieza es uniforme entre los 7 tipos (sin sesgo de módulo).
+ * - AZAR_BOLSA: cada bloque es una permutación de los 7 tipos (bolsa de 7).
+ *
+ * Las próximas piezas esperan en un búfer circular de capacidad fija con la
+ * profundidad de vista que se pida al iniciar.
+ */
+
+#ifndef _AZAR_H_
+#define _AZAR_H_
+
+#include "tablero.h"
+
+const int CAPACIDAD_VISTA = 8; ///< Máximo de piezas siguientes visibles (potencia de 2)
+
+/** @enum ModoAzar
+ *  @brief Forma de repartir las piezas.
+ */
+enum ModoAzar {
+    AZAR_PURO, ///< Cada pieza al azar, independiente de las demás
+    AZAR_BOLSA ///< Bolsas de 7: cada tipo sale una vez cada 7 piezas
+};
+
+/**
+ * @brief Avanza un generador splitmix64 y devuelve el siguiente número.
+ * @post Se usa para sembrar xoshiro a partir de la semilla de la partida
+ * @param estado Estado del generador (se actualiza)
+ * @return uint64_t -> Número pseudoaleatorio de 64 bits
+ */
+inline uint64_t siguienteAzar(uint64_t &estado) {
+    uint64_t z = (estado += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/** @struct Xoshiro
+ *  @brief Estado de un generador xoshiro128**.
+ */
+struct Xoshiro {
+    uint32_t s[4]; ///< Estado (nunca todo a cero)
+};
+
+/**
+ * @brief Avanza el generador xoshiro128** y devuelve el siguiente número.
+ * @param X Generador (se actualiza)
+ * @return uint32_t -> Número pseudoaleatorio de 32 bits
+ */
+inline uint32_t siguienteXoshiro(Xoshiro &X) {
+    uint32_t r = X.s[1] * 5;
+    r = ((r << 7) | (r >> 25)) * 9;
+    uint32_t t = X.s[1] << 9;
+    X.s[2] ^= X.s[0];
+    X.s[3] ^= X.s[1];
+    X.s[1] ^= X.s[2];
+    X.s[0] ^= X.s[3];
+    X.s[2] ^= t;
+    X.s[3] = (X.s[3] << 11) | (X.s[3] >> 21);
+    return r;
+}
+
+/**
+ * @brief Número uniforme en [0, n) sin sesgo (método de Lemire).
+ * @param X Generador (se actualiza)
+ * @param n Tamaño del intervalo (> 0)
+ * @return uint32_t -> Número en [0, n)
+ */
+inline uint32_t acotadoXoshiro(Xoshiro &X, uint32_t n) {
+    uint64_t m = uint64_t(siguienteXoshiro(X)) * n;
+    uint32_t bajo = uint32_t(m);
+    if (bajo < n) {
+        uint32_t umbral = uint32_t(-n) % n;
+        while (bajo < umbral) {
+            m = uint64_t(siguienteXoshiro(X)) * n;
+            bajo = uint32_t(m);
+        }
+    }
+    return uint32_t(m >> 32);
+}
+
+/** @struct Aleatorizador
+ *  @brief Generador de piezas de una partida con su cola de piezas siguientes.
+ */
+struct Aleatorizador {
+    uint64_t semilla; ///< Semilla de la partida
+    ModoAzar modo; ///< Forma de repartir las piezas
+    uint32_t generadas; ///< Piezas generadas hasta ahora (índice de la próxima)
+    uint32_t bloque; ///< Bloque cargado en tipos (UINT32_MAX: ninguno)
+    unsigned char tipos[TIPOS_PIEZA]; ///< Piezas del bloque cargado
+    unsigned char cola[CAPACIDAD_VISTA]; ///< Búfer circular de piezas siguientes
+    int inicio; ///< Posición en cola de la primera pieza siguiente
+    int vista; ///< Piezas siguientes en la cola (1..CAPACIDAD_VISTA)
+};
+
+void iniciarAzar(Aleatorizador &A, uint64_t semilla, ModoAzar modo, int vista);
+int tipoPieza(Aleatorizador &A, uint32_t n);
+int sacarPieza(Aleatorizador &A);
+void situarAzar(Aleatorizador &A, uint32_t generadas);
+
+/**
+ * @brief Tipo de una de las piezas siguientes sin sacarla.
+ * @param A Generador
+ * @param i Posición en la cola (0: la siguiente)
+ * @return int -> Tipo de pieza
+ */
+inline int verPieza(const Aleatorizador &A, int i) {
+    return A.cola[(A.inicio + i) & (CAPACIDAD_VISTA - 1)];
+}
+
+void pieza_nueva(Pieza &P, Aleatorizador &A);
+
+#endif
@@ -0,0 +1,324 @@
+/**
+ * @file bot.cpp
+ * @brief Jugador automático del Tetris
+ *
+ * @see bot.h
+ */
+
+#include "bot.h"
+#include "libro.h"
+
+const Pesos PESOS_DEFECTO = {-0.510066, -0.35663, -0.184483, 0.760666};
+
+/**
+ * @brief Calcula los rasgos de un tablero en una pasada de arriba a abajo.
+ * @post Las alturas salen del primer bit de cada columna; los huecos son los bits
+ *       a 0 bajo la unión de todas las filas anteriores.
+ * @param T Ocupación del tablero
+ * @param R Rasgos calculados
+ */
+void calculaRasgos(const Ocupacion &T, Rasgos &R) {
+    int alturas[COLUMNAS] = {0};
+    Fila cubierta = 0;
+    int huecos = 0;
+    for (int f = 0; f < FILAS; ++f) {
+        unsigned nuevas = T.fila[f] & ~cubierta;
+        while (nuevas) {
+            alturas[bitMasBajo(nuevas)] = FILAS - f;
+            nuevas &= nuevas - 1;
+        }
+        huecos += cuentaBits(cubierta & ~T.fila[f]);
+        cubierta |= T.fila[f];
+    }
+
+    int altura = alturas[0];
+    int rugosidad = 0;
+    for (int c = 1; c < COLUMNAS; ++c) {
+        altura += alturas[c];
+        int d = alturas[c] - alturas[c - 1];
+        rugosidad += d < 0 ? -d : d;
+    }
+    R.altura = altura;
+    R.huecos = huecos;
+    R.rugosidad = rugosidad;
+}
+
+/**
+ * @brief Puntúa un tablero tras una colocación.
+ * @param T Ocupación del tablero ya sin las filas llenas
+ * @param lineas Filas quitadas por la colocación
+ * @param W Pesos del evaluador
+ * @return double -> Puntuación: más alta es mejor
+ */
+double evaluaTablero(const Ocupacion &T, int lineas, const Pesos &W) {
+    Rasgos R;
+    calculaRasgos(T, R);
+    return W.altura * R.altura + W.huecos * R.huecos + W.rugosidad * R.rugosidad + W.lineas * lineas;
+}
+
+/**
+ * @brief Comprueba si dos colocaciones ocupan exactamente las mismas celdas.
+ * @post Las rotaciones 0 y 2 de S, 2 y el palo dan a veces la misma forma desplazada
+ * @param a Primera pieza
+ * @param b Segunda pieza
+ * @return bool -> true: mismas celdas
+ */
+bool mismasCeldas(const Pieza &a, const Pieza &b) {
+    const Huella &ha = a.huella();
+    const Huella &hb = b.huella();
+    return a.tipo == b.tipo && ha.canonica == hb.canonica &&
+           a.abs.x + ha.minx == b.abs.x + hb.minx && a.abs.y + ha.miny == b.abs.y + hb.miny;
+}
+
+/**
+ * @brief Añade las colocaciones alcanzables desplazando y dejando caer una pieza ya girada.
+ * @param T Ocupación del tablero
+ * @param R Pieza girada en la posición desde la que se desplaza
+ * @param giros Giros que se han hecho para llegar a R (negativo: a la izquierda)
+ * @param salida Lista de colocaciones
+ * @param n Número de colocaciones en la lista (se actualiza)
+ */
+static void desplazaYCae(const Ocupacion &T, const Pieza &R, int giros,
+                         Colocacion salida[MAX_COLOCACIONES], int &n) {
+    KernelColision k = COLISION[R.tipo][R.rot];
+    for (int dir = -1; dir <= 1; dir += 2) {
+        for (int d = (dir < 0 ? 0 : 1);; ++d) {
+            int x = R.abs.x + dir * d;
+            if (k(T, x, R.abs.y)) break;
+            int y = R.abs.y;
+            while (!k(T, x, y + 1)) ++y;
+
+            Colocacion c = {{{x, y}, R.tipo, R.rot}, giros, dir * d};
+            bool repetida = false;
+            for (int i = 0; i < n && !repetida; ++i) {
+                repetida = mismasCeldas(salida[i].P, c.P);
+            }
+            if (!repetida && n < MAX_COLOCACIONES) salida[n++] = c;
+        }
+    }
+}
+
+/**
+ * @brief Enumera todas las colocaciones finales legales de una pieza.
+ * @post Cada colocación es alcanzable con las reglas de paso(): primero girar
+ *       (0, 1 o 2 veces a la derecha, o 1 a la izquierda), luego desplazar y
+ *       luego bajar hasta fijarse. Las que ocupan las mismas celdas se cuentan una vez.
+ * @param T Ocupación del tablero
+ * @param P Pieza actual
+ * @param salida Colocaciones encontradas
+ * @return int -> Número de colocaciones (0 si la pieza ya colisiona)
+ */
+int enumeraColocaciones(const Ocupacion &T, const Pieza &P, Colocacion salida[MAX_COLOCACIONES]) {
+    int n = 0;
+    if (colisionPieza(T, P)) return 0;
+
+    desplazaYCae(T, P, 0, salida, n);
+    if (P.tipo == CUADRADO) return n;
+
+    Pieza R = P;
+    rota_derecha(R);
+    if (!colisionPieza(T, R)) {
+        desplazaYCae(T, R, 1, salida, n);
+        rota_derecha(R);
+        if (!colisionPieza(T, R)) desplazaYCae(T, R, 2, salida, n);
+    }
+
+    R = P;
+    rota_izquierda(R);
+    if (!colisionPieza(T, R)) desplazaYCae(T, R, -1, salida, n);
+    return n;
+}
+
+/**
+ * @brief Busca la colocación de la pieza actual con mejor puntuación.
+ * @param T Ocupación del tablero
+ * @param P Pieza actual
+ * @param W Pesos del evaluador
+ * @param mejor Mejor colocación encontrada
+ * @return bool -> true: hay al menos una colocación legal
+ */
+bool mejorColocacion(const Ocupacion &T, const Pieza &P, const Pesos &W, Colocacion &mejor) {
+    Colocacion lista[MAX_COLOCACIONES];
+    int n = enumeraColocaciones(T, P, lista);
+    double mejorValor = 0;
+    for (int i = 0; i < n; ++i) {
+        const Pieza &C = lista[i].P;
+        Ocupacion copia = T;
+        INSERCION[C.tipo][C.rot](copia, C.abs.x, C.abs.y);
+        int lineas = cuentaFila(copia);
+        double v = evaluaTablero(copia, lineas, W);
+        if (i == 0 || v > mejorValor) {
+            mejorValor = v;
+            mejor = lista[i];
+        }
+    }
+    return n > 0;
+}
+
+/**
+ * @brief Busca la mejor posición de bloqueo entre todas las alcanzables.
+ * @post Usa el generador por búsqueda en anchura, así que también valora
+ *       colocaciones bajo salientes. La ruta se obtiene con rutaMovimientos.
+ * @param G Memoria de la búsqueda (queda con los destinos de esta pieza)
+ * @param T Ocupación del tablero
+ * @param P Pieza actual
+ * @param W Pesos del evaluador
+ * @return int -> Índice del mejor destino en G.destino, o -1 si no hay ninguno
+ */
+int mejorDestino(GeneradorMovimientos &G, const Ocupacion &T, const Pieza &P, const Pesos &W) {
+    int n = generaMovimientos(G, T, P);
+    int mejor = -1;
+    double mejorValor = 0;
+    for (int i = 0; i < n; ++i) {
+        const Pieza &C = G.destino[i].P;
+        Ocupacion copia = T;
+        INSERCION[C.tipo][C.rot](copia, C.abs.x, C.abs.y);
+        int lineas = cuentaFila(copia);
+        double v = evaluaTablero(copia, lineas, W);
+        if (mejor < 0 || v > mejorValor) {
+            mejorValor = v;
+            mejor = i;
+        }
+    }
+    return mejor;
+}
+
+/**
+ * @brief Codifica una colocación en 16 bits para la tabla de transposición.
+ * @param P Pieza en su posición de bloqueo
+ * @return uint16_t -> rot | x << 2 | y << 7
+ */
+uint16_t codificaJugada(const Pieza &P) {
+    return uint16_t(P.rot | P.abs.x << 2 | P.abs.y << 7);
+}
+
+/**
+ * @brief Valor de un tablero sin las filas quitadas, redondeado a float.
+ * @post Es lo que se guarda en la tabla con profundidad 0: con o sin tabla, la
+ *       búsqueda usa exactamente los mismos valores
+ * @param T Ocupación del tablero ya sin las filas llenas
+ * @param clave Clave Zobrist de T
+ * @param W Pesos del evaluador
+ * @param TT Tabla de transposición (nullptr: sin tabla)
+ * @return float -> evaluaTablero(T, 0, W)
+ */
+float valorTablero(const Ocupacion &T, uint64_t clave, const Pesos &W, TablaTransposicion *TT) {
+    EntradaTabla E;
+    if (TT != nullptr && buscaTabla(*TT, clave, E)) return E.valor;
+    float v = float(evaluaTablero(T, 0, W));
+    if (TT != nullptr) guardaTabla(*TT, clave, {v, 0, 0});
+    return v;
+}
+
+/**
+ * @brief Valor de un tablero con la siguiente pieza por colocar: el de su mejor colocación.
+ * @post Se guarda en la tabla con profundidad 1 y la clave del tablero XOR la de la pieza
+ * @param G Memoria de la búsqueda de la siguiente pieza
+ * @param T Ocupación del tablero ya sin las filas llenas
+ * @param clave Clave Zobrist de T
+ * @param siguiente Tipo de la siguiente pieza
+ * @param W Pesos del evaluador
+ * @param TT Tabla de transposición (nullptr: sin tabla)
+ * @return float -> Mejor valor; VALOR_DERROTA si la pieza no cabe
+ */
+static float valorConSiguiente(GeneradorMovimientos &G, const Ocupacion &T, uint64_t clave, int siguiente,
+                               const Pesos &W, TablaTransposicion *TT) {
+    const uint64_t posicion = clave ^ ZOBRIST.pieza[siguiente];
+    EntradaTabla E;
+    if (TT != nullptr && buscaTabla(*TT, posicion, E) && E.profundidad >= 1) return E.valor;
+
+    Pieza N = {INICIO, siguiente, 0};
+    int n = colisionPieza(T, N) ? 0 : generaMovimientos(G, T, N);
+    float mejor = VALOR_DERROTA;
+    uint16_t jugada = 0;
+    for (int i = 0; i < n; ++i) {
+        const Pieza &C = G.destino[i].P;
+        Ocupacion copia = T;
+        uint64_t k = clave;
+        insertaPieza(copia, C, k);
+        int lineas = cuentaFila(copia, k);
+        float v = float(valorTablero(copia, k, W, TT) + W.lineas * lineas);
+        if (i == 0 || v > mejor) {
+            mejor = v;
+            jugada = codificaJugada(C);
+        }
+    }
+    if (TT != nullptr) guardaTabla(*TT, posicion, {mejor, 1, jugada});
+    return mejor;
+}
+
+/**
+ * @brief Busca la mejor posición de bloqueo mirando también la pieza siguiente.
+ * @post Cada destino vale las filas que quita más el valor de la mejor colocación
+ *       de la siguiente pieza en el tablero que deja. Los valores se redondean a
+ *       float en cada nivel, así que el resultado no depende de la tabla ni de lo
+ *       que otros hilos hayan guardado en ella.
+ * @param G Memoria de la búsqueda (queda con los destinos de esta pieza)
+ * @param G2 Memoria de la búsqueda de la siguiente pieza
+ * @param T Ocupación del tablero
+ * @param P Pieza actual
+ * @param siguiente Tipo de la siguiente pieza (verPieza)
+ * @param W Pesos del evaluador
+ * @param TT Tabla de transposición compartida (nullptr: sin tabla)
+ * @return int -> Índice del mejor destino en G.destino, o -1 si no hay ninguno
+ */
+int mejorDestinoPrevia(GeneradorMovimientos &G, GeneradorMovimientos &G2, const Ocupacion &T, const Pieza &P,
+                       int siguiente, const Pesos &W, TablaTransposicion *TT) {
+    int n = generaMovimientos(G, T, P);
+    const uint64_t clave = claveTablero(T);
+    int mejor = -1;
+    float mejorValor = 0;
+    for (int i = 0; i < n; ++i) {
+        Ocupacion copia = T;
+        uint64_t k = clave;
+        insertaPieza(copia, G.destino[i].P, k);
+        int lineas = cuentaFila(copia, k);
+        float v = float(W.lineas * lineas + valorConSiguiente(G2, copia, k, siguiente, W, TT));
+        if (mejor < 0 || v > mejorValor) {
+            mejorValor = v;
+            mejor = i;
+        }
+    }
+    return mejor;
+}
+
+/**
+ * @brief Prepara el jugador automático.
+ * @param B Bot
+ * @param W Pesos del evaluador
+ * @param libro Libro de aperturas abierto (nullptr: siempre busca)
+ */
+void iniciarBot(Bot &B, const Pesos &W, const LibroAperturas *libro) {
+    B.W = W;
+    B.libro = libro;
+    B.n = 0;
+    B.i = 0;
+    B.piezas = 0;
+    B.listo = false;
+}
+
+/**
+ * @brief Decide la acción del bot en este frame.
+ * @post Con cada pieza nueva busca la mejor posición de bloqueo (o la toma del
+ *       libro, si la posición está en él) y toma como plan la ruta más corta
+ *       hasta ella; cuando se acaba el plan, baja hasta fijarla.
+ * @param B Bot
+ * @param E Estado de la partida
+ * @return Accion -> Acción a pasar a paso() en este frame
+ */
+Accion accionBot(Bot &B, const EstadoJuego &E) {
+    if (!B.listo || B.piezas != E.piezas) {
+        B.listo = true;
+        B.piezas = E.piezas;
+        B.n = 0;
+        B.i = 0;
+
+        int mejor = -1;
+        if (B.libro != nullptr && E.azar.vista > 0) mejor = destinoLibro(*B.libro, B.G, E.T, E.P, verPieza(E.azar, 0));
+        if (mejor < 0) mejor = mejorDestino(B.G, E.T, E.P, B.W);
+        if (mejor < 0) return NADA;
+        B.n = rutaMovimientos(B.G, mejor, B.plan);
+    }
+    if (B.i < B.n) return B.plan[B.i++];
+    return BAJAR;
+}
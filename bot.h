@@ -0,0 +1,90 @@
+/**
+ * @file bot.h
+ * @brief Jugador automático del Tetris
+ *
+ * Para la pieza actual enumera todas las colocaciones finales legales, puntúa el
+ * tablero resultante con una combinación lineal de rasgos y juega la mejor.
+ * Genera Accion por frame, igual que las teclas de un jugador.
+ *
+ * Hay dos enumeradores: enumeraColocaciones (girar, desplazar y dejar caer, muy
+ * barato) y el generador por búsqueda en anchura de movimientos.h, que además
+ * encuentra colocaciones bajo salientes y es el que usa accionBot.
+ *
+ * mejorDestinoPrevia mira además la pieza siguiente, y puede compartir lo ya
+ * evaluado con otros hilos en una TablaTransposicion.
+ *
+ * Si el Bot tiene un libro de aperturas (libro.h), accionBot lo consulta antes
+ * de buscar: al principio de la partida la jugada sale de una sola consulta.
+ */
+
+#ifndef _BOT_H_
+#define _BOT_H_
+
+#include "juego.h"
+#include "movimientos.h"
+#include "transposicion.h"
+
+struct LibroAperturas;
+
+const int MAX_COLOCACIONES = 64; ///< Cota de colocaciones distintas de una pieza
+const float VALOR_DERROTA = -1e9f; ///< Valor de una posición en la que la siguiente pieza no cabe
+
+/** @struct Pesos
+ *  @brief Pesos del evaluador de tableros.
+ */
+struct Pesos {
+    double altura; ///< Peso de la suma de alturas de las columnas
+    double huecos; ///< Peso de las celdas vacías con algún bloque encima
+    double rugosidad; ///< Peso de la suma de diferencias de altura entre columnas vecinas
+    double lineas; ///< Peso de las filas quitadas por la colocación
+};
+
+extern const Pesos PESOS_DEFECTO; ///< Pesos por defecto del evaluador
+
+/** @struct Rasgos
+ *  @brief Rasgos de un tablero que usa el evaluador.
+ */
+struct Rasgos {
+    int altura; ///< Suma de alturas de las columnas
+    int huecos; ///< Celdas vacías con algún bloque encima en su columna
+    int rugosidad; ///< Suma de |altura[i] - altura[i + 1]|
+};
+
+/** @struct Colocacion
+ *  @brief Posición final de una pieza y cómo llegar a ella desde la posición actual.
+ */
+struct Colocacion {
+    Pieza P; ///< Pieza en su posición de bloqueo
+    int giros; ///< Giros a la derecha desde la pieza actual
+    int desplazamiento; ///< Columnas a desplazar (negativo: izquierda) tras girar
+};
+
+/** @struct Bot
+ *  @brief Estado del jugador automático entre frames.
+ */
+struct Bot {
+    Pesos W; ///< Pesos del evaluador
+    GeneradorMovimientos G; ///< Memoria de la búsqueda de movimientos
+    Accion plan[MAX_ESTADOS]; ///< Acciones pendientes antes de dejar caer
+    int n; ///< Número de acciones del plan
+    int i; ///< Siguiente acción del plan
+    int piezas; ///< Valor de EstadoJuego::piezas cuando se hizo el plan
+    bool listo; ///< Hay un plan para la pieza actual
+    const LibroAperturas *libro; ///< Libro que se consulta antes de buscar (nullptr: sin libro)
+};
+
+void calculaRasgos(const Ocupacion &T, Rasgos &R);
+double evaluaTablero(const Ocupacion &T, int lineas, const Pesos &W);
+bool mismasCeldas(const Pieza &a, const Pieza &b);
+int enumeraColocaciones(const Ocupacion &T, const Pieza &P, Colocacion salida[MAX_COLOCACIONES]);
+bool mejorColocacion(const Ocupacion &T, const Pieza &P, const Pesos &W, Colocacion &mejor);
+int mejorDestino(GeneradorMovimientos &G, const Ocupacion &T, const Pieza &P, const Pesos &W);
+uint16_t codificaJugada(const Pieza &P);
+float valorTablero(const Ocupacion &T, uint64_t clave, const Pesos &W, TablaTransposicion *TT);
+int mejorDestinoPrevia(GeneradorMovimientos &G, GeneradorMovimientos &G2, const Ocupacion &T, const Pieza &P,
+                       int siguiente, const Pesos &W, TablaTransposicion *TT);
+
+void iniciarBot(Bot &B, const Pesos &W, const LibroAperturas *libro = nullptr);
+Accion accionBot(Bot &B, const EstadoJuego &E);
+
+#endif
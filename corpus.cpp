@@ -0,0 +1,328 @@
+/**
+ * @file corpus.cpp
+ * @brief Validación e índice de un corpus de repeticiones
+ *
+ * Uso:
+ *     corpus validar <directorio> <indice> [--hilos N]
+ *     corpus buscar <indice> [--semilla S] [--min-puntos P] [--max-puntos P]
+ *                   [--min-lineas L] [--fin limite|game_over|victoria] [--fallos]
+ *
+ * validar recorre el directorio (y sus subdirectorios) buscando ficheros .rep,
+ * proyecta cada uno en memoria con mmap, lo vuelve a simular en el grupo de
+ * hilos y compara puntos, nivel, líneas, piezas y fin con los del pie. Nunca
+ * copia un fichero entero a memoria propia y el número de ficheros en vuelo está
+ * acotado, así que la memoria no crece con el tamaño del corpus.
+ *
+ * El índice son dos ficheros: <indice> con una cabecera y un RegistroIndice de
+ * tamaño fijo por repetición, ordenados por semilla y puntos, y <indice>.nombres
+ * con las rutas, una por línea. buscar proyecta ambos y filtra: por semilla con
+ * búsqueda binaria y el resto recorriendo los registros.
+ */
+
+#include "pool.h"
+#include "repeticion.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/** @enum EstadoRegistro
+ *  @brief Resultado de validar una repetición.
+ */
+enum EstadoRegistro {
+    REGISTRO_OK, ///< La simulación coincide con el pie
+    REGISTRO_DISTINTO, ///< La simulación no coincide con el pie
+    REGISTRO_INVALIDO ///< No se puede leer o el formato no es válido
+};
+
+/** @struct RegistroIndice
+ *  @brief Entrada de tamaño fijo del índice.
+ */
+struct RegistroIndice {
+    uint64_t semilla; ///< Semilla de la partida
+    uint64_t nombre; ///< Posición de la ruta en el fichero de nombres
+    int32_t ptos; ///< Puntos finales grabados
+    int32_t lineas; ///< Filas quitadas grabadas
+    int32_t piezas; ///< Piezas fijadas grabadas
+    uint32_t frames; ///< Frames grabados
+    uint8_t level; ///< Nivel final grabado
+    uint8_t fin; ///< Causa del final (valor de Fin)
+    uint8_t estado; ///< Resultado de la validación (EstadoRegistro)
+    uint8_t modo; ///< Modo del generador de piezas
+    uint32_t reservado; ///< Relleno a 40 bytes
+};
+
+/** @struct CabeceraIndice
+ *  @brief Cabecera del fichero de índice.
+ */
+struct CabeceraIndice {
+    char magia[4]; ///< "TTIX"
+    uint32_t tamRegistro; ///< sizeof(RegistroIndice), para detectar índices de otra versión
+    uint64_t registros; ///< Número de registros que siguen
+};
+
+static const char *FINES[] = {"limite", "game_over", "victoria"};
+static const char *ESTADOS[] = {"ok", "distinto", "invalido"};
+
+/** @struct Proyeccion
+ *  @brief Fichero proyectado en memoria.
+ */
+struct Proyeccion {
+    int fd = -1; ///< Descriptor del fichero
+    unsigned char *datos = nullptr; ///< Contenido proyectado
+    size_t n = 0; ///< Bytes
+
+    Proyeccion() = default;
+    Proyeccion(const Proyeccion &) = delete;
+    Proyeccion &operator=(const Proyeccion &) = delete;
+
+    /**
+     * @brief Proyecta un fichero entero.
+     * @param ruta Fichero
+     * @param escritura true: proyección compartida de lectura y escritura
+     * @return bool -> true: proyectado (un fichero vacío también cuenta)
+     */
+    bool abrir(const char *ruta, bool escritura) {
+        fd = open(ruta, escritura ? O_RDWR : O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) return false;
+        n = size_t(st.st_size);
+        if (n == 0) return true;
+        void *p = mmap(nullptr, n, escritura ? PROT_READ | PROT_WRITE : PROT_READ,
+                       escritura ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) return false;
+        datos = static_cast<unsigned char *>(p);
+        return true;
+    }
+
+    ~Proyeccion() {
+        if (datos) munmap(datos, n);
+        if (fd >= 0) close(fd);
+    }
+};
+
+/**
+ * @brief Valida una repetición y rellena su registro.
+ * @param ruta Fichero de la repetición
+ * @param r Registro (se rellena salvo el nombre)
+ * @return uint32_t -> Frames simulados
+ */
+static uint32_t validaFichero(const char *ruta, RegistroIndice &r) {
+    memset(&r, 0, sizeof(r));
+    r.estado = REGISTRO_INVALIDO;
+    Proyeccion f;
+    Repeticion R;
+    if (!f.abrir(ruta, false) || !leeRepeticion(R, f.datos, f.n)) return 0;
+    madvise(f.datos, f.n, MADV_SEQUENTIAL);
+
+    r.semilla = R.semilla;
+    r.modo = uint8_t(R.modo);
+    r.frames = R.final.frames;
+    r.ptos = R.final.ptos;
+    r.level = uint8_t(R.final.level);
+    r.lineas = R.final.lineas;
+    r.piezas = R.final.piezas;
+    r.fin = uint8_t(R.final.fin);
+
+    Reproductor P;
+    iniciarReproductor(P, R);
+    avanzaHasta(P, R.final.frames);
+    const EstadoJuego &E = P.E;
+    bool ok = E.ptos == R.final.ptos && E.level == R.final.level && E.lineas == R.final.lineas &&
+              E.piezas == R.final.piezas && E.fin == R.final.fin;
+    r.estado = ok ? REGISTRO_OK : REGISTRO_DISTINTO;
+    return R.final.frames;
+}
+
+/**
+ * @brief Valida todas las repeticiones de un directorio y escribe el índice.
+ * @param directorio Raíz del corpus
+ * @param indice Fichero de índice (y <indice>.nombres)
+ * @param hilos Hilos del grupo
+ * @return int -> 0 si todas son válidas y coinciden, 2 si alguna falla, 1 si hay error
+ */
+static int validar(const string &directorio, const string &indice, int hilos) {
+    FILE *fIndice = fopen(indice.c_str(), "wb");
+    FILE *fNombres = fopen((indice + ".nombres").c_str(), "wb");
+    if (!fIndice || !fNombres) {
+        cerr << "No se puede escribir el indice " << indice << endl;
+        return 1;
+    }
+    CabeceraIndice cab = {{'T', 'T', 'I', 'X'}, uint32_t(sizeof(RegistroIndice)), 0};
+    fwrite(&cab, sizeof(cab), 1, fIndice);
+
+    mutex mIndice;
+    uint64_t posNombre = 0, frames = 0;
+    long cuenta[3] = {0, 0, 0};
+
+    // Ficheros en vuelo acotados: el recorrido del directorio espera a los hilos
+    mutex mVuelo;
+    condition_variable hueco;
+    int enVuelo = 0;
+
+    auto inicio = chrono::steady_clock::now();
+    {
+        PoolTrabajo pool(hilos);
+        const int maxVuelo = 4 * pool.hilos();
+        error_code ec;
+        for (filesystem::recursive_directory_iterator it(directorio, ec), fin; !ec && it != fin; it.increment(ec)) {
+            if (!it->is_regular_file(ec) || it->path().extension() != ".rep") continue;
+            {
+                unique_lock<mutex> l(mVuelo);
+                hueco.wait(l, [&] { return enVuelo < maxVuelo; });
+                ++enVuelo;
+            }
+            pool.encolar([&, ruta = it->path().string()] {
+                RegistroIndice r;
+                uint32_t f = validaFichero(ruta.c_str(), r);
+                {
+                    lock_guard<mutex> l(mIndice);
+                    r.nombre = posNombre;
+                    fputs(ruta.c_str(), fNombres);
+                    fputc('\n', fNombres);
+                    posNombre += ruta.size() + 1;
+                    fwrite(&r, sizeof(r), 1, fIndice);
+                    cab.registros++;
+                    frames += f;
+                    cuenta[r.estado]++;
+                    if (r.estado != REGISTRO_OK) cerr << ESTADOS[r.estado] << ": " << ruta << endl;
+                }
+                lock_guard<mutex> l(mVuelo);
+                --enVuelo;
+                hueco.notify_one();
+            });
+        }
+        if (ec) cerr << "Error recorriendo " << directorio << ": " << ec.message() << endl;
+        pool.esperar();
+    }
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    fseek(fIndice, 0, SEEK_SET);
+    fwrite(&cab, sizeof(cab), 1, fIndice);
+    bool escrito = fclose(fIndice) == 0;
+    escrito = fclose(fNombres) == 0 && escrito;
+    if (!escrito) {
+        cerr << "Error escribiendo el indice " << indice << endl;
+        return 1;
+    }
+
+    // Ordena los registros en el propio fichero proyectado, sin copiarlos a memoria
+    Proyeccion p;
+    if (cab.registros > 0) {
+        // buscar hace búsqueda binaria por semilla: un índice sin ordenar daría resultados falsos
+        if (!p.abrir(indice.c_str(), true)) {
+            cerr << "No se puede ordenar el indice " << indice << endl;
+            return 1;
+        }
+        RegistroIndice *r = reinterpret_cast<RegistroIndice *>(p.datos + sizeof(CabeceraIndice));
+        sort(r, r + cab.registros, [](const RegistroIndice &a, const RegistroIndice &b) {
+            return a.semilla != b.semilla ? a.semilla < b.semilla : a.ptos < b.ptos;
+        });
+    }
+
+    cout << cab.registros << " repeticiones: " << cuenta[REGISTRO_OK] << " ok, " << cuenta[REGISTRO_DISTINTO]
+         << " distintas, " << cuenta[REGISTRO_INVALIDO] << " invalidas" << endl;
+    cout << "tiempo " << segundos << " s, " << cab.registros / segundos << " repeticiones/s, " << frames / segundos
+         << " frames/s" << endl;
+    return cuenta[REGISTRO_DISTINTO] + cuenta[REGISTRO_INVALIDO] > 0 ? 2 : 0;
+}
+
+/**
+ * @brief Lista los registros del índice que cumplen los filtros.
+ * @param argc Número de argumentos
+ * @param argv Argumentos: argv[2] es el índice y los siguientes, filtros
+ * @return int -> 0 si se ha podido leer el índice
+ */
+static int buscar(int argc, char *argv[]) {
+    string indice = argv[2];
+    bool porSemilla = false, soloFallos = false;
+    uint64_t semilla = 0;
+    long minPtos = LONG_MIN, maxPtos = LONG_MAX, minLineas = LONG_MIN;
+    int fin = -1;
+    for (int i = 3; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--semilla") == 0 && valor) {
+            porSemilla = true;
+            semilla = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--min-puntos") == 0 && valor) minPtos = atol(argv[++i]);
+        else if (strcmp(argv[i], "--max-puntos") == 0 && valor) maxPtos = atol(argv[++i]);
+        else if (strcmp(argv[i], "--min-lineas") == 0 && valor) minLineas = atol(argv[++i]);
+        else if (strcmp(argv[i], "--fin") == 0 && valor) {
+            ++i;
+            for (int f = 0; f < 3; ++f) if (strcmp(argv[i], FINES[f]) == 0) fin = f;
+        } else if (strcmp(argv[i], "--fallos") == 0) soloFallos = true;
+        else {
+            cerr << "Filtro desconocido: " << argv[i] << endl;
+            return 1;
+        }
+    }
+
+    Proyeccion pi, pn;
+    if (!pi.abrir(indice.c_str(), false) || !pn.abrir((indice + ".nombres").c_str(), false) ||
+        pi.n < sizeof(CabeceraIndice)) {
+        cerr << "No se puede leer el indice " << indice << endl;
+        return 1;
+    }
+    CabeceraIndice cab;
+    memcpy(&cab, pi.datos, sizeof(cab));
+    if (memcmp(cab.magia, "TTIX", 4) != 0 || cab.tamRegistro != sizeof(RegistroIndice) ||
+        sizeof(CabeceraIndice) + cab.registros * sizeof(RegistroIndice) > pi.n) {
+        cerr << indice << " no es un indice valido" << endl;
+        return 1;
+    }
+    const RegistroIndice *primero = reinterpret_cast<const RegistroIndice *>(pi.datos + sizeof(CabeceraIndice));
+    const RegistroIndice *ultimo = primero + cab.registros;
+    if (porSemilla) {
+        primero = lower_bound(primero, ultimo, semilla,
+                              [](const RegistroIndice &r, uint64_t s) { return r.semilla < s; });
+        ultimo = upper_bound(primero, ultimo, semilla,
+                             [](uint64_t s, const RegistroIndice &r) { return s < r.semilla; });
+    }
+
+    long encontrados = 0;
+    for (const RegistroIndice *r = primero; r != ultimo; ++r) {
+        if (r->ptos < minPtos || r->ptos > maxPtos || r->lineas < minLineas) continue;
+        if (fin >= 0 && r->fin != fin) continue;
+        if (soloFallos && r->estado == REGISTRO_OK) continue;
+        const char *nombre = "";
+        int largo = 0;
+        if (r->nombre < pn.n) {
+            nombre = reinterpret_cast<const char *>(pn.datos) + r->nombre;
+            const char *finNombre = static_cast<const char *>(memchr(nombre, '\n', size_t(pn.n - r->nombre)));
+            largo = finNombre ? int(finNombre - nombre) : 0;
+        }
+        printf("%.*s %llu %d %d %d %d %s %s\n", largo, nombre, (unsigned long long) r->semilla, r->ptos, r->level,
+               r->lineas, r->piezas, r->fin <= VICTORIA ? FINES[r->fin] : "?", ESTADOS[r->estado % 3]);
+        ++encontrados;
+    }
+    cerr << encontrados << " de " << cab.registros << " repeticiones" << endl;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 4 && strcmp(argv[1], "validar") == 0) {
+        int hilos = 0;
+        for (int i = 4; i + 1 < argc; ++i) {
+            if (strcmp(argv[i], "--hilos") == 0) hilos = atoi(argv[++i]);
+        }
+        return validar(argv[2], argv[3], hilos);
+    }
+    if (argc >= 3 && strcmp(argv[1], "buscar") == 0) return buscar(argc, argv);
+
+    cerr << "Uso: " << argv[0] << " validar <directorio> <indice> [--hilos N]" << endl
+         << "     " << argv[0] << " buscar <indice> [--semilla S] [--min-puntos P] [--max-puntos P]"
+         << " [--min-lineas L] [--fin limite|game_over|victoria] [--fallos]" << endl;
+    return 1;
+}
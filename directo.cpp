@@ -0,0 +1,304 @@
+/**
+ * @file directo.cpp
+ * @brief Retransmisión en directo de partidas del bot a muchos espectadores (Linux)
+ *
+ * Uso: directo emitir RUTA [--partidas N] [--segundos S] [--tick MS] [--semilla S]
+ *                          [--historia M] [--clave K]
+ *      directo mirar RUTA [--espectadores N] [--segundos S] [--lentos K] [--ritmo B]
+ *
+ * `emitir` juega partidas del bot un frame cada --tick milisegundos (16 por
+ * defecto; 0 es lo más rápido posible) y publica cada frame con Publicador en el
+ * socket Unix RUTA, con un fotograma clave cada K diferencias (64) y una historia
+ * de M mensajes (1024). Cada segundo muestra:
+ *
+ *     segundos frames mensajes bytes/frame espectadores enviados_KB saltos descartados publica_max_us
+ *
+ * bytes/frame es lo publicado por frame, a comparar con los bytes de un
+ * fotograma clave, que se muestran al arrancar.
+ *
+ * `mirar` conecta N espectadores (100 por defecto) desde un solo hilo con epoll y
+ * reconstruye la partida en cada uno con aplicaMensaje. Los K primeros leen como
+ * mucho B bytes por segundo (200 por defecto) para comprobar que el emisor los
+ * salta o los desconecta sin frenar a los demás. Cada segundo muestra:
+ *
+ *     segundos conectados mensajes aplicados ignorados claves desajustes invalidos
+ *
+ * y al terminar cuántos espectadores rápidos y lentos siguen sincronizados. Un
+ * desajuste (fotograma clave distinto de lo reconstruido) o un mensaje inválido
+ * es un error.
+ */
+
+#include "bot.h"
+#include "publicador.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+typedef chrono::steady_clock Reloj;
+
+/**
+ * @brief Juega partidas del bot y las publica.
+ * @param ruta Socket Unix
+ * @param argc Número de argumentos tras la ruta
+ * @param argv Argumentos tras la ruta
+ * @return int -> Código de salida
+ */
+static int emitir(const string &ruta, int argc, char *argv[]) {
+    long partidas = 0, segundos = 0, historia = long(HISTORIA_PUBLICADOR), clave = INTERVALO_CLAVES_ESPECTADOR;
+    int tick = 16;
+    uint64_t semilla = 1;
+    for (int i = 0; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--partidas") == 0 && valor) partidas = atol(argv[++i]);
+        else if (strcmp(argv[i], "--segundos") == 0 && valor) segundos = atol(argv[++i]);
+        else if (strcmp(argv[i], "--tick") == 0 && valor) tick = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) semilla = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--historia") == 0 && valor) historia = atol(argv[++i]);
+        else if (strcmp(argv[i], "--clave") == 0 && valor) clave = atol(argv[++i]);
+        else return -1;
+    }
+    if (tick < 0) tick = 0;
+
+    Publicador Pub(ruta, size_t(historia > 0 ? historia : 1), uint32_t(clave > 0 ? clave : 1));
+    if (!Pub.abierto()) {
+        cerr << "No se puede escuchar en " << ruta << endl;
+        return 1;
+    }
+    vector<unsigned char> muestra;
+    EmisorEspectador M;
+    iniciarEmisor(M);
+    codificaClave(M, muestra);
+    printf("fotograma clave: %zu bytes\n", muestra.size());
+    fflush(stdout);
+
+    unique_ptr<Bot> B(new Bot);
+    EstadoJuego E;
+    long jugadas = 0;
+    iniciarJuego(E, semilla, AZAR_BOLSA);
+    iniciarBot(*B, PESOS_DEFECTO);
+
+    auto inicio = Reloj::now(), siguiente = inicio, informe = inicio + chrono::seconds(1);
+    EstadisticasPublicador antes = Pub.estadisticas();
+    long frames = 0, framesAntes = 0;
+    double maximo = 0;
+    for (;;) {
+        paso(E, accionBot(*B, E));
+        auto t0 = Reloj::now();
+        Pub.publica(E);
+        double us = chrono::duration<double, micro>(Reloj::now() - t0).count();
+        if (us > maximo) maximo = us;
+        frames++;
+        if (E.fin != EN_JUEGO) {
+            if (partidas > 0 && ++jugadas >= partidas) break;
+            iniciarJuego(E, semilla + uint64_t(jugadas), AZAR_BOLSA);
+            iniciarBot(*B, PESOS_DEFECTO);
+        }
+
+        auto ahora = Reloj::now();
+        if (ahora >= informe) {
+            EstadisticasPublicador S = Pub.estadisticas();
+            long f = frames - framesAntes;
+            printf("%ld %ld %ld %.1f %ld %ld %ld %ld %.1f\n",
+                   long(chrono::duration_cast<chrono::seconds>(ahora - inicio).count()), f, S.mensajes - antes.mensajes,
+                   f > 0 ? double(S.bytesPublicados - antes.bytesPublicados) / double(f) : 0.0, S.suscriptores,
+                   (S.bytesEnviados - antes.bytesEnviados) / 1024, S.saltos, S.descartados, maximo);
+            fflush(stdout);
+            antes = S;
+            framesAntes = frames;
+            maximo = 0;
+            informe += chrono::seconds(1);
+            if (segundos > 0 && ahora - inicio >= chrono::seconds(segundos)) break;
+        }
+        if (tick > 0) {
+            siguiente += chrono::milliseconds(tick);
+            this_thread::sleep_until(siguiente);
+        }
+    }
+    // Da tiempo al hilo del publicador a repartir lo último
+    this_thread::sleep_for(chrono::milliseconds(200));
+    return 0;
+}
+
+/** @struct Espectador
+ *  @brief Conexión de `mirar` y su copia de la partida.
+ */
+struct Espectador {
+    int fd; ///< Socket (-1 si el emisor lo ha cerrado)
+    bool lento; ///< Lee como mucho `ritmo` bytes por segundo
+    Vista V; ///< Partida reconstruida
+    vector<unsigned char> entrada; ///< Bytes recibidos aún sin formar un mensaje
+};
+
+/** @struct CuentaMirar
+ *  @brief Contadores de `mirar`.
+ */
+struct CuentaMirar {
+    long mensajes, aplicados, ignorados, claves, desajustes, invalidos; ///< Mensajes por resultado
+};
+
+/**
+ * @brief Aplica los mensajes completos recibidos por un espectador.
+ * @param X Espectador
+ * @param C Contadores
+ * @return bool -> false: el flujo está corrupto
+ */
+static bool procesa(Espectador &X, CuentaMirar &C) {
+    size_t p = 0;
+    while (X.entrada.size() - p >= 2) {
+        size_t n = 2 + size_t(X.entrada[p] | X.entrada[p + 1] << 8);
+        if (n > MAX_MENSAJE_ESPECTADOR) return false;
+        if (X.entrada.size() - p < n) break;
+        C.mensajes++;
+        if (X.entrada[p + 2] == 'K') C.claves++;
+        switch (aplicaMensaje(X.V, X.entrada.data() + p, n)) {
+        case APLICADO: C.aplicados++; break;
+        case IGNORADO: C.ignorados++; break;
+        case DESAJUSTE: C.desajustes++; break;
+        case INVALIDO: C.invalidos++; break;
+        }
+        p += n;
+    }
+    X.entrada.erase(X.entrada.begin(), X.entrada.begin() + long(p));
+    return true;
+}
+
+/**
+ * @brief Lee de un espectador y aplica lo recibido.
+ * @param X Espectador
+ * @param C Contadores
+ * @param limite Máximo de bytes a leer
+ * @return bool -> false: la conexión se ha cerrado
+ */
+static bool lee(Espectador &X, CuentaMirar &C, size_t limite) {
+    unsigned char buf[16384];
+    while (limite > 0) {
+        ssize_t n = recv(X.fd, buf, limite < sizeof(buf) ? limite : sizeof(buf), 0);
+        if (n == 0) return false;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        X.entrada.insert(X.entrada.end(), buf, buf + n);
+        limite -= size_t(n);
+        if (!procesa(X, C)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Conecta espectadores y reconstruye la partida en cada uno.
+ * @param ruta Socket Unix
+ * @param argc Número de argumentos tras la ruta
+ * @param argv Argumentos tras la ruta
+ * @return int -> Código de salida
+ */
+static int mirar(const string &ruta, int argc, char *argv[]) {
+    int n = 100, lentos = 0;
+    long segundos = 10, ritmo = 200;
+    for (int i = 0; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--espectadores") == 0 && valor) n = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--segundos") == 0 && valor) segundos = atol(argv[++i]);
+        else if (strcmp(argv[i], "--lentos") == 0 && valor) lentos = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ritmo") == 0 && valor) ritmo = atol(argv[++i]);
+        else return -1;
+    }
+    sockaddr_un dir = {};
+    if (n < 1 || ruta.size() >= sizeof(dir.sun_path)) return -1;
+    dir.sun_family = AF_UNIX;
+    memcpy(dir.sun_path, ruta.c_str(), ruta.size() + 1);
+
+    int ep = epoll_create1(0);
+    vector<Espectador> X((size_t) n);
+    for (int i = 0; i < n; ++i) {
+        Espectador &x = X[size_t(i)];
+        x.fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (x.fd < 0 || connect(x.fd, (sockaddr *) &dir, sizeof(dir)) != 0) {
+            cerr << "No se puede conectar a " << ruta << endl;
+            return 1;
+        }
+        fcntl(x.fd, F_SETFL, fcntl(x.fd, F_GETFL) | O_NONBLOCK);
+        x.lento = i < lentos;
+        iniciarVista(x.V);
+        // Los lentos solo se vigilan por si el emisor los desconecta: se leen a su ritmo en cada vuelta
+        epoll_event ev = {};
+        ev.events = x.lento ? EPOLLRDHUP : EPOLLIN | EPOLLRDHUP;
+        ev.data.u32 = uint32_t(i);
+        epoll_ctl(ep, EPOLL_CTL_ADD, x.fd, &ev);
+    }
+
+    const int VUELTA_MS = 100;
+    CuentaMirar C = {}, antes = {};
+    auto inicio = Reloj::now(), informe = inicio + chrono::seconds(1), vuelta = inicio;
+    int conectados = n;
+    epoll_event eventos[256];
+    while (Reloj::now() - inicio < chrono::seconds(segundos)) {
+        int k = epoll_wait(ep, eventos, 256, VUELTA_MS);
+        for (int j = 0; j < k; ++j) {
+            Espectador &x = X[eventos[j].data.u32];
+            if (x.fd >= 0 && (x.lento || !lee(x, C, SIZE_MAX))) {
+                close(x.fd);
+                x.fd = -1;
+                conectados--;
+            }
+        }
+        auto ahora = Reloj::now();
+        if (ahora >= vuelta) {
+            for (int i = 0; i < lentos && i < n; ++i) {
+                Espectador &x = X[size_t(i)];
+                if (x.fd >= 0 && !lee(x, C, size_t(ritmo * VUELTA_MS / 1000 + 1))) {
+                    close(x.fd);
+                    x.fd = -1;
+                    conectados--;
+                }
+            }
+            vuelta += chrono::milliseconds(VUELTA_MS);
+        }
+        if (ahora >= informe) {
+            printf("%ld %d %ld %ld %ld %ld %ld %ld\n",
+                   long(chrono::duration_cast<chrono::seconds>(ahora - inicio).count()), conectados,
+                   C.mensajes - antes.mensajes, C.aplicados - antes.aplicados, C.ignorados - antes.ignorados,
+                   C.claves - antes.claves, C.desajustes, C.invalidos);
+            fflush(stdout);
+            antes = C;
+            informe += chrono::seconds(1);
+        }
+    }
+
+    int rapidos = 0, lentosSincronizados = 0, lentosCerrados = 0;
+    for (const Espectador &x : X) {
+        if (x.lento) {
+            lentosSincronizados += x.fd >= 0 && x.V.sincronizada;
+            lentosCerrados += x.fd < 0;
+        } else {
+            rapidos += x.fd >= 0 && x.V.sincronizada;
+        }
+        if (x.fd >= 0) close(x.fd);
+    }
+    close(ep);
+    printf("sincronizados: %d de %d rapidos, %d de %d lentos (%d desconectados)\n", rapidos, n - lentos,
+           lentosSincronizados, lentos, lentosCerrados);
+    return C.desajustes == 0 && C.invalidos == 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    int r = -1;
+    if (argc >= 3 && strcmp(argv[1], "emitir") == 0) r = emitir(argv[2], argc - 3, argv + 3);
+    else if (argc >= 3 && strcmp(argv[1], "mirar") == 0) r = mirar(argv[2], argc - 3, argv + 3);
+    if (r >= 0) return r;
+    cerr << "Uso: " << argv[0] << " emitir RUTA [--partidas N] [--segundos S] [--tick MS] [--semilla S]"
+         << " [--historia M] [--clave K]" << endl
+         << "     " << argv[0] << " mirar RUTA [--espectadores N] [--segundos S] [--lentos K] [--ritmo B]" << endl;
+    return 1;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file duelo.cpp
+ * @brief Partida a dos jugadores
+ *
+ * @see duelo.h
+ */
+
+#include "duelo.h"
+#include "instantanea.h"
+
+const int BASURA_FILAS[5] = {0, 0, 1, 2, 4};
+
+/**
+ * @brief Prepara un duelo nuevo.
+ * @post Los dos jugadores reciben la misma secuencia de piezas
+ * @param D Duelo
+ * @param semilla Semilla común de las piezas y de la basura
+ * @param modo Forma de repartir las piezas
+ */
+void iniciarDuelo(EstadoDuelo &D, uint64_t semilla, ModoAzar modo) {
+    for (int j = 0; j < JUGADORES; ++j) {
+        iniciarJuego(D.J[j], semilla, modo);
+        D.basura[j] = 0;
+    }
+    D.azar = semilla ^ 0x5DEECE66Dull;
+    D.frame = 0;
+    D.ganador = EN_CURSO;
+}
+
+/**
+ * @brief Mete la basura pendiente en el tablero de un jugador.
+ * @post Si un bloque sale por arriba o la pieza nueva ya no cabe, el jugador pierde
+ * @param D Duelo
+ * @param j Jugador
+ * @return int -> Indicadores Cambio
+ */
+static int recibeBasura(EstadoDuelo &D, int j) {
+    EstadoJuego &E = D.J[j];
+    int hueco = int(siguienteAzar(D.azar) % COLUMNAS);
+    bool fuera = subirFilas(E.T, D.basura[j], Fila(FILA_LLENA & ~(1u << hueco)), COLOR_BASURA);
+    D.basura[j] = 0;
+    if (fuera || colisionPieza(E.T, E.P)) {
+        E.fin = GAME_OVER;
+        return CAMBIO_PIEZA | CAMBIO_FIN;
+    }
+    return CAMBIO_PIEZA;
+}
+
+/**
+ * @brief Avanza el duelo un frame.
+ * @post Avanza las dos partidas, reparte la basura de las filas quitadas, mete la
+ *       pendiente en los tableros que acaban de fijar pieza y decide el ganador
+ * @param D Duelo
+ * @param a0 Acción del jugador 0
+ * @param a1 Acción del jugador 1
+ * @return int -> Indicadores Cambio del jugador 0 en los bits 0..3 y del jugador 1 en los 4..7
+ */
+int pasoDuelo(EstadoDuelo &D, Accion a0, Accion a1) {
+    if (D.ganador != EN_CURSO) return 0;
+
+    const Accion a[JUGADORES] = {a0, a1};
+    int lineas[JUGADORES], cambios[JUGADORES];
+    for (int j = 0; j < JUGADORES; ++j) {
+        lineas[j] = D.J[j].lineas;
+        cambios[j] = paso(D.J[j], a[j]);
+    }
+
+    // La basura enviada cancela primero la pendiente propia
+    for (int j = 0; j < JUGADORES; ++j) {
+        if (!(cambios[j] & CAMBIO_LINEAS)) continue;
+        int envia = BASURA_FILAS[D.J[j].lineas - lineas[j]];
+        int cancela = envia < D.basura[j] ? envia : D.basura[j];
+        D.basura[j] -= cancela;
+        D.basura[1 - j] += envia - cancela;
+    }
+    for (int j = 0; j < JUGADORES; ++j) {
+        if ((cambios[j] & CAMBIO_FIJADA) && D.basura[j] > 0 && D.J[j].fin == EN_JUEGO) {
+            cambios[j] |= recibeBasura(D, j);
+        }
+    }
+    D.frame++;
+
+    bool gana[JUGADORES], pierde[JUGADORES];
+    for (int j = 0; j < JUGADORES; ++j) {
+        gana[j] = D.J[j].fin == VICTORIA;
+        pierde[j] = D.J[j].fin == GAME_OVER;
+    }
+    if (gana[0] || gana[1]) D.ganador = gana[0] && gana[1] ? EMPATE : gana[0] ? 0 : 1;
+    else if (pierde[0] || pierde[1]) D.ganador = pierde[0] && pierde[1] ? EMPATE : pierde[0] ? 1 : 0;
+
+    return cambios[0] | cambios[1] << 4;
+}
+
+/**
+ * @brief Mezcla una palabra en una suma de comprobación.
+ * @param h Suma acumulada
+ * @param v Palabra
+ * @return uint64_t -> Suma nueva
+ */
+static inline uint64_t mezcla(uint64_t h, uint64_t v) {
+    h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    return h * 0xBF58476D1CE4E5B9ull;
+}
+
+/**
+ * @brief Suma de comprobación del estado del duelo.
+ * @post Solo depende del estado de juego, no del relleno de las estructuras ni
+ *       del plano de color, así que dos máquinas sincronizadas dan la misma suma
+ * @param D Duelo
+ * @return uint64_t -> Suma de comprobación
+ */
+uint64_t sumaDuelo(const EstadoDuelo &D) {
+    uint64_t h = mezcla(D.frame, D.azar);
+    for (int j = 0; j < JUGADORES; ++j) {
+        Instantanea I;
+        guardaInstantanea(D.J[j], I);
+        for (uint64_t w : I.bits) h = mezcla(h, w);
+        h = mezcla(h, uint64_t(D.J[j].piezas) << 32 | uint32_t(D.basura[j]));
+    }
+    return mezcla(h, uint64_t(D.ganador + 1));
+}
@@ -0,0 +1,47 @@
+/**
+ * @file duelo.h
+ * @brief Partida a dos jugadores
+ *
+ * Dos partidas con la misma semilla avanzan frame a frame a la vez. Quitar
+ * varias filas de una vez manda basura al rival (1, 2 o 4 filas por 2, 3 o 4
+ * filas quitadas), que primero cancela la basura pendiente propia. La basura
+ * entra por abajo al fijar la siguiente pieza, con un hueco en una columna
+ * elegida por el generador del duelo. Pierde quien no puede sacar pieza o
+ * empuja bloques fuera por arriba; gana también quien alcanza el último nivel.
+ *
+ * Todo es determinista: dos máquinas con la misma semilla y las mismas
+ * acciones llegan al mismo estado, que es lo que necesita el rollback (rollback.h).
+ */
+
+#ifndef _DUELO_H_
+#define _DUELO_H_
+
+#include "juego.h"
+
+const int JUGADORES = 2; ///< Jugadores de un duelo
+const int COLOR_BASURA = 7; ///< Color de las filas de basura (BLANCO en miniwin)
+const int EN_CURSO = -1; ///< Valor de EstadoDuelo::ganador mientras nadie ha ganado
+const int EMPATE = JUGADORES; ///< Valor de EstadoDuelo::ganador si terminan los dos a la vez
+
+/**
+ * @brief Filas de basura enviadas según las filas quitadas de una vez
+ * @post 0 o 1 fila: nada; 2 filas: 1; 3 filas: 2; 4 filas: 4
+ */
+extern const int BASURA_FILAS[5];
+
+/** @struct EstadoDuelo
+ *  @brief Estado completo de un duelo.
+ */
+struct EstadoDuelo {
+    EstadoJuego J[JUGADORES]; ///< Partida de cada jugador
+    int basura[JUGADORES]; ///< Filas de basura pendientes de entrar en cada tablero
+    uint64_t azar; ///< Generador de las columnas de los huecos de la basura
+    uint32_t frame; ///< Frames jugados
+    int ganador; ///< EN_CURSO, índice del ganador o EMPATE
+};
+
+void iniciarDuelo(EstadoDuelo &D, uint64_t semilla, ModoAzar modo = AZAR_BOLSA);
+int pasoDuelo(EstadoDuelo &D, Accion a0, Accion a1);
+uint64_t sumaDuelo(const EstadoDuelo &D);
+
+#endif
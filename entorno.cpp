@@ -0,0 +1,178 @@
+/**
+ * @file entorno.cpp
+ * @brief Entornos de aprendizaje por refuerzo vectorizados (ABI de C)
+ *
+ * @see entorno.h
+ */
+
+#include "entorno.h"
+#include "juego.h"
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <vector>
+
+static_assert(TETRIS_FILAS == FILAS && TETRIS_COLUMNAS == COLUMNAS && TETRIS_ACCIONES == ACCIONES,
+              "entorno.h no coincide con el motor");
+static_assert(sizeof(TetrisObservacion) == 216 && offsetof(TetrisObservacion, puntos) == 208,
+              "El formato de TetrisObservacion es parte del ABI");
+
+/** @struct TetrisEntornos
+ *  @brief Partidas de un conjunto de entornos.
+ */
+struct TetrisEntornos {
+    std::vector<EstadoJuego> E; ///< Partida de cada entorno
+    std::vector<uint64_t> azar; ///< Generador de semillas de cada entorno
+    ModoAzar modo; ///< Forma de repartir las piezas
+};
+
+/** @struct TablaBits
+ *  @brief Celdas (0 o 1) de cada máscara de 5 columnas.
+ */
+struct TablaBits {
+    unsigned char celdas[32][5]; ///< celdas[m][c]: bit c de m
+};
+
+/**
+ * @brief Genera en compilación la tabla para pasar máscaras de fila a celdas.
+ * @return TablaBits -> Tabla
+ */
+static constexpr TablaBits creaTablaBits() {
+    TablaBits t = {};
+    for (int m = 0; m < 32; ++m) {
+        for (int c = 0; c < 5; ++c) t.celdas[m][c] = (unsigned char) ((m >> c) & 1);
+    }
+    return t;
+}
+
+/// Celdas de cada máscara de 5 columnas
+static constexpr TablaBits BITS = creaTablaBits();
+
+static_assert(COLUMNAS == 10, "escribeObservacion pasa cada fila en dos mitades de 5 columnas");
+
+/**
+ * @brief Escribe la observación de una partida.
+ * @param E Estado de la partida
+ * @param o Destino
+ */
+static void escribeObservacion(const EstadoJuego &E, TetrisObservacion &o) {
+    for (int f = 0; f < FILAS; ++f) {
+        memcpy(&o.tablero[f][0], BITS.celdas[E.T.fila[f] & 31], 5);
+        memcpy(&o.tablero[f][5], BITS.celdas[(E.T.fila[f] >> 5) & 31], 5);
+    }
+    o.pieza = (uint8_t) E.P.tipo;
+    o.rotacion = (uint8_t) E.P.rot;
+    o.x = (int8_t) E.P.abs.x;
+    o.y = (int8_t) E.P.abs.y;
+    o.siguiente = (uint8_t) verPieza(E.azar, 0);
+    o.nivel = (uint8_t) E.level;
+    o.reservado[0] = o.reservado[1] = 0;
+    o.puntos = E.ptos;
+    o.lineas = E.lineas;
+}
+
+/**
+ * @brief Empieza una partida nueva en un entorno.
+ * @param e Entornos
+ * @param i Entorno
+ */
+static void reiniciaEntorno(TetrisEntornos &e, size_t i) {
+    iniciarJuego(e.E[i], siguienteAzar(e.azar[i]), e.modo);
+}
+
+/**
+ * @brief Versión del ABI con la que se ha compilado la biblioteca.
+ * @return uint32_t -> TETRIS_RL_VERSION
+ */
+uint32_t tetris_version(void) {
+    return TETRIS_RL_VERSION;
+}
+
+/**
+ * @brief Crea un conjunto de entornos.
+ * @post Cada entorno tiene su propia secuencia de semillas, derivada de la
+ *       semilla y de su índice: el mismo conjunto se puede repetir
+ * @param n Número de entornos
+ * @param semilla Semilla del conjunto
+ * @param bolsa 0: piezas al azar; otro valor: bolsas de 7
+ * @return TetrisEntornos* -> Entornos reiniciados; NULL si n es 0 o no hay memoria
+ */
+TetrisEntornos *tetris_crear(uint32_t n, uint64_t semilla, int bolsa) {
+    if (n == 0) return nullptr;
+    TetrisEntornos *e = new (std::nothrow) TetrisEntornos;
+    if (e == nullptr) return nullptr;
+    // Ninguna excepción puede cruzar el ABI de C
+    try {
+        e->E.resize(n);
+        e->azar.resize(n);
+    } catch (...) {
+        delete e;
+        return nullptr;
+    }
+    e->modo = bolsa ? AZAR_BOLSA : AZAR_PURO;
+    for (uint32_t i = 0; i < n; ++i) {
+        e->azar[i] = semilla ^ (uint64_t(i) * 0x9E3779B97F4A7C15ull);
+        reiniciaEntorno(*e, i);
+    }
+    return e;
+}
+
+/**
+ * @brief Libera un conjunto de entornos.
+ * @param e Entornos (puede ser NULL)
+ */
+void tetris_destruir(TetrisEntornos *e) {
+    delete e;
+}
+
+/**
+ * @brief Número de entornos del conjunto.
+ * @param e Entornos
+ * @return uint32_t -> B
+ */
+uint32_t tetris_numero(const TetrisEntornos *e) {
+    return uint32_t(e->E.size());
+}
+
+/**
+ * @brief Empieza una partida nueva en todos los entornos.
+ * @param e Entornos
+ * @param obs Observaciones de salida (B elementos; NULL: no se escriben)
+ */
+void tetris_reiniciar(TetrisEntornos *e, TetrisObservacion *obs) {
+    for (size_t i = 0; i < e->E.size(); ++i) {
+        reiniciaEntorno(*e, i);
+        if (obs != nullptr) escribeObservacion(e->E[i], obs[i]);
+    }
+}
+
+/**
+ * @brief Avanza un frame todos los entornos.
+ * @post La recompensa es la diferencia de puntos del frame. Un entorno cuya
+ *       partida termina marca en terminados su final (1: game over, 2: victoria),
+ *       se reinicia en su sitio y devuelve la observación de la partida nueva.
+ *       Una acción fuera de rango cuenta como NADA.
+ * @param e Entornos
+ * @param acciones Acción de cada entorno (B elementos, 0..TETRIS_ACCIONES-1)
+ * @param obs Observaciones de salida (B elementos)
+ * @param recompensas Recompensas de salida (B elementos)
+ * @param terminados Finales de salida (B elementos; 0: la partida sigue)
+ * @return uint32_t -> Entornos que han terminado su partida en este frame
+ */
+uint32_t tetris_pasos(TetrisEntornos *e, const uint8_t *acciones, TetrisObservacion *obs, float *recompensas,
+                      uint8_t *terminados) {
+    uint32_t fin = 0;
+    for (size_t i = 0; i < e->E.size(); ++i) {
+        EstadoJuego &E = e->E[i];
+        int antes = E.ptos;
+        paso(E, acciones[i] < ACCIONES ? Accion(acciones[i]) : NADA);
+        recompensas[i] = float(E.ptos - antes);
+        terminados[i] = (uint8_t) E.fin;
+        if (E.fin != EN_JUEGO) {
+            reiniciaEntorno(*e, i);
+            fin++;
+        }
+        escribeObservacion(E, obs[i]);
+    }
+    return fin;
+}
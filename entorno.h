@@ -0,0 +1,72 @@
+/**
+ * @file entorno.h
+ * @brief Entornos de aprendizaje por refuerzo vectorizados (ABI de C)
+ *
+ * Interfaz en C de la biblioteca compartida `tetrisrl` para entrenar agentes con
+ * las reglas exactas del juego (RELATIVOS, PUNTOS_NIVEL, VELOCIDAD_NIVEL y la
+ * puntuación 100/300/500/800). Una llamada a tetris_pasos() avanza B entornos un
+ * frame cada uno y escribe sus observaciones, recompensas y finales en buffers
+ * contiguos del llamante: no se reserva memoria ni se hace una llamada por
+ * entorno. Cuando una partida termina, el entorno se reinicia en su sitio con
+ * una semilla nueva y la observación que se devuelve es ya la de la partida nueva.
+ *
+ * Solo usa tipos de <stdint.h> y estructuras de tamaño fijo, así que se puede
+ * cargar desde C, ctypes, cffi o cualquier lenguaje con FFI. Cambiar el formato
+ * de TetrisObservacion o las funciones sube TETRIS_RL_VERSION.
+ */
+
+#ifndef _ENTORNO_H_
+#define _ENTORNO_H_
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(TETRIS_RL_EXPORTAR)
+#define TETRIS_API __declspec(dllexport)
+#else
+#define TETRIS_API __declspec(dllimport)
+#endif
+#else
+#define TETRIS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TETRIS_RL_VERSION 1 /**< Versión del ABI */
+#define TETRIS_FILAS 20 /**< Filas del tablero */
+#define TETRIS_COLUMNAS 10 /**< Columnas del tablero */
+#define TETRIS_ACCIONES 6 /**< Acciones: nada, rotar derecha, rotar izquierda, bajar, izquierda, derecha */
+
+/** @struct TetrisObservacion
+ *  @brief Observación de un entorno (216 bytes, alineada a 4).
+ */
+typedef struct TetrisObservacion {
+    uint8_t tablero[TETRIS_FILAS][TETRIS_COLUMNAS]; /**< 1: celda ocupada (sin la pieza actual); fila 0 arriba */
+    uint8_t pieza; /**< Tipo de la pieza actual (0..6) */
+    uint8_t rotacion; /**< Giros de la pieza actual (0..3) */
+    int8_t x; /**< Columna del bloque central de la pieza actual */
+    int8_t y; /**< Fila del bloque central de la pieza actual */
+    uint8_t siguiente; /**< Tipo de la pieza siguiente */
+    uint8_t nivel; /**< Nivel (1..7) */
+    uint8_t reservado[2]; /**< Siempre 0 */
+    int32_t puntos; /**< Puntos de la partida */
+    int32_t lineas; /**< Filas quitadas en la partida */
+} TetrisObservacion;
+
+typedef struct TetrisEntornos TetrisEntornos; /**< Conjunto opaco de entornos */
+
+TETRIS_API uint32_t tetris_version(void);
+TETRIS_API TetrisEntornos *tetris_crear(uint32_t n, uint64_t semilla, int bolsa);
+TETRIS_API void tetris_destruir(TetrisEntornos *e);
+TETRIS_API uint32_t tetris_numero(const TetrisEntornos *e);
+TETRIS_API void tetris_reiniciar(TetrisEntornos *e, TetrisObservacion *obs);
+TETRIS_API uint32_t tetris_pasos(TetrisEntornos *e, const uint8_t *acciones, TetrisObservacion *obs,
+                                 float *recompensas, uint8_t *terminados);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
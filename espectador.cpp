@@ -0,0 +1,285 @@
+/**
+ * @file espectador.cpp
+ * @brief Retransmisión de partidas por diferencias
+ *
+ * @see espectador.h
+ */
+
+#include "espectador.h"
+#include <cstring>
+
+/// Bytes de la cabecera: longitud, tipo, secuencia y campos
+const size_t CABECERA_ESPECTADOR = 2 + 1 + 4 + 1;
+/// Celdas del tablero
+const int CELDAS = FILAS * COLUMNAS;
+/// Bytes de CAMPO_TABLERO
+const size_t BYTES_TABLERO = CELDAS / 2;
+
+static_assert(CELDAS % 2 == 0 && CELDAS < 256, "Índices de celda de un byte y tablero de dos colores por byte");
+
+/**
+ * @brief Añade un entero de 32 bits en little-endian.
+ * @param v Destino
+ * @param x Valor
+ */
+static void pon32(std::vector<unsigned char> &v, uint32_t x) {
+    for (int i = 0; i < 4; ++i) v.push_back((unsigned char) (x >> (8 * i)));
+}
+
+/**
+ * @brief Lee un entero de 32 bits en little-endian.
+ * @param p Origen
+ * @return uint32_t -> Valor
+ */
+static uint32_t lee32(const unsigned char *p) {
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+/**
+ * @brief Obtiene lo que vería un espectador de una partida.
+ * @param E Estado de la partida
+ * @param V Vista (se reemplaza)
+ */
+void vistaDeJuego(const EstadoJuego &E, Vista &V) {
+    memcpy(V.color, E.T.color, sizeof(V.color));
+    V.P = E.P;
+    V.siguiente = verPieza(E.azar, 0);
+    V.ptos = E.ptos;
+    V.level = E.level;
+    V.lineas = E.lineas;
+    V.fin = E.fin;
+}
+
+/**
+ * @brief Prepara el codificador de una partida.
+ * @post El primer frame codificado lleva el estado entero y un fotograma clave
+ * @param M Emisor
+ * @param intervalo Diferencias entre fotogramas clave (al menos 1)
+ */
+void iniciarEmisor(EmisorEspectador &M, uint32_t intervalo) {
+    iniciarVista(M.ultima);
+    M.secuencia = 0;
+    M.intervalo = intervalo > 0 ? intervalo : 1;
+}
+
+/**
+ * @brief Empieza un mensaje.
+ * @param salida Destino
+ * @param tipo 'D' o 'K'
+ * @param secuencia Número de diferencia
+ * @return size_t -> Posición del mensaje en salida (para cerrarMensaje)
+ */
+static size_t abreMensaje(std::vector<unsigned char> &salida, char tipo, uint32_t secuencia) {
+    size_t inicio = salida.size();
+    salida.push_back(0);
+    salida.push_back(0);
+    salida.push_back((unsigned char) tipo);
+    pon32(salida, secuencia);
+    salida.push_back(0);
+    return inicio;
+}
+
+/**
+ * @brief Escribe los campos indicados de una vista.
+ * @param V Vista
+ * @param campos CampoEspectador a escribir, salvo CAMPO_CELDAS
+ * @param salida Destino
+ */
+static void escribeCampos(const Vista &V, int campos, std::vector<unsigned char> &salida) {
+    if (campos & CAMPO_PIEZA) {
+        salida.push_back((unsigned char) (V.P.tipo << 2 | V.P.rot));
+        salida.push_back((unsigned char) V.P.abs.x);
+        salida.push_back((unsigned char) V.P.abs.y);
+    }
+    if (campos & CAMPO_MARCADOR) {
+        pon32(salida, uint32_t(V.ptos));
+        salida.push_back((unsigned char) V.level);
+        pon32(salida, uint32_t(V.lineas));
+    }
+    if (campos & CAMPO_SIGUIENTE) salida.push_back((unsigned char) V.siguiente);
+    if (campos & CAMPO_FIN) salida.push_back((unsigned char) V.fin);
+}
+
+/**
+ * @brief Escribe el tablero entero, dos colores por byte.
+ * @param V Vista
+ * @param salida Destino
+ */
+static void escribeTablero(const Vista &V, std::vector<unsigned char> &salida) {
+    const unsigned char *c = &V.color[0][0];
+    for (int i = 0; i < CELDAS; i += 2) salida.push_back((unsigned char) (c[i] | c[i + 1] << 4));
+}
+
+/**
+ * @brief Cierra un mensaje escribiendo su longitud y sus campos.
+ * @param salida Destino
+ * @param inicio Posición devuelta por abreMensaje
+ * @param campos CampoEspectador presentes
+ */
+static void cierraMensaje(std::vector<unsigned char> &salida, size_t inicio, int campos) {
+    size_t longitud = salida.size() - inicio - 2;
+    salida[inicio] = (unsigned char) longitud;
+    salida[inicio + 1] = (unsigned char) (longitud >> 8);
+    salida[inicio + 7] = (unsigned char) campos;
+}
+
+/**
+ * @brief Añade un fotograma clave con lo último emitido.
+ * @param M Emisor
+ * @param salida Destino (se añade al final)
+ */
+void codificaClave(const EmisorEspectador &M, std::vector<unsigned char> &salida) {
+    const int campos = CAMPO_PIEZA | CAMPO_MARCADOR | CAMPO_SIGUIENTE | CAMPO_FIN | CAMPO_TABLERO;
+    size_t inicio = abreMensaje(salida, 'K', M.secuencia);
+    escribeCampos(M.ultima, campos, salida);
+    escribeTablero(M.ultima, salida);
+    cierraMensaje(salida, inicio, campos);
+}
+
+/**
+ * @brief Codifica los cambios de un frame.
+ * @post Si algo ha cambiado añade una diferencia y, cada M.intervalo diferencias
+ *       (y en la primera), un fotograma clave del mismo instante
+ * @param M Emisor
+ * @param E Estado de la partida
+ * @param salida Destino (se añade al final)
+ * @return TipoMensaje -> Qué se ha añadido
+ */
+TipoMensaje codificaFrame(EmisorEspectador &M, const EstadoJuego &E, std::vector<unsigned char> &salida) {
+    Vista V;
+    vistaDeJuego(E, V);
+    const Vista &A = M.ultima;
+
+    int campos = 0;
+    if (V.P.tipo != A.P.tipo || V.P.rot != A.P.rot || V.P.abs.x != A.P.abs.x || V.P.abs.y != A.P.abs.y) {
+        campos |= CAMPO_PIEZA;
+    }
+    if (V.ptos != A.ptos || V.level != A.level || V.lineas != A.lineas) campos |= CAMPO_MARCADOR;
+    if (V.siguiente != A.siguiente) campos |= CAMPO_SIGUIENTE;
+    if (V.fin != A.fin) campos |= CAMPO_FIN;
+
+    unsigned char cambiadas[CELDAS];
+    int n = 0;
+    const unsigned char *nuevo = &V.color[0][0], *viejo = &A.color[0][0];
+    for (int i = 0; i < CELDAS; ++i) {
+        if (nuevo[i] != viejo[i]) cambiadas[n++] = (unsigned char) i;
+    }
+    // Cada celda cuesta 2 bytes: con muchas, el tablero entero ocupa menos
+    if (n > 0) campos |= 1 + 2 * size_t(n) < BYTES_TABLERO ? CAMPO_CELDAS : CAMPO_TABLERO;
+    if (campos == 0) return SIN_CAMBIOS;
+
+    M.secuencia++;
+    size_t inicio = abreMensaje(salida, 'D', M.secuencia);
+    escribeCampos(V, campos, salida);
+    if (campos & CAMPO_CELDAS) {
+        salida.push_back((unsigned char) n);
+        for (int k = 0; k < n; ++k) {
+            salida.push_back(cambiadas[k]);
+            salida.push_back(nuevo[cambiadas[k]]);
+        }
+    }
+    if (campos & CAMPO_TABLERO) escribeTablero(V, salida);
+    cierraMensaje(salida, inicio, campos);
+
+    M.ultima = V;
+    if (M.secuencia % M.intervalo != 1 && M.intervalo > 1) return MENSAJE_DIFERENCIA;
+    codificaClave(M, salida);
+    return MENSAJE_CLAVE;
+}
+
+/**
+ * @brief Deja una vista vacía y sin sincronizar.
+ * @param V Vista
+ */
+void iniciarVista(Vista &V) {
+    memset(V.color, VACIO, sizeof(V.color));
+    V.P = {{-1, -1}, 0, 0};
+    V.siguiente = -1;
+    V.ptos = V.level = V.lineas = -1;
+    V.fin = EN_JUEGO;
+    V.sincronizada = false;
+    V.secuencia = 0;
+}
+
+/**
+ * @brief Compara dos vistas.
+ * @param a Vista
+ * @param b Vista
+ * @return bool -> true: muestran lo mismo
+ */
+static bool mismaVista(const Vista &a, const Vista &b) {
+    return memcmp(a.color, b.color, sizeof(a.color)) == 0 && a.P.tipo == b.P.tipo && a.P.rot == b.P.rot &&
+           a.P.abs.x == b.P.abs.x && a.P.abs.y == b.P.abs.y && a.siguiente == b.siguiente && a.ptos == b.ptos &&
+           a.level == b.level && a.lineas == b.lineas && a.fin == b.fin;
+}
+
+/**
+ * @brief Aplica un mensaje a la vista de un espectador.
+ * @post Una diferencia solo se aplica si la vista está sincronizada y es la
+ *       siguiente a la última aplicada; si no, la vista queda sin sincronizar
+ *       hasta el siguiente fotograma clave, que siempre se aplica.
+ * @param V Vista
+ * @param datos Mensaje completo, con su longitud
+ * @param n Bytes del mensaje
+ * @return Aplicado -> Qué se ha hecho con el mensaje
+ */
+Aplicado aplicaMensaje(Vista &V, const unsigned char *datos, size_t n) {
+    if (n < CABECERA_ESPECTADOR || size_t(datos[0] | datos[1] << 8) + 2 != n) return INVALIDO;
+    char tipo = char(datos[2]);
+    uint32_t secuencia = lee32(datos + 3);
+    int campos = datos[7];
+    if ((tipo != 'D' && tipo != 'K') || campos >= 2 * CAMPO_TABLERO) return INVALIDO;
+
+    // Comprueba que los campos caben antes de tocar la vista
+    const int todos = CAMPO_PIEZA | CAMPO_MARCADOR | CAMPO_SIGUIENTE | CAMPO_FIN | CAMPO_TABLERO;
+    if (tipo == 'K' && campos != todos) return INVALIDO;
+    size_t fijos = (campos & CAMPO_PIEZA ? 3 : 0) + (campos & CAMPO_MARCADOR ? 9 : 0) +
+                   (campos & CAMPO_SIGUIENTE ? 1 : 0) + (campos & CAMPO_FIN ? 1 : 0);
+    size_t necesarios = CABECERA_ESPECTADOR + fijos + (campos & CAMPO_TABLERO ? BYTES_TABLERO : 0);
+    if (campos & CAMPO_CELDAS) {
+        if (necesarios >= n) return INVALIDO;
+        necesarios += 1 + 2 * size_t(datos[CABECERA_ESPECTADOR + fijos]);
+    }
+    if (necesarios != n) return INVALIDO;
+
+    bool clave = tipo == 'K';
+    if (!clave && (!V.sincronizada || secuencia != V.secuencia + 1)) {
+        V.sincronizada = false;
+        return IGNORADO;
+    }
+    Vista N = V;
+    const unsigned char *p = datos + CABECERA_ESPECTADOR;
+    if (campos & CAMPO_PIEZA) {
+        N.P.tipo = (p[0] >> 2) % TIPOS_PIEZA;
+        N.P.rot = p[0] & 3;
+        N.P.abs.x = (signed char) p[1];
+        N.P.abs.y = (signed char) p[2];
+        p += 3;
+    }
+    if (campos & CAMPO_MARCADOR) {
+        N.ptos = int(lee32(p));
+        N.level = p[4];
+        N.lineas = int(lee32(p + 5));
+        p += 9;
+    }
+    if (campos & CAMPO_SIGUIENTE) N.siguiente = *p++;
+    if (campos & CAMPO_FIN) N.fin = Fin(*p++ % 3);
+    if (campos & CAMPO_CELDAS) {
+        int k = *p++;
+        for (int i = 0; i < k; ++i, p += 2) (&N.color[0][0])[p[0] % CELDAS] = p[1];
+    }
+    if (campos & CAMPO_TABLERO) {
+        unsigned char *c = &N.color[0][0];
+        for (int i = 0; i < CELDAS; i += 2, ++p) {
+            c[i] = *p & 15;
+            c[i + 1] = *p >> 4;
+        }
+    }
+
+    // El fotograma clave acompaña a la diferencia de su secuencia: si ya se ha aplicado, deben coincidir
+    bool desajuste = clave && V.sincronizada && V.secuencia == secuencia && !mismaVista(V, N);
+    N.sincronizada = true;
+    N.secuencia = secuencia;
+    V = N;
+    return desajuste ? DESAJUSTE : APLICADO;
+}
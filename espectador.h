@@ -0,0 +1,105 @@
+/**
+ * @file espectador.h
+ * @brief Retransmisión de partidas por diferencias
+ *
+ * En lugar de mandar el tablero entero cada frame, el emisor compara la
+ * partida con lo último que mandó y solo codifica lo que ha cambiado: las
+ * celdas del tablero, la posición de la pieza, el marcador (puntos, nivel y
+ * filas), la pieza siguiente y el final. Un frame en que solo se mueve la pieza
+ * ocupa 11 bytes, frente a los más de 200 del tablero entero.
+ *
+ * Cada cierto número de diferencias se manda además un fotograma clave con el
+ * estado completo del mismo instante. Sirve para que un espectador que llega
+ * tarde, o que se ha saltado mensajes, se sincronice; y al que ya estaba
+ * sincronizado le permite comprobar que lo reconstruido coincide.
+ *
+ * Formato de un mensaje (enteros little-endian):
+ * - longitud (2): bytes que siguen
+ * - tipo (1): 'D' diferencia o 'K' fotograma clave
+ * - secuencia (4): número de diferencia; el fotograma clave lleva el de la
+ *   diferencia a la que acompaña
+ * - campos (1): CampoEspectador presentes, en este orden:
+ *   - CAMPO_PIEZA (3): tipo << 2 | rot, x e y
+ *   - CAMPO_MARCADOR (9): puntos (4), nivel (1) y filas quitadas (4)
+ *   - CAMPO_SIGUIENTE (1): tipo de la pieza siguiente
+ *   - CAMPO_FIN (1): valor de Fin
+ *   - CAMPO_CELDAS (1 + 2n): n celdas, cada una índice (fila * COLUMNAS + columna) y color
+ *   - CAMPO_TABLERO (100): todas las celdas, dos colores por byte
+ *
+ * Una diferencia con muchas celdas (al quitar filas todo el tablero baja) lleva
+ * CAMPO_TABLERO en vez de CAMPO_CELDAS si así ocupa menos.
+ */
+
+#ifndef _ESPECTADOR_H_
+#define _ESPECTADOR_H_
+
+#include "juego.h"
+#include <cstddef>
+#include <vector>
+
+const uint32_t INTERVALO_CLAVES_ESPECTADOR = 64; ///< Diferencias entre fotogramas clave por defecto
+const size_t MAX_MENSAJE_ESPECTADOR = 2 + 6 + 3 + 9 + 1 + 1 + FILAS * COLUMNAS / 2; ///< Mayor mensaje posible
+
+/** @enum CampoEspectador
+ *  @brief Campos presentes en un mensaje.
+ */
+enum CampoEspectador {
+    CAMPO_PIEZA = 1, ///< Tipo, rotación y posición de la pieza actual
+    CAMPO_MARCADOR = 2, ///< Puntos, nivel y filas quitadas
+    CAMPO_SIGUIENTE = 4, ///< Pieza siguiente
+    CAMPO_FIN = 8, ///< Estado de finalización
+    CAMPO_CELDAS = 16, ///< Celdas del tablero que han cambiado
+    CAMPO_TABLERO = 32 ///< Tablero entero
+};
+
+/** @enum TipoMensaje
+ *  @brief Resultado de codificar un frame.
+ */
+enum TipoMensaje {
+    SIN_CAMBIOS, ///< No ha cambiado nada: no hay mensaje
+    MENSAJE_DIFERENCIA, ///< Se ha añadido una diferencia
+    MENSAJE_CLAVE ///< Se ha añadido una diferencia y un fotograma clave
+};
+
+/** @enum Aplicado
+ *  @brief Resultado de aplicar un mensaje a una vista.
+ */
+enum Aplicado {
+    APLICADO, ///< La vista refleja el mensaje
+    IGNORADO, ///< Diferencia sin la anterior: hay que esperar al siguiente fotograma clave
+    DESAJUSTE, ///< Fotograma clave distinto de lo reconstruido (la vista se corrige)
+    INVALIDO ///< El mensaje está mal formado
+};
+
+/** @struct Vista
+ *  @brief Lo que ve un espectador de una partida.
+ */
+struct Vista {
+    unsigned char color[FILAS][COLUMNAS]; ///< Colores del tablero (VACIO: celda libre)
+    Pieza P; ///< Pieza actual
+    int siguiente; ///< Tipo de la pieza siguiente
+    int ptos; ///< Puntos
+    int level; ///< Nivel
+    int lineas; ///< Filas quitadas
+    Fin fin; ///< Estado de finalización
+    bool sincronizada; ///< Ha recibido un fotograma clave y no ha perdido ninguna diferencia
+    uint32_t secuencia; ///< Última diferencia aplicada
+};
+
+/** @struct EmisorEspectador
+ *  @brief Estado del codificador de una partida retransmitida.
+ */
+struct EmisorEspectador {
+    Vista ultima; ///< Lo último que se ha mandado
+    uint32_t secuencia; ///< Diferencias emitidas
+    uint32_t intervalo; ///< Diferencias entre fotogramas clave
+};
+
+void vistaDeJuego(const EstadoJuego &E, Vista &V);
+void iniciarEmisor(EmisorEspectador &M, uint32_t intervalo = INTERVALO_CLAVES_ESPECTADOR);
+TipoMensaje codificaFrame(EmisorEspectador &M, const EstadoJuego &E, std::vector<unsigned char> &salida);
+void codificaClave(const EmisorEspectador &M, std::vector<unsigned char> &salida);
+void iniciarVista(Vista &V);
+Aplicado aplicaMensaje(Vista &V, const unsigned char *datos, size_t n);
+
+#endif
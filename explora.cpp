@@ -0,0 +1,145 @@
+/**
+ * @file explora.cpp
+ * @brief Mide el bot de búsqueda en haz: nodos por segundo y aceleración con hilos
+ *
+ * Uso: explora [--profundidad D] [--anchura W] [--vista V] [--nodos N] [--ms T] [--hilos H]
+ *              [--partidas K] [--piezas P] [--megas M] [--bolsa] [--semilla S] [--escala]
+ *
+ * Juega K partidas (4 por defecto) de hasta P piezas (200) con buscaHaz, una
+ * detrás de otra, expandiendo cada nivel del haz con H hilos. La vista de las
+ * partidas es V piezas (por defecto D - 1, para que se puedan usar las D). Con
+ * --nodos o --ms cada jugada tiene ese presupuesto. Muestra:
+ *
+ *     hilos nodos/s jugadas/s aceleracion puntos_medios niveles_medios aciertos%
+ *
+ * Con --escala repite con 1, 2, ... H hilos y comprueba que, sin límite de
+ * tiempo, las partidas hacen las mismas jugadas con cualquier número de hilos.
+ */
+
+#include "haz.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/** @struct ResultadoLote
+ *  @brief Totales de un lote de partidas.
+ */
+struct ResultadoLote {
+    vector<int> puntos; ///< Puntos de cada partida
+    vector<uint64_t> jugadasHechas; ///< Resumen de las colocaciones de cada partida
+    long jugadas; ///< Colocaciones
+    long nodos; ///< Tableros generados
+    long niveles; ///< Suma de niveles completos de cada jugada
+    double segundos; ///< Tiempo de búsqueda
+};
+
+/**
+ * @brief Juega las partidas con un número de hilos.
+ * @param hilos Hilos que expanden el haz
+ * @param O Forma y presupuesto de la búsqueda
+ * @param partidas Partidas
+ * @param piezas Piezas por partida como mucho
+ * @param vista Piezas siguientes visibles
+ * @param modo Forma de repartir las piezas
+ * @param semilla Semilla de la primera partida
+ * @param TT Tabla compartida (nullptr: sin tabla; se vacía antes de empezar)
+ * @return ResultadoLote -> Totales
+ */
+static ResultadoLote juega(int hilos, const OpcionesHaz &O, int partidas, int piezas, int vista, ModoAzar modo,
+                           uint64_t semilla, TablaTransposicion *TT) {
+    PoolTrabajo pool(hilos);
+    BuscadorHaz B;
+    iniciarHaz(B, &pool, TT);
+    if (TT != nullptr) limpiaTabla(*TT);
+    ResultadoLote L = {vector<int>(), vector<uint64_t>(), 0, 0, 0, 0};
+    for (int k = 0; k < partidas; ++k) {
+        EstadoJuego E;
+        iniciarJuego(E, semilla + uint64_t(k), modo, vista);
+        uint64_t resumen = 0;
+        while (E.fin == EN_JUEGO && E.piezas < piezas) {
+            if (TT != nullptr) nuevaEdadTabla(*TT);
+            int tipos[MAX_PROFUNDIDAD_HAZ];
+            int n = piezasConocidas(E, tipos);
+            ResultadoHaz R;
+            int d = buscaHaz(B, E.T, E.P, tipos, n, PESOS_DEFECTO, O, R);
+            L.nodos += R.nodos;
+            L.niveles += R.niveles;
+            L.segundos += R.ms / 1000;
+            if (d < 0) break;
+            colocaPieza(E, B.G[0]->destino[d].P);
+            resumen = resumen * 0x100000001B3ull ^ codificaJugada(B.G[0]->destino[d].P);
+            L.jugadas++;
+        }
+        L.puntos.push_back(E.ptos);
+        L.jugadasHechas.push_back(resumen);
+    }
+    return L;
+}
+
+int main(int argc, char *argv[]) {
+    OpcionesHaz O = HAZ_DEFECTO;
+    int hilos = int(thread::hardware_concurrency()), partidas = 4, piezas = 200, vista = 0;
+    double megas = 16;
+    uint64_t semilla = 1;
+    bool escala = false;
+    ModoAzar modo = AZAR_PURO;
+    for (int i = 1; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--profundidad") == 0 && valor) O.profundidad = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--anchura") == 0 && valor) O.anchura = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--vista") == 0 && valor) vista = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--nodos") == 0 && valor) O.nodos = atol(argv[++i]);
+        else if (strcmp(argv[i], "--ms") == 0 && valor) O.ms = atof(argv[++i]);
+        else if (strcmp(argv[i], "--hilos") == 0 && valor) hilos = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--partidas") == 0 && valor) partidas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--piezas") == 0 && valor) piezas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--megas") == 0 && valor) megas = atof(argv[++i]);
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) semilla = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--bolsa") == 0) modo = AZAR_BOLSA;
+        else if (strcmp(argv[i], "--escala") == 0) escala = true;
+        else {
+            cerr << "Uso: " << argv[0] << " [--profundidad D] [--anchura W] [--vista V] [--nodos N] [--ms T]"
+                 << " [--hilos H] [--partidas K] [--piezas P] [--megas M] [--bolsa] [--semilla S] [--escala]" << endl;
+            return 1;
+        }
+    }
+    if (hilos < 1) hilos = 1;
+    if (partidas < 1) partidas = 1;
+    if (vista < 1) vista = O.profundidad - 1;
+    if (vista < 1) vista = 1;
+    if (vista > CAPACIDAD_VISTA) vista = CAPACIDAD_VISTA;
+
+    unique_ptr<TablaTransposicion> TT;
+    if (megas > 0) {
+        TT.reset(new TablaTransposicion);
+        iniciarTabla(*TT, size_t(megas * 1024 * 1024));
+    }
+
+    double base = 0;
+    vector<uint64_t> primeras;
+    for (int h = escala ? 1 : hilos; h <= hilos; ++h) {
+        ResultadoLote L = juega(h, O, partidas, piezas, vista, modo, semilla, TT.get());
+        double nodosSegundo = L.nodos / L.segundos;
+        if (base == 0) base = nodosSegundo;
+        double puntos = 0;
+        for (int p : L.puntos) puntos += p;
+        EstadisticasTabla S = TT ? estadisticasTabla(*TT) : EstadisticasTabla{};
+        printf("%d %.0f %.1f %.2f %.1f %.2f %.1f\n", h, nodosSegundo, L.jugadas / L.segundos, nodosSegundo / base,
+               puntos / partidas, L.jugadas > 0 ? double(L.niveles) / L.jugadas : 0.0,
+               S.sondeos > 0 ? 100.0 * S.aciertos / S.sondeos : 0.0);
+        fflush(stdout);
+
+        if (O.ms > 0) continue;
+        if (primeras.empty()) primeras = L.jugadasHechas;
+        else if (L.jugadasHechas != primeras) {
+            cerr << "Con " << h << " hilos las partidas no hacen las mismas jugadas que con 1" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
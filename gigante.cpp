@@ -0,0 +1,190 @@
+/**
+ * @file gigante.cpp
+ * @brief Prueba de carga del motor con tableros de muchos tamaños
+ *
+ * Uso: gigante [--piezas N] [--frames F] [--semilla S]
+ *
+ * Primero deja caer las mismas N piezas (20000 por defecto) en tableros del
+ * mismo tamaño con máscaras de fila distintas (16 bits, 64 bits y FilaAncha de
+ * una o varias palabras) y comprueba tras cada pieza que la caída, las filas
+ * quitadas y todas las celdas y colores coinciden. El tablero estándar usa sus
+ * núcleos especializados, así que también se comparan con la versión genérica.
+ * Cada partida empieza con la mitad de abajo llena salvo un hueco por fila, y la
+ * mitad de las piezas son palos que se dejan caer en un hueco, para que se
+ * quiten filas a menudo.
+ *
+ * Después juega F frames (200000) de paso() con acciones al azar en cada tamaño
+ * y muestra una línea por tamaño:
+ *
+ *     columnas filas bytes_fila frames/s piezas_fijadas
+ */
+
+#include "juego.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+
+const int PALO = 5; ///< Tipo del palo en RELATIVOS (vertical en la rotación 0)
+
+/**
+ * @brief Empieza una partida de la prueba: mitad de abajo llena salvo un hueco por fila.
+ * @param T Tablero
+ * @param huecos Columna del hueco de cada fila (la misma para todos los tableros del grupo)
+ */
+template <int A, int H, class R>
+static void preparaTablero(TableroDe<A, H, R> &T, const vector<int> &huecos) {
+    vaciarTablero(T);
+    for (int f = H / 2; f < H; ++f) {
+        for (int c = 0; c < A; ++c) {
+            if (c == huecos[size_t(f)]) continue;
+            OperacionesFila<R>::marca(T.fila[f], 1, c);
+            T.color[f][c] = (unsigned char) (1 + c % TIPOS_PIEZA);
+        }
+    }
+}
+
+/**
+ * @brief Deja caer una pieza desde arriba y la fija.
+ * @param T Tablero
+ * @param P Pieza en la fila de aparición
+ * @param lineas Filas quitadas
+ * @return int -> Fila de bloqueo (-1: no cabe al aparecer)
+ */
+template <class TB>
+static int dejaCaer(TB &T, Pieza P, int &lineas) {
+    if (colisionPieza(T, P)) return -1;
+    while (true) {
+        P.abs.y++;
+        if (colisionPieza(T, P)) break;
+    }
+    P.abs.y--;
+    insertaPieza(T, P);
+    lineas = cuentaFila(T);
+    return P.abs.y;
+}
+
+/**
+ * @brief Compara dos tableros celda a celda.
+ * @return bool -> true: mismas celdas ocupadas y mismos colores
+ */
+template <int A, int H, class R1, class R2>
+static bool mismasCeldas(const TableroDe<A, H, R1> &a, const TableroDe<A, H, R2> &b) {
+    for (int f = 0; f < H; ++f) {
+        for (int c = 0; c < A; ++c) {
+            bool x = OperacionesFila<R1>::celda(a.fila[f], c), y = OperacionesFila<R2>::celda(b.fila[f], c);
+            if (x != y || a.color[f][c] != b.color[f][c] || (a.color[f][c] != VACIO) != x) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Juega las mismas caídas en tres tableros del mismo tamaño y los compara.
+ * @param piezas Piezas a dejar caer
+ * @param semilla Semilla de las piezas y los huecos
+ * @return bool -> true: los tres tableros coinciden en todo momento
+ */
+template <int A, int H, class R1, class R2, class R3>
+static bool compruebaGrupo(int piezas, uint64_t semilla) {
+    unique_ptr<TableroDe<A, H, R1>> T1(new TableroDe<A, H, R1>);
+    unique_ptr<TableroDe<A, H, R2>> T2(new TableroDe<A, H, R2>);
+    unique_ptr<TableroDe<A, H, R3>> T3(new TableroDe<A, H, R3>);
+    mt19937_64 azar(semilla);
+    vector<int> huecos((size_t) H);
+    long lineas = 0;
+    bool nueva = true;
+    for (int i = 0; i < piezas; ++i) {
+        if (nueva) {
+            for (int &h : huecos) h = int(azar() % A);
+            preparaTablero(*T1, huecos);
+            preparaTablero(*T2, huecos);
+            preparaTablero(*T3, huecos);
+            nueva = false;
+        }
+        Pieza P = {inicioPieza(A), int(azar() % TIPOS_PIEZA), int(azar() % ROTACIONES)};
+        if (azar() & 1) {
+            // Un palo vertical en el primer hueco de la fila más baja que no esté llena
+            P.tipo = PALO;
+            P.rot = 0;
+            bool hueco = false;
+            for (int f = H - 1; f >= 0 && !hueco; --f) {
+                for (int c = 0; c < A && !hueco; ++c) {
+                    hueco = !OperacionesFila<R1>::celda(T1->fila[f], c);
+                    if (hueco) P.abs.x = c;
+                }
+            }
+        } else {
+            const Huella &h = P.huella();
+            P.abs.x = int(azar() % (A - (h.maxx - h.minx))) - h.minx;
+        }
+        int l1 = 0, l2 = 0, l3 = 0;
+        int y1 = dejaCaer(*T1, P, l1), y2 = dejaCaer(*T2, P, l2), y3 = dejaCaer(*T3, P, l3);
+        if (y1 != y2 || y1 != y3 || l1 != l2 || l1 != l3 || !mismasCeldas(*T1, *T2) || !mismasCeldas(*T1, *T3)) {
+            cerr << A << "x" << H << ": los tableros no coinciden tras la pieza " << i << endl;
+            return false;
+        }
+        lineas += l1;
+        nueva = y1 < 0;
+    }
+    printf("%dx%d: %d piezas, %ld lineas, mismas celdas\n", A, H, piezas, lineas);
+    return true;
+}
+
+/**
+ * @brief Mide paso() con acciones al azar en un tamaño de tablero.
+ * @param frames Frames a jugar
+ * @param semilla Semilla de las partidas y las acciones
+ */
+template <int A, int H>
+static void mideTamano(long frames, uint64_t semilla) {
+    unique_ptr<EstadoJuegoDe<A, H>> E(new EstadoJuegoDe<A, H>);
+    iniciarJuego(*E, semilla);
+    mt19937 azar((uint32_t) semilla);
+    long fijadas = 0;
+    auto inicio = chrono::steady_clock::now();
+    for (long f = 0; f < frames; ++f) {
+        // Más bajadas que movimientos, para que las piezas se fijen a menudo
+        unsigned r = azar() % 8;
+        Accion a = r < 3 ? BAJAR : r < 6 ? Accion(MOVER_IZQUIERDA + (r & 1)) : Accion(ROTAR_DERECHA + (r & 1));
+        int cambios = paso(*E, a);
+        fijadas += (cambios & CAMBIO_FIJADA) != 0;
+        if (cambios & CAMBIO_FIN) iniciarJuego(*E, semilla + uint64_t(f));
+    }
+    double s = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    printf("%d %d %zu %.0f %ld\n", A, H, sizeof(typename decltype(E->T)::TipoFila), double(frames) / s, fijadas);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    int piezas = 20000;
+    long frames = 200000;
+    uint64_t semilla = 1;
+    for (int i = 1; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--piezas") == 0 && valor) piezas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && valor) frames = atol(argv[++i]);
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) semilla = strtoull(argv[++i], nullptr, 10);
+        else {
+            cerr << "Uso: " << argv[0] << " [--piezas N] [--frames F] [--semilla S]" << endl;
+            return 1;
+        }
+    }
+
+    bool bien = compruebaGrupo<COLUMNAS, FILAS, Fila, uint64_t, FilaAncha<1>>(piezas, semilla) &&
+                compruebaGrupo<64, 128, uint64_t, FilaAncha<1>, FilaAncha<2>>(piezas, semilla) &&
+                compruebaGrupo<300, 200, FilaAncha<5>, FilaAncha<6>, FilaAncha<9>>(piezas, semilla);
+    if (!bien) return 1;
+
+    mideTamano<COLUMNAS, FILAS>(frames, semilla);
+    mideTamano<16, 40>(frames, semilla);
+    mideTamano<64, 128>(frames, semilla);
+    mideTamano<256, 512>(frames, semilla);
+    mideTamano<1024, 2048>(frames, semilla);
+    return 0;
+}
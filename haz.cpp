@@ -0,0 +1,189 @@
+/**
+ * @file haz.cpp
+ * @brief Bot con búsqueda en haz sobre la pieza actual y las siguientes
+ *
+ * @see haz.h
+ */
+
+#include "haz.h"
+#include <algorithm>
+#include <chrono>
+
+const OpcionesHaz HAZ_DEFECTO = {3, 32, 0, 0};
+
+/**
+ * @brief Prepara la memoria de la búsqueda.
+ * @param B Buscador
+ * @param pool Hilos que expanden los nodos (nullptr: en el hilo que llama)
+ * @param TT Tabla de transposición compartida (nullptr: sin tabla)
+ */
+void iniciarHaz(BuscadorHaz &B, PoolTrabajo *pool, TablaTransposicion *TT) {
+    B.pool = pool;
+    B.TT = TT;
+    B.G.clear();
+    // G[0] guarda los destinos de la raíz; sin grupo, los demás niveles usan G[1]
+    int hilos = pool != nullptr ? pool->hilos() : 1;
+    for (int h = 0; h <= hilos; ++h) B.G.emplace_back(new GeneradorMovimientos);
+    B.nodos = 0;
+    B.agotado = false;
+}
+
+/**
+ * @brief Piezas siguientes que ya se conocen en una partida.
+ * @param E Estado de la partida
+ * @param tipos Tipos de las piezas siguientes, en orden
+ * @return int -> Número de piezas (la vista de la partida)
+ */
+int piezasConocidas(const EstadoJuego &E, int tipos[MAX_PROFUNDIDAD_HAZ]) {
+    int n = E.azar.vista < MAX_PROFUNDIDAD_HAZ ? E.azar.vista : MAX_PROFUNDIDAD_HAZ - 1;
+    for (int i = 0; i < n; ++i) tipos[i] = verPieza(E.azar, i);
+    return n;
+}
+
+/**
+ * @brief Orden del haz: más valor primero y, a igual valor, el camino generado antes.
+ * @return bool -> true: a va antes que b
+ */
+static bool mejorQue(const NodoHaz &a, const NodoHaz &b) {
+    if (a.valor != b.valor) return a.valor > b.valor;
+    if (a.padre != b.padre) return a.padre < b.padre;
+    return a.orden < b.orden;
+}
+
+/**
+ * @brief Añade a salida los tableros de todas las colocaciones de una pieza.
+ * @param B Buscador (tabla y cuenta de nodos)
+ * @param G Memoria de búsqueda del hilo
+ * @param N Nodo de partida
+ * @param P Pieza a colocar en N.T
+ * @param padre Índice de N en su nivel (-1: raíz)
+ * @param W Pesos del evaluador
+ * @param salida Hijos
+ * @return int -> Destinos de la pieza (sus índices en G.destino)
+ */
+static int expande(BuscadorHaz &B, GeneradorMovimientos &G, const NodoHaz &N, const Pieza &P, int padre,
+                   const Pesos &W, std::vector<NodoHaz> &salida) {
+    if (colisionPieza(N.T, P)) return 0;
+    int n = generaMovimientos(G, N.T, P);
+    for (int j = 0; j < n; ++j) {
+        NodoHaz h;
+        h.T = N.T;
+        h.clave = N.clave;
+        insertaPieza(h.T, G.destino[j].P, h.clave);
+        int lineas = cuentaFila(h.T, h.clave);
+        h.lineas = float(N.lineas + W.lineas * lineas);
+        h.valor = float(h.lineas + valorTablero(h.T, h.clave, W, B.TT));
+        h.raiz = padre < 0 ? j : N.raiz;
+        h.padre = padre;
+        h.orden = j;
+        salida.push_back(h);
+    }
+    B.nodos.fetch_add(n, std::memory_order_relaxed);
+    return n;
+}
+
+/**
+ * @brief Elige el haz del nivel siguiente entre los candidatos.
+ * @post B.haz tiene los `anchura` mejores candidatos con claves distintas; de
+ *       los repetidos queda el primero en el orden de mejorQue
+ * @param B Buscador
+ * @param anchura Tamaño del haz
+ */
+static void selecciona(BuscadorHaz &B, int anchura) {
+    std::vector<NodoHaz> &C = B.candidatos;
+    B.haz.clear();
+    // Casi nunca hay más de unos pocos repetidos: basta con ordenar el principio
+    size_t ordenados = std::min(C.size(), size_t(2 * anchura));
+    std::partial_sort(C.begin(), C.begin() + ptrdiff_t(ordenados), C.end(), mejorQue);
+    for (size_t i = 0; i < C.size() && int(B.haz.size()) < anchura; ++i) {
+        if (i == ordenados) {
+            std::sort(C.begin() + ptrdiff_t(i), C.end(), mejorQue);
+            ordenados = C.size();
+        }
+        bool repetido = false;
+        for (const NodoHaz &h : B.haz) repetido = repetido || h.clave == C[i].clave;
+        if (!repetido) B.haz.push_back(C[i]);
+    }
+}
+
+/**
+ * @brief Busca la mejor colocación de la pieza actual mirando las siguientes.
+ * @pre No se llama desde un hilo de B.pool
+ * @post El primer nivel se completa siempre. Los demás se expanden en paralelo
+ *       mientras haya piezas conocidas, profundidad y presupuesto; un nivel sin
+ *       ningún tablero vivo (la pieza no cabe en ninguno) no cuenta.
+ * @param B Buscador
+ * @param T Ocupación del tablero
+ * @param P Pieza actual
+ * @param siguientes Tipos de las piezas siguientes (piezasConocidas)
+ * @param n Número de piezas siguientes
+ * @param W Pesos del evaluador
+ * @param O Forma y presupuesto de la búsqueda
+ * @param R Resumen de la búsqueda
+ * @return int -> Índice del mejor destino en B.G[0]->destino, o -1 si no hay ninguno
+ */
+int buscaHaz(BuscadorHaz &B, const Ocupacion &T, const Pieza &P, const int siguientes[], int n, const Pesos &W,
+             const OpcionesHaz &O, ResultadoHaz &R) {
+    typedef std::chrono::steady_clock Reloj;
+    const Reloj::time_point inicio = Reloj::now();
+    const Reloj::time_point limite = inicio + std::chrono::duration_cast<Reloj::duration>(
+            std::chrono::duration<double, std::milli>(O.ms));
+    const int anchura = O.anchura < 1 ? 1 : O.anchura;
+    int profundidad = O.profundidad < 1 ? 1 : O.profundidad;
+    if (profundidad > n + 1) profundidad = n + 1;
+    if (profundidad > MAX_PROFUNDIDAD_HAZ) profundidad = MAX_PROFUNDIDAD_HAZ;
+    B.nodos = 0;
+    B.agotado = false;
+    R = {-1, 0, 0, 0, 0};
+
+    NodoHaz raiz = {T, claveTablero(T), 0, 0, -1, -1, 0};
+    B.candidatos.clear();
+    expande(B, *B.G[0], raiz, P, -1, W, B.candidatos);
+    if (!B.candidatos.empty()) {
+        selecciona(B, anchura);
+        R.niveles = 1;
+    }
+
+    for (int d = 1; d < profundidad && R.niveles == d; ++d) {
+        if (O.nodos > 0 && B.nodos.load() >= O.nodos) break;
+        if (O.ms > 0 && Reloj::now() >= limite) break;
+
+        const Pieza Q = {INICIO, siguientes[d - 1], 0};
+        if (B.hijos.size() < B.haz.size()) B.hijos.resize(B.haz.size());
+        auto tarea = [&B, &Q, &W, &O, limite](int i, GeneradorMovimientos &G) {
+            std::vector<NodoHaz> &salida = B.hijos[size_t(i)];
+            salida.clear();
+            if (B.agotado.load(std::memory_order_relaxed)) return;
+            if (O.ms > 0 && Reloj::now() >= limite) {
+                B.agotado = true;
+                return;
+            }
+            expande(B, G, B.haz[size_t(i)], Q, i, W, salida);
+        };
+        if (B.pool != nullptr) {
+            for (int i = 0; i < int(B.haz.size()); ++i) {
+                B.pool->encolar([&B, &tarea, i] { tarea(i, *B.G[size_t(PoolTrabajo::hiloActual() + 1)]); });
+            }
+            B.pool->esperar();
+        } else {
+            for (int i = 0; i < int(B.haz.size()); ++i) tarea(i, *B.G[1]);
+        }
+        if (B.agotado) break;
+
+        B.candidatos.clear();
+        for (size_t i = 0; i < B.haz.size(); ++i) {
+            B.candidatos.insert(B.candidatos.end(), B.hijos[i].begin(), B.hijos[i].end());
+        }
+        if (B.candidatos.empty()) break;
+        selecciona(B, anchura);
+        R.niveles++;
+    }
+
+    if (R.niveles > 0) {
+        R.destino = B.haz[0].raiz;
+        R.valor = B.haz[0].valor;
+    }
+    R.nodos = B.nodos.load();
+    R.ms = std::chrono::duration<double, std::milli>(Reloj::now() - inicio).count();
+    return R.destino;
+}
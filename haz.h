@@ -0,0 +1,88 @@
+/**
+ * @file haz.h
+ * @brief Bot con búsqueda en haz sobre la pieza actual y las siguientes
+ *
+ * Expande nivel a nivel: el nivel d son los tableros tras colocar las d primeras
+ * piezas conocidas (la actual y las de la vista de EstadoJuego::azar). De cada
+ * nivel solo siguen los `anchura` tableros con más valor, que es el de las filas
+ * quitadas por el camino más la evaluación del tablero al que llegan; los
+ * tableros repetidos (misma clave Zobrist por otro orden de colocaciones) se
+ * cuentan una vez. La jugada es la primera colocación del mejor camino.
+ *
+ * Cada nodo del haz se expande en una tarea de PoolTrabajo, que reparte los
+ * nodos con robo de trabajo. La selección ordena con desempates fijos, así que
+ * el resultado no depende del número de hilos. Con un presupuesto de nodos o de
+ * tiempo la búsqueda se para entre niveles (o a mitad de uno, si se acaba el
+ * tiempo) y juega con el último nivel completo: siempre hay respuesta.
+ *
+ * La evaluación de cada tablero se guarda en la TablaTransposicion: el nivel 1
+ * de una jugada es el nivel 2 de la anterior, así que se reutiliza entre jugadas.
+ */
+
+#ifndef _HAZ_H_
+#define _HAZ_H_
+
+#include "bot.h"
+#include "pool.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+const int MAX_PROFUNDIDAD_HAZ = 1 + CAPACIDAD_VISTA; ///< La pieza actual más toda la vista posible
+
+/** @struct OpcionesHaz
+ *  @brief Forma y presupuesto de la búsqueda.
+ */
+struct OpcionesHaz {
+    int profundidad; ///< Piezas a colocar (1..MAX_PROFUNDIDAD_HAZ; se limita a las conocidas)
+    int anchura; ///< Tableros que siguen en cada nivel
+    long nodos; ///< Tableros a generar como mucho por jugada (0: sin límite)
+    double ms; ///< Milisegundos por jugada como mucho (0: sin límite)
+};
+
+extern const OpcionesHaz HAZ_DEFECTO; ///< 3 piezas, anchura 32, sin límites
+
+/** @struct NodoHaz
+ *  @brief Tablero del haz.
+ */
+struct NodoHaz {
+    Ocupacion T; ///< Tablero ya sin filas llenas
+    uint64_t clave; ///< Clave Zobrist de T
+    float lineas; ///< Valor de las filas quitadas en el camino (W.lineas por fila)
+    float valor; ///< lineas + evaluación de T
+    int raiz; ///< Destino de la primera pieza del camino
+    int padre; ///< Nodo del nivel anterior
+    int orden; ///< Destino dentro del padre (desempate)
+};
+
+/** @struct ResultadoHaz
+ *  @brief Resumen de una búsqueda.
+ */
+struct ResultadoHaz {
+    int destino; ///< Índice en BuscadorHaz::G[0]->destino (-1: la pieza no cabe)
+    float valor; ///< Valor del mejor camino
+    int niveles; ///< Niveles completos
+    long nodos; ///< Tableros generados
+    double ms; ///< Milisegundos de la búsqueda
+};
+
+/** @struct BuscadorHaz
+ *  @brief Memoria de la búsqueda, reutilizada entre jugadas.
+ */
+struct BuscadorHaz {
+    PoolTrabajo *pool; ///< Hilos que expanden los nodos (nullptr: en el hilo que llama)
+    TablaTransposicion *TT; ///< Evaluaciones compartidas (nullptr: sin tabla)
+    std::vector<std::unique_ptr<GeneradorMovimientos>> G; ///< G[0]: raíz; G[h + 1]: hilo h (sin grupo, G[1])
+    std::vector<NodoHaz> haz; ///< Nivel actual
+    std::vector<std::vector<NodoHaz>> hijos; ///< Hijos de cada nodo del nivel actual
+    std::vector<NodoHaz> candidatos; ///< Hijos de todo el nivel, para elegir
+    std::atomic<long> nodos; ///< Tableros generados en esta búsqueda
+    std::atomic<bool> agotado; ///< Se acabó el tiempo a mitad de nivel
+};
+
+void iniciarHaz(BuscadorHaz &B, PoolTrabajo *pool, TablaTransposicion *TT);
+int piezasConocidas(const EstadoJuego &E, int tipos[MAX_PROFUNDIDAD_HAZ]);
+int buscaHaz(BuscadorHaz &B, const Ocupacion &T, const Pieza &P, const int tipos[], int n, const Pesos &W,
+             const OpcionesHaz &O, ResultadoHaz &R);
+
+#endif
@@ -0,0 +1,239 @@
+/**
+ * @file instantanea.cpp
+ * @brief Instantáneas de 32 bytes del estado de una partida
+ *
+ * @see instantanea.h
+ */
+
+#include "instantanea.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/// Campos del resto del estado (56 bits): posición y ancho en bits
+enum CampoInstantanea {
+    BIT_TIPO = 0, ANCHO_TIPO = 3,
+    BIT_ROT = BIT_TIPO + ANCHO_TIPO, ANCHO_ROT = 2,
+    BIT_X = BIT_ROT + ANCHO_ROT, ANCHO_X = 4,
+    BIT_Y = BIT_X + ANCHO_X, ANCHO_Y = 5,
+    BIT_NIVEL = BIT_Y + ANCHO_Y, ANCHO_NIVEL = 3,
+    BIT_FRAME = BIT_NIVEL + ANCHO_NIVEL, ANCHO_FRAME = 5,
+    BIT_FIN = BIT_FRAME + ANCHO_FRAME, ANCHO_FIN = 2,
+    BIT_PUNTOS = BIT_FIN + ANCHO_FIN, ANCHO_PUNTOS = 14,
+    BIT_LINEAS = BIT_PUNTOS + ANCHO_PUNTOS, ANCHO_LINEAS = 18,
+    BITS_RESTO = BIT_LINEAS + ANCHO_LINEAS
+};
+
+/// Filas del tablero en cada una de las tres primeras palabras (las dos últimas van en la cuarta)
+const int FILAS_PALABRA = 6;
+/// Bits del resto del estado en la cuarta palabra, tras las dos últimas filas
+const int RESTO_ULTIMA = 64 - 2 * COLUMNAS;
+
+static_assert(FILAS == 3 * FILAS_PALABRA + 2 && COLUMNAS == 10, "Reparto de filas pensado para 20x10");
+static_assert(BITS_RESTO == RESTO_ULTIMA + 3 * 4, "El resto del estado debe llenar los bits libres");
+
+/// Tamaño en disco de un punto de control: cabecera de 16 bytes más la instantánea
+const size_t TAM_PUNTO_CONTROL = 16 + sizeof(Instantanea);
+
+/** @struct TablaColores
+ *  @brief Celdas de color de 8 columnas para cada máscara de 8 bits.
+ */
+struct TablaColores {
+    unsigned char c[256][8]; ///< COLOR_RESTAURADO donde el bit está a 1, VACIO donde no
+};
+
+/**
+ * @brief Construye en compilación la tabla de colores restaurados.
+ * @return TablaColores -> Tabla completa
+ */
+constexpr TablaColores calculaColores() {
+    TablaColores t{};
+    for (int m = 0; m < 256; ++m) {
+        for (int i = 0; i < 8; ++i) t.c[m][i] = (unsigned char) ((m >> i) & 1 ? COLOR_RESTAURADO : VACIO);
+    }
+    return t;
+}
+
+static constexpr TablaColores COLORES = calculaColores();
+
+/**
+ * @brief Extrae un campo del resto del estado.
+ * @param resto Los 56 bits del resto del estado
+ * @param pos Primer bit del campo
+ * @param n Ancho en bits
+ * @return uint64_t -> Valor del campo
+ */
+static inline uint64_t campo(uint64_t resto, int pos, int n) {
+    return (resto >> pos) & ((uint64_t(1) << n) - 1);
+}
+
+/**
+ * @brief Limita un valor al máximo que cabe en un campo.
+ * @param v Valor (no negativo)
+ * @param n Ancho en bits
+ * @return uint64_t -> Valor saturado
+ */
+static inline uint64_t satura(long v, int n) {
+    uint64_t maximo = (uint64_t(1) << n) - 1;
+    return uint64_t(v) > maximo ? maximo : uint64_t(v);
+}
+
+/**
+ * @brief Empaqueta el estado de una partida.
+ * @post Tiempo constante. frame se satura a 31: cualquier valor mayor que la
+ *       velocidad más lenta (30) produce la misma caída en el siguiente NADA.
+ *       Los puntos se guardan en centenas (todas las puntuaciones lo son).
+ * @param E Estado de la partida
+ * @param I Instantánea
+ */
+void guardaInstantanea(const EstadoJuego &E, Instantanea &I) {
+    uint64_t resto = uint64_t(E.P.tipo) << BIT_TIPO | uint64_t(E.P.rot) << BIT_ROT |
+                     uint64_t(E.P.abs.x) << BIT_X | uint64_t(E.P.abs.y) << BIT_Y |
+                     uint64_t(E.level) << BIT_NIVEL | satura(E.frame, ANCHO_FRAME) << BIT_FRAME |
+                     uint64_t(E.fin) << BIT_FIN | satura(E.ptos / 100, ANCHO_PUNTOS) << BIT_PUNTOS |
+                     satura(E.lineas, ANCHO_LINEAS) << BIT_LINEAS;
+
+    // Palabras 0..2: seis filas en los bits 0..59 y 4 bits del resto en 60..63
+    for (int w = 0; w < 3; ++w) {
+        uint64_t b = campo(resto, RESTO_ULTIMA + 4 * w, 4) << 60;
+        for (int i = 0; i < FILAS_PALABRA; ++i) {
+            b |= uint64_t(E.T.fila[w * FILAS_PALABRA + i]) << (i * COLUMNAS);
+        }
+        I.bits[w] = b;
+    }
+    // Palabra 3: las dos últimas filas y el resto del estado
+    I.bits[3] = uint64_t(E.T.fila[FILAS - 2]) | uint64_t(E.T.fila[FILAS - 1]) << COLUMNAS |
+                campo(resto, 0, RESTO_ULTIMA) << (2 * COLUMNAS);
+}
+
+/**
+ * @brief Restaura el estado de una partida desde una instantánea.
+ * @pre E.azar se ha iniciado con la semilla, el modo y la vista de la partida
+ *      (por ejemplo con iniciarJuego), y E.sinFin es el de la partida
+ * @post Tiempo constante. Las celdas ocupadas toman COLOR_RESTAURADO.
+ * @param E Estado de la partida
+ * @param I Instantánea
+ */
+void restauraInstantanea(EstadoJuego &E, const Instantanea &I) {
+    int celdas = 0;
+    uint64_t resto = I.bits[3] >> (2 * COLUMNAS);
+    for (int w = 0; w < 3; ++w) {
+        resto |= (I.bits[w] >> 60) << (RESTO_ULTIMA + 4 * w);
+        for (int i = 0; i < FILAS_PALABRA; ++i) {
+            E.T.fila[w * FILAS_PALABRA + i] = Fila((I.bits[w] >> (i * COLUMNAS)) & FILA_LLENA);
+        }
+    }
+    E.T.fila[FILAS - 2] = Fila(I.bits[3] & FILA_LLENA);
+    E.T.fila[FILAS - 1] = Fila((I.bits[3] >> COLUMNAS) & FILA_LLENA);
+    for (int f = 0; f < FILAS; ++f) {
+        Fila fila = E.T.fila[f];
+        celdas += cuentaBits(fila);
+        memcpy(E.T.color[f], COLORES.c[fila & 0xFF], 8);
+        memcpy(E.T.color[f] + 8, COLORES.c[fila >> 8], COLUMNAS - 8);
+    }
+
+    E.P.tipo = int(campo(resto, BIT_TIPO, ANCHO_TIPO));
+    E.P.rot = int(campo(resto, BIT_ROT, ANCHO_ROT));
+    E.P.abs.x = int(campo(resto, BIT_X, ANCHO_X));
+    E.P.abs.y = int(campo(resto, BIT_Y, ANCHO_Y));
+    E.level = int(campo(resto, BIT_NIVEL, ANCHO_NIVEL));
+    E.frame = int(campo(resto, BIT_FRAME, ANCHO_FRAME));
+    E.fin = Fin(campo(resto, BIT_FIN, ANCHO_FIN));
+    E.ptos = int(campo(resto, BIT_PUNTOS, ANCHO_PUNTOS)) * 100;
+    E.lineas = int(campo(resto, BIT_LINEAS, ANCHO_LINEAS));
+
+    // Cada pieza fijada pone 4 celdas y cada fila quitada se lleva COLUMNAS
+    E.piezas = (celdas + E.lineas * COLUMNAS) / 4;
+    // Tras iniciarJuego hay vista + 1 piezas generadas y cada pieza fijada genera otra
+    situarAzar(E.azar, uint32_t(E.azar.vista + 1 + E.piezas));
+}
+
+/**
+ * @brief Escribe un fichero y lo sustituye de forma atómica.
+ * @post Escribe en fichero.tmp, lo sincroniza con el disco y lo renombra
+ * @param fichero Ruta del fichero
+ * @param datos Contenido
+ * @param n Bytes
+ * @return bool -> true: el fichero nuevo está en el disco
+ */
+bool escribeAtomico(const char *fichero, const unsigned char *datos, size_t n) {
+    std::string temporal = std::string(fichero) + ".tmp";
+    FILE *f = fopen(temporal.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(datos, 1, n, f) == n && fflush(f) == 0;
+#if defined(_WIN32)
+    ok = ok && _commit(_fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    ok = ok && MoveFileExA(temporal.c_str(), fichero, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    ok = ok && fsync(fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    ok = ok && rename(temporal.c_str(), fichero) == 0;
+    if (ok) {
+        // Sincroniza el directorio para que el renombrado sobreviva a un corte
+        std::string dir(fichero);
+        size_t barra = dir.find_last_of('/');
+        dir = barra == std::string::npos ? "." : barra == 0 ? "/" : dir.substr(0, barra);
+        int d = open(dir.c_str(), O_RDONLY);
+        if (d >= 0) {
+            fsync(d);
+            close(d);
+        }
+    }
+#endif
+    if (!ok) remove(temporal.c_str());
+    return ok;
+}
+
+/**
+ * @brief Guarda un punto de control de la partida en disco.
+ * @post El fichero tiene el punto anterior o el nuevo aunque el proceso se corte
+ * @param fichero Ruta del punto de control
+ * @param E Estado de la partida
+ * @return bool -> true: se ha guardado
+ */
+bool guardaPuntoControl(const char *fichero, const EstadoJuego &E) {
+    unsigned char datos[TAM_PUNTO_CONTROL] = {'T', 'T', 'P', 'C', 1, (unsigned char) E.azar.modo,
+                                              (unsigned char) E.azar.vista, (unsigned char) E.sinFin};
+    Instantanea I;
+    guardaInstantanea(E, I);
+    for (int i = 0; i < 8; ++i) datos[8 + i] = (unsigned char) (E.azar.semilla >> (8 * i));
+    for (int w = 0; w < 4; ++w) {
+        for (int i = 0; i < 8; ++i) datos[16 + 8 * w + i] = (unsigned char) (I.bits[w] >> (8 * i));
+    }
+    return escribeAtomico(fichero, datos, sizeof(datos));
+}
+
+/**
+ * @brief Carga un punto de control guardado con guardaPuntoControl.
+ * @param fichero Ruta del punto de control
+ * @param E Estado de la partida (se reemplaza)
+ * @return bool -> true: se ha cargado; false: no existe o no es válido
+ */
+bool cargaPuntoControl(const char *fichero, EstadoJuego &E) {
+    unsigned char datos[TAM_PUNTO_CONTROL];
+    FILE *f = fopen(fichero, "rb");
+    if (!f) return false;
+    bool ok = fread(datos, 1, sizeof(datos), f) == sizeof(datos) && fgetc(f) == EOF;
+    fclose(f);
+    if (!ok || memcmp(datos, "TTPC", 4) != 0 || datos[4] != 1 || datos[5] > AZAR_BOLSA || datos[7] > 1) return false;
+
+    uint64_t semilla = 0;
+    Instantanea I;
+    for (int i = 0; i < 8; ++i) semilla |= uint64_t(datos[8 + i]) << (8 * i);
+    for (int w = 0; w < 4; ++w) {
+        I.bits[w] = 0;
+        for (int i = 0; i < 8; ++i) I.bits[w] |= uint64_t(datos[16 + 8 * w + i]) << (8 * i);
+    }
+    iniciarJuego(E, semilla, ModoAzar(datos[5]), datos[6], datos[7] != 0);
+    restauraInstantanea(E, I);
+    return true;
+}
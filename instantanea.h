@@ -0,0 +1,53 @@
+/**
+ * @file instantanea.h
+ * @brief Instantáneas de 32 bytes del estado de una partida
+ *
+ * Una Instantanea guarda en 256 bits todo lo que hace falta para continuar una
+ * partida de forma idéntica:
+ * - 200 bits: la ocupación del tablero, 10 bits por fila, seis filas en cada
+ *   una de las tres primeras palabras y las dos últimas en la cuarta.
+ * - 14 bits: tipo, rotación y posición de la pieza actual.
+ * - 42 bits: nivel, frames desde la última caída, fin, puntos / 100 y filas quitadas.
+ *
+ * Estos 56 bits van en los 4 bits altos de las tres primeras palabras y en los
+ * 44 altos de la cuarta, así que cada fila se extrae con un solo desplazamiento.
+ *
+ * El resto se deduce: las piezas fijadas salen de las celdas ocupadas y las
+ * filas quitadas (cada pieza pone 4 celdas y cada fila quita COLUMNAS), y la
+ * cola de piezas siguientes sale del generador situado en esa pieza. La
+ * semilla, el modo y la vista son de la partida, no del instante, y no se guardan.
+ *
+ * No se guarda el plano de color: al restaurar, las celdas ocupadas toman
+ * COLOR_RESTAURADO. Solo afecta a cómo se pinta el tablero, no a las reglas.
+ *
+ * Los puntos de control en disco añaden una cabecera con la semilla, el modo,
+ * la vista y si la partida es sin fin (48 bytes en total) y se escriben en un fichero temporal que se
+ * sincroniza y se renombra, así que un corte deja el anterior o el nuevo, nunca
+ * uno a medias.
+ */
+
+#ifndef _INSTANTANEA_H_
+#define _INSTANTANEA_H_
+
+#include "juego.h"
+#include <cstddef>
+
+const int COLOR_RESTAURADO = 7; ///< Color de las celdas restauradas (BLANCO en miniwin)
+
+/** @struct Instantanea
+ *  @brief Estado de una partida empaquetado en 32 bytes.
+ */
+struct Instantanea {
+    uint64_t bits[4]; ///< Filas del tablero y, en los bits libres, el resto del estado
+};
+
+static_assert(sizeof(Instantanea) == 32, "La instantánea debe ocupar 32 bytes");
+
+void guardaInstantanea(const EstadoJuego &E, Instantanea &I);
+void restauraInstantanea(EstadoJuego &E, const Instantanea &I);
+
+bool escribeAtomico(const char *fichero, const unsigned char *datos, size_t n);
+bool guardaPuntoControl(const char *fichero, const EstadoJuego &E);
+bool cargaPuntoControl(const char *fichero, EstadoJuego &E);
+
+#endif
@@ -0,0 +1,19 @@
+/**
+ * @file juego.cpp
+ * @brief Motor del juego Tetris sin interfaz
+ *
+ * Las reglas son plantillas en juego.h; aquí están las tablas de niveles y la
+ * instancia de la partida estándar.
+ *
+ * @see juego.h
+ */
+
+#include "juego.h"
+
+const int PUNTOS_NIVEL[NIVELES] = {0, 100, 300, 600, 1000, 1500, 2000};
+
+const int VELOCIDAD_NIVEL[NIVELES] = {30, 25, 20, 15, 10, 5, 1};
+
+template void iniciarJuego(EstadoJuego &E, uint64_t semilla, ModoAzar modo, int vista, bool sinFin);
+template int paso(EstadoJuego &E, Accion a);
+template int colocaPieza(EstadoJuego &E, const Pieza &P);
@@ -0,0 +1,298 @@
+/**
+ * @file juego.h
+ * @brief Motor del juego Tetris sin interfaz
+ *
+ * Todo el estado de una partida vive en EstadoJuego y avanza un frame cada vez
+ * que se llama a paso() con la acción del jugador en ese frame. Las reglas son
+ * las del bucle principal original: gravedad por frames según VELOCIDAD_NIVEL,
+ * puntuación 100/300/500/800 y subida de nivel según PUNTOS_NIVEL.
+ *
+ * No depende de miniwin, Windows.h ni winmm, así que puede simularse sin pantalla.
+ *
+ * El estado y las reglas son plantillas sobre las dimensiones del tablero
+ * (EstadoJuegoDe); EstadoJuego es la partida estándar de FILAS x COLUMNAS y se
+ * instancia una sola vez en juego.cpp, con los núcleos especializados de tablero.h.
+ */
+
+#ifndef _JUEGO_H_
+#define _JUEGO_H_
+
+#include "azar.h"
+
+const int NIVELES = 7; ///< Número de niveles; alcanzar el último gana la partida
+
+/**
+ * @brief Puntos necesarios para alcanzar cada nivel
+ * @post Los puntos necesarios para alcanzar cada nivel son:
+ * - Nivel 1: 0 puntos
+ * - Nivel 2: 100 puntos
+ * - Nivel 3: 300 puntos
+ * - Nivel 4: 600 puntos
+ * - Nivel 5: 1000 puntos
+ * - Nivel 6: 1500 puntos
+ * - Nivel 7: 2000 puntos
+ */
+extern const int PUNTOS_NIVEL[NIVELES];
+
+/**
+ * @brief Velocidad de caída de la pieza en cada nivel
+ * @post Número de frames que tarda la pieza en bajar una posición:
+ * - Nivel 1: 30 frames por posición
+ * - Nivel 2: 25 frames por posición
+ * - Nivel 3: 20 frames por posición
+ * - Nivel 4: 15 frames por posición
+ * - Nivel 5: 10 frames por posición
+ * - Nivel 6: 5 frames por posición
+ * - Nivel 7: 1 frame por posición
+ */
+extern const int VELOCIDAD_NIVEL[NIVELES];
+
+/** @enum Accion
+ *  @brief Entrada del jugador en un frame.
+ */
+enum Accion {
+    NADA, ///< Sin tecla: solo actúa la gravedad
+    ROTAR_DERECHA, ///< ARRIBA o 'Z'
+    ROTAR_IZQUIERDA, ///< 'X'
+    BAJAR, ///< ABAJO
+    MOVER_IZQUIERDA, ///< IZQUIERDA
+    MOVER_DERECHA ///< DERECHA
+};
+
+const int ACCIONES = 6; ///< Número de valores de Accion
+
+/** @enum Fin
+ *  @brief Estado de finalización de la partida.
+ */
+enum Fin {
+    EN_JUEGO, ///< La partida sigue
+    GAME_OVER, ///< La pieza nueva colisiona al aparecer
+    VICTORIA ///< Se ha alcanzado el último nivel
+};
+
+/** @enum Cambio
+ *  @brief Indicadores devueltos por paso() sobre lo ocurrido en el frame.
+ */
+enum Cambio {
+    CAMBIO_PIEZA = 1, ///< Se ha aplicado una acción o la gravedad: hay que repintar
+    CAMBIO_FIJADA = 2, ///< La pieza se ha fijado en el tablero
+    CAMBIO_LINEAS = 4, ///< Se han quitado filas llenas
+    CAMBIO_FIN = 8 ///< La partida ha terminado (ver EstadoJuego::fin)
+};
+
+/** @struct EstadoJuegoDe
+ *  @brief Estado completo de una partida en un tablero de ALTO x ANCHO.
+ */
+template <int ANCHO, int ALTO>
+struct EstadoJuegoDe {
+    TableroDe<ANCHO, ALTO> T; ///< Tablero del juego
+    Pieza P; ///< Pieza actual en juego
+    int ptos; ///< Puntos actuales del jugador
+    int level; ///< Nivel actual del juego (desde 1)
+    int frame; ///< Frames desde la última caída por gravedad
+    int lineas; ///< Filas quitadas en toda la partida
+    int piezas; ///< Piezas fijadas en toda la partida
+    Fin fin; ///< Estado de finalización
+    bool sinFin; ///< Sin VICTORIA: el nivel se queda en el penúltimo y solo se acaba por GAME_OVER
+    Aleatorizador azar; ///< Generador de piezas y cola de piezas siguientes
+};
+
+typedef EstadoJuegoDe<COLUMNAS, FILAS> EstadoJuego; ///< Partida en el tablero estándar
+
+/**
+ * @brief Saca la siguiente pieza en su posición de aparición.
+ * @param E Estado de la partida
+ */
+template <int ANCHO, int ALTO>
+void sacaPieza(EstadoJuegoDe<ANCHO, ALTO> &E) {
+    pieza_nueva(E.P, E.azar);
+    if (ANCHO != COLUMNAS) E.P.abs = inicioPieza(ANCHO);
+}
+
+/**
+ * @brief Prepara una partida nueva
+ * @post Tablero vacío, pieza actual en INICIO, piezas siguientes en la cola, nivel 1 y 0 puntos
+ * @post La misma semilla y el mismo modo dan siempre la misma secuencia de piezas
+ * @param E Estado de la partida
+ * @param semilla Semilla del generador de piezas de la partida
+ * @param modo Forma de repartir las piezas
+ * @param vista Piezas siguientes visibles
+ * @param sinFin true: partida sin VICTORIA (para medir cuánto aguanta un jugador)
+ */
+template <int ANCHO, int ALTO>
+void iniciarJuego(EstadoJuegoDe<ANCHO, ALTO> &E, uint64_t semilla, ModoAzar modo = AZAR_PURO, int vista = 1,
+                  bool sinFin = false) {
+    iniciarAzar(E.azar, semilla, modo, vista);
+    vaciarTablero(E.T);
+    sacaPieza(E);
+    E.ptos = 0;
+    E.level = 1;
+    E.frame = 0;
+    E.lineas = 0;
+    E.piezas = 0;
+    E.fin = EN_JUEGO;
+    E.sinFin = sinFin;
+}
+
+/**
+ * @brief Puntos obtenidos al quitar varias filas de una vez
+ * @param cont Filas quitadas (0..4)
+ * @return int -> Puntos: 100, 300, 500 u 800
+ */
+inline int puntosFilas(int cont) {
+    switch (cont) {
+        case 1:
+            return 100;
+        case 2:
+            return 300;
+        case 3:
+            return 500;
+        case 4:
+            return 800;
+    }
+    return 0;
+}
+
+/**
+ * @brief Fija la pieza actual en el tablero
+ * @post Quita filas, suma puntos, sube de nivel y saca la siguiente pieza
+ * @param E Estado de la partida
+ * @return int -> Combinación de indicadores Cambio
+ */
+template <int ANCHO, int ALTO>
+int fijaPieza(EstadoJuegoDe<ANCHO, ALTO> &E) {
+    insertaPieza(E.T, E.P);
+    E.piezas++;
+    int cambios = CAMBIO_FIJADA;
+
+    // Se cuentan y eliminan las filas llenas, y se actualizan los puntos y nivel
+    int cont = cuentaFila(E.T);
+    if (cont > 0) {
+        E.lineas += cont;
+        E.ptos += puntosFilas(cont);
+        cambios |= CAMBIO_LINEAS;
+    }
+    if (E.level < (E.sinFin ? NIVELES - 1 : NIVELES) && PUNTOS_NIVEL[E.level] <= E.ptos) {
+        E.level++;
+    }
+
+    // Se obtiene una nueva pieza para continuar el juego
+    sacaPieza(E);
+
+    // Si la nueva pieza colisiona con el tablero, el jugador pierde
+    if (colisionPieza(E.T, E.P)) {
+        E.fin = GAME_OVER;
+        cambios |= CAMBIO_FIN;
+    }
+    return cambios;
+}
+
+/**
+ * @brief Indica si a la gravedad le toca bajar la pieza.
+ * @post paso() solo la aplica en un frame sin acción
+ * @param E Estado de la partida
+ * @return bool -> true: un paso() con NADA baja la pieza
+ */
+template <int ANCHO, int ALTO>
+inline bool tocaGravedad(const EstadoJuegoDe<ANCHO, ALTO> &E) {
+    return E.fin == EN_JUEGO && E.level < NIVELES && E.frame > VELOCIDAD_NIVEL[E.level - 1];
+}
+
+/**
+ * @brief Avanza la partida un frame
+ * @post Aplica la acción (o la gravedad si no hay acción y ha pasado el tiempo),
+ *       deshace el movimiento si colisiona y, si la colisión era hacia abajo,
+ *       fija la pieza, quita filas, suma puntos, sube de nivel y saca la siguiente pieza.
+ * @param E Estado de la partida
+ * @param a Acción del jugador en este frame
+ * @return int -> Combinación de indicadores Cambio
+ */
+template <int ANCHO, int ALTO>
+int paso(EstadoJuegoDe<ANCHO, ALTO> &E, Accion a) {
+    if (E.fin != EN_JUEGO) return CAMBIO_FIN;
+
+    // Si el jugador alcanza el nivel máximo, gana el juego
+    if (E.level == NIVELES) {
+        E.fin = VICTORIA;
+        return CAMBIO_FIN;
+    }
+
+    // Si ha pasado el tiempo necesario, la pieza cae automáticamente
+    if (a == NADA && E.frame > VELOCIDAD_NIVEL[E.level - 1]) {
+        E.frame = 0;
+        a = BAJAR;
+    }
+
+    int cambios = 0;
+    if (a != NADA) cambios |= CAMBIO_PIEZA;
+
+    Pieza copia = E.P;
+
+    // Actualiza la posición de la pieza según la acción
+    switch (a) {
+        case ROTAR_DERECHA:
+            rota_derecha(E.P);
+            break;
+        case ROTAR_IZQUIERDA:
+            rota_izquierda(E.P);
+            break;
+        case BAJAR:
+            E.P.abs.y++;
+            break;
+        case MOVER_IZQUIERDA:
+            E.P.abs.x--;
+            break;
+        case MOVER_DERECHA:
+            E.P.abs.x++;
+            break;
+        case NADA:
+            break;
+    }
+
+    // Si la pieza colisiona con el tablero, se restaura su posición original
+    if (a != NADA && colisionPieza(E.T, E.P)) {
+        E.P = copia;
+
+        // Si la colisión es hacia abajo, la pieza se inserta en el tablero
+        if (a == BAJAR) cambios |= fijaPieza(E);
+    }
+
+    E.frame++;
+    return cambios;
+}
+
+/**
+ * @brief Coloca la pieza actual directamente en su posición de bloqueo
+ * @pre P es una posición de bloqueo alcanzable desde E.P (uno de los destinos
+ *      de generaMovimientos), así que el resultado es el mismo que llevarla con paso()
+ * @post Fija la pieza como paso() y deja la gravedad a cero para la siguiente.
+ *       Si se alcanza el último nivel la partida termina ya con VICTORIA.
+ * @param E Estado de la partida
+ * @param P Pieza en su posición de bloqueo
+ * @return int -> Combinación de indicadores Cambio
+ */
+template <int ANCHO, int ALTO>
+int colocaPieza(EstadoJuegoDe<ANCHO, ALTO> &E, const Pieza &P) {
+    if (E.fin != EN_JUEGO) return CAMBIO_FIN;
+    if (E.level == NIVELES) {
+        E.fin = VICTORIA;
+        return CAMBIO_FIN;
+    }
+    E.P = P;
+    E.frame = 0;
+    int cambios = CAMBIO_PIEZA | fijaPieza(E);
+
+    // Sin frames entre colocaciones, la victoria se decide ya y no en la siguiente llamada
+    if (E.fin == EN_JUEGO && E.level == NIVELES) {
+        E.fin = VICTORIA;
+        cambios |= CAMBIO_FIN;
+    }
+    return cambios;
+}
+
+// La partida estándar se compila una vez, en juego.cpp
+extern template void iniciarJuego(EstadoJuego &E, uint64_t semilla, ModoAzar modo, int vista, bool sinFin);
+extern template int paso(EstadoJuego &E, Accion a);
+extern template int colocaPieza(EstadoJuego &E, const Pieza &P);
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ * @file libro.cpp
+ * @brief Libro de aperturas: colocaciones ya calculadas para el principio de la partida
+ *
+ * @see libro.h
+ */
+
+#include "libro.h"
+#include "bot.h"
+#include "instantanea.h"
+#include <cstring>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Clave de una posición del libro.
+ * @param T Ocupación del tablero
+ * @param actual Tipo de la pieza por colocar
+ * @param siguiente Tipo de la pieza siguiente
+ * @return uint64_t -> Clave (nunca 0, que marca los huecos libres)
+ */
+uint64_t claveLibro(const Ocupacion &T, int actual, int siguiente) {
+    uint64_t k = claveTablero(T) ^ ZOBRIST.pieza[actual] ^ ZOBRIST.siguiente[siguiente];
+    return k != 0 ? k : 1;
+}
+
+/**
+ * @brief Añade un entero little-endian a un buffer.
+ * @param datos Buffer
+ * @param v Valor
+ * @param bytes Bytes del valor
+ */
+static void pon(std::vector<unsigned char> &datos, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) datos.push_back((unsigned char) (v >> (8 * i)));
+}
+
+/**
+ * @brief Escribe un libro.
+ * @post La capacidad es al menos el doble de las entradas, así que casi todas
+ *       las consultas miran un solo hueco. Si una clave se repite, vale la última.
+ *       El fichero se sustituye de forma atómica (escribeAtomico).
+ * @param fichero Ruta del libro
+ * @param entradas Posiciones y jugadas
+ * @return bool -> true: escrito
+ */
+bool escribeLibro(const char *fichero, const std::vector<EntradaLibro> &entradas) {
+    uint32_t capacidad = 16;
+    while (capacidad < 2 * entradas.size()) capacidad *= 2;
+    const uint32_t mascara = capacidad - 1;
+    std::vector<uint64_t> claves(capacidad, 0);
+    std::vector<uint16_t> jugadas(capacidad, 0);
+    uint32_t n = 0;
+    for (const EntradaLibro &e : entradas) {
+        uint32_t i = uint32_t(e.clave) & mascara;
+        while (claves[i] != 0 && claves[i] != e.clave) i = (i + 1) & mascara;
+        n += claves[i] == 0;
+        claves[i] = e.clave;
+        jugadas[i] = e.jugada;
+    }
+
+    std::vector<unsigned char> datos;
+    datos.reserve(CABECERA_LIBRO + size_t(capacidad) * 10);
+    datos.insert(datos.end(), {'T', 'L', 'I', 'B'});
+    pon(datos, VERSION_LIBRO, 2);
+    pon(datos, 0, 2);
+    pon(datos, capacidad, 4);
+    pon(datos, n, 4);
+    for (uint64_t k : claves) pon(datos, k, 8);
+    for (uint16_t j : jugadas) pon(datos, j, 2);
+    return escribeAtomico(fichero, datos.data(), datos.size());
+}
+
+/**
+ * @brief Proyecta un libro en memoria.
+ * @post Las claves y jugadas se leen directamente de la proyección, así que el
+ *       formato little-endian debe coincidir con el del sistema
+ * @post Cuenta las claves de la tabla: un libro cuyas claves no ocupadas no
+ *       coinciden con la cabecera, o sin ningún hueco libre, se rechaza
+ * @param L Libro (se cierra antes si estaba abierto; un LibroAperturas nuevo empieza cerrado)
+ * @param fichero Ruta del libro
+ * @return bool -> true: abierto y con una cabecera válida
+ */
+bool abreLibro(LibroAperturas &L, const char *fichero) {
+    cierraLibro(L);
+#if defined(_WIN32)
+    HANDLE f = CreateFileA(fichero, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER tam;
+    HANDLE m = GetFileSizeEx(f, &tam) ? CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(f);
+    if (m == nullptr) return false;
+    L.mapa = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(m);
+    L.bytes = size_t(tam.QuadPart);
+#else
+    int fd = open(fichero, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            L.mapa = p;
+            L.bytes = size_t(st.st_size);
+        }
+    }
+    close(fd);
+#endif
+    if (L.mapa == nullptr) return false;
+
+    const unsigned char *d = static_cast<const unsigned char *>(L.mapa);
+    uint32_t capacidad = 0, entradas = 0;
+    if (L.bytes >= CABECERA_LIBRO) {
+        memcpy(&capacidad, d + 8, 4);
+        memcpy(&entradas, d + 12, 4);
+    }
+    bool valido = L.bytes >= CABECERA_LIBRO && memcmp(d, "TLIB", 4) == 0 && d[4] == VERSION_LIBRO && d[5] == 0 &&
+                  capacidad > 0 && (capacidad & (capacidad - 1)) == 0 &&
+                  L.bytes == CABECERA_LIBRO + size_t(capacidad) * 10 && entradas < capacidad;
+    if (!valido) {
+        cierraLibro(L);
+        return false;
+    }
+    L.claves = reinterpret_cast<const uint64_t *>(d + CABECERA_LIBRO);
+    L.jugadas = reinterpret_cast<const uint16_t *>(d + CABECERA_LIBRO + size_t(capacidad) * 8);
+    L.mascara = capacidad - 1;
+    L.entradas = entradas;
+
+    // Un fichero dañado o ajeno podría no tener huecos libres y dejar sin fin el sondeo
+    uint32_t ocupadas = 0;
+    for (uint32_t i = 0; i < capacidad; ++i) ocupadas += L.claves[i] != 0;
+    if (ocupadas != entradas) {
+        cierraLibro(L);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Libera la proyección de un libro.
+ * @param L Libro
+ */
+void cierraLibro(LibroAperturas &L) {
+    if (L.mapa != nullptr) {
+#if defined(_WIN32)
+        UnmapViewOfFile(L.mapa);
+#else
+        munmap(L.mapa, L.bytes);
+#endif
+    }
+    L.mapa = nullptr;
+    L.bytes = 0;
+    L.claves = nullptr;
+    L.jugadas = nullptr;
+    L.mascara = 0;
+    L.entradas = 0;
+}
+
+/**
+ * @brief Busca una posición en el libro.
+ * @post Mira como mucho toda la tabla, aunque no tenga huecos libres
+ * @param L Libro abierto
+ * @param clave claveLibro de la posición
+ * @param jugada Jugada guardada
+ * @return bool -> true: la posición está en el libro
+ */
+bool consultaLibro(const LibroAperturas &L, uint64_t clave, uint16_t &jugada) {
+    if (L.mapa == nullptr) return false;
+    uint32_t i = uint32_t(clave) & L.mascara;
+    for (uint64_t n = 0; n <= L.mascara; ++n, i = (i + 1) & L.mascara) {
+        uint64_t k = L.claves[i];
+        if (k == clave) {
+            jugada = L.jugadas[i];
+            return true;
+        }
+        if (k == 0) return false;
+    }
+    return false;
+}
+
+/**
+ * @brief Destino que indica el libro para la pieza actual.
+ * @post Solo genera los movimientos si la posición está en el libro, y comprueba
+ *       que la colocación guardada es alcanzable desde P (G queda con sus destinos)
+ * @param L Libro abierto
+ * @param G Memoria de la búsqueda de movimientos
+ * @param T Ocupación del tablero
+ * @param P Pieza actual
+ * @param siguiente Tipo de la pieza siguiente
+ * @return int -> Índice del destino en G.destino, o -1 si el libro no tiene la posición
+ */
+int destinoLibro(const LibroAperturas &L, GeneradorMovimientos &G, const Ocupacion &T, const Pieza &P,
+                 int siguiente) {
+    uint16_t j;
+    if (!consultaLibro(L, claveLibro(T, P.tipo, siguiente), j)) return -1;
+    Pieza C = {{(j >> 2) & 31, j >> 7}, P.tipo, j & 3};
+    int n = generaMovimientos(G, T, P);
+    for (int i = 0; i < n; ++i) {
+        if (mismasCeldas(G.destino[i].P, C)) return i;
+    }
+    return -1;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file libro.h
+ * @brief Libro de aperturas: colocaciones ya calculadas para el principio de la partida
+ *
+ * Todas las partidas empiezan con el tablero vacío, así que las primeras
+ * búsquedas del bot se repiten en cada partida. El libro guarda, para cada
+ * posición (clave Zobrist del tablero, pieza actual y siguiente), la colocación
+ * que se debe jugar. Lo construye la herramienta aperturas; en juego basta con
+ * una consulta antes de buscar.
+ *
+ * Formato del fichero (enteros little-endian, se proyecta en memoria tal cual):
+ * - Cabecera (16 bytes): "TLIB", versión (2), 2 bytes libres, capacidad (4,
+ *   potencia de 2) y entradas (4).
+ * - Claves: capacidad palabras de 64 bits; 0 es un hueco libre. Es una tabla
+ *   con direccionamiento abierto: la clave k está en k & (capacidad - 1) o en
+ *   los huecos siguientes hasta el primero libre.
+ * - Jugadas: capacidad valores de 16 bits (codificaJugada) en las mismas posiciones.
+ */
+
+#ifndef _LIBRO_H_
+#define _LIBRO_H_
+
+#include "movimientos.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const int VERSION_LIBRO = 1; ///< Versión del formato
+const size_t CABECERA_LIBRO = 16; ///< Bytes de la cabecera
+
+/** @struct EntradaLibro
+ *  @brief Posición y jugada, para construir un libro.
+ */
+struct EntradaLibro {
+    uint64_t clave; ///< claveLibro de la posición
+    uint16_t jugada; ///< codificaJugada de la colocación
+};
+
+/** @struct LibroAperturas
+ *  @brief Libro proyectado en memoria (solo lectura).
+ */
+struct LibroAperturas {
+    void *mapa = nullptr; ///< Proyección del fichero (nullptr: cerrado)
+    size_t bytes = 0; ///< Tamaño de la proyección
+    const uint64_t *claves = nullptr; ///< Tabla de claves
+    const uint16_t *jugadas = nullptr; ///< Jugada de cada clave
+    uint32_t mascara = 0; ///< Capacidad - 1
+    uint32_t entradas = 0; ///< Posiciones guardadas
+};
+
+uint64_t claveLibro(const Ocupacion &T, int actual, int siguiente);
+bool escribeLibro(const char *fichero, const std::vector<EntradaLibro> &entradas);
+bool abreLibro(LibroAperturas &L, const char *fichero);
+void cierraLibro(LibroAperturas &L);
+bool consultaLibro(const LibroAperturas &L, uint64_t clave, uint16_t &jugada);
+int destinoLibro(const LibroAperturas &L, GeneradorMovimientos &G, const Ocupacion &T, const Pieza &P, int siguiente);
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * @file lotes.cpp
+ * @brief Mide el cálculo de rasgos por lotes frente al de un tablero cada vez
+ *
+ * Uso: lotes [--tableros N] [--repeticiones R] [--semilla S]
+ *
+ * Reúne N tableros reales (100000 por defecto): todos los tableros candidatos que
+ * valora el bot, ya sin filas llenas, en partidas jugadas con mejorDestino. Calcula
+ * sus rasgos R veces (20) con cada método y muestra una línea por método:
+ *
+ *     metodo ns/tablero aceleracion
+ *
+ * donde la aceleración es respecto al bucle de calculaRasgos. Antes comprueba que
+ * todos los núcleos dan exactamente los mismos rasgos que rasgosReferencia, y los
+ * de calculaRasgos que este comparte.
+ */
+
+#include "bot.h"
+#include "rasgos.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Reúne los tableros candidatos de partidas del bot.
+ * @param n Tableros a reunir
+ * @param semilla Semilla de la primera partida
+ * @return vector<Ocupacion> -> n tableros
+ */
+static vector<Ocupacion> reuneTableros(size_t n, uint64_t semilla) {
+    vector<Ocupacion> tableros;
+    tableros.reserve(n);
+    unique_ptr<GeneradorMovimientos> G(new GeneradorMovimientos);
+    EstadoJuego E;
+    iniciarJuego(E, semilla);
+    while (tableros.size() < n) {
+        int d = mejorDestino(*G, E.T, E.P, PESOS_DEFECTO);
+        if (d < 0 || E.fin != EN_JUEGO) {
+            iniciarJuego(E, ++semilla);
+            continue;
+        }
+        for (int i = 0; i < G->destinos && tableros.size() < n; ++i) {
+            const Pieza &C = G->destino[i].P;
+            Ocupacion copia = E.T;
+            INSERCION[C.tipo][C.rot](copia, C.abs.x, C.abs.y);
+            cuentaFila(copia);
+            tableros.push_back(copia);
+        }
+        colocaPieza(E, G->destino[d].P);
+    }
+    return tableros;
+}
+
+/**
+ * @brief Compara dos rasgos.
+ * @return bool -> true: idénticos
+ */
+static bool iguales(const RasgosTablero &a, const RasgosTablero &b) {
+    return memcmp(a.alturas, b.alturas, sizeof(a.alturas)) == 0 && a.altura == b.altura && a.maxima == b.maxima &&
+           a.huecos == b.huecos && a.transiciones == b.transiciones && a.pozos == b.pozos &&
+           a.rugosidad == b.rugosidad;
+}
+
+/**
+ * @brief Mide una función repetida R veces.
+ * @param R Repeticiones
+ * @param n Tableros por repetición
+ * @param f Función a medir
+ * @return double -> Nanosegundos por tablero
+ */
+template <class F> static double mide(int R, size_t n, F f) {
+    auto inicio = chrono::steady_clock::now();
+    for (int r = 0; r < R; ++r) f();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - inicio).count() / (double(R) * n);
+}
+
+int main(int argc, char *argv[]) {
+    static const char *NOMBRES[] = {"auto", "escalar", "sse4.1", "avx2"};
+    size_t n = 100000;
+    int repeticiones = 20;
+    uint64_t semilla = 1;
+    for (int i = 1; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--tableros") == 0 && valor) n = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--repeticiones") == 0 && valor) repeticiones = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) semilla = strtoull(argv[++i], nullptr, 10);
+        else {
+            cerr << "Uso: " << argv[0] << " [--tableros N] [--repeticiones R] [--semilla S]" << endl;
+            return 1;
+        }
+    }
+    if (n < 1) n = 1;
+    if (repeticiones < 1) repeticiones = 1;
+
+    vector<Ocupacion> tableros = reuneTableros(n, semilla);
+    LoteTableros L;
+    iniciarLote(L, n);
+    for (const Ocupacion &T : tableros) anadeTablero(L, T);
+
+    vector<RasgosTablero> referencia(n);
+    for (size_t i = 0; i < n; ++i) {
+        rasgosReferencia(tableros[i], referencia[i]);
+        Rasgos R;
+        calculaRasgos(tableros[i], R);
+        if (R.altura != referencia[i].altura || R.huecos != referencia[i].huecos ||
+            R.rugosidad != referencia[i].rugosidad) {
+            cerr << "calculaRasgos no coincide con la referencia en el tablero " << i << endl;
+            return 1;
+        }
+    }
+
+    NucleoRasgos mejor = nucleoRasgos();
+    cerr << n << " tableros, nucleo de la CPU: " << NOMBRES[mejor] << endl;
+    RasgosLote R;
+    for (int k = NUCLEO_ESCALAR; k <= mejor; ++k) {
+        calculaRasgosLote(L, R, NucleoRasgos(k));
+        for (size_t i = 0; i < n; ++i) {
+            RasgosTablero T;
+            rasgosDeLote(R, L, i, T);
+            if (!iguales(T, referencia[i])) {
+                cerr << "El nucleo " << NOMBRES[k] << " no coincide con la referencia en el tablero " << i << endl;
+                return 1;
+            }
+        }
+    }
+
+    // Las sumas impiden que el compilador quite los cálculos
+    volatile long suma = 0;
+    double base = mide(repeticiones, n, [&] {
+        long s = 0;
+        for (const Ocupacion &T : tableros) {
+            Rasgos X;
+            calculaRasgos(T, X);
+            s += X.altura + X.huecos + X.rugosidad;
+        }
+        suma = suma + s;
+    });
+    double ref = mide(repeticiones, n, [&] {
+        long s = 0;
+        for (const Ocupacion &T : tableros) {
+            RasgosTablero X;
+            rasgosReferencia(T, X);
+            s += X.altura + X.huecos + X.rugosidad;
+        }
+        suma = suma + s;
+    });
+    printf("referencia %.2f %.2f\n", ref, base / ref);
+    printf("calculaRasgos %.2f 1.00\n", base);
+    for (int k = NUCLEO_ESCALAR; k <= mejor; ++k) {
+        double t = mide(repeticiones, n, [&] {
+            calculaRasgosLote(L, R, NucleoRasgos(k));
+            suma = suma + R.huecos[0];
+        });
+        printf("lote_%s %.2f %.2f\n", NOMBRES[k], t, base / t);
+    }
+    return 0;
+}
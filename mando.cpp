@@ -0,0 +1,86 @@
+/**
+ * @file mando.cpp
+ * @brief Repetición de los movimientos con las teclas mantenidas (DAS/ARR)
+ *
+ * @see mando.h
+ */
+
+#include "mando.h"
+
+/**
+ * @brief Prepara un mando sin teclas mantenidas.
+ * @param M Mando
+ * @param das Ticks hasta la primera repetición (al menos 1)
+ * @param arr Ticks entre repeticiones (al menos 1)
+ */
+void iniciarMando(Mando &M, int das, int arr) {
+    M.das = das < 1 ? 1 : das;
+    M.arr = arr < 1 ? 1 : arr;
+    M.direccion = 0;
+    M.movidas = 0;
+    M.espera = 0;
+    M.bajando = false;
+    M.esperaBajada = 0;
+    M.toques[0] = M.toques[1] = M.toques[2] = 0;
+}
+
+/**
+ * @brief Acción del jugador en este tick.
+ * @post Va primero la rotación; después, una pulsación pendiente (la de la
+ *       dirección mantenida antes), que arranca el DAS de su dirección; después
+ *       la repetición de la dirección mantenida cuando toca y, si no, la bajada.
+ *       Lo que no cabe en este tick queda para el siguiente. Las repeticiones
+ *       ceden el frame a la gravedad cuando le toca, porque paso() solo la
+ *       aplica en los frames sin acción.
+ * @param M Mando
+ * @param K Teclado leído en este tick
+ * @param gravedad La gravedad toca en este frame (tocaGravedad)
+ * @return Accion -> Acción para paso()
+ */
+Accion accionMando(Mando &M, const TeclasMando &K, bool gravedad) {
+    for (int i = 0; i < 3; ++i) M.toques[i] += K.pulsaciones[i];
+
+    int direccion = K.direccion;
+    if (direccion == 0) {
+        M.movidas = 0;
+    } else if (direccion != M.direccion) {
+        // Dirección nueva sin su pulsación (se ha soltado la otra): se mueve ya
+        M.movidas = 0;
+        M.espera = 0;
+    } else if (M.espera > 0) {
+        M.espera--;
+    }
+    M.direccion = direccion;
+
+    if (K.bajando && !M.bajando) M.esperaBajada = 0;
+    else if (K.bajando && M.esperaBajada > 0) M.esperaBajada--;
+    M.bajando = K.bajando;
+
+    if (K.rotacion != NADA) return K.rotacion;
+
+    int i = direccion < 0 ? 0 : 1;
+    if (M.toques[i] == 0) i = 1 - i;
+    if (M.toques[i] > 0) {
+        // La pulsación es el primer movimiento de su dirección, esté o no mantenida ya
+        M.toques[i]--;
+        M.direccion = i == 0 ? -1 : 1;
+        M.movidas = 1;
+        M.espera = M.das;
+        return i == 0 ? MOVER_IZQUIERDA : MOVER_DERECHA;
+    }
+    if (direccion != 0 && M.espera == 0 && !(M.movidas > 0 && gravedad)) {
+        M.espera = M.movidas++ == 0 ? M.das : M.arr;
+        return direccion < 0 ? MOVER_IZQUIERDA : MOVER_DERECHA;
+    }
+    if (M.toques[2] > 0) {
+        M.toques[2]--;
+        M.bajando = true;
+        M.esperaBajada = M.arr;
+        return BAJAR;
+    }
+    if (K.bajando && M.esperaBajada == 0) {
+        M.esperaBajada = M.arr;
+        return BAJAR;
+    }
+    return NADA;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file mando.h
+ * @brief Repetición de los movimientos con las teclas mantenidas (DAS/ARR)
+ *
+ * Con la repetición automática del sistema, la pieza se movía tan deprisa como
+ * repitiera el teclado en cada máquina. Mando decide en cada tick qué acción
+ * produce el teclado a partir de las teclas mantenidas: la dirección se mueve
+ * una celda al pulsarla, otra a los das ticks (delayed auto shift) y desde ahí
+ * una cada arr ticks (auto repeat rate). ABAJO repite cada arr ticks sin retardo.
+ *
+ * Las pulsaciones llegan contadas, no por la cola de teclas: cada una mueve una
+ * vez (también un toque que se suelta entre dos ticks) y es el primer movimiento
+ * de su dirección. Si se lee lo mantenido antes que las cuentas, una pulsación
+ * que llega entre las dos lecturas solo se ve como pulsación, y la dirección
+ * mantenida que aparece en el tick siguiente sigue con su DAS en lugar de mover
+ * otra vez.
+ * Todo va en ticks de paso(), así que la respuesta es la misma en cualquier
+ * máquina y queda grabada en las repeticiones como cualquier otra acción.
+ */
+
+#ifndef _MANDO_H_
+#define _MANDO_H_
+
+#include "juego.h"
+
+const int DAS_TICKS = 6; ///< Ticks entre el primer movimiento y la primera repetición (180 ms)
+const int ARR_TICKS = 2; ///< Ticks entre repeticiones (1: una celda por tick)
+
+/** @struct TeclasMando
+ *  @brief Lectura del teclado en un tick.
+ */
+struct TeclasMando {
+    Accion rotacion; ///< Rotación pulsada desde el tick anterior (NADA si no hay)
+    int direccion; ///< Dirección mantenida (-1 izquierda, 0 ninguna, 1 derecha)
+    bool bajando; ///< ABAJO mantenida
+    int pulsaciones[3]; ///< Pulsaciones de IZQUIERDA, DERECHA y ABAJO desde el tick anterior
+};
+
+/** @struct Mando
+ *  @brief Estado de la repetición de las teclas mantenidas.
+ */
+struct Mando {
+    int das; ///< Ticks entre el primer movimiento y la primera repetición
+    int arr; ///< Ticks entre repeticiones
+    int direccion; ///< Dirección mantenida en el último tick (-1 izquierda, 0 ninguna, 1 derecha)
+    int movidas; ///< Movimientos hechos con la dirección mantenida
+    int espera; ///< Ticks que faltan para el siguiente movimiento (0: toca ya)
+    bool bajando; ///< ABAJO mantenida en el último tick
+    int esperaBajada; ///< Ticks que faltan para la siguiente bajada
+    int toques[3]; ///< Pulsaciones de IZQUIERDA, DERECHA y ABAJO aún sin aplicar
+};
+
+void iniciarMando(Mando &M, int das = DAS_TICKS, int arr = ARR_TICKS);
+Accion accionMando(Mando &M, const TeclasMando &K, bool gravedad);
+
+#endif
@@ -18,6 +18,8 @@
 #include <fstream>
 #include <sstream>
 #include <queue>
+#include <chrono>
+#include <stdlib.h>
 #include <math.h>
 #include <process.h>
 #include <windows.h>
@@ -41,6 +43,10 @@ std::queue<int> _teclas;           // cola de teclas
 bool            _raton_dentro;     // el raton est dentro del 'client area'
 int             _xraton, _yraton;  // posicion del raton
 bool            _bot_izq, _bot_der;// botones izquierdo y derecho
+HANDLE          _evento = CreateEvent(NULL, FALSE, FALSE, NULL); // avisa de teclas y raton
+unsigned long long _pulsadas[2];   // bit t: la tecla t (codigo de miniwin) esta pulsada
+long long       _pulsada_en[128];  // ms (steady_clock) en que se pulso cada tecla
+int             _pulsaciones[128]; // veces que se ha pulsado cada tecla
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -54,6 +60,52 @@ std::ostream& log() {
    return _log;
 }
 
+// Teclas que llegan a la cola (virtual-key codes)
+bool _tecla_valida(WPARAM vk) {
+   // Escape, flechas, barra espaciadora y Return
+   if (vk == VK_ESCAPE || vk == VK_LEFT || vk == VK_RIGHT || vk == VK_UP ||
+       vk == VK_DOWN || vk == VK_SPACE || vk == VK_RETURN) return true;
+
+   // Nmeros 0-9 y letras A-Z
+   if ((vk >= 48 && vk <= 57) || (vk >= 65 && vk <= 90)) return true;
+
+   // Teclas de funcin
+   return vk >= VK_F1 && vk <= VK_F10;
+}
+
+// Traduce un virtual-key code al codigo de tecla de miniwin
+int _codigo(int vk) {
+   switch (vk) {
+   case VK_LEFT:   return miniwin::IZQUIERDA;
+   case VK_RIGHT:  return miniwin::DERECHA;
+   case VK_UP:     return miniwin::ARRIBA;
+   case VK_DOWN:   return miniwin::ABAJO;
+   case VK_ESCAPE: return miniwin::ESCAPE;
+   case VK_SPACE:  return miniwin::ESPACIO;
+   case VK_RETURN: return miniwin::RETURN;
+   }
+   if (vk >= VK_F1 && vk <= VK_F10) return miniwin::F1 + (vk - VK_F1);
+   return vk;
+}
+
+long long _ahora_ms() {
+   using namespace std::chrono;
+   return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void _marca_tecla(int t, bool pulsada) {
+   if (t < 0 || t >= 128) return;
+   unsigned long long bit = 1ULL << (t % 64);
+   if (pulsada) {
+      // La cuenta antes que el bit: quien vea la tecla pulsada ve ya la pulsacion
+      _pulsaciones[t]++;
+      _pulsada_en[t] = _ahora_ms();
+      _pulsadas[t / 64] |= bit;
+   } else {
+      _pulsadas[t / 64] &= ~bit;
+   }
+}
+
 VOID Thread(PVOID pvoid) {
    Sleep(50); // FIXME
    _main_();
@@ -220,61 +272,59 @@ LRESULT CALLBACK WindowProcedure (HWND hWnd,
       _yraton = GET_Y_LPARAM(lParam);
       _bot_izq = wParam & MK_LBUTTON;
       _bot_der = wParam & MK_RBUTTON;
+      SetEvent(_evento);
       break;
    }
    case WM_MOUSELEAVE: {
       _raton_dentro = false;
+      SetEvent(_evento);
       break;
    }
    case WM_LBUTTONDOWN: {
       _bot_izq = true;
+      SetEvent(_evento);
       break;
    }
    case WM_LBUTTONUP: {
       _bot_izq = false;
+      SetEvent(_evento);
       break;
    }
    case WM_RBUTTONDOWN: {
       _bot_der = true;
+      SetEvent(_evento);
       break;
    }
    case WM_RBUTTONUP: {
       _bot_der = false;
+      SetEvent(_evento);
       break;
    }
    case WM_KEYDOWN: {
-     bool push_it = false;
-
-     // Escape
-     push_it |= (wParam == VK_ESCAPE);
-
-     // Flechas
-     push_it |= (wParam == VK_LEFT ||
-                 wParam == VK_RIGHT ||
-                 wParam == VK_UP ||
-                 wParam == VK_DOWN);
-
-     // Barra espaciadora
-     push_it |= (wParam == VK_SPACE);
-
-     push_it |= (wParam == VK_RETURN);
-
-     // Nmeros 0-9
-     push_it |= (wParam >= 48 && wParam <= 57);
-
-     // Letras A-Z
-     push_it |= (wParam >= 65 && wParam <= 90);
-
-     // Teclas de funcin
-     for (unsigned int i = 0; i < 10; i++) {
-       push_it |= (wParam == (VK_F1 + i));
+     // El bit 30 indica que ya estaba pulsada: es la repeticion del sistema,
+     // que no se encola (la repeticion la decide el programa con tecla_pulsada)
+     if (_tecla_valida(wParam) && !(lParam & (1 << 30))) {
+        _teclas.push(wParam);
+        _marca_tecla(_codigo(wParam), true);
+        SetEvent(_evento);
      }
-
-     if (push_it) _teclas.push(wParam);
-
+     break;
+   }
+   case WM_KEYUP: {
+     if (_tecla_valida(wParam)) {
+        _marca_tecla(_codigo(wParam), false);
+        SetEvent(_evento);
+     }
+     break;
+   }
+   case WM_KILLFOCUS: {
+     // Sin foco no llegan los WM_KEYUP: se sueltan todas
+     _pulsadas[0] = _pulsadas[1] = 0;
+     SetEvent(_evento);
      break;
    }
    case WM_DESTROY: {
+      SetEvent(_evento);
       DeleteObject (hBitmap);
       DeleteDC (hDCMem);
       PostQuitMessage(0);
@@ -300,31 +350,25 @@ namespace miniwin {
 int tecla() {
     if (_teclas.empty()) return NINGUNA;
 
-    int ret = NINGUNA;
-    switch(_teclas.front()) {
-    case VK_LEFT:   ret = IZQUIERDA; break;
-    case VK_RIGHT:  ret = DERECHA; break;
-    case VK_UP:     ret = ARRIBA; break;
-    case VK_DOWN:   ret = ABAJO; break;
-    case VK_ESCAPE: ret = ESCAPE; break;
-    case VK_SPACE:  ret = ESPACIO; break;
-    case VK_RETURN: ret = RETURN; break;
-    case VK_F1:     ret = F1; break;
-    case VK_F2:     ret = F2; break;
-    case VK_F3:     ret = F3; break;
-    case VK_F4:     ret = F4; break;
-    case VK_F5:     ret = F5; break;
-    case VK_F6:     ret = F6; break;
-    case VK_F7:     ret = F7; break;
-    case VK_F8:     ret = F8; break;
-    case VK_F9:     ret = F9; break;
-    case VK_F10:    ret = F10; break;
-    default: ret = _teclas.front();
-    }
+    int ret = _codigo(_teclas.front());
     _teclas.pop();
     return ret;
 }
 
+bool tecla_pulsada(int t) {
+   if (t < 0 || t >= 128) return false;
+   return (_pulsadas[t / 64] >> (t % 64)) & 1;
+}
+
+int tecla_pulsada_ms(int t) {
+   if (!tecla_pulsada(t)) return -1;
+   return int(_ahora_ms() - _pulsada_en[t]);
+}
+
+int tecla_pulsaciones(int t) {
+   return t >= 0 && t < 128 ? _pulsaciones[t] : 0;
+}
+
 bool raton(float& x, float& y) {
    if (!_raton_dentro) {
       return false;
@@ -363,6 +407,16 @@ void espera(int miliseg) {
    Sleep(miliseg);
 }
 
+bool espera_evento(int miliseg) {
+   if (!_teclas.empty()) return true;
+   return WaitForSingleObject(_evento, miliseg < 0 ? INFINITE : DWORD(miliseg)) == WAIT_OBJECT_0;
+}
+
+const std::vector<std::string>& argumentos() {
+   static std::vector<std::string> _args(__argv + 1, __argv + __argc);
+   return _args;
+}
+
 void mensaje(std::string msj) {
    MessageBox(hWnd, msj.c_str(), "Mensaje...", MB_OK);
 }
@@ -512,11 +566,18 @@ void vcierra() {
 #include <iostream>
 #include <string>
 #include <queue>
+#include <cerrno>
+#include <ctime>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/Xos.h>
 #include <X11/Xatom.h>
 #include <X11/keysym.h>
+#include <X11/XKBlib.h>
+#include <chrono>
 using namespace std;
 
 #define MINIWIN_SOURCE
@@ -535,6 +596,12 @@ std::queue<int> _teclas;
 bool            _end = false;
 pthread_t       _thread;
 pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t  _evento;          // avisa de teclas, raton y cierre (con _mutex)
+unsigned long   _eventos = 0;     // eventos avisados hasta ahora
+unsigned long long _pulsadas[2];  // bit t: la tecla t (codigo de miniwin) esta pulsada
+long long       _pulsada_en[128]; // ms (steady_clock) en que se pulso cada tecla
+int             _pulsaciones[128];// veces que se ha pulsado cada tecla
+std::vector<std::string> _args;   // argumentos de la linea de comandos
 
 //////////////////////////////////////////////////////////////////////
 
@@ -578,27 +645,53 @@ inline void _refresh() {
 inline void _lock()   { pthread_mutex_lock(&_mutex); }
 inline void _unlock() { pthread_mutex_unlock(&_mutex); }
 
-void _handlekey(KeySym key) {
+// Traduce un KeySym al codigo de tecla de miniwin (-1: no se usa)
+int _codigo(KeySym key) {
    switch (key) {
-   case XK_Escape: _teclas.push(miniwin::ESCAPE); break;
-   case XK_space:  _teclas.push(miniwin::ESPACIO); break;
-   case XK_Return: _teclas.push(miniwin::RETURN); break;
-   case XK_Left:   _teclas.push(miniwin::IZQUIERDA); break;
-   case XK_Right:  _teclas.push(miniwin::DERECHA); break;
-   case XK_Up:     _teclas.push(miniwin::ARRIBA); break;
-   case XK_Down:   _teclas.push(miniwin::ABAJO); break;
+   case XK_Escape: return miniwin::ESCAPE;
+   case XK_space:  return miniwin::ESPACIO;
+   case XK_Return: return miniwin::RETURN;
+   case XK_Left:   return miniwin::IZQUIERDA;
+   case XK_Right:  return miniwin::DERECHA;
+   case XK_Up:     return miniwin::ARRIBA;
+   case XK_Down:   return miniwin::ABAJO;
    default: {
       if ((key >= int('0') && key <= int('9')) ||
           (key >= int('A') && key <= int('Z'))) {
-         _teclas.push(key);
+         return key;
       } else if (key >= int('a') && key <= int('z')) {
-         _teclas.push(key - 32);
+         return key - 32;
       } else if (key >= XK_F1 && key <= XK_F10) {
          int dif = key - XK_F1;
-         _teclas.push(miniwin::F1 + dif);
+         return miniwin::F1 + dif;
       }
    }
    }
+   return -1;
+}
+
+long long _ahora_ms() {
+   return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool _tecla_pulsada(int t) {
+   return t >= 0 && t < 128 && ((_pulsadas[t / 64] >> (t % 64)) & 1);
+}
+
+// Pulsar encola la tecla y la marca; si ya estaba pulsada es la repeticion
+// automatica del servidor, que no se encola (la decide el programa)
+void _handlekey(KeySym key, bool pulsada) {
+   int t = _codigo(key);
+   if (t < 0) return;
+   unsigned long long bit = 1ULL << (t % 64);
+   if (!pulsada) {
+      _pulsadas[t / 64] &= ~bit;
+   } else if (!_tecla_pulsada(t)) {
+      _pulsadas[t / 64] |= bit;
+      _pulsada_en[t] = _ahora_ms();
+      _pulsaciones[t]++;
+      _teclas.push(t);
+   }
 }
 
 void _change_width_height(int w, int h) {
@@ -628,6 +721,8 @@ void _new_window() {
                 StructureNotifyMask |
                 ExposureMask |
                 KeyPressMask |
+                KeyReleaseMask |
+                FocusChangeMask |
                 ButtonPressMask |
                 PointerMotionMask |
                 ButtonPressMask |
@@ -641,6 +736,11 @@ void _new_window() {
    // http://cboard.cprogramming.com/linux-programming/60466-xwindows-close-window-event.html
    Atom wmDelete = XInternAtom(_dsp, "WM_DELETE_WINDOW", True);
    XSetWMProtocols(_dsp, _win, &wmDelete, 1);
+
+   // Con la repeticion automatica "detectable" el servidor no manda un
+   // KeyRelease antes de cada KeyPress repetido
+   Bool detectable;
+   XkbSetDetectableAutoRepeat(_dsp, True, &detectable);
 }
 
 void _close_window() {
@@ -674,7 +774,26 @@ void _maybe_call_main() {
    }
 }
 
+// Despierta a quien este en espera_evento (se llama con _mutex cogido)
+inline void _avisa() {
+   _eventos++;
+   pthread_cond_broadcast(&_evento);
+}
+
 void _process_event() {
+   switch  (_report.type) {
+   case KeyPress:
+   case KeyRelease:
+   case FocusOut:
+   case ClientMessage:
+   case MotionNotify:
+   case ButtonPress:
+   case ButtonRelease:
+   case EnterNotify:
+   case LeaveNotify:
+      _avisa();
+      break;
+   }
    switch  (_report.type) {
    case Expose: {
       _refresh();
@@ -682,7 +801,25 @@ void _process_event() {
    }
    case KeyPress: {
       KeySym key = XLookupKeysym(&_report.xkey, 0);
-      _handlekey(key);
+      _handlekey(key, true);
+      break;
+   }
+   case KeyRelease: {
+      // Sin repeticion detectable, cada repeticion llega como un KeyRelease
+      // seguido de un KeyPress con el mismo instante: la tecla sigue pulsada
+      if (XEventsQueued(_dsp, QueuedAfterReading) > 0) {
+         XEvent sig;
+         XPeekEvent(_dsp, &sig);
+         if (sig.type == KeyPress && sig.xkey.keycode == _report.xkey.keycode &&
+             sig.xkey.time == _report.xkey.time) break;
+      }
+      KeySym key = XLookupKeysym(&_report.xkey, 0);
+      _handlekey(key, false);
+      break;
+   }
+   case FocusOut: {
+      // Sin foco no llegan los KeyRelease: se sueltan todas
+      _pulsadas[0] = _pulsadas[1] = 0;
       break;
    }
    case MapNotify: {
@@ -721,19 +858,29 @@ void _process_event() {
    }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+   _args.assign(argv + 1, argv + argc);
+   pthread_condattr_t attr;
+   pthread_condattr_init(&attr);
+   pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+   pthread_cond_init(&_evento, &attr);
+   pthread_condattr_destroy(&attr);
    _open_display();
    _new_window();
    _new_buffer();
 
+   // Sin eventos, duerme en la conexion con el servidor en lugar de sondearla.
+   // El timeout solo cubre eventos que Xlib ya haya leido al esperar una
+   // respuesta desde el hilo de main y el cierre con vcierra().
+   struct pollfd conexion = { ConnectionNumber(_dsp), POLLIN, 0 };
 	while (!_end)  {
        _lock();
-       if (XPending(_dsp) > 0) {
-          XNextEvent(_dsp, &_report); // this blocks
+       while (!_end && XPending(_dsp) > 0) {
+          XNextEvent(_dsp, &_report);
           _process_event();
        }
        _unlock();
-       usleep(100);
+       if (!_end) poll(&conexion, 1, 50);
 	}
    pthread_cancel(_thread);
    XDestroyWindow(_dsp, _win);
@@ -866,6 +1013,27 @@ int tecla() {
    }
 }
 
+bool tecla_pulsada(int t) {
+   _lock();
+   bool ret = _tecla_pulsada(t);
+   _unlock();
+   return ret;
+}
+
+int tecla_pulsada_ms(int t) {
+   _lock();
+   int ret = _tecla_pulsada(t) ? int(_ahora_ms() - _pulsada_en[t]) : -1;
+   _unlock();
+   return ret;
+}
+
+int tecla_pulsaciones(int t) {
+   _lock();
+   int ret = t >= 0 && t < 128 ? _pulsaciones[t] : 0;
+   _unlock();
+   return ret;
+}
+
 bool raton(float& x, float& y) {
    x = _mouse_state.x;
    y = _mouse_state.y;
@@ -911,6 +1079,36 @@ void espera(int miliseg) {
    usleep(miliseg * 1000);
 }
 
+bool espera_evento(int miliseg) {
+   _lock();
+   unsigned long visto = _eventos;
+   if (_teclas.empty()) {
+      if (miliseg < 0) {
+         while (_eventos == visto) pthread_cond_wait(&_evento, &_mutex);
+      } else {
+         timespec limite;
+         clock_gettime(CLOCK_MONOTONIC, &limite);
+         limite.tv_sec  += miliseg / 1000;
+         limite.tv_nsec += long(miliseg % 1000) * 1000000L;
+         if (limite.tv_nsec >= 1000000000L) {
+            limite.tv_sec++;
+            limite.tv_nsec -= 1000000000L;
+         }
+         int r = 0;
+         while (_eventos == visto && r != ETIMEDOUT) {
+            r = pthread_cond_timedwait(&_evento, &_mutex, &limite);
+         }
+      }
+   }
+   bool hay = !_teclas.empty() || _eventos != visto;
+   _unlock();
+   return hay;
+}
+
+const std::vector<std::string>& argumentos() {
+   return _args;
+}
+
 } // namespace miniwin
 
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -14,6 +14,8 @@
 #define _MINIWIN_H_
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 #ifndef MINIWIN_SOURCE
 #define main _main_ // Super-cutre hack! (pero funciona)
@@ -32,6 +34,8 @@ void refresca();
 void mensaje(std::string msj);
 bool pregunta(std::string msj);
 void espera(int miliseg);
+bool espera_evento(int miliseg); // true: tecla, raton o cierre; miliseg < 0: sin limite
+const std::vector<std::string>& argumentos();
 
 int  vancho();
 int  valto();
@@ -49,7 +53,10 @@ void circulo(float x_cen, float y_cen, float radio);
 void circulo_lleno(float x_cen, float y_cen, float radio);
 void texto(float x, float y, const std::string& texto);
 
-int tecla();
+int tecla(); // Una vez por pulsación: la repetición automática del sistema no se encola
+bool tecla_pulsada(int t); // t: código de tecla() (flechas, ESCAPE, 'A'-'Z', '0'-'9'...)
+int  tecla_pulsada_ms(int t); // ms desde que se pulsó; -1 si no está pulsada
+int  tecla_pulsaciones(int t); // Pulsaciones desde el principio (tras leer tecla_pulsada, incluye la vista)
 
 bool  raton(float& x, float& y);
 bool  raton_dentro();
@@ -0,0 +1,117 @@
+/**
+ * @file movimientos.cpp
+ * @brief Generador de movimientos por búsqueda en anchura
+ *
+ * @see movimientos.h
+ */
+
+#include "movimientos.h"
+#include <cstring>
+
+/**
+ * @brief Índice de un estado (x, y, rotación) de la pieza.
+ * @param x Columna de abs
+ * @param y Fila de abs
+ * @param rot Rotación
+ * @return int -> Índice en [0, MAX_ESTADOS)
+ */
+static inline int indiceEstado(int x, int y, int rot) {
+    return (rot * FILAS + y) * COLUMNAS + x;
+}
+
+/**
+ * @brief Comprueba y marca un estado en un conjunto de bits.
+ * @param bits Conjunto de bits
+ * @param i Índice del estado
+ * @return bool -> true: el estado ya estaba marcado
+ */
+static inline bool marca(uint64_t *bits, int i) {
+    uint64_t b = uint64_t(1) << (i & 63);
+    bool estaba = bits[i >> 6] & b;
+    bits[i >> 6] |= b;
+    return estaba;
+}
+
+/**
+ * @brief Busca todas las posiciones de bloqueo alcanzables por la pieza.
+ * @post G.destino contiene cada posición de bloqueo distinta una sola vez (dos
+ *       rotaciones con las mismas celdas cuentan como una) junto con el estado
+ *       por el que se llega antes. Un BAJAR más desde ese estado fija la pieza.
+ * @param G Memoria de la búsqueda
+ * @param T Ocupación del tablero
+ * @param P Pieza actual
+ * @return int -> Número de posiciones de bloqueo (0 si la pieza ya colisiona)
+ */
+int generaMovimientos(GeneradorMovimientos &G, const Ocupacion &T, const Pieza &P) {
+    memset(G.visitado, 0, sizeof(G.visitado));
+    memset(G.fijado, 0, sizeof(G.fijado));
+    G.destinos = 0;
+    if (colisionPieza(T, P)) return 0;
+
+    const int tipo = P.tipo;
+    const bool gira = tipo != CUADRADO;
+    int cabeza = 0, final = 0;
+
+    int inicio = indiceEstado(P.abs.x, P.abs.y, P.rot);
+    marca(G.visitado, inicio);
+    G.distancia[inicio] = 0;
+    G.cola[final++] = uint16_t(inicio);
+
+    while (cabeza < final) {
+        const int e = G.cola[cabeza++];
+        const int x = e % COLUMNAS;
+        const int y = (e / COLUMNAS) % FILAS;
+        const int rot = e / (COLUMNAS * FILAS);
+        const int d = G.distancia[e] + 1;
+
+        // Vecinos en el orden de las teclas: giros, desplazamientos y bajar
+        const int vx[5] = {x, x, x - 1, x + 1, x};
+        const int vy[5] = {y, y, y, y, y + 1};
+        const int vr[5] = {(rot + 1) & (ROTACIONES - 1), (rot + ROTACIONES - 1) & (ROTACIONES - 1), rot, rot, rot};
+        const Accion va[5] = {ROTAR_DERECHA, ROTAR_IZQUIERDA, MOVER_IZQUIERDA, MOVER_DERECHA, BAJAR};
+
+        for (int k = gira ? 0 : 2; k < 5; ++k) {
+            if (COLISION[tipo][vr[k]](T, vx[k], vy[k])) {
+                // Si no puede bajar, este estado es una posición de bloqueo
+                if (va[k] == BAJAR) {
+                    const Huella &h = HUELLAS.h[tipo][rot];
+                    int forma = indiceEstado(x + h.minx, y + h.miny, h.canonica);
+                    if (!marca(G.fijado, forma)) {
+                        Destino &D = G.destino[G.destinos++];
+                        D.P.abs = {x, y};
+                        D.P.tipo = tipo;
+                        D.P.rot = rot;
+                        D.estado = uint16_t(e);
+                        D.longitud = uint16_t(d - 1);
+                    }
+                }
+                continue;
+            }
+            int v = indiceEstado(vx[k], vy[k], vr[k]);
+            if (marca(G.visitado, v)) continue;
+            G.padre[v] = uint16_t(e);
+            G.accion[v] = uint8_t(va[k]);
+            G.distancia[v] = uint16_t(d);
+            G.cola[final++] = uint16_t(v);
+        }
+    }
+    return G.destinos;
+}
+
+/**
+ * @brief Reconstruye la ruta más corta hasta una posición de bloqueo.
+ * @post La ruta no incluye el BAJAR final que fija la pieza.
+ * @param G Memoria de la última búsqueda
+ * @param d Índice del destino en G.destino
+ * @param ruta Acciones en orden, desde la pieza inicial
+ * @return int -> Número de acciones de la ruta
+ */
+int rutaMovimientos(const GeneradorMovimientos &G, int d, Accion ruta[MAX_ESTADOS]) {
+    int n = G.destino[d].longitud;
+    int e = G.destino[d].estado;
+    for (int i = n - 1; i >= 0; --i) {
+        ruta[i] = Accion(G.accion[e]);
+        e = G.padre[e];
+    }
+    return n;
+}
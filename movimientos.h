@@ -0,0 +1,51 @@
+/**
+ * @file movimientos.h
+ * @brief Generador de movimientos por búsqueda en anchura
+ *
+ * Explora todos los estados (x, y, rotación) alcanzables por la pieza actual con
+ * las mismas reglas que paso(): ROTAR_DERECHA, ROTAR_IZQUIERDA, MOVER_IZQUIERDA,
+ * MOVER_DERECHA y BAJAR, con colisionPieza decidiendo qué es legal. Así encuentra
+ * también las colocaciones que solo se alcanzan deslizando o girando bajo un saliente.
+ *
+ * La gravedad no se modela: se supone que el jugador pulsa una tecla en cada frame,
+ * con lo que paso() nunca baja la pieza por su cuenta.
+ *
+ * Toda la memoria de la búsqueda (visitados, cola, padres y destinos) vive en
+ * GeneradorMovimientos y se reutiliza: no hay reservas dinámicas por búsqueda.
+ */
+
+#ifndef _MOVIMIENTOS_H_
+#define _MOVIMIENTOS_H_
+
+#include "juego.h"
+
+/// Estados posibles de una pieza: abs siempre es un bloque, así que está dentro del tablero
+const int MAX_ESTADOS = COLUMNAS * FILAS * ROTACIONES;
+
+/** @struct Destino
+ *  @brief Posición de bloqueo distinta alcanzada por la búsqueda.
+ */
+struct Destino {
+    Pieza P; ///< Pieza en la posición de bloqueo
+    uint16_t estado; ///< Estado (x, y, rotación) con el que se alcanzó
+    uint16_t longitud; ///< Número de acciones de la ruta más corta hasta él
+};
+
+/** @struct GeneradorMovimientos
+ *  @brief Memoria reutilizable de la búsqueda en anchura y sus resultados.
+ */
+struct GeneradorMovimientos {
+    uint64_t visitado[(MAX_ESTADOS + 63) / 64]; ///< Estados ya encolados
+    uint64_t fijado[(MAX_ESTADOS + 63) / 64]; ///< Posiciones de bloqueo ya dadas (por forma)
+    uint16_t cola[MAX_ESTADOS]; ///< Cola de tamaño fijo: cada estado entra una vez
+    uint16_t padre[MAX_ESTADOS]; ///< Estado desde el que se llegó a cada estado
+    uint8_t accion[MAX_ESTADOS]; ///< Acción con la que se llegó a cada estado
+    uint16_t distancia[MAX_ESTADOS]; ///< Acciones desde la pieza inicial
+    Destino destino[MAX_ESTADOS]; ///< Posiciones de bloqueo distintas, por distancia creciente
+    int destinos; ///< Número de posiciones de bloqueo encontradas
+};
+
+int generaMovimientos(GeneradorMovimientos &G, const Ocupacion &T, const Pieza &P);
+int rutaMovimientos(const GeneradorMovimientos &G, int d, Accion ruta[MAX_ESTADOS]);
+
+#endif
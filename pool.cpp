@@ -0,0 +1,133 @@
+/**
+ * @file pool.cpp
+ * @brief Grupo de hilos con robo de trabajo
+ *
+ * @see pool.h
+ */
+
+#include "pool.h"
+
+/// Índice del hilo del grupo que ejecuta el código, o -1 fuera del grupo
+static thread_local int hiloPropio = -1;
+/// Grupo al que pertenece el hilo que ejecuta el código
+static thread_local const PoolTrabajo *poolPropio = nullptr;
+
+/**
+ * @brief Arranca el grupo de hilos.
+ * @param hilos Número de hilos; 0 usa todos los núcleos disponibles
+ */
+PoolTrabajo::PoolTrabajo(int hilos) : pendientes(0), turno(0), parar(false) {
+    if (hilos <= 0) hilos = int(std::thread::hardware_concurrency());
+    if (hilos <= 0) hilos = 1;
+    for (int i = 0; i < hilos; ++i) colas.emplace_back(new Cola);
+    for (int i = 0; i < hilos; ++i) equipo.emplace_back(&PoolTrabajo::trabajar, this, i);
+}
+
+/**
+ * @brief Espera a que terminen las tareas pendientes y detiene los hilos.
+ */
+PoolTrabajo::~PoolTrabajo() {
+    esperar();
+    {
+        std::lock_guard<std::mutex> l(mEspera);
+        parar = true;
+    }
+    hayTrabajo.notify_all();
+    for (std::thread &t : equipo) t.join();
+}
+
+/**
+ * @brief Índice del hilo del grupo que llama.
+ * @return int -> Índice en [0, hilos()) o -1 si no es un hilo de ningún grupo
+ */
+int PoolTrabajo::hiloActual() {
+    return hiloPropio;
+}
+
+/**
+ * @brief Añade una tarea.
+ * @post Desde un hilo del grupo va a su propia cola; desde fuera, por turnos
+ * @param t Tarea
+ */
+void PoolTrabajo::encolar(Tarea t) {
+    int destino = poolPropio == this ? hiloPropio : int(turno++ % unsigned(hilos()));
+    pendientes++;
+    {
+        std::lock_guard<std::mutex> l(colas[destino]->m);
+        colas[destino]->tareas.push_back(std::move(t));
+    }
+    {
+        std::lock_guard<std::mutex> l(mEspera);
+    }
+    hayTrabajo.notify_one();
+}
+
+/**
+ * @brief Bloquea hasta que no quede ninguna tarea pendiente.
+ * @pre No debe llamarse desde una tarea del propio grupo
+ */
+void PoolTrabajo::esperar() {
+    std::unique_lock<std::mutex> l(mEspera);
+    terminado.wait(l, [this] { return pendientes.load() == 0; });
+}
+
+/**
+ * @brief Toma una tarea: primero de la cola propia y si no, robando.
+ * @param yo Índice del hilo
+ * @param t Tarea tomada
+ * @return bool -> true: hay tarea
+ */
+bool PoolTrabajo::tomar(int yo, Tarea &t) {
+    {
+        Cola &c = *colas[yo];
+        std::lock_guard<std::mutex> l(c.m);
+        if (!c.tareas.empty()) {
+            t = std::move(c.tareas.back());
+            c.tareas.pop_back();
+            return true;
+        }
+    }
+    for (int k = 1; k < hilos(); ++k) {
+        Cola &c = *colas[(yo + k) % hilos()];
+        std::lock_guard<std::mutex> l(c.m);
+        if (!c.tareas.empty()) {
+            t = std::move(c.tareas.front());
+            c.tareas.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Bucle de cada hilo trabajador.
+ * @param yo Índice del hilo
+ */
+void PoolTrabajo::trabajar(int yo) {
+    hiloPropio = yo;
+    poolPropio = this;
+    Tarea t;
+    while (true) {
+        if (tomar(yo, t)) {
+            t();
+            t = nullptr;
+            if (--pendientes == 0) {
+                std::lock_guard<std::mutex> l(mEspera);
+                terminado.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> l(mEspera);
+        if (parar) return;
+        // Se vuelve a mirar con el cerrojo tomado para no perder un aviso
+        hayTrabajo.wait(l, [&] {
+            if (parar) return true;
+            for (auto &c : colas) {
+                std::lock_guard<std::mutex> lc(c->m);
+                if (!c->tareas.empty()) return true;
+            }
+            return false;
+        });
+        if (parar && pendientes.load() == 0) return;
+    }
+}
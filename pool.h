@@ -0,0 +1,70 @@
+/**
+ * @file pool.h
+ * @brief Grupo de hilos con robo de trabajo
+ *
+ * Cada hilo tiene su propia cola de tareas. Las tareas encoladas desde un hilo
+ * del grupo van a su cola; las de fuera se reparten por turnos. Un hilo sin
+ * trabajo toma primero de su cola (por el final, lo último que encoló) y si está
+ * vacía roba de las de los demás (por el principio, lo más antiguo).
+ */
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** @class PoolTrabajo
+ *  @brief Grupo fijo de hilos que reparte tareas con robo de trabajo.
+ */
+class PoolTrabajo {
+public:
+    typedef std::function<void()> Tarea; ///< Trabajo a ejecutar en algún hilo
+
+    explicit PoolTrabajo(int hilos = 0);
+    ~PoolTrabajo();
+
+    PoolTrabajo(const PoolTrabajo &) = delete;
+    PoolTrabajo &operator=(const PoolTrabajo &) = delete;
+
+    void encolar(Tarea t);
+    void esperar();
+
+    /** @brief Número de hilos del grupo.
+     *  @return int -> Hilos trabajadores
+     */
+    int hilos() const {
+        return int(colas.size());
+    }
+
+    static int hiloActual();
+
+private:
+    /** @struct Cola
+     *  @brief Cola de tareas de un hilo.
+     */
+    struct Cola {
+        std::mutex m; ///< Protege las tareas
+        std::deque<Tarea> tareas; ///< Tareas pendientes
+    };
+
+    bool tomar(int yo, Tarea &t);
+    void trabajar(int yo);
+
+    std::vector<std::unique_ptr<Cola>> colas; ///< Una cola por hilo
+    std::vector<std::thread> equipo; ///< Hilos trabajadores
+    std::mutex mEspera; ///< Protege las esperas de los hilos y de esperar()
+    std::condition_variable hayTrabajo; ///< Avisa a los hilos dormidos
+    std::condition_variable terminado; ///< Avisa a esperar() cuando no queda nada
+    std::atomic<long> pendientes; ///< Tareas encoladas y aún no terminadas
+    std::atomic<unsigned> turno; ///< Reparto por turnos de las tareas de fuera
+    bool parar; ///< El destructor pide a los hilos que terminen
+};
+
+#endif
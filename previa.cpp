@@ -0,0 +1,124 @@
+/**
+ * @file previa.cpp
+ * @brief Mide la tabla de transposición con el bot que mira la pieza siguiente
+ *
+ * Uso: previa [--partidas K] [--piezas P] [--hilos H] [--semilla S] [--megas M1,M2,...]
+ *
+ * Para cada tamaño de tabla (0: sin tabla) juega K partidas (32 por defecto) de
+ * hasta P piezas (300) con mejorDestinoPrevia, repartidas entre H hilos que
+ * comparten una misma tabla. Muestra una línea por tamaño:
+ *
+ *     megas jugadas/s aciertos% sondeo_ns sondeo_max_ns ocupacion% reemplazos
+ *
+ * y comprueba que las partidas dan los mismos puntos con cualquier tamaño: la
+ * tabla solo ahorra cálculo, no cambia las decisiones.
+ */
+
+#include "bot.h"
+#include "pool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/** @struct MemoriaHilo
+ *  @brief Memoria de búsqueda de un hilo.
+ */
+struct MemoriaHilo {
+    GeneradorMovimientos G; ///< Búsqueda de la pieza actual
+    GeneradorMovimientos G2; ///< Búsqueda de la pieza siguiente
+};
+
+/**
+ * @brief Juega una partida con el bot de dos piezas.
+ * @param M Memoria de búsqueda del hilo
+ * @param semilla Semilla de la partida
+ * @param piezas Máximo de piezas
+ * @param TT Tabla compartida (nullptr: sin tabla)
+ * @param jugadas Colocaciones hechas (se suman)
+ * @return int -> Puntos
+ */
+static int juegaPartida(MemoriaHilo &M, uint64_t semilla, int piezas, TablaTransposicion *TT, long &jugadas) {
+    EstadoJuego E;
+    iniciarJuego(E, semilla);
+    while (E.fin == EN_JUEGO && E.piezas < piezas) {
+        if (TT != nullptr) nuevaEdadTabla(*TT);
+        int d = mejorDestinoPrevia(M.G, M.G2, E.T, E.P, verPieza(E.azar, 0), PESOS_DEFECTO, TT);
+        if (d < 0) break;
+        colocaPieza(E, M.G.destino[d].P);
+        jugadas++;
+    }
+    return E.ptos;
+}
+
+int main(int argc, char *argv[]) {
+    int partidas = 32, piezas = 300, hilos = int(thread::hardware_concurrency());
+    uint64_t semilla = 1;
+    string megas = "0,1,16,256";
+    for (int i = 1; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--partidas") == 0 && valor) partidas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--piezas") == 0 && valor) piezas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hilos") == 0 && valor) hilos = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) semilla = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--megas") == 0 && valor) megas = argv[++i];
+        else {
+            cerr << "Uso: " << argv[0] << " [--partidas K] [--piezas P] [--hilos H] [--semilla S] [--megas M1,M2,...]"
+                 << endl;
+            return 1;
+        }
+    }
+    if (partidas < 1) partidas = 1;
+    if (hilos < 1) hilos = 1;
+
+    PoolTrabajo pool(hilos);
+    vector<unique_ptr<MemoriaHilo>> memoria;
+    for (int h = 0; h < pool.hilos(); ++h) memoria.emplace_back(new MemoriaHilo);
+    vector<int> primeros;
+
+    for (const char *m = megas.c_str(); *m != '\0';) {
+        char *fin;
+        double mb = strtod(m, &fin);
+        if (fin == m) break;
+        m = *fin == ',' ? fin + 1 : fin;
+
+        unique_ptr<TablaTransposicion> TT;
+        if (mb > 0) {
+            TT.reset(new TablaTransposicion);
+            iniciarTabla(*TT, size_t(mb * 1024 * 1024));
+        }
+        vector<int> puntos((size_t) partidas);
+        vector<long> jugadas((size_t) pool.hilos(), 0);
+        auto inicio = chrono::steady_clock::now();
+        for (int i = 0; i < partidas; ++i) {
+            pool.encolar([&, i] {
+                int h = PoolTrabajo::hiloActual();
+                puntos[size_t(i)] = juegaPartida(*memoria[size_t(h)], semilla + uint64_t(i), piezas, TT.get(),
+                                                 jugadas[size_t(h)]);
+            });
+        }
+        pool.esperar();
+        double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+        long total = 0;
+        for (long j : jugadas) total += j;
+        EstadisticasTabla S = TT ? estadisticasTabla(*TT) : EstadisticasTabla{};
+        printf("%g %.1f %.1f %.0f %.0f %.1f %llu\n", mb, total / segundos,
+               S.sondeos > 0 ? 100.0 * S.aciertos / S.sondeos : 0.0, S.nsSondeo, S.nsMaximo, 100 * S.ocupacion,
+               (unsigned long long) S.reemplazos);
+        fflush(stdout);
+
+        if (primeros.empty()) primeros = puntos;
+        else if (puntos != primeros) {
+            cerr << "Las partidas con " << mb << " MB no dan los mismos puntos que con el primer tamaño" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,342 @@
+/**
+ * @file publicador.cpp
+ * @brief Reparto de una partida retransmitida a muchos espectadores (Linux)
+ *
+ * @see publicador.h
+ */
+
+#include "publicador.h"
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/// Eventos de epoll leídos de una vez
+const int MAX_EVENTOS_PUBLICADOR = 256;
+/// Mensajes escritos a un espectador en una sola llamada
+const int MAX_IOV_PUBLICADOR = 64;
+
+/**
+ * @brief Abre el socket y arranca el hilo que reparte los mensajes.
+ * @post Si el socket no se puede crear, abierto() es false y no hay hilo
+ * @param ruta Ruta del socket Unix (se reemplaza si existe)
+ * @param historia Mensajes guardados para los espectadores lentos; se amplía
+ *        si no caben dos intervalos entre fotogramas clave
+ * @param intervalo Diferencias entre fotogramas clave
+ */
+Publicador::Publicador(const std::string &ruta, size_t historia, uint32_t intervalo)
+    : ruta(ruta), escucha(-1), aviso(-1), epoll(-1), parar(false), primero(0), ultimaClave(0), hayClave(false),
+      conexiones(0), mensajes(0), claves(0), bytesPublicados(0), bytesEnviados(0), saltos(0), descartados(0),
+      activos(0) {
+    iniciarEmisor(M, intervalo);
+    // Un espectador que salta debe encontrar el último fotograma clave en la historia
+    size_t minimo = 2 * size_t(M.intervalo) + 2;
+    capacidad = historia > minimo ? historia : minimo;
+
+    sockaddr_un dir = {};
+    if (ruta.size() >= sizeof(dir.sun_path)) return;
+    int s = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (s < 0) return;
+    dir.sun_family = AF_UNIX;
+    memcpy(dir.sun_path, ruta.c_str(), ruta.size() + 1);
+    unlink(ruta.c_str());
+    aviso = eventfd(0, EFD_NONBLOCK);
+    epoll = epoll_create1(0);
+    if (bind(s, (sockaddr *) &dir, sizeof(dir)) != 0 || listen(s, 4096) != 0 || aviso < 0 || epoll < 0) {
+        close(s);
+        return;
+    }
+    escucha = s;
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = escucha;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, escucha, &ev);
+    ev.data.fd = aviso;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, aviso, &ev);
+    hilo = std::thread(&Publicador::trabajar, this);
+}
+
+/**
+ * @brief Detiene el hilo, desconecta a los espectadores y borra el socket.
+ */
+Publicador::~Publicador() {
+    if (hilo.joinable()) {
+        {
+            std::lock_guard<std::mutex> l(m);
+            parar = true;
+        }
+        uint64_t uno = 1;
+        if (write(aviso, &uno, sizeof(uno)) < 0) perror("eventfd");
+        hilo.join();
+    }
+    for (auto &s : suscriptores) close(s.first);
+    if (escucha >= 0) {
+        close(escucha);
+        unlink(ruta.c_str());
+    }
+    if (aviso >= 0) close(aviso);
+    if (epoll >= 0) close(epoll);
+}
+
+/**
+ * @brief Publica un frame de la partida.
+ * @post Codifica lo que ha cambiado desde el último frame y lo deja para el hilo
+ *       del publicador; solo toma un mutex y, si la cola estaba vacía, escribe
+ *       en el eventfd. Nunca espera a los espectadores.
+ * @param E Estado de la partida
+ * @return TipoMensaje -> Qué se ha publicado
+ */
+TipoMensaje Publicador::publica(const EstadoJuego &E) {
+    if (!abierto()) return SIN_CAMBIOS;
+    codificado.clear();
+    TipoMensaje t = codificaFrame(M, E, codificado);
+    if (t == SIN_CAMBIOS) return t;
+
+    // Una diferencia y, a veces, un fotograma clave: cada uno es un mensaje de la historia
+    std::pair<Mensaje, bool> nuevos[2];
+    int k = 0;
+    for (size_t p = 0; p < codificado.size() && k < 2; ++k) {
+        size_t n = 2 + size_t(codificado[p] | codificado[p + 1] << 8);
+        nuevos[k].first = std::make_shared<const std::vector<unsigned char>>(codificado.begin() + long(p),
+                                                                              codificado.begin() + long(p + n));
+        nuevos[k].second = codificado[p + 2] == 'K';
+        p += n;
+    }
+    mensajes += k;
+    if (t == MENSAJE_CLAVE) claves++;
+    bytesPublicados += long(codificado.size());
+
+    bool despertar;
+    {
+        std::lock_guard<std::mutex> l(m);
+        despertar = entrantes.empty();
+        for (int i = 0; i < k; ++i) entrantes.push_back(std::move(nuevos[i]));
+    }
+    uint64_t uno = 1;
+    if (despertar && write(aviso, &uno, sizeof(uno)) < 0) perror("eventfd");
+    return t;
+}
+
+/**
+ * @brief Copia los contadores.
+ * @return EstadisticasPublicador -> Contadores acumulados
+ */
+EstadisticasPublicador Publicador::estadisticas() const {
+    EstadisticasPublicador S;
+    S.suscriptores = activos;
+    S.conexiones = conexiones;
+    S.mensajes = mensajes;
+    S.claves = claves;
+    S.bytesPublicados = bytesPublicados;
+    S.bytesEnviados = bytesEnviados;
+    S.saltos = saltos;
+    S.descartados = descartados;
+    return S;
+}
+
+/**
+ * @brief Pasa los mensajes publicados a la historia.
+ * @post La historia no pasa de su capacidad: los mensajes más viejos salen
+ */
+void Publicador::recogeMensajes() {
+    std::vector<std::pair<Mensaje, bool>> nuevos;
+    {
+        std::lock_guard<std::mutex> l(m);
+        nuevos.swap(entrantes);
+    }
+    for (auto &x : nuevos) {
+        if (x.second) {
+            ultimaClave = primero + historia.size();
+            hayClave = true;
+        }
+        historia.push_back(std::move(x.first));
+    }
+    while (historia.size() > capacidad) {
+        historia.pop_front();
+        primero++;
+    }
+}
+
+/**
+ * @brief Acepta a los espectadores que esperan.
+ * @post Cada uno empieza en el último fotograma clave
+ */
+void Publicador::acepta() {
+    int fd;
+    while ((fd = accept4(escucha, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+        std::unique_ptr<Suscriptor> S(new Suscriptor);
+        S->fd = fd;
+        S->cursor = hayClave ? ultimaClave : primero + historia.size();
+        S->escrito = 0;
+        S->saltos = 0;
+        S->bloqueado = false;
+        // Con miles de espectadores, un buffer grande por cada uno solo esconde el retraso
+        int buffer = BUFFER_ESPECTADOR;
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+        epoll_event ev = {};
+        ev.events = EPOLLRDHUP;
+        ev.data.fd = fd;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev);
+        Suscriptor &ref = *S;
+        suscriptores[fd] = std::move(S);
+        conexiones++;
+        activos++;
+        if (!hayClave) continue;
+        envia(ref);
+    }
+}
+
+/**
+ * @brief Desconecta a un espectador.
+ * @param fd Socket del espectador
+ */
+void Publicador::cierra(int fd) {
+    close(fd);
+    suscriptores.erase(fd);
+    activos--;
+}
+
+/**
+ * @brief Salta al último fotograma clave si lo siguiente de un espectador ya no está en la historia.
+ * @post Tras MAX_SALTOS_ESPECTADOR saltos se le desconecta
+ * @param S Espectador (puede quedar desconectado y borrado)
+ * @return bool -> false: se le ha desconectado
+ */
+bool Publicador::alcanzaHistoria(Suscriptor &S) {
+    if (S.cursor >= primero) return true;
+    S.cursor = ultimaClave;
+    saltos++;
+    if (++S.saltos <= MAX_SALTOS_ESPECTADOR) return true;
+    descartados++;
+    cierra(S.fd);
+    return false;
+}
+
+/**
+ * @brief Escribe a un espectador todo lo que le falta, mientras el socket lo admita.
+ * @post Si se queda a medias espera a EPOLLOUT; si iba tan atrasado que lo
+ *       siguiente ya no está en la historia, salta antes al último fotograma
+ *       clave. Un mensaje a medio escribir siempre se termina: el flujo nunca se
+ *       corta a mitad de mensaje.
+ * @param S Espectador (puede quedar desconectado y borrado)
+ */
+void Publicador::envia(Suscriptor &S) {
+    bool bloquear = false;
+    for (;;) {
+        if (!alcanzaHistoria(S)) return;
+        iovec iov[MAX_IOV_PUBLICADOR];
+        int k = 0;
+        size_t total = 0;
+        if (S.actual) {
+            iov[k].iov_base = (void *) (S.actual->data() + S.escrito);
+            iov[k].iov_len = S.actual->size() - S.escrito;
+            total += iov[k++].iov_len;
+        }
+        for (uint64_t c = S.cursor; k < MAX_IOV_PUBLICADOR && c < primero + historia.size(); ++c) {
+            const Mensaje &x = historia[size_t(c - primero)];
+            iov[k].iov_base = (void *) x->data();
+            iov[k].iov_len = x->size();
+            total += iov[k++].iov_len;
+        }
+        if (k == 0) break;
+
+        msghdr h = {};
+        h.msg_iov = iov;
+        h.msg_iovlen = size_t(k);
+        ssize_t n = sendmsg(S.fd, &h, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                cierra(S.fd);
+                return;
+            }
+            bloquear = true;
+            break;
+        }
+        bytesEnviados += long(n);
+
+        size_t r = size_t(n);
+        if (S.actual) {
+            size_t falta = S.actual->size() - S.escrito;
+            if (r < falta) {
+                S.escrito += r;
+                r = 0;
+            } else {
+                r -= falta;
+                S.actual.reset();
+                S.escrito = 0;
+            }
+        }
+        while (r > 0) {
+            const Mensaje &x = historia[size_t(S.cursor - primero)];
+            S.cursor++;
+            if (r < x->size()) {
+                S.actual = x;
+                S.escrito = r;
+                r = 0;
+            } else {
+                r -= x->size();
+            }
+        }
+        if (size_t(n) < total) {
+            bloquear = true;
+            break;
+        }
+    }
+
+    if (bloquear != S.bloqueado) {
+        epoll_event ev = {};
+        ev.events = EPOLLRDHUP | (bloquear ? uint32_t(EPOLLOUT) : 0u);
+        ev.data.fd = S.fd;
+        epoll_ctl(epoll, EPOLL_CTL_MOD, S.fd, &ev);
+        S.bloqueado = bloquear;
+    }
+}
+
+/**
+ * @brief Bucle del hilo del publicador.
+ */
+void Publicador::trabajar() {
+    // Sin esto, en una máquina con pocos núcleos, el aviso de publica() cede el
+    // procesador al reparto en mitad del frame del juego
+    sched_param prioridad = {};
+    pthread_setschedparam(pthread_self(), SCHED_BATCH, &prioridad);
+    epoll_event eventos[MAX_EVENTOS_PUBLICADOR];
+    std::vector<Suscriptor *> listos;
+    for (;;) {
+        int n = epoll_wait(epoll, eventos, MAX_EVENTOS_PUBLICADOR, -1);
+        if (n < 0 && errno != EINTR) break;
+        for (int i = 0; i < n; ++i) {
+            int fd = eventos[i].data.fd;
+            if (fd == escucha) {
+                acepta();
+            } else if (fd == aviso) {
+                uint64_t cuenta;
+                if (read(aviso, &cuenta, sizeof(cuenta)) < 0 && errno != EAGAIN) perror("eventfd");
+                {
+                    std::lock_guard<std::mutex> l(m);
+                    if (parar) return;
+                }
+                recogeMensajes();
+                // Los bloqueados siguen cuando su socket admita más (EPOLLOUT), pero
+                // saltan ya: uno que no lee nunca acaba desconectado
+                listos.clear();
+                for (auto &s : suscriptores) listos.push_back(s.second.get());
+                for (Suscriptor *S : listos) {
+                    if (!S->bloqueado) envia(*S);
+                    else alcanzaHistoria(*S);
+                }
+            } else {
+                auto it = suscriptores.find(fd);
+                if (it == suscriptores.end()) continue;
+                if (eventos[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) cierra(fd);
+                else if (eventos[i].events & EPOLLOUT) envia(*it->second);
+            }
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/**
+ * @file publicador.h
+ * @brief Reparto de una partida retransmitida a muchos espectadores (Linux)
+ *
+ * El bucle del juego llama a publica() cada frame: codifica las diferencias con
+ * espectador.h y las deja en una cola, sin tocar ningún socket. Un hilo propio
+ * las pasa a una historia acotada de mensajes compartidos y las escribe con
+ * epoll a todos los espectadores conectados al socket Unix, agrupando en una
+ * sola llamada los mensajes pendientes de cada uno.
+ *
+ * Un espectador lento nunca frena la partida: si lo que le falta por leer ya
+ * ha salido de la historia, salta al último fotograma clave (y sus mensajes
+ * intermedios se pierden); si salta demasiadas veces, se le desconecta. Los
+ * espectadores nuevos empiezan en el último fotograma clave.
+ */
+
+#ifndef _PUBLICADOR_H_
+#define _PUBLICADOR_H_
+
+#include "espectador.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+const size_t HISTORIA_PUBLICADOR = 1024; ///< Mensajes guardados por defecto para los espectadores lentos
+const int MAX_SALTOS_ESPECTADOR = 8; ///< Saltos al fotograma clave tras los que se desconecta a un espectador
+const int BUFFER_ESPECTADOR = 32768; ///< Buffer de envío del núcleo por espectador (la historia hace el resto)
+
+/** @struct EstadisticasPublicador
+ *  @brief Contadores acumulados de un publicador.
+ */
+struct EstadisticasPublicador {
+    long suscriptores; ///< Espectadores conectados ahora
+    long conexiones; ///< Espectadores aceptados en total
+    long mensajes; ///< Mensajes publicados (diferencias y fotogramas clave)
+    long claves; ///< Fotogramas clave publicados
+    long bytesPublicados; ///< Bytes de los mensajes publicados
+    long bytesEnviados; ///< Bytes escritos a todos los espectadores
+    long saltos; ///< Veces que un espectador lento ha saltado al fotograma clave
+    long descartados; ///< Espectadores desconectados por lentos
+};
+
+/** @class Publicador
+ *  @brief Hilo que reparte por un socket Unix lo que publica el bucle del juego.
+ */
+class Publicador {
+public:
+    explicit Publicador(const std::string &ruta, size_t historia = HISTORIA_PUBLICADOR,
+                        uint32_t intervalo = INTERVALO_CLAVES_ESPECTADOR);
+    ~Publicador();
+
+    Publicador(const Publicador &) = delete;
+    Publicador &operator=(const Publicador &) = delete;
+
+    /** @brief Indica si el socket está escuchando.
+     *  @return bool -> false: no se ha podido crear y publica() no hace nada
+     */
+    bool abierto() const {
+        return escucha >= 0;
+    }
+
+    TipoMensaje publica(const EstadoJuego &E);
+    EstadisticasPublicador estadisticas() const;
+
+private:
+    typedef std::shared_ptr<const std::vector<unsigned char>> Mensaje; ///< Mensaje inmutable compartido
+
+    /** @struct Suscriptor
+     *  @brief Espectador conectado y lo que le falta por recibir.
+     */
+    struct Suscriptor {
+        int fd; ///< Socket
+        uint64_t cursor; ///< Siguiente mensaje de la historia que le toca
+        Mensaje actual; ///< Mensaje a medio escribir (nullptr si ninguno)
+        size_t escrito; ///< Bytes ya escritos de actual
+        int saltos; ///< Veces que ha saltado al fotograma clave
+        bool bloqueado; ///< Espera a EPOLLOUT para seguir escribiendo
+    };
+
+    void trabajar();
+    void recogeMensajes();
+    void acepta();
+    bool alcanzaHistoria(Suscriptor &S);
+    void envia(Suscriptor &S);
+    void cierra(int fd);
+
+    std::string ruta; ///< Ruta del socket Unix
+    int escucha; ///< Socket que acepta espectadores
+    int aviso; ///< eventfd con el que publica() despierta al hilo
+    int epoll; ///< Descriptor de epoll del hilo
+    size_t capacidad; ///< Mensajes que se guardan en la historia
+
+    EmisorEspectador M; ///< Codificador (solo lo usa publica())
+    std::vector<unsigned char> codificado; ///< Buffer de publica()
+
+    std::mutex m; ///< Protege entrantes y parar
+    std::vector<std::pair<Mensaje, bool>> entrantes; ///< Mensajes publicados y aún no repartidos (y si son clave)
+    bool parar; ///< Pide al hilo que termine
+
+    std::deque<Mensaje> historia; ///< Últimos mensajes publicados
+    uint64_t primero; ///< Número del primer mensaje de la historia
+    uint64_t ultimaClave; ///< Número del último fotograma clave
+    bool hayClave; ///< Se ha publicado algún fotograma clave
+    std::unordered_map<int, std::unique_ptr<Suscriptor>> suscriptores; ///< Espectadores por descriptor
+
+    std::atomic<long> conexiones, mensajes, claves, bytesPublicados, bytesEnviados, saltos, descartados,
+        activos; ///< Contadores de estadisticas()
+
+    std::thread hilo; ///< Hilo que reparte los mensajes
+};
+
+#endif
@@ -0,0 +1,370 @@
+/**
+ * @file rasgos.cpp
+ * @brief Rasgos de muchos tableros a la vez con instrucciones SIMD
+ *
+ * Los núcleos vectoriales cuentan bits por bytes con una tabla de 16 entradas
+ * (pshufb) y acumulan las cuentas de las FILAS filas en bytes; solo al final
+ * suman los dos bytes de cada tablero. Se compilan con atributos target, así que
+ * el resto del motor no necesita -mavx2 y el binario funciona en cualquier CPU.
+ *
+ * @see rasgos.h
+ */
+
+#include "rasgos.h"
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define RASGOS_X86
+#include <immintrin.h>
+#endif
+
+/// Columnas de una fila
+const unsigned MASCARA_COLUMNAS = (1u << COLUMNAS) - 1;
+/// Parejas de columnas vecinas
+const unsigned MASCARA_PAREJAS = (1u << (COLUMNAS - 1)) - 1;
+/// Parejas de celdas vecinas con las dos paredes
+const unsigned MASCARA_PAREJAS_PAREDES = (1u << (COLUMNAS + 1)) - 1;
+/// Pared derecha en una fila desplazada una columna a la izquierda
+const unsigned PARED_DERECHA = 1u << (COLUMNAS - 1);
+/// Pared derecha en una fila con la pared izquierda en el bit 0
+const unsigned PARED_DERECHA_DESPLAZADA = 1u << (COLUMNAS + 1);
+
+/// Bits del contador de filas cubiertas de cada columna
+const int BITS_ALTURA = 5;
+
+static_assert((1 << BITS_ALTURA) > FILAS, "El contador de altura debe llegar a FILAS");
+static_assert(COLUMNAS + 2 <= 16, "Una fila con sus paredes debe caber en 16 bits");
+static_assert(FILAS * 8 < 256, "Las cuentas de bits por byte de todas las filas deben caber en un byte");
+
+/**
+ * @brief Calcula los rasgos de un tablero celda a celda.
+ * @post Es la definición de cada rasgo, sin trucos de bits: sirve para comprobar
+ *       los núcleos de calculaRasgosLote
+ * @param T Ocupación del tablero
+ * @param R Rasgos calculados
+ */
+void rasgosReferencia(const Ocupacion &T, RasgosTablero &R) {
+    auto llena = [&](int f, int c) { return (T.fila[f] >> c) & 1; };
+    R.altura = R.maxima = R.huecos = R.transiciones = R.pozos = R.rugosidad = 0;
+    for (int c = 0; c < COLUMNAS; ++c) {
+        int f = 0;
+        while (f < FILAS && !llena(f, c)) ++f;
+        R.alturas[c] = FILAS - f;
+        R.altura += R.alturas[c];
+        if (R.alturas[c] > R.maxima) R.maxima = R.alturas[c];
+        for (int g = f + 1; g < FILAS; ++g) R.huecos += !llena(g, c);
+        // Las celdas de pozo están por encima de la columna, entre dos llenas
+        for (int g = 0; g < f; ++g) R.pozos += (c == 0 || llena(g, c - 1)) && (c == COLUMNAS - 1 || llena(g, c + 1));
+    }
+    for (int f = 0; f < FILAS; ++f) {
+        int antes = 1;
+        for (int c = 0; c < COLUMNAS; ++c) {
+            R.transiciones += llena(f, c) != antes;
+            antes = llena(f, c);
+        }
+        R.transiciones += antes != 1;
+    }
+    for (int c = 0; c + 1 < COLUMNAS; ++c) {
+        int d = R.alturas[c] - R.alturas[c + 1];
+        R.rugosidad += d < 0 ? -d : d;
+    }
+}
+
+/**
+ * @brief Prepara un lote vacío.
+ * @param L Lote
+ * @param capacidad Tableros que debe admitir (se redondea a ANCHO_LOTE)
+ */
+void iniciarLote(LoteTableros &L, size_t capacidad) {
+    L.capacidad = (capacidad + ANCHO_LOTE - 1) / ANCHO_LOTE * ANCHO_LOTE;
+    L.filas.assign(size_t(FILAS) * L.capacidad, 0);
+    L.n = 0;
+}
+
+/**
+ * @brief Añade un tablero al lote.
+ * @param L Lote
+ * @param T Ocupación del tablero
+ * @return bool -> false: el lote está lleno
+ */
+bool anadeTablero(LoteTableros &L, const Ocupacion &T) {
+    if (L.n == L.capacidad) return false;
+    for (int f = 0; f < FILAS; ++f) L.filas[size_t(f) * L.capacidad + L.n] = T.fila[f];
+    L.n++;
+    return true;
+}
+
+/**
+ * @brief Núcleo de un tablero cada vez, con los mismos trucos de bits que los vectoriales.
+ * @post Recorre el lote en bloques de ANCHO_LOTE tableros fila a fila, para leer
+ *       la memoria seguida igual que los núcleos vectoriales
+ * @param L Lote
+ * @param R Rasgos
+ */
+static void nucleoEscalar(const LoteTableros &L, RasgosLote &R) {
+    const size_t cap = L.capacidad;
+    for (size_t i = 0; i < cap; i += ANCHO_LOTE) {
+        unsigned cubierta[ANCHO_LOTE] = {0};
+        int huecos[ANCHO_LOTE] = {0}, pozos[ANCHO_LOTE] = {0}, altura[ANCHO_LOTE] = {0}, maxima[ANCHO_LOTE] = {0};
+        int rugosidad[ANCHO_LOTE] = {0}, transiciones[ANCHO_LOTE] = {0};
+        int alturas[ANCHO_LOTE][COLUMNAS] = {{0}};
+        for (int f = 0; f < FILAS; ++f) {
+            const Fila *fila = &L.filas[size_t(f) * cap + i];
+            for (size_t j = 0; j < ANCHO_LOTE; ++j) {
+                unsigned x = fila[j], &cub = cubierta[j];
+                for (unsigned nuevas = x & ~cub; nuevas; nuevas &= nuevas - 1) alturas[j][bitMasBajo(nuevas)] = FILAS - f;
+                huecos[j] += cuentaBits(cub & ~x);
+                pozos[j] += cuentaBits(((x << 1) | 1) & ((x >> 1) | PARED_DERECHA) & ~(x | cub) & MASCARA_COLUMNAS);
+                cub |= x;
+                altura[j] += cuentaBits(cub);
+                maxima[j] += cub != 0;
+                rugosidad[j] += cuentaBits((cub ^ (cub >> 1)) & MASCARA_PAREJAS);
+                unsigned y = (x << 1) | 1 | PARED_DERECHA_DESPLAZADA;
+                transiciones[j] += cuentaBits((y ^ (y >> 1)) & MASCARA_PAREJAS_PAREDES);
+            }
+        }
+        for (size_t j = 0; j < ANCHO_LOTE; ++j) {
+            for (int c = 0; c < COLUMNAS; ++c) R.alturas[size_t(c) * cap + i + j] = uint16_t(alturas[j][c]);
+            R.altura[i + j] = uint16_t(altura[j]);
+            R.maxima[i + j] = uint16_t(maxima[j]);
+            R.huecos[i + j] = uint16_t(huecos[j]);
+            R.transiciones[i + j] = uint16_t(transiciones[j]);
+            R.pozos[i + j] = uint16_t(pozos[j]);
+            R.rugosidad[i + j] = uint16_t(rugosidad[j]);
+        }
+    }
+}
+
+#ifdef RASGOS_X86
+
+/**
+ * @brief Cuenta los bits de cada byte (AVX2).
+ * @param v Vector
+ * @param tabla Bits de cada valor de 4 bits, repetida en cada mitad
+ * @return __m256i -> Bits de cada byte
+ */
+__attribute__((target("avx2"))) static inline __m256i cuentaBytes(__m256i v, __m256i tabla) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i bajo = _mm256_and_si256(v, nibble);
+    __m256i alto = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(tabla, bajo), _mm256_shuffle_epi8(tabla, alto));
+}
+
+/**
+ * @brief Suma los dos bytes de cada palabra de 16 bits (AVX2).
+ * @param v Cuentas por byte
+ * @return __m256i -> Cuenta de cada tablero
+ */
+__attribute__((target("avx2"))) static inline __m256i sumaBytes(__m256i v) {
+    return _mm256_add_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0xFF)), _mm256_srli_epi16(v, 8));
+}
+
+/**
+ * @brief Núcleo AVX2: 16 tableros por instrucción.
+ * @param L Lote
+ * @param R Rasgos
+ */
+__attribute__((target("avx2"))) static void nucleoAvx2(const LoteTableros &L, RasgosLote &R) {
+    const size_t cap = L.capacidad;
+    const __m256i tabla = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+                                           2, 3, 2, 3, 3, 4);
+    const __m256i cero = _mm256_setzero_si256(), uno = _mm256_set1_epi16(1);
+    const __m256i columnas = _mm256_set1_epi16(short(MASCARA_COLUMNAS));
+    const __m256i parejas = _mm256_set1_epi16(short(MASCARA_PAREJAS));
+    const __m256i parejasParedes = _mm256_set1_epi16(short(MASCARA_PAREJAS_PAREDES));
+    const __m256i paredDerecha = _mm256_set1_epi16(short(PARED_DERECHA));
+    const __m256i paredes = _mm256_set1_epi16(short(1 | PARED_DERECHA_DESPLAZADA));
+
+    for (size_t i = 0; i < cap; i += 16) {
+        __m256i cubierta = cero, huecos = cero, pozos = cero, altura = cero, rugosidad = cero, transiciones = cero;
+        __m256i maxima = cero, contador[BITS_ALTURA];
+        for (int k = 0; k < BITS_ALTURA; ++k) contador[k] = cero;
+        for (int f = 0; f < FILAS; ++f) {
+            __m256i x = _mm256_loadu_si256((const __m256i *) &L.filas[size_t(f) * cap + i]);
+            huecos = _mm256_add_epi8(huecos, cuentaBytes(_mm256_andnot_si256(x, cubierta), tabla));
+            __m256i izquierda = _mm256_or_si256(_mm256_slli_epi16(x, 1), uno);
+            __m256i derecha = _mm256_or_si256(_mm256_srli_epi16(x, 1), paredDerecha);
+            __m256i libre = _mm256_andnot_si256(_mm256_or_si256(x, cubierta), columnas);
+            pozos = _mm256_add_epi8(pozos, cuentaBytes(_mm256_and_si256(_mm256_and_si256(izquierda, derecha), libre), tabla));
+            cubierta = _mm256_or_si256(cubierta, x);
+            altura = _mm256_add_epi8(altura, cuentaBytes(cubierta, tabla));
+            // cmpeq da -1 en los tableros aún vacíos: -1 + 1 = 0
+            maxima = _mm256_add_epi16(maxima, _mm256_add_epi16(_mm256_cmpeq_epi16(cubierta, cero), uno));
+            __m256i vecinas = _mm256_and_si256(_mm256_xor_si256(cubierta, _mm256_srli_epi16(cubierta, 1)), parejas);
+            rugosidad = _mm256_add_epi8(rugosidad, cuentaBytes(vecinas, tabla));
+            __m256i y = _mm256_or_si256(_mm256_slli_epi16(x, 1), paredes);
+            __m256i cambios = _mm256_and_si256(_mm256_xor_si256(y, _mm256_srli_epi16(y, 1)), parejasParedes);
+            transiciones = _mm256_add_epi8(transiciones, cuentaBytes(cambios, tabla));
+            // Suma cubierta a un contador de BITS_ALTURA bits por columna
+            __m256i acarreo = cubierta;
+            for (int k = 0; k < BITS_ALTURA; ++k) {
+                __m256i siguiente = _mm256_and_si256(contador[k], acarreo);
+                contador[k] = _mm256_xor_si256(contador[k], acarreo);
+                acarreo = siguiente;
+            }
+        }
+        for (int c = 0; c < COLUMNAS; ++c) {
+            __m256i h = cero;
+            for (int k = 0; k < BITS_ALTURA; ++k) {
+                __m256i b = _mm256_and_si256(_mm256_srli_epi16(contador[k], c), uno);
+                h = _mm256_or_si256(h, _mm256_slli_epi16(b, k));
+            }
+            _mm256_storeu_si256((__m256i *) &R.alturas[size_t(c) * cap + i], h);
+        }
+        _mm256_storeu_si256((__m256i *) &R.altura[i], sumaBytes(altura));
+        _mm256_storeu_si256((__m256i *) &R.maxima[i], maxima);
+        _mm256_storeu_si256((__m256i *) &R.huecos[i], sumaBytes(huecos));
+        _mm256_storeu_si256((__m256i *) &R.transiciones[i], sumaBytes(transiciones));
+        _mm256_storeu_si256((__m256i *) &R.pozos[i], sumaBytes(pozos));
+        _mm256_storeu_si256((__m256i *) &R.rugosidad[i], sumaBytes(rugosidad));
+    }
+}
+
+/**
+ * @brief Cuenta los bits de cada byte (SSE4.1).
+ * @param v Vector
+ * @param tabla Bits de cada valor de 4 bits
+ * @return __m128i -> Bits de cada byte
+ */
+__attribute__((target("sse4.1"))) static inline __m128i cuentaBytes(__m128i v, __m128i tabla) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i bajo = _mm_and_si128(v, nibble);
+    __m128i alto = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+    return _mm_add_epi8(_mm_shuffle_epi8(tabla, bajo), _mm_shuffle_epi8(tabla, alto));
+}
+
+/**
+ * @brief Suma los dos bytes de cada palabra de 16 bits (SSE4.1).
+ * @param v Cuentas por byte
+ * @return __m128i -> Cuenta de cada tablero
+ */
+__attribute__((target("sse4.1"))) static inline __m128i sumaBytes(__m128i v) {
+    return _mm_add_epi16(_mm_and_si128(v, _mm_set1_epi16(0xFF)), _mm_srli_epi16(v, 8));
+}
+
+/**
+ * @brief Núcleo SSE4.1: 8 tableros por instrucción.
+ * @param L Lote
+ * @param R Rasgos
+ */
+__attribute__((target("sse4.1"))) static void nucleoSse(const LoteTableros &L, RasgosLote &R) {
+    const size_t cap = L.capacidad;
+    const __m128i tabla = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m128i cero = _mm_setzero_si128(), uno = _mm_set1_epi16(1);
+    const __m128i columnas = _mm_set1_epi16(short(MASCARA_COLUMNAS));
+    const __m128i parejas = _mm_set1_epi16(short(MASCARA_PAREJAS));
+    const __m128i parejasParedes = _mm_set1_epi16(short(MASCARA_PAREJAS_PAREDES));
+    const __m128i paredDerecha = _mm_set1_epi16(short(PARED_DERECHA));
+    const __m128i paredes = _mm_set1_epi16(short(1 | PARED_DERECHA_DESPLAZADA));
+
+    for (size_t i = 0; i < cap; i += 8) {
+        __m128i cubierta = cero, huecos = cero, pozos = cero, altura = cero, rugosidad = cero, transiciones = cero;
+        __m128i maxima = cero, contador[BITS_ALTURA];
+        for (int k = 0; k < BITS_ALTURA; ++k) contador[k] = cero;
+        for (int f = 0; f < FILAS; ++f) {
+            __m128i x = _mm_loadu_si128((const __m128i *) &L.filas[size_t(f) * cap + i]);
+            huecos = _mm_add_epi8(huecos, cuentaBytes(_mm_andnot_si128(x, cubierta), tabla));
+            __m128i izquierda = _mm_or_si128(_mm_slli_epi16(x, 1), uno);
+            __m128i derecha = _mm_or_si128(_mm_srli_epi16(x, 1), paredDerecha);
+            __m128i libre = _mm_andnot_si128(_mm_or_si128(x, cubierta), columnas);
+            pozos = _mm_add_epi8(pozos, cuentaBytes(_mm_and_si128(_mm_and_si128(izquierda, derecha), libre), tabla));
+            cubierta = _mm_or_si128(cubierta, x);
+            altura = _mm_add_epi8(altura, cuentaBytes(cubierta, tabla));
+            maxima = _mm_add_epi16(maxima, _mm_add_epi16(_mm_cmpeq_epi16(cubierta, cero), uno));
+            __m128i vecinas = _mm_and_si128(_mm_xor_si128(cubierta, _mm_srli_epi16(cubierta, 1)), parejas);
+            rugosidad = _mm_add_epi8(rugosidad, cuentaBytes(vecinas, tabla));
+            __m128i y = _mm_or_si128(_mm_slli_epi16(x, 1), paredes);
+            __m128i cambios = _mm_and_si128(_mm_xor_si128(y, _mm_srli_epi16(y, 1)), parejasParedes);
+            transiciones = _mm_add_epi8(transiciones, cuentaBytes(cambios, tabla));
+            // Suma cubierta a un contador de BITS_ALTURA bits por columna
+            __m128i acarreo = cubierta;
+            for (int k = 0; k < BITS_ALTURA; ++k) {
+                __m128i siguiente = _mm_and_si128(contador[k], acarreo);
+                contador[k] = _mm_xor_si128(contador[k], acarreo);
+                acarreo = siguiente;
+            }
+        }
+        for (int c = 0; c < COLUMNAS; ++c) {
+            __m128i h = cero;
+            for (int k = 0; k < BITS_ALTURA; ++k) {
+                __m128i b = _mm_and_si128(_mm_srli_epi16(contador[k], c), uno);
+                h = _mm_or_si128(h, _mm_slli_epi16(b, k));
+            }
+            _mm_storeu_si128((__m128i *) &R.alturas[size_t(c) * cap + i], h);
+        }
+        _mm_storeu_si128((__m128i *) &R.altura[i], sumaBytes(altura));
+        _mm_storeu_si128((__m128i *) &R.maxima[i], maxima);
+        _mm_storeu_si128((__m128i *) &R.huecos[i], sumaBytes(huecos));
+        _mm_storeu_si128((__m128i *) &R.transiciones[i], sumaBytes(transiciones));
+        _mm_storeu_si128((__m128i *) &R.pozos[i], sumaBytes(pozos));
+        _mm_storeu_si128((__m128i *) &R.rugosidad[i], sumaBytes(rugosidad));
+    }
+}
+
+#endif
+
+/**
+ * @brief Mejor núcleo que admite la CPU.
+ * @return NucleoRasgos -> NUCLEO_AVX2, NUCLEO_SSE o NUCLEO_ESCALAR
+ */
+NucleoRasgos nucleoRasgos() {
+#ifdef RASGOS_X86
+    static const NucleoRasgos mejor = __builtin_cpu_supports("avx2")     ? NUCLEO_AVX2
+                                      : __builtin_cpu_supports("sse4.1") ? NUCLEO_SSE
+                                                                         : NUCLEO_ESCALAR;
+    return mejor;
+#else
+    return NUCLEO_ESCALAR;
+#endif
+}
+
+/**
+ * @brief Calcula los rasgos de todos los tableros de un lote.
+ * @post R tiene capacidad valores por rasgo; los de los huecos sin tablero son
+ *       los de un tablero vacío
+ * @param L Lote
+ * @param R Rasgos (se redimensionan si hace falta)
+ * @param nucleo Núcleo a usar; si la CPU no lo admite, el mejor que admita
+ * @return NucleoRasgos -> Núcleo usado
+ */
+NucleoRasgos calculaRasgosLote(const LoteTableros &L, RasgosLote &R, NucleoRasgos nucleo) {
+    const size_t cap = L.capacidad;
+    if (R.altura.size() != cap) {
+        R.alturas.resize(size_t(COLUMNAS) * cap);
+        for (auto *v : {&R.altura, &R.maxima, &R.huecos, &R.transiciones, &R.pozos, &R.rugosidad}) v->resize(cap);
+    }
+    NucleoRasgos disponible = nucleoRasgos();
+    if (nucleo == NUCLEO_AUTO || nucleo > disponible) nucleo = disponible;
+    switch (nucleo) {
+#ifdef RASGOS_X86
+        case NUCLEO_AVX2:
+            nucleoAvx2(L, R);
+            break;
+        case NUCLEO_SSE:
+            nucleoSse(L, R);
+            break;
+#endif
+        default:
+            nucleo = NUCLEO_ESCALAR;
+            nucleoEscalar(L, R);
+            break;
+    }
+    return nucleo;
+}
+
+/**
+ * @brief Copia los rasgos de un tablero del lote.
+ * @param R Rasgos del lote
+ * @param L Lote
+ * @param i Tablero
+ * @param T Rasgos del tablero
+ */
+void rasgosDeLote(const RasgosLote &R, const LoteTableros &L, size_t i, RasgosTablero &T) {
+    for (int c = 0; c < COLUMNAS; ++c) T.alturas[c] = R.alturas[size_t(c) * L.capacidad + i];
+    T.altura = R.altura[i];
+    T.maxima = R.maxima[i];
+    T.huecos = R.huecos[i];
+    T.transiciones = R.transiciones[i];
+    T.pozos = R.pozos[i];
+    T.rugosidad = R.rugosidad[i];
+}
@@ -0,0 +1,79 @@
+/**
+ * @file rasgos.h
+ * @brief Rasgos de muchos tableros a la vez con instrucciones SIMD
+ *
+ * La búsqueda de colocaciones puntúa cientos de tableros candidatos con los
+ * mismos rasgos. Aquí los tableros se guardan en un LoteTableros por filas (la
+ * fila r de todos los tableros seguida, SoA) y calculaRasgosLote calcula los
+ * rasgos de 16 tableros por instrucción con AVX2, de 8 con SSE4.1 o de uno en uno
+ * en otras CPU. El núcleo se elige al ejecutar según la CPU y el resultado es
+ * idéntico en todos: son sumas de enteros.
+ *
+ * Todos los rasgos salen de una pasada por las filas de arriba a abajo con la
+ * unión de las filas ya vistas (cubierta): la altura de una columna es el número
+ * de filas en que está cubierta, y la diferencia de alturas entre dos columnas
+ * vecinas es el número de filas en que una está cubierta y la otra no.
+ */
+
+#ifndef _RASGOS_H_
+#define _RASGOS_H_
+
+#include "tablero.h"
+#include <cstddef>
+#include <vector>
+
+const size_t ANCHO_LOTE = 16; ///< Tableros por vector AVX2: la capacidad de un lote es múltiplo de esto
+
+/** @enum NucleoRasgos
+ *  @brief Implementación de calculaRasgosLote.
+ */
+enum NucleoRasgos {
+    NUCLEO_AUTO, ///< El mejor que admita la CPU
+    NUCLEO_ESCALAR, ///< Un tablero cada vez
+    NUCLEO_SSE, ///< 8 tableros por instrucción (SSE4.1)
+    NUCLEO_AVX2 ///< 16 tableros por instrucción (AVX2)
+};
+
+/** @struct RasgosTablero
+ *  @brief Rasgos de un tablero.
+ */
+struct RasgosTablero {
+    int alturas[COLUMNAS]; ///< Altura de cada columna (0: vacía)
+    int altura; ///< Suma de alturas de las columnas
+    int maxima; ///< Altura de la columna más alta
+    int huecos; ///< Celdas vacías con algún bloque encima en su columna
+    int transiciones; ///< Cambios entre celda llena y vacía a lo largo de cada fila (las paredes cuentan como llenas)
+    int pozos; ///< Celdas vacías sin nada encima y con las dos vecinas (o la pared) llenas
+    int rugosidad; ///< Suma de |altura[c] - altura[c + 1]|
+};
+
+/** @struct LoteTableros
+ *  @brief Tableros guardados por filas: la fila r del tablero i está en filas[r * capacidad + i].
+ */
+struct LoteTableros {
+    std::vector<Fila> filas; ///< FILAS x capacidad máscaras (los huecos sin tablero, a 0)
+    size_t capacidad; ///< Tableros que caben (múltiplo de ANCHO_LOTE)
+    size_t n; ///< Tableros guardados
+};
+
+/** @struct RasgosLote
+ *  @brief Rasgos de un lote, también por rasgo: el valor del tablero i está en la posición i.
+ */
+struct RasgosLote {
+    std::vector<uint16_t> alturas; ///< COLUMNAS x capacidad: alturas[c * capacidad + i]
+    std::vector<uint16_t> altura; ///< Suma de alturas
+    std::vector<uint16_t> maxima; ///< Altura máxima
+    std::vector<uint16_t> huecos; ///< Huecos
+    std::vector<uint16_t> transiciones; ///< Transiciones en las filas
+    std::vector<uint16_t> pozos; ///< Celdas de pozo
+    std::vector<uint16_t> rugosidad; ///< Rugosidad
+};
+
+void rasgosReferencia(const Ocupacion &T, RasgosTablero &R);
+void iniciarLote(LoteTableros &L, size_t capacidad);
+bool anadeTablero(LoteTableros &L, const Ocupacion &T);
+NucleoRasgos nucleoRasgos();
+NucleoRasgos calculaRasgosLote(const LoteTableros &L, RasgosLote &R, NucleoRasgos nucleo = NUCLEO_AUTO);
+void rasgosDeLote(const RasgosLote &R, const LoteTableros &L, size_t i, RasgosTablero &T);
+
+#endif
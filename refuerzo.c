@@ -0,0 +1,90 @@
+/**
+ * @file refuerzo.c
+ * @brief Mide la biblioteca tetrisrl desde C con una política al azar
+ *
+ * Uso: refuerzo [--entornos B] [--pasos N] [--semilla S] [--bolsa]
+ *
+ * Crea B entornos (1024 por defecto) y los avanza N veces (10000) con acciones
+ * al azar, como haría un entrenador: los buffers de acciones, observaciones,
+ * recompensas y finales se reservan una vez y se reutilizan en cada llamada.
+ * Muestra:
+ *
+ *     entornos pasos pasos/s partidas recompensa_media_por_partida
+ *
+ * Está escrito en C para comprobar que entorno.h se usa sin C++.
+ */
+
+#include "entorno.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Segundos del reloj del sistema.
+ * @return double -> Segundos
+ */
+static double segundos(void) {
+    struct timespec t;
+    timespec_get(&t, TIME_UTC);
+    return (double) t.tv_sec + (double) t.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t b = 1024;
+    long pasos = 10000;
+    uint64_t semilla = 1, azar;
+    int bolsa = 0, i;
+    for (i = 1; i < argc; ++i) {
+        int valor = i + 1 < argc;
+        if (strcmp(argv[i], "--entornos") == 0 && valor) b = (uint32_t) atol(argv[++i]);
+        else if (strcmp(argv[i], "--pasos") == 0 && valor) pasos = atol(argv[++i]);
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) semilla = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--bolsa") == 0) bolsa = 1;
+        else {
+            fprintf(stderr, "Uso: %s [--entornos B] [--pasos N] [--semilla S] [--bolsa]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (tetris_version() != TETRIS_RL_VERSION) {
+        fprintf(stderr, "Versión de tetrisrl %u, se esperaba %d\n", tetris_version(), TETRIS_RL_VERSION);
+        return 1;
+    }
+
+    TetrisEntornos *e = tetris_crear(b, semilla, bolsa);
+    uint8_t *acciones = malloc(b);
+    TetrisObservacion *obs = malloc(b * sizeof(TetrisObservacion));
+    float *recompensas = malloc(b * sizeof(float));
+    uint8_t *terminados = malloc(b);
+    if (e == NULL || acciones == NULL || obs == NULL || recompensas == NULL || terminados == NULL) {
+        fprintf(stderr, "No hay memoria para %u entornos\n", b);
+        return 1;
+    }
+    tetris_reiniciar(e, obs);
+
+    /* Acciones al azar con un generador lineal: NADA la mitad de las veces */
+    azar = semilla * 2862933555777941757ull + 3037000493ull;
+    long partidas = 0;
+    double recompensa = 0, inicio = segundos(), tiempo;
+    long k;
+    for (k = 0; k < pasos; ++k) {
+        uint32_t j;
+        for (j = 0; j < b; ++j) {
+            azar = azar * 6364136223846793005ull + 1442695040888963407ull;
+            uint32_t x = (uint32_t) (azar >> 33);
+            acciones[j] = (uint8_t) (x & 1 ? 0 : 1 + (x >> 1) % (TETRIS_ACCIONES - 1));
+        }
+        partidas += tetris_pasos(e, acciones, obs, recompensas, terminados);
+        for (j = 0; j < b; ++j) recompensa += recompensas[j];
+    }
+    tiempo = segundos() - inicio;
+
+    printf("%u %ld %.0f %ld %.1f\n", b, pasos * (long) b, (double) pasos * b / tiempo, partidas,
+           partidas > 0 ? recompensa / (double) partidas : 0.0);
+    tetris_destruir(e);
+    free(acciones);
+    free(obs);
+    free(recompensas);
+    free(terminados);
+    return 0;
+}
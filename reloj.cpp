@@ -0,0 +1,128 @@
+/**
+ * @file reloj.cpp
+ * @brief Paso de tiempo fijo para los bucles de juego
+ *
+ * @see reloj.h
+ */
+
+#include "reloj.h"
+#include <thread>
+
+/**
+ * @brief Prepara un reloj de paso fijo.
+ * @post El primer ticksPendientes devuelve ya un tick, sin esperar
+ * @param R Reloj
+ * @param tickMs Milisegundos por tick
+ * @param maxSeguidos Ticks atrasados que se simulan como mucho en una vuelta
+ */
+void iniciarRelojFijo(RelojFijo &R, double tickMs, int maxSeguidos) {
+    R.tick = std::chrono::duration_cast<RelojFijo::Reloj::duration>(std::chrono::duration<double, std::milli>(tickMs));
+    if (R.tick <= RelojFijo::Reloj::duration::zero()) R.tick = RelojFijo::Reloj::duration(1);
+    R.acumulado = R.tick;
+    R.ultimo = RelojFijo::Reloj::now();
+    R.maxSeguidos = maxSeguidos < 1 ? 1 : maxSeguidos;
+    R.ticks = 0;
+    R.descartados = 0;
+    R.ventana = R.ultimo;
+    R.ticksVentana = 0;
+    R.jitterVentana = 0;
+    R.jitterMaxVentana = 0;
+    R.esperasVentana = 0;
+    R.medido = {0, 0, 0, 0, 0};
+}
+
+/**
+ * @brief Cierra el segundo de medida si ya ha pasado.
+ * @param R Reloj
+ * @param ahora Lectura actual del reloj
+ */
+static void cierraVentana(RelojFijo &R, RelojFijo::Reloj::time_point ahora) {
+    double s = std::chrono::duration<double>(ahora - R.ventana).count();
+    if (s < 1) return;
+    R.medido.hz = double(R.ticksVentana) / s;
+    R.medido.jitterMedioMs = R.esperasVentana > 0 ? R.jitterVentana / double(R.esperasVentana) : 0;
+    R.medido.jitterMaxMs = R.jitterMaxVentana;
+    R.ventana = ahora;
+    R.ticksVentana = 0;
+    R.jitterVentana = 0;
+    R.jitterMaxVentana = 0;
+    R.esperasVentana = 0;
+}
+
+/**
+ * @brief Ticks que hay que simular ahora.
+ * @post Suma al acumulado el tiempo real desde la última lectura y le quita los
+ *       ticks devueltos. Si van más de maxSeguidos atrasados, el resto se
+ *       descarta: la partida se frena en lugar de simular a saltos.
+ * @param R Reloj
+ * @return int -> Ticks a simular (0..maxSeguidos)
+ */
+int ticksPendientes(RelojFijo &R) {
+    RelojFijo::Reloj::time_point ahora = RelojFijo::Reloj::now();
+    R.acumulado += ahora - R.ultimo;
+    R.ultimo = ahora;
+    long n = long(R.acumulado / R.tick);
+    R.acumulado -= n * R.tick;
+    if (n > R.maxSeguidos) {
+        R.descartados += n - R.maxSeguidos;
+        n = R.maxSeguidos;
+    }
+    R.ticks += n;
+    R.ticksVentana += n;
+    cierraVentana(R, ahora);
+    return int(n);
+}
+
+/**
+ * @brief Simula ya el siguiente tick en lugar de esperar a su instante.
+ * @post Descuenta el tick del acumulado, así que el ritmo medio no cambia: el
+ *       tick siguiente llega un tick más tarde. Solo se puede ir un tick por delante.
+ * @param R Reloj (recién leído con ticksPendientes)
+ * @return bool -> true: hay que simular un tick ahora
+ */
+bool adelantaTick(RelojFijo &R) {
+    if (R.acumulado < RelojFijo::Reloj::duration::zero()) return false;
+    R.acumulado -= R.tick;
+    R.ticks++;
+    R.ticksVentana++;
+    return true;
+}
+
+/**
+ * @brief Milisegundos enteros que faltan para el siguiente tick.
+ * @post Redondea hacia abajo, para que una espera de ese tiempo no se pase del tick
+ * @param R Reloj
+ * @return int -> Milisegundos (0 si ya ha llegado o falta menos de uno)
+ */
+int msHastaTick(const RelojFijo &R) {
+    RelojFijo::Reloj::time_point limite = R.ultimo + (R.tick - R.acumulado);
+    long ms = long(std::chrono::duration_cast<std::chrono::milliseconds>(limite - RelojFijo::Reloj::now()).count());
+    return ms > 0 ? int(ms) : 0;
+}
+
+/**
+ * @brief Duerme hasta el instante del siguiente tick.
+ * @post Vuelve enseguida si ya ha pasado. El retraso al despertar cuenta como jitter.
+ * @param R Reloj
+ */
+void esperaTick(RelojFijo &R) {
+    RelojFijo::Reloj::time_point limite = R.ultimo + (R.tick - R.acumulado);
+    std::this_thread::sleep_until(limite);
+    double tarde = std::chrono::duration<double, std::milli>(RelojFijo::Reloj::now() - limite).count();
+    if (tarde < 0) tarde = 0;
+    R.jitterVentana += tarde;
+    if (tarde > R.jitterMaxVentana) R.jitterMaxVentana = tarde;
+    R.esperasVentana++;
+}
+
+/**
+ * @brief Medidas de un reloj.
+ * @param R Reloj
+ * @return EstadisticasReloj -> Ritmo y jitter del último segundo completo y totales
+ */
+EstadisticasReloj estadisticasReloj(const RelojFijo &R) {
+    EstadisticasReloj S = R.medido;
+    S.ticks = R.ticks;
+    S.descartados = R.descartados;
+    return S;
+}
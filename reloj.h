@@ -0,0 +1,66 @@
+/**
+ * @file reloj.h
+ * @brief Paso de tiempo fijo para los bucles de juego
+ *
+ * La gravedad cuenta frames de paso(), así que la velocidad de caída solo es
+ * la misma en cualquier máquina si los frames se simulan a ritmo fijo. RelojFijo
+ * acumula el tiempo real medido con steady_clock y dice cuántos ticks tocan en
+ * cada vuelta del bucle: si pintar o leer el teclado tarda, se simulan los ticks
+ * atrasados de golpe (hasta un máximo, para no entrar en una espiral de retraso)
+ * en lugar de retrasar la partida. Entre vueltas se duerme hasta el instante del
+ * siguiente tick, no una duración fija.
+ *
+ * Para que una tecla no espere al siguiente tick, el bucle puede dormir en
+ * espera_evento hasta el instante del tick (msHastaTick) y, si llega una tecla,
+ * simular ese tick por adelantado (adelantaTick).
+ *
+ * También mide los ticks por segundo reales y el jitter: cuánto tarda el
+ * sistema en despertar al bucle después del instante pedido.
+ */
+
+#ifndef _RELOJ_H_
+#define _RELOJ_H_
+
+#include <chrono>
+
+const double TICK_JUEGO_MS = 30; ///< Duración de un frame de paso() en las partidas con pantalla
+const int MAX_TICKS_SEGUIDOS = 8; ///< Ticks atrasados que se simulan como mucho en una vuelta
+
+/** @struct EstadisticasReloj
+ *  @brief Medidas del último segundo completo de un RelojFijo.
+ */
+struct EstadisticasReloj {
+    double hz; ///< Ticks simulados por segundo
+    double jitterMedioMs; ///< Retraso medio al despertar respecto al siguiente tick
+    double jitterMaxMs; ///< Retraso máximo al despertar
+    long ticks; ///< Ticks simulados desde el principio
+    long descartados; ///< Ticks que no se simularon por ir más de MAX_TICKS_SEGUIDOS atrasado
+};
+
+/** @struct RelojFijo
+ *  @brief Acumulador de tiempo real para simular a ritmo fijo.
+ */
+struct RelojFijo {
+    typedef std::chrono::steady_clock Reloj; ///< Reloj monótono
+    Reloj::duration tick; ///< Duración de un tick
+    Reloj::duration acumulado; ///< Tiempo real aún no simulado (menos de un tick tras ticksPendientes; negativo si se adelantó uno)
+    Reloj::time_point ultimo; ///< Última lectura del reloj
+    int maxSeguidos; ///< Ticks atrasados que se simulan como mucho en una vuelta
+    long ticks; ///< Ticks simulados
+    long descartados; ///< Ticks descartados por retraso
+    Reloj::time_point ventana; ///< Inicio del segundo que se está midiendo
+    long ticksVentana; ///< Ticks del segundo que se está midiendo
+    double jitterVentana; ///< Suma de retrasos al despertar en el segundo actual (ms)
+    double jitterMaxVentana; ///< Retraso máximo al despertar en el segundo actual (ms)
+    long esperasVentana; ///< Esperas en el segundo actual
+    EstadisticasReloj medido; ///< Medidas del último segundo completo
+};
+
+void iniciarRelojFijo(RelojFijo &R, double tickMs = TICK_JUEGO_MS, int maxSeguidos = MAX_TICKS_SEGUIDOS);
+int ticksPendientes(RelojFijo &R);
+bool adelantaTick(RelojFijo &R);
+int msHastaTick(const RelojFijo &R);
+void esperaTick(RelojFijo &R);
+EstadisticasReloj estadisticasReloj(const RelojFijo &R);
+
+#endif
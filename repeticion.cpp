@@ -0,0 +1,286 @@
+/**
+ * @file repeticion.cpp
+ * @brief Grabación y reproducción de partidas
+ *
+ * @see repeticion.h
+ */
+
+#include "repeticion.h"
+#include <cstdio>
+#include <cstring>
+
+/// Bytes de un fotograma clave: posición del evento, frame del anterior e instantánea
+const size_t TAM_CLAVE = 8 + sizeof(Instantanea);
+
+/**
+ * @brief Añade un entero de 32 bits en little-endian.
+ * @param v Destino
+ * @param x Valor
+ */
+static void pon32(std::vector<unsigned char> &v, uint32_t x) {
+    for (int i = 0; i < 4; ++i) v.push_back((unsigned char) (x >> (8 * i)));
+}
+
+/**
+ * @brief Añade un entero de 64 bits en little-endian.
+ * @param v Destino
+ * @param x Valor
+ */
+static void pon64(std::vector<unsigned char> &v, uint64_t x) {
+    pon32(v, uint32_t(x));
+    pon32(v, uint32_t(x >> 32));
+}
+
+/**
+ * @brief Lee un entero de 32 bits en little-endian.
+ * @param p Origen
+ * @return uint32_t -> Valor
+ */
+static uint32_t lee32(const unsigned char *p) {
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+/**
+ * @brief Lee un entero de 64 bits en little-endian.
+ * @param p Origen
+ * @return uint64_t -> Valor
+ */
+static uint64_t lee64(const unsigned char *p) {
+    return uint64_t(lee32(p)) | uint64_t(lee32(p + 4)) << 32;
+}
+
+/**
+ * @brief Empieza a grabar una partida.
+ * @pre La partida se ha iniciado con iniciarJuego(E, semilla, modo)
+ * @param G Grabación
+ * @param semilla Semilla de la partida
+ * @param modo Modo del generador de piezas
+ * @param intervalo Frames entre fotogramas clave
+ */
+void iniciarGrabacion(Grabacion &G, uint64_t semilla, ModoAzar modo, uint32_t intervalo) {
+    G.semilla = semilla;
+    G.modo = modo;
+    G.intervalo = intervalo > 0 ? intervalo : INTERVALO_CLAVES;
+    G.frames = 0;
+    G.ultimo = 0;
+    G.eventos.clear();
+    G.claves.clear();
+}
+
+/**
+ * @brief Graba la acción de un frame.
+ * @pre Se llama justo antes de paso(E, a)
+ * @post Cada intervalo frames guarda además un fotograma clave con el estado E
+ * @param G Grabación
+ * @param E Estado de la partida antes del frame
+ * @param a Acción del frame
+ */
+void grabaFrame(Grabacion &G, const EstadoJuego &E, Accion a) {
+    if (G.frames % G.intervalo == 0) {
+        pon32(G.claves, uint32_t(G.eventos.size()));
+        pon32(G.claves, G.ultimo);
+        Instantanea I;
+        guardaInstantanea(E, I);
+        for (uint64_t w : I.bits) pon64(G.claves, w);
+    }
+    if (a != NADA) {
+        uint64_t v = uint64_t(G.frames - G.ultimo) << 3 | uint64_t(a);
+        while (v >= 0x80) {
+            G.eventos.push_back((unsigned char) (v | 0x80));
+            v >>= 7;
+        }
+        G.eventos.push_back((unsigned char) v);
+        G.ultimo = G.frames;
+    }
+    G.frames++;
+}
+
+/**
+ * @brief Construye el fichero completo de una grabación.
+ * @param G Grabación
+ * @param E Estado de la partida al terminar (para el pie)
+ * @param datos Bytes del fichero (se reemplazan)
+ */
+void serializaGrabacion(const Grabacion &G, const EstadoJuego &E, std::vector<unsigned char> &datos) {
+    datos.clear();
+    datos.reserve(CABECERA_REPETICION + G.eventos.size() + G.claves.size() + PIE_REPETICION);
+    datos.insert(datos.end(), {'T', 'T', 'R', 'P', (unsigned char) VERSION_REPETICION, (unsigned char) G.modo, 0, 0});
+    pon64(datos, G.semilla);
+    pon32(datos, G.intervalo);
+    pon32(datos, uint32_t(TAM_CLAVE));
+
+    datos.insert(datos.end(), G.eventos.begin(), G.eventos.end());
+    datos.insert(datos.end(), G.claves.begin(), G.claves.end());
+
+    pon32(datos, uint32_t(G.eventos.size()));
+    pon32(datos, uint32_t(G.claves.size() / TAM_CLAVE));
+    pon32(datos, G.frames);
+    pon32(datos, uint32_t(E.ptos));
+    pon32(datos, uint32_t(E.level));
+    pon32(datos, uint32_t(E.lineas));
+    pon32(datos, uint32_t(E.piezas));
+    datos.insert(datos.end(), {(unsigned char) E.fin, 0, 0, 0, 'T', 'T', 'R', 'F'});
+}
+
+/**
+ * @brief Escribe una grabación en un fichero.
+ * @param G Grabación
+ * @param E Estado de la partida al terminar (para el pie)
+ * @param fichero Ruta del fichero
+ * @return bool -> true: se ha escrito entero
+ */
+bool guardaGrabacion(const Grabacion &G, const EstadoJuego &E, const char *fichero) {
+    std::vector<unsigned char> datos;
+    serializaGrabacion(G, E, datos);
+    FILE *f = fopen(fichero, "wb");
+    if (!f) return false;
+    bool ok = fwrite(datos.data(), 1, datos.size(), f) == datos.size();
+    return fclose(f) == 0 && ok;
+}
+
+/**
+ * @brief Interpreta una repetición en memoria.
+ * @post R apunta dentro de datos, que debe seguir vivo mientras se use R
+ * @param R Repetición
+ * @param datos Bytes del fichero
+ * @param n Número de bytes
+ * @return bool -> true: el formato es válido
+ */
+bool leeRepeticion(Repeticion &R, const unsigned char *datos, size_t n) {
+    if (n < CABECERA_REPETICION + PIE_REPETICION) return false;
+    const unsigned char *pie = datos + n - PIE_REPETICION;
+    if (memcmp(datos, "TTRP", 4) != 0 || memcmp(pie + 32, "TTRF", 4) != 0) return false;
+    if (datos[4] != VERSION_REPETICION || datos[5] > AZAR_BOLSA || lee32(datos + 20) != TAM_CLAVE) return false;
+
+    R.semilla = lee64(datos + 8);
+    R.modo = ModoAzar(datos[5]);
+    R.intervalo = lee32(datos + 16);
+    R.bytesEventos = lee32(pie);
+    R.numClaves = lee32(pie + 4);
+    if (R.intervalo == 0 || pie[28] > VICTORIA) return false;
+    if (CABECERA_REPETICION + R.bytesEventos + uint64_t(R.numClaves) * TAM_CLAVE + PIE_REPETICION != n) return false;
+    R.eventos = datos + CABECERA_REPETICION;
+    R.claves = R.eventos + R.bytesEventos;
+
+    R.final.frames = lee32(pie + 8);
+    R.final.ptos = int(lee32(pie + 12));
+    R.final.level = int(lee32(pie + 16));
+    R.final.lineas = int(lee32(pie + 20));
+    R.final.piezas = int(lee32(pie + 24));
+    R.final.fin = Fin(pie[28]);
+    return true;
+}
+
+/**
+ * @brief Lee un fichero entero.
+ * @param fichero Ruta del fichero
+ * @param datos Contenido (se reemplaza)
+ * @return bool -> true: se ha leído
+ */
+bool cargaFichero(const char *fichero, std::vector<unsigned char> &datos) {
+    FILE *f = fopen(fichero, "rb");
+    if (!f) return false;
+    datos.clear();
+    unsigned char bloque[65536];
+    size_t leidos;
+    while ((leidos = fread(bloque, 1, sizeof(bloque), f)) > 0) {
+        datos.insert(datos.end(), bloque, bloque + leidos);
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+/**
+ * @brief Decodifica el siguiente evento.
+ * @pre P.proximo es el frame del evento anterior
+ * @post P.proximo y P.accion describen el nuevo evento pendiente, o proximo = UINT32_MAX
+ * @param P Reproductor
+ */
+static void leeEvento(Reproductor &P) {
+    const Repeticion &R = *P.R;
+    uint64_t v = 0;
+    for (int desp = 0; P.pos < R.bytesEventos && desp < 64; desp += 7) {
+        unsigned char b = R.eventos[P.pos++];
+        v |= uint64_t(b & 0x7F) << desp;
+        if (!(b & 0x80)) {
+            P.proximo += uint32_t(v >> 3);
+            P.accion = Accion(v & 7);
+            return;
+        }
+    }
+    P.proximo = UINT32_MAX;
+    P.accion = NADA;
+}
+
+/**
+ * @brief Prepara la reproducción desde el principio.
+ * @param P Reproductor
+ * @param R Repetición (debe seguir viva mientras se use P)
+ */
+void iniciarReproductor(Reproductor &P, const Repeticion &R) {
+    P.R = &R;
+    buscaFrame(P, 0);
+}
+
+/**
+ * @brief Salta a un frame de la partida.
+ * @post Restaura el fotograma clave anterior y simula como mucho un intervalo de frames
+ * @param P Reproductor
+ * @param frame Frame de destino (se limita a los frames grabados)
+ */
+void buscaFrame(Reproductor &P, uint32_t frame) {
+    const Repeticion &R = *P.R;
+    if (frame > R.final.frames) frame = R.final.frames;
+    uint32_t k = frame / R.intervalo;
+    iniciarJuego(P.E, R.semilla, R.modo);
+    P.frame = 0;
+    P.pos = 0;
+    P.proximo = 0;
+    // El primer fotograma clave es el estado inicial: desde el principio no hace falta
+    if (k > 0 && R.numClaves > 0) {
+        if (k >= R.numClaves) k = R.numClaves - 1;
+        const unsigned char *c = R.claves + size_t(k) * TAM_CLAVE;
+        P.pos = lee32(c);
+        P.proximo = lee32(c + 4);
+        Instantanea I;
+        for (int w = 0; w < 4; ++w) I.bits[w] = lee64(c + 8 + 8 * w);
+        restauraInstantanea(P.E, I);
+        P.frame = k * R.intervalo;
+    }
+    leeEvento(P);
+    avanzaHasta(P, frame);
+}
+
+/**
+ * @brief Simula el siguiente frame con la acción grabada.
+ * @param P Reproductor
+ * @return int -> Indicadores Cambio devueltos por paso
+ */
+int avanzaFrame(Reproductor &P) {
+    Accion a = NADA;
+    if (P.frame == P.proximo) {
+        a = P.accion;
+        leeEvento(P);
+    }
+    P.frame++;
+    return paso(P.E, a);
+}
+
+/**
+ * @brief Simula hasta llegar a un frame sin pintar nada.
+ * @param P Reproductor
+ * @param frame Frame de destino (se limita a los frames grabados)
+ */
+void avanzaHasta(Reproductor &P, uint32_t frame) {
+    if (frame > P.R->final.frames) frame = P.R->final.frames;
+    while (P.frame < frame) {
+        // Entre eventos todos los frames son NADA
+        uint32_t hasta = P.proximo < frame ? P.proximo : frame;
+        while (P.frame < hasta) {
+            paso(P.E, NADA);
+            P.frame++;
+        }
+        if (P.frame < frame) avanzaFrame(P);
+    }
+}
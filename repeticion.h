@@ -0,0 +1,100 @@
+/**
+ * @file repeticion.h
+ * @brief Grabación y reproducción de partidas
+ *
+ * Una partida queda determinada por la semilla, el modo del generador y la
+ * acción de cada frame, así que basta con grabar las acciones. Casi todos los
+ * frames son NADA: solo se guardan los demás, cada uno como un varint
+ * (frames desde el evento anterior << 3 | acción).
+ *
+ * Formato del fichero (enteros little-endian):
+ * - Cabecera (24 bytes): "TTRP", versión, modo, 2 bytes libres, semilla (8),
+ *   intervalo entre fotogramas clave (4) y tamaño de cada estado guardado (4).
+ * - Eventos: la secuencia de varints.
+ * - Fotogramas clave: uno cada intervalo frames, con la posición del siguiente
+ *   evento (4), el frame del evento anterior (4) y la Instantanea de la partida
+ *   (32, cuatro palabras de 64 bits). Con ellos se salta a cualquier frame
+ *   simulando como mucho un intervalo; tras un salto el tablero se pinta sin
+ *   los colores originales (ver instantanea.h).
+ * - Pie (36 bytes): bytes de eventos, fotogramas clave, frames jugados, puntos,
+ *   nivel, líneas, piezas, fin, 3 bytes libres y "TTRF". Como tiene tamaño fijo,
+ *   el resultado se lee sin recorrer el fichero.
+ */
+
+#ifndef _REPETICION_H_
+#define _REPETICION_H_
+
+#include "instantanea.h"
+#include <cstddef>
+#include <vector>
+
+const int VERSION_REPETICION = 2; ///< Versión del formato
+const uint32_t INTERVALO_CLAVES = 512; ///< Frames entre fotogramas clave por defecto
+const size_t CABECERA_REPETICION = 24; ///< Bytes de la cabecera
+const size_t PIE_REPETICION = 36; ///< Bytes del pie
+
+/** @struct ResultadoRepeticion
+ *  @brief Resultado final guardado en el pie de la repetición.
+ */
+struct ResultadoRepeticion {
+    uint32_t frames; ///< Frames jugados (llamadas a paso)
+    int ptos; ///< Puntos finales
+    int level; ///< Nivel final
+    int lineas; ///< Filas quitadas
+    int piezas; ///< Piezas fijadas
+    Fin fin; ///< Cómo terminó (EN_JUEGO si se interrumpió)
+};
+
+/** @struct Grabacion
+ *  @brief Repetición en construcción mientras se juega.
+ */
+struct Grabacion {
+    uint64_t semilla; ///< Semilla de la partida
+    ModoAzar modo; ///< Modo del generador de piezas
+    uint32_t intervalo; ///< Frames entre fotogramas clave
+    uint32_t frames; ///< Frames grabados
+    uint32_t ultimo; ///< Frame del último evento grabado
+    std::vector<unsigned char> eventos; ///< Varints de los eventos
+    std::vector<unsigned char> claves; ///< Fotogramas clave ya serializados
+};
+
+void iniciarGrabacion(Grabacion &G, uint64_t semilla, ModoAzar modo, uint32_t intervalo = INTERVALO_CLAVES);
+void grabaFrame(Grabacion &G, const EstadoJuego &E, Accion a);
+void serializaGrabacion(const Grabacion &G, const EstadoJuego &E, std::vector<unsigned char> &datos);
+bool guardaGrabacion(const Grabacion &G, const EstadoJuego &E, const char *fichero);
+
+/** @struct Repeticion
+ *  @brief Vista de solo lectura de una repetición en memoria (no copia los datos).
+ */
+struct Repeticion {
+    uint64_t semilla; ///< Semilla de la partida
+    ModoAzar modo; ///< Modo del generador de piezas
+    uint32_t intervalo; ///< Frames entre fotogramas clave
+    const unsigned char *eventos; ///< Varints de los eventos
+    size_t bytesEventos; ///< Bytes de eventos
+    const unsigned char *claves; ///< Fotogramas clave
+    uint32_t numClaves; ///< Número de fotogramas clave
+    ResultadoRepeticion final; ///< Resultado guardado en el pie
+};
+
+bool leeRepeticion(Repeticion &R, const unsigned char *datos, size_t n);
+bool cargaFichero(const char *fichero, std::vector<unsigned char> &datos);
+
+/** @struct Reproductor
+ *  @brief Partida en reproducción.
+ */
+struct Reproductor {
+    const Repeticion *R; ///< Repetición que se reproduce
+    EstadoJuego E; ///< Estado de la partida
+    uint32_t frame; ///< Frames ya simulados
+    size_t pos; ///< Byte del evento siguiente al pendiente
+    uint32_t proximo; ///< Frame del evento pendiente (UINT32_MAX: no quedan)
+    Accion accion; ///< Acción del evento pendiente
+};
+
+void iniciarReproductor(Reproductor &P, const Repeticion &R);
+void buscaFrame(Reproductor &P, uint32_t frame);
+int avanzaFrame(Reproductor &P);
+void avanzaHasta(Reproductor &P, uint32_t frame);
+
+#endif
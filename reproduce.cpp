@@ -0,0 +1,72 @@
+/**
+ * @file reproduce.cpp
+ * @brief Reproducción sin pantalla de una repetición grabada
+ *
+ * Simula la partida a toda velocidad y comprueba que el resultado coincide con
+ * el guardado en el pie. Con --frame salta a ese frame usando los fotogramas
+ * clave y muestra el estado en ese punto.
+ *
+ * Uso: reproduce <fichero> [--frame F] [--veces N]
+ *
+ * Con --veces repite la reproducción completa N veces para medir frames por segundo.
+ */
+
+#include "repeticion.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        cerr << "Uso: " << argv[0] << " <fichero> [--frame F] [--veces N]" << endl;
+        return 1;
+    }
+    long frame = -1;
+    int veces = 1;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--frame") == 0) frame = atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--veces") == 0) veces = atoi(argv[i + 1]);
+    }
+    if (veces < 1) veces = 1;
+
+    vector<unsigned char> datos;
+    Repeticion R;
+    if (!cargaFichero(argv[1], datos)) {
+        cerr << "No se puede leer " << argv[1] << endl;
+        return 1;
+    }
+    if (!leeRepeticion(R, datos.data(), datos.size())) {
+        cerr << argv[1] << " no es una repeticion valida" << endl;
+        return 1;
+    }
+    cout << "semilla " << R.semilla << ", modo " << (R.modo == AZAR_BOLSA ? "bolsa" : "puro") << ", "
+         << R.final.frames << " frames, " << datos.size() << " bytes (" << R.bytesEventos << " de eventos, "
+         << R.numClaves << " fotogramas clave)" << endl;
+
+    Reproductor P;
+    if (frame >= 0) {
+        iniciarReproductor(P, R);
+        buscaFrame(P, uint32_t(frame));
+        cout << "frame " << P.frame << ": puntos " << P.E.ptos << ", nivel " << P.E.level << ", lineas "
+             << P.E.lineas << ", piezas " << P.E.piezas << endl;
+        return 0;
+    }
+
+    auto inicio = chrono::steady_clock::now();
+    for (int v = 0; v < veces; ++v) {
+        iniciarReproductor(P, R);
+        avanzaHasta(P, R.final.frames);
+    }
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    const EstadoJuego &E = P.E;
+    bool ok = E.ptos == R.final.ptos && E.level == R.final.level && E.lineas == R.final.lineas &&
+              E.piezas == R.final.piezas && E.fin == R.final.fin;
+    cout << "puntos " << E.ptos << ", nivel " << E.level << ", lineas " << E.lineas << ", piezas " << E.piezas
+         << (ok ? ": coincide" : ": NO coincide con el pie") << endl;
+    cout << "tiempo " << segundos << " s, " << double(R.final.frames) * veces / segundos << " frames/s" << endl;
+    return ok ? 0 : 2;
+}
@@ -0,0 +1,241 @@
+/**
+ * @file rollback.cpp
+ * @brief Sincronización de un duelo en red con retraso de entrada y rollback
+ *
+ * Formato de un paquete (little-endian):
+ * - 0..3: "TB", versión 1 y número n de acciones locales
+ * - 4..7: frame de la primera acción
+ * - 8..11: acciones del rival recibidas sin huecos (confirmación)
+ * - 12..15: frame de la suma de comprobación o SIN_FRAME
+ * - 16..23: suma de comprobación del duelo tras ese frame
+ * - 24..: n acciones, una por byte
+ *
+ * @see rollback.h
+ */
+
+#include "rollback.h"
+
+/// Máscara para indexar la ventana con un número de frame
+const uint32_t MASCARA_VENTANA = VENTANA_ROLLBACK - 1;
+
+static_assert((VENTANA_ROLLBACK & MASCARA_VENTANA) == 0, "La ventana debe ser potencia de 2");
+
+/**
+ * @brief Escribe un entero de 32 bits en little-endian.
+ * @param p Destino
+ * @param x Valor
+ */
+static void pon32(unsigned char *p, uint32_t x) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char) (x >> (8 * i));
+}
+
+/**
+ * @brief Lee un entero de 32 bits en little-endian.
+ * @param p Origen
+ * @return uint32_t -> Valor
+ */
+static uint32_t lee32(const unsigned char *p) {
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+/**
+ * @brief Limita un valor a un intervalo.
+ * @param v Valor
+ * @param minimo Mínimo
+ * @param maximo Máximo
+ * @return int -> Valor limitado
+ */
+static int limita(int v, int minimo, int maximo) {
+    return v < minimo ? minimo : v > maximo ? maximo : v;
+}
+
+/**
+ * @brief Prepara la sincronización de un duelo.
+ * @post Las acciones de los primeros `retraso` frames son NADA en las dos máquinas
+ * @param R Sincronización
+ * @param semilla Semilla del duelo (la misma en las dos máquinas)
+ * @param local Jugador de esta máquina (0 o 1)
+ * @param retraso Frames de retraso de entrada (0..MAX_RETRASO)
+ * @param maxRollback Máximo de frames a re-simular (0..MAX_ROLLBACK; 0 es lockstep)
+ */
+void iniciarRollback(Rollback &R, uint64_t semilla, int local, int retraso, int maxRollback) {
+    iniciarDuelo(R.D, semilla);
+    R.local = local & 1;
+    R.retraso = limita(retraso, 0, MAX_RETRASO);
+    R.maxRollback = limita(maxRollback, 0, MAX_ROLLBACK);
+    R.frame = 0;
+    R.localHasta = R.remotoHasta = R.confirmadoRival = uint32_t(R.retraso);
+    R.corregir = SIN_FRAME;
+    for (int i = 0; i < VENTANA_ROLLBACK; ++i) {
+        R.suma[i] = 0;
+        R.accionLocal[i] = R.accionRemota[i] = R.usadaRemota[i] = NADA;
+        R.frameRemoto[i] = uint32_t(i) < R.remotoHasta ? uint32_t(i) : SIN_FRAME;
+    }
+    R.frameSumaRival = SIN_FRAME;
+    R.sumaRival = 0;
+    R.desincronizado = false;
+    R.frameDesincronizado = SIN_FRAME;
+    R.correcciones = R.resimulados = R.esperas = R.sumasComparadas = 0;
+    R.maxResimulados = 0;
+}
+
+/**
+ * @brief Simula un frame con las acciones conocidas o predichas.
+ * @pre R.D es el estado antes del frame
+ * @param R Sincronización
+ * @param f Frame
+ */
+static void simulaFrame(Rollback &R, uint32_t f) {
+    uint32_t i = f & MASCARA_VENTANA;
+    R.antes[i] = R.D;
+    R.usadaRemota[i] = R.frameRemoto[i] == f ? R.accionRemota[i] : (unsigned char) NADA;
+    Accion a[JUGADORES];
+    a[R.local] = Accion(R.accionLocal[i]);
+    a[1 - R.local] = Accion(R.usadaRemota[i]);
+    pasoDuelo(R.D, a[0], a[1]);
+    R.suma[i] = sumaDuelo(R.D);
+}
+
+/**
+ * @brief Compara la última suma del rival con la propia del mismo frame.
+ * @post Si no coinciden marca el duelo como desincronizado
+ * @param R Sincronización
+ */
+static void compruebaSuma(Rollback &R) {
+    uint32_t f = R.frameSumaRival;
+    if (f == SIN_FRAME || f >= frameConfirmado(R)) return;
+    R.frameSumaRival = SIN_FRAME;
+    if (f + VENTANA_ROLLBACK <= R.frame) return; // Ya no está en la ventana
+    R.sumasComparadas++;
+    if (R.suma[f & MASCARA_VENTANA] != R.sumaRival && !R.desincronizado) {
+        R.desincronizado = true;
+        R.frameDesincronizado = f;
+    }
+}
+
+/**
+ * @brief Aplica las correcciones pendientes.
+ * @post Si alguna predicción ha fallado, vuelve al estado anterior al primer
+ *       frame equivocado y re-simula hasta el actual. Después compara la última
+ *       suma del rival.
+ * @param R Sincronización
+ * @return int -> Frames re-simulados
+ */
+int corrigeRollback(Rollback &R) {
+    int n = 0;
+    if (R.corregir != SIN_FRAME) {
+        uint32_t desde = R.corregir;
+        R.corregir = SIN_FRAME;
+        R.D = R.antes[desde & MASCARA_VENTANA];
+        for (uint32_t f = desde; f < R.frame; ++f) simulaFrame(R, f);
+        n = int(R.frame - desde);
+        R.correcciones++;
+        R.resimulados += n;
+        if (n > R.maxResimulados) R.maxResimulados = n;
+    }
+    compruebaSuma(R);
+    return n;
+}
+
+/**
+ * @brief Simula un frame nuevo.
+ * @post No avanza si va maxRollback frames por delante del rival o si el duelo
+ *       ha terminado
+ * @param R Sincronización
+ * @param a Acción local leída en este tick (se aplica `retraso` frames después)
+ * @return bool -> true: se ha simulado un frame nuevo; false: se ha esperado
+ */
+bool avanzaRollback(Rollback &R, Accion a) {
+    if (!puedeAvanzar(R)) {
+        if (R.D.ganador == EN_CURSO) R.esperas++;
+        return false;
+    }
+    R.accionLocal[R.localHasta & MASCARA_VENTANA] = (unsigned char) a;
+    R.localHasta++;
+    simulaFrame(R, R.frame);
+    R.frame++;
+    return true;
+}
+
+/**
+ * @brief Construye el paquete a enviar al rival.
+ * @post Lleva las acciones locales que el rival no ha confirmado, la confirmación
+ *       de las suyas y la suma del último frame confirmado
+ * @param R Sincronización
+ * @param buf Destino (al menos TAM_PAQUETE bytes)
+ * @return int -> Bytes escritos
+ */
+int creaPaquete(const Rollback &R, unsigned char *buf) {
+    uint32_t primero = R.confirmadoRival;
+    uint32_t n = R.localHasta - primero;
+    if (n > uint32_t(VENTANA_ROLLBACK)) {
+        primero = R.localHasta - VENTANA_ROLLBACK;
+        n = VENTANA_ROLLBACK;
+    }
+    uint32_t confirmado = frameConfirmado(R);
+    uint32_t frameSuma = confirmado > 0 ? confirmado - 1 : SIN_FRAME;
+    uint64_t suma = frameSuma != SIN_FRAME ? R.suma[frameSuma & MASCARA_VENTANA] : 0;
+
+    buf[0] = 'T';
+    buf[1] = 'B';
+    buf[2] = 1;
+    buf[3] = (unsigned char) n;
+    pon32(buf + 4, primero);
+    pon32(buf + 8, R.remotoHasta);
+    pon32(buf + 12, frameSuma);
+    pon32(buf + 16, uint32_t(suma));
+    pon32(buf + 20, uint32_t(suma >> 32));
+    for (uint32_t k = 0; k < n; ++k) buf[24 + k] = R.accionLocal[(primero + k) & MASCARA_VENTANA];
+    return 24 + int(n);
+}
+
+/**
+ * @brief Procesa un paquete del rival.
+ * @post Guarda sus acciones nuevas y, si alguna contradice la predicción de un
+ *       frame ya simulado, deja pendiente la corrección para el siguiente tick.
+ *       Paquetes repetidos o desordenados no hacen daño.
+ * @param R Sincronización
+ * @param buf Paquete
+ * @param n Bytes
+ * @return bool -> false: el paquete no es válido y se ha ignorado
+ */
+bool recibePaquete(Rollback &R, const unsigned char *buf, int n) {
+    if (n < 24 || buf[0] != 'T' || buf[1] != 'B' || buf[2] != 1) return false;
+    uint32_t k = buf[3];
+    if (k > uint32_t(VENTANA_ROLLBACK) || n != 24 + int(k)) return false;
+    uint32_t primero = lee32(buf + 4);
+    uint32_t confirmado = lee32(buf + 8);
+    for (uint32_t j = 0; j < k; ++j) {
+        if (buf[24 + j] >= ACCIONES) return false;
+    }
+    if (confirmado > R.localHasta) return false;
+
+    if (confirmado > R.confirmadoRival) R.confirmadoRival = confirmado;
+    for (uint32_t j = 0; j < k; ++j) {
+        uint32_t f = primero + j;
+        if (f < R.remotoHasta || f >= R.remotoHasta + VENTANA_ROLLBACK) continue;
+        uint32_t i = f & MASCARA_VENTANA;
+        if (R.frameRemoto[i] == f) continue;
+        R.frameRemoto[i] = f;
+        R.accionRemota[i] = buf[24 + j];
+        if (f < R.frame && R.usadaRemota[i] != buf[24 + j] && f < R.corregir) R.corregir = f;
+    }
+    while (R.frameRemoto[R.remotoHasta & MASCARA_VENTANA] == R.remotoHasta) R.remotoHasta++;
+
+    uint32_t frameSuma = lee32(buf + 12);
+    if (frameSuma != SIN_FRAME && (R.frameSumaRival == SIN_FRAME || frameSuma > R.frameSumaRival)) {
+        R.frameSumaRival = frameSuma;
+        R.sumaRival = uint64_t(lee32(buf + 16)) | uint64_t(lee32(buf + 20)) << 32;
+    }
+    return true;
+}
+
+/**
+ * @brief Indica si el duelo ha terminado de forma definitiva.
+ * @param R Sincronización
+ * @return bool -> true: hay ganador y ninguna acción pendiente del rival puede cambiarlo
+ */
+bool rollbackTerminado(const Rollback &R) {
+    // D.frame se queda en el frame en que terminó el duelo aunque R.frame vaya por delante
+    return R.D.ganador != EN_CURSO && R.D.frame <= frameConfirmado(R);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file rollback.h
+ * @brief Sincronización de un duelo en red con retraso de entrada y rollback
+ *
+ * Cada máquina simula el duelo entero. La acción local se aplica `retraso`
+ * frames después de leerla, lo que da ese margen a que llegue al rival. La
+ * acción del rival que aún no ha llegado se predice como NADA (la inmensa
+ * mayoría de frames no hay ninguna tecla). Cuando llega la real y no coincide
+ * con la predicha, se vuelve al estado guardado antes de ese frame y se simula
+ * otra vez hasta el actual, todo dentro del mismo tick.
+ *
+ * Nunca se adelanta más de `maxRollback` frames al último frame del rival
+ * confirmado: si hace falta, se espera. Así una corrección nunca re-simula más
+ * de maxRollback frames.
+ *
+ * Cada paquete lleva todas las acciones locales que el rival aún no ha
+ * confirmado (la siguiente llegada repara una pérdida), la confirmación de
+ * las suyas y la suma de comprobación del último frame confirmado: si no
+ * coincide con la propia de ese frame, el duelo se ha desincronizado.
+ */
+
+#ifndef _ROLLBACK_H_
+#define _ROLLBACK_H_
+
+#include "duelo.h"
+
+const int VENTANA_ROLLBACK = 64; ///< Frames de historia guardados (potencia de 2)
+const int MAX_RETRASO = 8; ///< Máximo retraso de entrada en frames
+const int MAX_ROLLBACK = 20; ///< Máximo de frames re-simulados por corrección
+const int TAM_PAQUETE = 24 + VENTANA_ROLLBACK; ///< Tamaño máximo de un paquete
+const uint32_t SIN_FRAME = 0xFFFFFFFFu; ///< Ningún frame
+
+static_assert(2 * (MAX_RETRASO + MAX_ROLLBACK) < VENTANA_ROLLBACK, "La ventana debe cubrir retraso y rollback");
+
+/** @struct Rollback
+ *  @brief Estado de la sincronización de un duelo en una de las dos máquinas.
+ */
+struct Rollback {
+    EstadoDuelo D; ///< Duelo en el frame actual
+    int local; ///< Jugador de esta máquina (0 o 1)
+    int retraso; ///< Frames entre leer la acción local y aplicarla
+    int maxRollback; ///< Máximo de frames por delante del último confirmado del rival
+
+    uint32_t frame; ///< Siguiente frame a simular (igual a D.frame)
+    uint32_t localHasta; ///< Acciones locales conocidas: frames < localHasta
+    uint32_t remotoHasta; ///< Acciones del rival confirmadas sin huecos: frames < remotoHasta
+    uint32_t confirmadoRival; ///< El rival tiene las acciones locales de frames < confirmadoRival
+    uint32_t corregir; ///< Primer frame simulado con una predicción fallida o SIN_FRAME
+
+    EstadoDuelo antes[VENTANA_ROLLBACK]; ///< Estado antes de simular cada frame
+    uint64_t suma[VENTANA_ROLLBACK]; ///< Suma de comprobación tras simular cada frame
+    unsigned char accionLocal[VENTANA_ROLLBACK]; ///< Acción local de cada frame
+    unsigned char accionRemota[VENTANA_ROLLBACK]; ///< Acción real del rival de cada frame
+    uint32_t frameRemoto[VENTANA_ROLLBACK]; ///< Frame al que corresponde accionRemota o SIN_FRAME
+    unsigned char usadaRemota[VENTANA_ROLLBACK]; ///< Acción del rival con la que se simuló cada frame
+
+    uint32_t frameSumaRival; ///< Frame de la última suma recibida del rival o SIN_FRAME
+    uint64_t sumaRival; ///< Última suma recibida del rival
+    bool desincronizado; ///< Alguna suma del rival no ha coincidido
+    uint32_t frameDesincronizado; ///< Frame de la primera suma que no ha coincidido
+
+    long correcciones; ///< Rollbacks hechos
+    long resimulados; ///< Frames re-simulados en total
+    int maxResimulados; ///< Máximo de frames re-simulados en un tick
+    long esperas; ///< Ticks sin avanzar por ir demasiado por delante del rival
+    long sumasComparadas; ///< Sumas del rival comprobadas
+};
+
+void iniciarRollback(Rollback &R, uint64_t semilla, int local, int retraso, int maxRollback);
+int corrigeRollback(Rollback &R);
+bool avanzaRollback(Rollback &R, Accion a);
+int creaPaquete(const Rollback &R, unsigned char *buf);
+bool recibePaquete(Rollback &R, const unsigned char *buf, int n);
+bool rollbackTerminado(const Rollback &R);
+
+/**
+ * @brief Frames con las acciones de los dos jugadores conocidas y ya simulados.
+ * @param R Sincronización
+ * @return uint32_t -> Los frames menores que este ya no pueden cambiar
+ */
+inline uint32_t frameConfirmado(const Rollback &R) {
+    uint32_t f = R.remotoHasta < R.frame ? R.remotoHasta : R.frame;
+    return R.corregir < f ? R.corregir : f;
+}
+
+/**
+ * @brief Indica si avanzaRollback simularía un frame nuevo.
+ * @param R Sincronización
+ * @return bool -> false: el duelo ha terminado o hay que esperar al rival
+ */
+inline bool puedeAvanzar(const Rollback &R) {
+    return R.D.ganador == EN_CURSO && R.frame < R.remotoHasta + uint32_t(R.maxRollback);
+}
+
+/**
+ * @brief Avanza la sincronización un tick del bucle principal.
+ * @post Corrige las predicciones fallidas y simula un frame nuevo si puede
+ * @param R Sincronización
+ * @param a Acción local leída en este tick
+ * @return bool -> true: se ha simulado un frame nuevo; false: se ha esperado
+ */
+inline bool tickRollback(Rollback &R, Accion a) {
+    corrigeRollback(R);
+    return avanzaRollback(R, a);
+}
+
+#endif
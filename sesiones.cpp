@@ -0,0 +1,169 @@
+/**
+ * @file sesiones.cpp
+ * @brief Muchas partidas independientes en un solo proceso
+ *
+ * @see sesiones.h
+ */
+
+#include "sesiones.h"
+
+/// Bytes que ocupa cada sesión en los vectores de Sesiones
+const size_t BYTES_SESION = sizeof(EstadoJuego) + 2 * sizeof(uint32_t) + 2 + sizeof(int);
+
+static_assert(BYTES_SESION <= PRESUPUESTO_SESION, "Una sesión no cabe en su presupuesto de memoria");
+
+/**
+ * @brief Bytes que ocupa cada sesión.
+ * @return size_t -> Bytes por sesión, sin memoria dinámica aparte
+ */
+size_t bytesPorSesion() {
+    return BYTES_SESION;
+}
+
+/**
+ * @brief Reserva las sesiones que caben en un presupuesto de memoria.
+ * @post Todas las sesiones están libres y no se vuelve a reservar memoria
+ * @param S Sesiones
+ * @param presupuesto Bytes disponibles
+ * @param lote Sesiones por tarea del grupo de hilos
+ * @return size_t -> Número de sesiones que caben
+ */
+size_t iniciarSesiones(Sesiones &S, size_t presupuesto, size_t lote) {
+    size_t n = presupuesto / BYTES_SESION;
+    S.estados.assign(n, EstadoJuego());
+    S.proximo.assign(n, SIN_TICK);
+    S.ultimo.assign(n, 0);
+    S.accion.assign(n, (unsigned char) NADA);
+    S.cambios.assign(n, 0);
+    S.libres.resize(n);
+    // Las primeras sesiones en abrirse son las primeras del vector
+    for (size_t i = 0; i < n; ++i) S.libres[i] = int(n - 1 - i);
+    S.tick = 0;
+    S.activas = 0;
+    S.lote = lote > 0 ? lote : 1;
+    return n;
+}
+
+/**
+ * @brief Tick de la próxima caída por gravedad de una sesión.
+ * @param E Estado tras simular el tick t
+ * @param t Tick simulado
+ * @return uint32_t -> Primer tick en que paso(E, NADA) hace algo más que contar el tiempo
+ */
+static uint32_t siguienteCaida(const EstadoJuego &E, uint32_t t) {
+    if (E.fin != EN_JUEGO) return SIN_TICK;
+    // En el último nivel el siguiente paso() declara la victoria
+    if (E.level == NIVELES) return t + 1;
+    int v = VELOCIDAD_NIVEL[E.level - 1];
+    return t + 1 + uint32_t(E.frame > v ? 0 : v + 1 - E.frame);
+}
+
+/**
+ * @brief Abre una sesión nueva.
+ * @post Empieza a simularse en el siguiente tick
+ * @param S Sesiones
+ * @param semilla Semilla de la partida
+ * @param modo Forma de repartir las piezas
+ * @return int -> Identificador de la sesión; -1 si no queda sitio en el presupuesto
+ */
+int abreSesion(Sesiones &S, uint64_t semilla, ModoAzar modo) {
+    if (S.libres.empty()) return -1;
+    int id = S.libres.back();
+    S.libres.pop_back();
+    EstadoJuego &E = S.estados[size_t(id)];
+    iniciarJuego(E, semilla, modo);
+    S.ultimo[size_t(id)] = S.tick;
+    S.proximo[size_t(id)] = siguienteCaida(E, S.tick);
+    S.accion[size_t(id)] = NADA;
+    S.cambios[size_t(id)] = 0;
+    S.activas++;
+    return id;
+}
+
+/**
+ * @brief Cierra una sesión y deja su sitio libre.
+ * @param S Sesiones
+ * @param id Sesión abierta
+ */
+void cierraSesion(Sesiones &S, int id) {
+    S.proximo[size_t(id)] = SIN_TICK;
+    S.accion[size_t(id)] = NADA;
+    S.libres.push_back(id);
+    S.activas--;
+}
+
+/**
+ * @brief Deja la acción del jugador para el siguiente tick.
+ * @post Sustituye a la que hubiera pendiente; no hace nada si la partida ha terminado
+ * @param S Sesiones
+ * @param id Sesión abierta
+ * @param a Acción
+ */
+void ponAccion(Sesiones &S, int id, Accion a) {
+    if (S.proximo[size_t(id)] != SIN_TICK) S.accion[size_t(id)] = (unsigned char) a;
+}
+
+/**
+ * @brief Simula un lote de sesiones en un tick.
+ * @param S Sesiones
+ * @param desde Primera sesión del lote
+ * @param hasta Sesión siguiente a la última del lote
+ * @param t Tick a simular
+ * @return long -> Sesiones simuladas
+ */
+static long simulaLote(Sesiones &S, size_t desde, size_t hasta, uint32_t t) {
+    long n = 0;
+    for (size_t i = desde; i < hasta; ++i) {
+        // Solo se mira el estado completo de las sesiones que tienen algo que hacer
+        if (S.accion[i] == NADA && S.proximo[i] > t) {
+            S.cambios[i] = 0;
+            continue;
+        }
+        EstadoJuego &E = S.estados[i];
+        E.frame += int(t - S.ultimo[i] - 1);
+        S.cambios[i] = (unsigned char) paso(E, Accion(S.accion[i]));
+        S.accion[i] = NADA;
+        S.ultimo[i] = t;
+        S.proximo[i] = siguienteCaida(E, t);
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Avanza un tick todas las sesiones abiertas.
+ * @post Cada sesión queda como si se hubiera llamado a paso() con su acción
+ *       pendiente (o NADA); cambios dice qué ha pasado en las simuladas
+ * @pre No se llama a la vez que ponAccion, abreSesion ni cierraSesion
+ * @param S Sesiones
+ * @param pool Grupo de hilos que reparte los lotes (nullptr: en este hilo)
+ * @return long -> Sesiones que se han tenido que simular
+ */
+long tickSesiones(Sesiones &S, PoolTrabajo *pool) {
+    uint32_t t = ++S.tick;
+    size_t n = S.estados.size();
+    if (pool == nullptr || n <= S.lote) return simulaLote(S, 0, n, t);
+
+    size_t lotes = (n + S.lote - 1) / S.lote;
+    std::vector<long> simuladas(lotes, 0);
+    for (size_t k = 0; k < lotes; ++k) {
+        size_t desde = k * S.lote, hasta = desde + S.lote < n ? desde + S.lote : n;
+        pool->encolar([&S, &simuladas, k, desde, hasta, t] { simuladas[k] = simulaLote(S, desde, hasta, t); });
+    }
+    pool->esperar();
+    long total = 0;
+    for (long x : simuladas) total += x;
+    return total;
+}
+
+/**
+ * @brief Frame de gravedad de una sesión, como si se hubiera simulado cada tick.
+ * @param S Sesiones
+ * @param id Sesión abierta
+ * @return int -> Valor que tendría estados[id].frame
+ */
+int frameSesion(const Sesiones &S, int id) {
+    const EstadoJuego &E = S.estados[size_t(id)];
+    if (E.fin != EN_JUEGO) return E.frame;
+    return E.frame + int(S.tick - S.ultimo[size_t(id)]);
+}
@@ -0,0 +1,63 @@
+/**
+ * @file sesiones.h
+ * @brief Muchas partidas independientes en un solo proceso
+ *
+ * Las partidas (sesiones) viven en vectores contiguos reservados de una vez
+ * según un presupuesto de memoria: los estados completos por un lado y, por
+ * otro, los pocos bytes que hacen falta para decidir si una sesión tiene trabajo
+ * en un tick (su acción pendiente y el tick de su próxima caída por gravedad).
+ *
+ * Cada tick equivale a un frame de paso(). tickSesiones() reparte las sesiones
+ * en lotes contiguos entre los hilos de un PoolTrabajo, y cada lote solo simula
+ * las que tienen una acción pendiente o a las que les toca caer según
+ * VELOCIDAD_NIVEL de su nivel. Las demás no se tocan: los frames en que solo
+ * habría contado el tiempo se suman de golpe la siguiente vez que se simulan, con
+ * el mismo resultado que llamar a paso(E, NADA) en cada tick. No hay un hilo ni
+ * una espera por sesión.
+ */
+
+#ifndef _SESIONES_H_
+#define _SESIONES_H_
+
+#include "juego.h"
+#include "pool.h"
+#include <cstddef>
+#include <vector>
+
+const size_t PRESUPUESTO_SESION = 512; ///< Bytes máximos por sesión, estado y planificación incluidos
+const size_t LOTE_SESIONES = 1024; ///< Sesiones por tarea del grupo de hilos
+const uint32_t SIN_TICK = UINT32_MAX; ///< Sesión libre o terminada: no se simula
+
+/** @struct Sesiones
+ *  @brief Conjunto de partidas que avanzan al mismo ritmo de ticks.
+ */
+struct Sesiones {
+    std::vector<EstadoJuego> estados; ///< Estado de cada sesión (frame puede ir retrasado, ver frameSesion)
+    std::vector<uint32_t> proximo; ///< Tick de la próxima caída por gravedad (SIN_TICK: no se simula)
+    std::vector<uint32_t> ultimo; ///< Último tick simulado
+    std::vector<unsigned char> accion; ///< Acción pendiente para el siguiente tick
+    std::vector<unsigned char> cambios; ///< Indicadores Cambio del último tick (0 si no se ha simulado)
+    std::vector<int> libres; ///< Sesiones sin usar
+    uint32_t tick; ///< Ticks transcurridos
+    size_t activas; ///< Sesiones abiertas
+    size_t lote; ///< Sesiones por tarea
+};
+
+size_t bytesPorSesion();
+size_t iniciarSesiones(Sesiones &S, size_t presupuesto, size_t lote = LOTE_SESIONES);
+int abreSesion(Sesiones &S, uint64_t semilla, ModoAzar modo = AZAR_BOLSA);
+void cierraSesion(Sesiones &S, int id);
+void ponAccion(Sesiones &S, int id, Accion a);
+long tickSesiones(Sesiones &S, PoolTrabajo *pool);
+int frameSesion(const Sesiones &S, int id);
+
+/**
+ * @brief Sesiones que caben en el presupuesto.
+ * @param S Sesiones
+ * @return size_t -> Capacidad reservada
+ */
+inline size_t capacidadSesiones(const Sesiones &S) {
+    return S.estados.size();
+}
+
+#endif
@@ -0,0 +1,233 @@
+/**
+ * @file tablero.cpp
+ * @brief Operaciones sobre el tablero y las piezas del Tetris
+ *
+ * @see tablero.h
+ */
+
+#include "tablero.h"
+#include <cstring>
+
+/// Tabla de núcleos de colisión de las cuatro rotaciones de un tipo
+#define KERNELS_COLISION(t) {&colisionHuella<t, 0>, &colisionHuella<t, 1>, &colisionHuella<t, 2>, &colisionHuella<t, 3>}
+/// Tabla de núcleos de inserción de las cuatro rotaciones de un tipo
+#define KERNELS_INSERCION(t) {&insertaHuella<t, 0>, &insertaHuella<t, 1>, &insertaHuella<t, 2>, &insertaHuella<t, 3>}
+
+const KernelColision COLISION[TIPOS_PIEZA][ROTACIONES] = {
+        KERNELS_COLISION(0), KERNELS_COLISION(1), KERNELS_COLISION(2), KERNELS_COLISION(3),
+        KERNELS_COLISION(4), KERNELS_COLISION(5), KERNELS_COLISION(6)
+};
+
+const KernelInsercion INSERCION[TIPOS_PIEZA][ROTACIONES] = {
+        KERNELS_INSERCION(0), KERNELS_INSERCION(1), KERNELS_INSERCION(2), KERNELS_INSERCION(3),
+        KERNELS_INSERCION(4), KERNELS_INSERCION(5), KERNELS_INSERCION(6)
+};
+
+#undef KERNELS_COLISION
+#undef KERNELS_INSERCION
+
+/**
+ * @brief Rota una pieza en sentido horario.
+ * @post Solo cambia la rotación; la forma se lee de HUELLAS
+ * @param P Pieza a rotar.
+ */
+void rota_derecha(Pieza &P) {
+    if (P.tipo == CUADRADO) return;
+    P.rot = (P.rot + 1) & (ROTACIONES - 1);
+}
+
+/**
+ * @brief Rota una pieza en sentido antihorario.
+ * @post Solo cambia la rotación; la forma se lee de HUELLAS
+ * @param P Pieza a rotar.
+ */
+void rota_izquierda(Pieza &P) {
+    if (P.tipo == CUADRADO) return;
+    P.rot = (P.rot + ROTACIONES - 1) & (ROTACIONES - 1);
+}
+
+/**
+ * @brief Vacía el Tablero de juego.
+ * @post Establece todas sus celdas a VACIO
+ * @param T Tablero
+ */
+void vaciarTablero(Tablero &T) {
+    memset(T.fila, 0, sizeof(T.fila));
+    memset(T.color, VACIO, sizeof(T.color));
+}
+
+/**
+ * @brief Inserta una pieza en el Tablero de juego
+ * @post Activa los bits de la pieza y coloca su color en el plano de color.
+ * @param T Tablero del juego
+ * @param P Pieza a insertar
+ */
+void insertaPieza(Tablero &T, const Pieza &P) {
+    INSERCION[P.tipo][P.rot](T, P.abs.x, P.abs.y);
+    for (int i = 0; i < 4; ++i) {
+        Coord c = P.posicionBloque(i);
+        T.color[c.y][c.x] = (unsigned char) P.color();
+    }
+}
+
+/**
+ * @brief Inserta una pieza solo en el bitboard, sin tocar el plano de color.
+ * @post Activa los bits de la pieza con su núcleo especializado. Pensada para simulaciones.
+ * @param T Ocupación del tablero
+ * @param P Pieza a insertar
+ */
+void insertaPieza(Ocupacion &T, const Pieza &P) {
+    INSERCION[P.tipo][P.rot](T, P.abs.x, P.abs.y);
+}
+
+/**
+ * @brief Inserta una pieza en el bitboard y actualiza su clave Zobrist.
+ * @pre La pieza no colisiona: sus celdas estaban vacías
+ * @post clave cambia solo por las celdas de la pieza, sin recorrer el tablero
+ * @param T Ocupación del tablero
+ * @param P Pieza a insertar
+ * @param clave Clave Zobrist de T (se actualiza)
+ */
+void insertaPieza(Ocupacion &T, const Pieza &P, uint64_t &clave) {
+    const Huella &H = P.huella();
+    const int x0 = P.abs.x + H.minx;
+    const int y0 = P.abs.y + H.miny;
+    for (int i = 0; i < H.alto; ++i) clave ^= claveFila(y0 + i, unsigned(H.mascara[i]) << x0);
+    INSERCION[P.tipo][P.rot](T, P.abs.x, P.abs.y);
+}
+
+/**
+ * @brief Comprueba si hay colisión entre una pieza y la celda del Tablero
+ * @post Delega en el núcleo colisionHuella de su tipo y rotación, que verifica
+ *        -> la caja de la pieza está fuera de los límites del tablero
+ *        -> alguna máscara de la pieza se solapa con la de su fila
+ * @param T Ocupación del tablero del juego
+ * @param P Pieza que pueda colisionar
+ * @return bool -> true: la pieza colisiona en el tablero
+ *              -> false: caso contrario.
+ */
+bool colisionPieza(const Ocupacion &T, const Pieza &P) {
+    return COLISION[P.tipo][P.rot](T, P.abs.x, P.abs.y);
+}
+
+/**
+ * @brief Comprueba si una fila del Tablero esta llena.
+ * @param T Ocupación del tablero del juego
+ * @param fila Número de la fila que se va a verificar.
+ * @return bool -> true: fila llena
+ *              -> false: caso contrario.
+ */
+bool filaLlena(const Ocupacion &T, int fila) {
+    return T.fila[fila] == FILA_LLENA;
+}
+
+/**
+ * @brief Quita una fila del Tablero.
+ * @post Desplaza todas las filas superiores a la indicada hacia abajo
+ * @post Establece todas las celdas de la fila superior a VACIO
+ * @param T Tablero del juego
+ * @param fila Número de la fila que se va a quitar.
+ */
+void quitarFila(Tablero &T, int fila) {
+    memmove(&T.fila[1], &T.fila[0], fila * sizeof(Fila));
+    memmove(&T.color[1], &T.color[0], fila * sizeof(T.color[0]));
+    T.fila[0] = 0;
+    memset(T.color[0], VACIO, sizeof(T.color[0]));
+}
+
+/**
+ * @brief Sube el contenido del Tablero y añade filas por abajo.
+ * @post Las n filas de arriba se pierden y las n de abajo son fila, con el color dado
+ * @param T Tablero del juego
+ * @param n Número de filas a añadir (0..FILAS)
+ * @param fila Ocupación de cada fila añadida
+ * @param color Color de las celdas ocupadas de las filas añadidas
+ * @return bool -> true: alguna celda ocupada ha salido por arriba
+ */
+bool subirFilas(Tablero &T, int n, Fila fila, unsigned char color) {
+    if (n <= 0) return false;
+    if (n > FILAS) n = FILAS;
+    Fila perdidas = 0;
+    for (int i = 0; i < n; ++i) perdidas |= T.fila[i];
+    memmove(&T.fila[0], &T.fila[n], (FILAS - n) * sizeof(Fila));
+    memmove(&T.color[0], &T.color[n], (FILAS - n) * sizeof(T.color[0]));
+    for (int i = FILAS - n; i < FILAS; ++i) {
+        T.fila[i] = fila;
+        for (int c = 0; c < COLUMNAS; ++c) T.color[i][c] = (unsigned char) ((fila >> c) & 1 ? color : VACIO);
+    }
+    return perdidas != 0;
+}
+
+/**
+ * @brief Cuenta y Quita las filas del Tablero que están llenas.
+ * @post Compacta el tablero en una sola pasada de abajo a arriba: cada fila no llena
+ *       se copia (si hace falta) a la siguiente posición libre y el resto se vacía.
+ * @param T Tablero del juego
+ * @return int -> Cantidad de filas quitadas
+ */
+int cuentaFila(Tablero &T) {
+    int destino = FILAS - 1;
+    for (int fila = FILAS - 1; fila >= 0; --fila) {
+        if (T.fila[fila] == FILA_LLENA) continue;
+        if (destino != fila) {
+            T.fila[destino] = T.fila[fila];
+            memcpy(T.color[destino], T.color[fila], sizeof(T.color[0]));
+        }
+        --destino;
+    }
+    int cont = destino + 1;
+    if (cont > 0) {
+        memset(T.fila, 0, cont * sizeof(Fila));
+        memset(T.color, VACIO, cont * sizeof(T.color[0]));
+    }
+    return cont;
+}
+
+/**
+ * @brief Cuenta y Quita las filas llenas de un bitboard, sin plano de color.
+ * @post Misma compactación que cuentaFila(Tablero &), pero sin saltos: cada fila se
+ *       copia siempre y el destino solo avanza si no estaba llena.
+ * @param T Ocupación del tablero
+ * @return int -> Cantidad de filas quitadas
+ */
+int cuentaFila(Ocupacion &T) {
+    int destino = FILAS - 1;
+    for (int fila = FILAS - 1; fila >= 0; --fila) {
+        Fila m = T.fila[fila];
+        T.fila[destino] = m;
+        destino -= (m != FILA_LLENA);
+    }
+    for (int fila = 0; fila <= destino; ++fila) {
+        T.fila[fila] = 0;
+    }
+    return destino + 1;
+}
+
+/**
+ * @brief Cuenta y Quita las filas llenas de un bitboard y actualiza su clave Zobrist.
+ * @post Las filas por debajo de la última llena no se mueven, así que solo se
+ *       recalculan las claves de las de encima
+ * @param T Ocupación del tablero
+ * @param clave Clave Zobrist de T (se actualiza)
+ * @return int -> Cantidad de filas quitadas
+ */
+int cuentaFila(Ocupacion &T, uint64_t &clave) {
+    int baja = FILAS - 1;
+    while (baja >= 0 && T.fila[baja] != FILA_LLENA) --baja;
+    if (baja < 0) return 0;
+    for (int f = 0; f <= baja; ++f) clave ^= claveFila(f, T.fila[f]);
+    int n = cuentaFila(T);
+    for (int f = 0; f <= baja; ++f) clave ^= claveFila(f, T.fila[f]);
+    return n;
+}
+
+/**
+ * @brief Calcula la clave Zobrist de un bitboard desde cero.
+ * @param T Ocupación del tablero
+ * @return uint64_t -> XOR de las claves de sus celdas ocupadas (0: tablero vacío)
+ */
+uint64_t claveTablero(const Ocupacion &T) {
+    uint64_t k = 0;
+    for (int f = 0; f < FILAS; ++f) k ^= claveFila(f, T.fila[f]);
+    return k;
+}
@@ -0,0 +1,639 @@
+/**
+ * @file tablero.h
+ * @brief Tablero y piezas del Tetris
+ *
+ * Representación del tablero (bitboard + plano de color), de las piezas y de
+ * las operaciones básicas sobre ellos: rotar, insertar, colisionar y quitar filas.
+ * No depende de miniwin ni de Windows: forma parte del motor sin interfaz.
+ *
+ * Los colores de las piezas siguen la numeración de miniwin (NEGRO = 0 = VACIO,
+ * ROJO = 1 = cuadrado, ...) para que el cliente pueda pintarlos directamente.
+ *
+ * Las dimensiones son parámetros de plantilla (OcupacionDe, TableroDe). La
+ * máscara de cada fila depende del ancho: 16 bits hasta 16 columnas, 64 bits
+ * hasta 64 y varias palabras de 64 bits (FilaAncha) en tableros más anchos.
+ * Ocupacion y Tablero son el tablero estándar de FILAS x COLUMNAS y tienen
+ * funciones propias con núcleos especializados por pieza (COLISION, INSERCION)
+ * y claves Zobrist; las plantillas genéricas solo se usan con otros tamaños.
+ *
+ * @see Para más información, puedes visitar https://github.com/fjeo0002/Tetris
+ */
+
+#ifndef _TABLERO_H_
+#define _TABLERO_H_
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+const int FILAS = 20; ///< Número de filas en el tablero del juego
+const int COLUMNAS = 10; ///< Número de columnas en el tablero del juego
+
+const int VACIO = 0; ///< Color de una celda vacía (NEGRO en miniwin)
+
+const int TIPOS_PIEZA = 7; ///< Número de formas de pieza distintas
+const int ROTACIONES = 4; ///< Número de rotaciones de cada pieza
+const int CUADRADO = 0; ///< Tipo de la pieza cuadrada, que no rota
+
+/** @struct Coord
+ *  @brief Estructura para almacenar las coordenadas x e y.
+ */
+struct Coord {
+    int x; ///< Coordenada x
+    int y; ///< Coordenada y
+};
+
+typedef uint16_t Fila; ///< Máscara de ocupación de una fila (bit i = columna i)
+
+const Fila FILA_LLENA = (1u << COLUMNAS) - 1; ///< Máscara de una fila completa
+
+/**
+ * @brief Cuenta los bits activos de una máscara.
+ * @param m Máscara
+ * @return int -> Número de bits a 1
+ */
+inline int cuentaBits(unsigned m) {
+#if defined(__GNUC__)
+    return __builtin_popcount(m);
+#else
+    int n = 0;
+    for (; m; m &= m - 1) ++n;
+    return n;
+#endif
+}
+
+/**
+ * @brief Cuenta los bits activos de una máscara de 64 bits.
+ * @param m Máscara
+ * @return int -> Número de bits a 1
+ */
+inline int cuentaBits64(uint64_t m) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(m);
+#else
+    int n = 0;
+    for (; m; m &= m - 1) ++n;
+    return n;
+#endif
+}
+
+/**
+ * @brief Posición del bit activo más bajo de una máscara.
+ * @pre m != 0
+ * @param m Máscara
+ * @return int -> Índice del bit a 1 menos significativo
+ */
+inline int bitMasBajo(unsigned m) {
+#if defined(__GNUC__)
+    return __builtin_ctz(m);
+#else
+    int n = 0;
+    while (!(m & 1u)) {
+        m >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+/**
+ * @brief Coordenadas relativas para las diferentes Piezas
+ * @post Las formas de las piezas son las siguientes:
+ * - Cuadrado (ROJO)
+ * - S (VERDE)
+ * - 2 (AZUL)
+ * - L (AMARILLO)
+ * - L invertida (MAGENTA)
+ * - Palo (CYAN)
+ * - T (BLANCO)
+ */
+constexpr Coord RELATIVOS[TIPOS_PIEZA][3] = {
+        {{1,  0},  {1, 1}, {0,  1}},
+        {{1,  0},  {0, 1}, {-1, 1}},
+        {{-1, 0},  {0, 1}, {1,  1}},
+        {{0,  -1}, {0, 1}, {1,  1}},
+        {{0,  -1}, {0, 1}, {-1, 1}},
+        {{0,  -1}, {0, 1}, {0,  2}},
+        {{-1, 0},  {0, 1}, {1,  0}}
+};
+
+/**
+ * @brief Rota una coordenada en sentido horario.
+ * @param c Coordenada a rotar.
+ * @return Nueva coordenada rotada en sentido horario de la entrada.
+ */
+constexpr Coord rota_derecha(const Coord &c) {
+    return {-c.y, c.x};
+}
+
+/**
+ * @brief Rota una coordenada en sentido antihorario.
+ * @param c Coordenada a rotar.
+ * @return Nueva coordenada rotada en sentido antihorario de la entrada.
+ */
+constexpr Coord rota_izquierda(const Coord &c) {
+    return {c.y, -c.x};
+}
+
+/** @struct Huella
+ *  @brief Forma de una pieza en una rotación concreta, calculada en compilación.
+ *  @post Las máscaras van de la fila miny a la maxy (relativas a abs) y están
+ *        desplazadas para que la columna minx quede en el bit 0.
+ */
+struct Huella {
+    Coord bloque[4]; ///< Bloques relativos a abs (bloque[0] es siempre {0, 0})
+    int minx, maxx, miny, maxy; ///< Caja que envuelve los bloques, relativa a abs
+    int alto; ///< Número de filas que ocupa: maxy - miny + 1
+    Fila mascara[4]; ///< Máscara de cada fila ocupada, de arriba a abajo
+    int canonica; ///< Menor rotación con la misma forma (S, 2 y el palo repiten forma)
+};
+
+/**
+ * @brief Calcula la huella de una pieza girada a la derecha rot veces.
+ * @post El cuadrado no rota, así que todas sus rotaciones son la misma
+ * @param tipo Tipo de pieza (fila de RELATIVOS)
+ * @param rot Número de giros a la derecha (0..3)
+ * @return Huella con bloques, caja y máscaras por fila
+ */
+constexpr Huella calculaHuella(int tipo, int rot) {
+    Huella h{};
+    for (int i = 0; i < 3; ++i) {
+        Coord c = RELATIVOS[tipo][i];
+        for (int r = 0; r < rot && tipo != CUADRADO; ++r) c = rota_derecha(c);
+        h.bloque[i + 1] = c;
+    }
+    h.minx = h.maxx = h.miny = h.maxy = 0;
+    for (int i = 1; i < 4; ++i) {
+        if (h.bloque[i].x < h.minx) h.minx = h.bloque[i].x;
+        if (h.bloque[i].x > h.maxx) h.maxx = h.bloque[i].x;
+        if (h.bloque[i].y < h.miny) h.miny = h.bloque[i].y;
+        if (h.bloque[i].y > h.maxy) h.maxy = h.bloque[i].y;
+    }
+    h.alto = h.maxy - h.miny + 1;
+    for (int i = 0; i < 4; ++i) {
+        h.mascara[h.bloque[i].y - h.miny] |= Fila(1u << (h.bloque[i].x - h.minx));
+    }
+    return h;
+}
+
+/** @struct TablaHuellas
+ *  @brief Huellas de todas las piezas en todas sus rotaciones.
+ */
+struct TablaHuellas {
+    Huella h[TIPOS_PIEZA][ROTACIONES]; ///< Huella por tipo y rotación
+};
+
+/**
+ * @brief Genera en compilación la tabla de huellas a partir de RELATIVOS.
+ * @return TablaHuellas completa
+ */
+constexpr TablaHuellas calculaHuellas() {
+    TablaHuellas t{};
+    for (int tipo = 0; tipo < TIPOS_PIEZA; ++tipo) {
+        for (int rot = 0; rot < ROTACIONES; ++rot) {
+            t.h[tipo][rot] = calculaHuella(tipo, rot);
+        }
+        for (int rot = 0; rot < ROTACIONES; ++rot) {
+            Huella &h = t.h[tipo][rot];
+            h.canonica = rot;
+            for (int otra = rot - 1; otra >= 0; --otra) {
+                const Huella &o = t.h[tipo][otra];
+                bool igual = o.alto == h.alto && o.maxx - o.minx == h.maxx - h.minx;
+                for (int i = 0; i < h.alto && igual; ++i) igual = o.mascara[i] == h.mascara[i];
+                if (igual) h.canonica = otra;
+            }
+        }
+    }
+    return t;
+}
+
+inline constexpr TablaHuellas HUELLAS = calculaHuellas(); ///< Huellas por tipo y rotación
+
+/** @struct Pieza
+ *  @brief Estructura para representar una pieza del juego.
+ *  @post La forma se lee de HUELLAS[tipo][rot]; no se recalcula al rotar ni al colisionar.
+ */
+struct Pieza {
+    Coord abs; ///< Coordenadas absolutas de la pieza
+    int tipo; ///< Tipo de pieza (fila de RELATIVOS)
+    int rot; ///< Giros a la derecha desde la posición inicial (0..3)
+
+    /** @brief Obtiene la huella de la pieza en su rotación actual.
+     *  @return Huella precalculada.
+     */
+    const Huella &huella() const {
+        return HUELLAS.h[tipo][rot];
+    }
+
+    /** @brief Obtiene la posición del bloque.
+     *  @param n Índice del bloque (0 = absoluto, entre 1 y 3 = relativos)
+     *  @return Coordenadas del bloque.
+     */
+    Coord posicionBloque(int n) const {
+        const Coord &r = huella().bloque[n];
+        return {abs.x + r.x, abs.y + r.y};
+    }
+
+    /** @brief Color de la pieza (numeración de miniwin).
+     *  @return int -> tipo + 1
+     */
+    int color() const {
+        return tipo + 1;
+    }
+};
+
+constexpr Coord INICIO = {4, 1}; ///< Posición en la que aparece cada pieza nueva
+
+/** @struct FilaAncha
+ *  @brief Máscara de una fila de más de 64 columnas: bit c en palabra[c / 64].
+ */
+template <int PALABRAS>
+struct FilaAncha {
+    uint64_t palabra[PALABRAS]; ///< Palabras de la máscara, columna 0 en el bit 0 de la primera
+};
+
+/**
+ * @brief Tipo de la máscara de una fila según el ancho del tablero.
+ * @post 16 bits hasta 16 columnas, 64 bits hasta 64 y FilaAncha en el resto
+ */
+template <int ANCHO>
+using FilaDe = typename std::conditional<(ANCHO <= 16), uint16_t,
+        typename std::conditional<(ANCHO <= 64), uint64_t, FilaAncha<(ANCHO + 63) / 64>>::type>::type;
+
+/** @struct OperacionesFila
+ *  @brief Operaciones sobre una máscara de fila entera (16 o 64 bits).
+ *  @post Las piezas ocupan como mucho 4 columnas: m son sus bits desde la columna x
+ */
+template <class R>
+struct OperacionesFila {
+    /** @brief Máscara de una fila llena de ANCHO columnas. */
+    template <int ANCHO>
+    static constexpr R llena() {
+        return ANCHO >= 64 ? R(~uint64_t(0)) : R((uint64_t(1) << ANCHO) - 1);
+    }
+
+    /** @brief true: alguna de las celdas m << x está ocupada en f. */
+    static bool choca(const R &f, unsigned m, int x) {
+        return (f & (R(m) << x)) != 0;
+    }
+
+    /** @brief Ocupa las celdas m << x de f. */
+    static void marca(R &f, unsigned m, int x) {
+        f = R(f | (R(m) << x));
+    }
+
+    /** @brief true: f es una fila llena de ANCHO columnas. */
+    template <int ANCHO>
+    static bool completa(const R &f) {
+        return f == llena<ANCHO>();
+    }
+
+    /** @brief Estado de la celda c de f. */
+    static bool celda(const R &f, int c) {
+        return (f >> c) & 1;
+    }
+
+    /** @brief Vacía f. */
+    static void vacia(R &f) {
+        f = 0;
+    }
+
+    /** @brief Celdas ocupadas de f. */
+    static int bits(const R &f) {
+        return cuentaBits64(f);
+    }
+};
+
+/** @struct OperacionesFila
+ *  @brief Operaciones sobre una FilaAncha.
+ *  @post Una pieza toca una palabra o, como mucho, dos vecinas. La comprobación
+ *        de fila llena recorre la fila en bloques de 256 bits con los vectores
+ *        de GCC (AVX2 o dos SSE2 según el objetivo de compilación).
+ */
+template <int N>
+struct OperacionesFila<FilaAncha<N>> {
+    typedef FilaAncha<N> R; ///< Máscara de la fila
+
+    template <int ANCHO>
+    static R llena() {
+        R f;
+        for (int i = 0; i < N; ++i) {
+            int resto = ANCHO - 64 * i;
+            f.palabra[i] = resto >= 64 ? ~uint64_t(0) : resto <= 0 ? 0 : (uint64_t(1) << resto) - 1;
+        }
+        return f;
+    }
+
+    static bool choca(const R &f, unsigned m, int x) {
+        const int w = x >> 6, s = x & 63;
+        uint64_t choque = f.palabra[w] & (uint64_t(m) << s);
+        if (s > 60 && w + 1 < N) choque |= f.palabra[w + 1] & (uint64_t(m) >> (64 - s));
+        return choque != 0;
+    }
+
+    static void marca(R &f, unsigned m, int x) {
+        const int w = x >> 6, s = x & 63;
+        f.palabra[w] |= uint64_t(m) << s;
+        if (s > 60 && w + 1 < N) f.palabra[w + 1] |= uint64_t(m) >> (64 - s);
+    }
+
+    template <int ANCHO>
+    static bool completa(const R &f) {
+        // Las palabras enteras del ancho deben ser ~0: se acumula su AND
+        constexpr int ENTERAS = ANCHO / 64, RESTO = ANCHO % 64;
+        uint64_t todas = ~uint64_t(0);
+        int i = 0;
+#if defined(__GNUC__)
+        typedef uint64_t Bloque __attribute__((vector_size(32)));
+        Bloque y = {~uint64_t(0), ~uint64_t(0), ~uint64_t(0), ~uint64_t(0)};
+        for (; i + 4 <= ENTERAS; i += 4) {
+            Bloque b;
+            memcpy(&b, &f.palabra[i], sizeof(b));
+            y &= b;
+        }
+        todas = y[0] & y[1] & y[2] & y[3];
+#endif
+        for (; i < ENTERAS; ++i) todas &= f.palabra[i];
+        // Las columnas de más allá del ancho nunca se ocupan
+        return todas == ~uint64_t(0) && (ENTERAS >= N || f.palabra[ENTERAS] == (uint64_t(1) << RESTO) - 1);
+    }
+
+    static bool celda(const R &f, int c) {
+        return (f.palabra[c >> 6] >> (c & 63)) & 1;
+    }
+
+    static void vacia(R &f) {
+        memset(f.palabra, 0, sizeof(f.palabra));
+    }
+
+    static int bits(const R &f) {
+        int n = 0;
+        for (int i = 0; i < N; ++i) n += cuentaBits64(f.palabra[i]);
+        return n;
+    }
+};
+
+/** @struct OcupacionDe
+ *  @brief Bitboard de un tablero de ALTO x ANCHO: una máscara R por fila.
+ *  Es todo lo que necesitan las colisiones y el borrado de líneas.
+ */
+template <int ANCHO, int ALTO, class R = FilaDe<ANCHO>>
+struct OcupacionDe {
+    static constexpr int COLUMNAS = ANCHO; ///< Columnas del tablero
+    static constexpr int FILAS = ALTO; ///< Filas del tablero
+    typedef R TipoFila; ///< Máscara de una fila
+    R fila[ALTO]; ///< Máscaras de ocupación, fila 0 arriba
+};
+
+/** @struct TableroDe
+ *  @brief Tablero del juego: bitboard más un plano de color que solo se usa para pintar.
+ *  @post Invariante: color[f][c] == VACIO si y solo si la celda c de fila[f] está ocupada
+ */
+template <int ANCHO, int ALTO, class R = FilaDe<ANCHO>>
+struct TableroDe : OcupacionDe<ANCHO, ALTO, R> {
+    unsigned char color[ALTO][ANCHO]; ///< Color de cada celda, por filas
+};
+
+typedef OcupacionDe<COLUMNAS, FILAS> Ocupacion; ///< Bitboard del tablero estándar (16 bits por fila)
+typedef TableroDe<COLUMNAS, FILAS> Tablero; ///< Tablero estándar del juego
+
+static_assert(std::is_same<Ocupacion::TipoFila, Fila>::value && sizeof(Ocupacion) == FILAS * sizeof(Fila),
+              "El tablero estándar debe seguir siendo una Fila por fila");
+
+/**
+ * @brief Núcleo de colisión especializado para una pieza y rotación.
+ * @post Toda la forma es constante en compilación: una comprobación de caja y
+ *       un AND por fila ocupada, sin bucle por bloques.
+ * @param T Ocupación del tablero
+ * @param x Columna de abs
+ * @param y Fila de abs
+ * @return bool -> true: la pieza se sale del tablero o pisa una celda ocupada
+ */
+template <int TIPO, int ROT>
+inline bool colisionHuella(const Ocupacion &T, int x, int y) {
+    constexpr Huella H = HUELLAS.h[TIPO][ROT];
+    const int x0 = x + H.minx;
+    const int y0 = y + H.miny;
+    if (unsigned(x0) > unsigned(COLUMNAS - (H.maxx - H.minx + 1)) ||
+        unsigned(y0) > unsigned(FILAS - H.alto)) {
+        return true;
+    }
+    unsigned choque = 0;
+    for (int i = 0; i < H.alto; ++i) {
+        choque |= T.fila[y0 + i] & (unsigned(H.mascara[i]) << x0);
+    }
+    return choque != 0;
+}
+
+/**
+ * @brief Núcleo de inserción especializado para una pieza y rotación.
+ * @pre La pieza cabe en el tablero (colisionHuella ha devuelto false)
+ * @param T Ocupación del tablero
+ * @param x Columna de abs
+ * @param y Fila de abs
+ */
+template <int TIPO, int ROT>
+inline void insertaHuella(Ocupacion &T, int x, int y) {
+    constexpr Huella H = HUELLAS.h[TIPO][ROT];
+    const int x0 = x + H.minx;
+    const int y0 = y + H.miny;
+    for (int i = 0; i < H.alto; ++i) {
+        T.fila[y0 + i] |= Fila(H.mascara[i] << x0);
+    }
+}
+
+const int TROZO_CLAVE = 5; ///< Columnas que cubre cada tabla de claves Zobrist de una fila
+const int TROZOS_CLAVE = (COLUMNAS + TROZO_CLAVE - 1) / TROZO_CLAVE; ///< Tablas de claves por fila
+
+/** @struct TablaZobrist
+ *  @brief Claves Zobrist del tablero y de las piezas, calculadas en compilación.
+ *  @post Cada celda tiene una clave de 64 bits; fila[f][t][m] es el XOR de las
+ *        claves de las celdas de la fila f marcadas en m, en el trozo t de
+ *        TROZO_CLAVE columnas. Así la clave de una fila entera son TROZOS_CLAVE lecturas.
+ */
+struct TablaZobrist {
+    uint64_t fila[FILAS][TROZOS_CLAVE][1 << TROZO_CLAVE]; ///< Claves por fila, trozo y máscara del trozo
+    uint64_t pieza[TIPOS_PIEZA]; ///< Clave de la pieza por mover, para distinguir posiciones de búsqueda
+    uint64_t siguiente[TIPOS_PIEZA]; ///< Clave de la pieza siguiente
+};
+
+/**
+ * @brief Genera en compilación las claves Zobrist con splitmix64 y semilla fija.
+ * @post Las claves son siempre las mismas: se pueden guardar en ficheros
+ * @return TablaZobrist completa
+ */
+constexpr TablaZobrist calculaZobrist() {
+    TablaZobrist t{};
+    uint64_t estado = 0x5A0B12C7A5E7D1ull;
+    auto azar = [&estado]() {
+        uint64_t z = (estado += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    };
+    for (int f = 0; f < FILAS; ++f) {
+        for (int tr = 0; tr < TROZOS_CLAVE; ++tr) {
+            uint64_t celda[TROZO_CLAVE] = {};
+            for (int c = 0; c < TROZO_CLAVE; ++c) celda[c] = azar();
+            for (int m = 1; m < (1 << TROZO_CLAVE); ++m) {
+                int c = 0;
+                while (!((m >> c) & 1)) ++c;
+                t.fila[f][tr][m] = t.fila[f][tr][m & (m - 1)] ^ celda[c];
+            }
+        }
+    }
+    for (int i = 0; i < TIPOS_PIEZA; ++i) t.pieza[i] = azar();
+    for (int i = 0; i < TIPOS_PIEZA; ++i) t.siguiente[i] = azar();
+    return t;
+}
+
+inline constexpr TablaZobrist ZOBRIST = calculaZobrist(); ///< Claves Zobrist
+
+/**
+ * @brief Clave Zobrist de las celdas marcadas en una fila.
+ * @param f Fila
+ * @param m Máscara de celdas
+ * @return uint64_t -> XOR de las claves de esas celdas
+ */
+inline uint64_t claveFila(int f, unsigned m) {
+    uint64_t k = 0;
+    for (int t = 0; t < TROZOS_CLAVE; ++t) k ^= ZOBRIST.fila[f][t][(m >> (t * TROZO_CLAVE)) & ((1u << TROZO_CLAVE) - 1)];
+    return k;
+}
+
+typedef bool (*KernelColision)(const Ocupacion &T, int x, int y); ///< Núcleo de colisión
+typedef void (*KernelInsercion)(Ocupacion &T, int x, int y); ///< Núcleo de inserción
+
+extern const KernelColision COLISION[TIPOS_PIEZA][ROTACIONES]; ///< colisionHuella por tipo y rotación
+extern const KernelInsercion INSERCION[TIPOS_PIEZA][ROTACIONES]; ///< insertaHuella por tipo y rotación
+
+void rota_derecha(Pieza &P);
+void rota_izquierda(Pieza &P);
+
+void vaciarTablero(Tablero &T);
+void insertaPieza(Tablero &T, const Pieza &P);
+void insertaPieza(Ocupacion &T, const Pieza &P);
+void insertaPieza(Ocupacion &T, const Pieza &P, uint64_t &clave);
+bool colisionPieza(const Ocupacion &T, const Pieza &P);
+bool filaLlena(const Ocupacion &T, int fila);
+void quitarFila(Tablero &T, int fila);
+int cuentaFila(Tablero &T);
+int cuentaFila(Ocupacion &T);
+int cuentaFila(Ocupacion &T, uint64_t &clave);
+uint64_t claveTablero(const Ocupacion &T);
+bool subirFilas(Tablero &T, int n, Fila fila, unsigned char color);
+
+/**
+ * @brief Posición en la que aparece cada pieza nueva en un tablero de un ancho.
+ * @param ancho Columnas del tablero
+ * @return Coord -> Columna central a la izquierda, fila 1 (INICIO en el estándar)
+ */
+constexpr Coord inicioPieza(int ancho) {
+    return {ancho / 2 - 1, 1};
+}
+
+static_assert(inicioPieza(COLUMNAS).x == INICIO.x && inicioPieza(COLUMNAS).y == INICIO.y,
+              "INICIO es la posición de aparición del tablero estándar");
+
+// Versiones genéricas para tableros de otros tamaños. Con Ocupacion y Tablero
+// la resolución de sobrecargas prefiere las funciones no plantilla de arriba.
+
+/**
+ * @brief Vacía un tablero de cualquier tamaño.
+ * @param T Tablero
+ */
+template <int A, int H, class R>
+void vaciarTablero(TableroDe<A, H, R> &T) {
+    for (int f = 0; f < H; ++f) OperacionesFila<R>::vacia(T.fila[f]);
+    memset(T.color, VACIO, sizeof(T.color));
+}
+
+/**
+ * @brief Comprueba si una pieza se sale de un tablero de cualquier tamaño o pisa una celda ocupada.
+ * @param T Ocupación del tablero
+ * @param P Pieza
+ * @return bool -> true: la pieza colisiona
+ */
+template <int A, int H, class R>
+bool colisionPieza(const OcupacionDe<A, H, R> &T, const Pieza &P) {
+    const Huella &h = P.huella();
+    const int x0 = P.abs.x + h.minx;
+    const int y0 = P.abs.y + h.miny;
+    if (unsigned(x0) > unsigned(A - (h.maxx - h.minx + 1)) || unsigned(y0) > unsigned(H - h.alto)) return true;
+    for (int i = 0; i < h.alto; ++i) {
+        if (OperacionesFila<R>::choca(T.fila[y0 + i], h.mascara[i], x0)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Inserta una pieza en el bitboard de un tablero de cualquier tamaño.
+ * @pre La pieza no colisiona
+ * @param T Ocupación del tablero
+ * @param P Pieza
+ */
+template <int A, int H, class R>
+void insertaPieza(OcupacionDe<A, H, R> &T, const Pieza &P) {
+    const Huella &h = P.huella();
+    const int x0 = P.abs.x + h.minx;
+    const int y0 = P.abs.y + h.miny;
+    for (int i = 0; i < h.alto; ++i) OperacionesFila<R>::marca(T.fila[y0 + i], h.mascara[i], x0);
+}
+
+/**
+ * @brief Inserta una pieza con su color en un tablero de cualquier tamaño.
+ * @pre La pieza no colisiona
+ * @param T Tablero
+ * @param P Pieza
+ */
+template <int A, int H, class R>
+void insertaPieza(TableroDe<A, H, R> &T, const Pieza &P) {
+    insertaPieza(static_cast<OcupacionDe<A, H, R> &>(T), P);
+    for (int i = 0; i < 4; ++i) {
+        Coord c = P.posicionBloque(i);
+        T.color[c.y][c.x] = (unsigned char) P.color();
+    }
+}
+
+/**
+ * @brief Cuenta y Quita las filas llenas de un bitboard de cualquier tamaño.
+ * @post Misma compactación de abajo a arriba que cuentaFila(Ocupacion &)
+ * @param T Ocupación del tablero
+ * @return int -> Cantidad de filas quitadas
+ */
+template <int A, int H, class R>
+int cuentaFila(OcupacionDe<A, H, R> &T) {
+    int destino = H - 1;
+    for (int fila = H - 1; fila >= 0; --fila) {
+        if (OperacionesFila<R>::template completa<A>(T.fila[fila])) continue;
+        if (destino != fila) T.fila[destino] = T.fila[fila];
+        --destino;
+    }
+    for (int fila = 0; fila <= destino; ++fila) OperacionesFila<R>::vacia(T.fila[fila]);
+    return destino + 1;
+}
+
+/**
+ * @brief Cuenta y Quita las filas llenas de un tablero de cualquier tamaño, con su color.
+ * @post Misma compactación que cuentaFila(Tablero &)
+ * @param T Tablero
+ * @return int -> Cantidad de filas quitadas
+ */
+template <int A, int H, class R>
+int cuentaFila(TableroDe<A, H, R> &T) {
+    int destino = H - 1;
+    for (int fila = H - 1; fila >= 0; --fila) {
+        if (OperacionesFila<R>::template completa<A>(T.fila[fila])) continue;
+        if (destino != fila) {
+            T.fila[destino] = T.fila[fila];
+            memcpy(T.color[destino], T.color[fila], sizeof(T.color[0]));
+        }
+        --destino;
+    }
+    int cont = destino + 1;
+    for (int fila = 0; fila < cont; ++fila) OperacionesFila<R>::vacia(T.fila[fila]);
+    if (cont > 0) memset(T.color, VACIO, cont * sizeof(T.color[0]));
+    return cont;
+}
+
+#endif
@@ -8,6 +8,9 @@
  * Las piezas pueden rotarse y moverse horizontalmente.
  * El objetivo del juego es completar filas para obtener puntos.
  *
+ * Las reglas viven en el motor sin interfaz (juego.h); este archivo solo
+ * traduce teclas a acciones, pinta el estado con miniwin y reproduce la música.
+ *
  * @author Francisco José Escabias Ortega
  * @date 26/04/2024
  *
@@ -15,49 +18,49 @@
  */
 
 #include "miniwin.h"
-#include <Windows.h>
+#include "bot.h"
+#include "juego.h"
+#include "libro.h"
+#include "mando.h"
+#include "reloj.h"
+#include "repeticion.h"
+#include "rollback.h"
+#include "udp.h"
+#include <cstdio>
 #include <iostream>
-#include <mmsystem.h>
+#include <memory>
 #include <time.h>
 
+#if defined(_WIN32)
+#include <Windows.h>
+#include <mmsystem.h>
+#endif
+
 using namespace std;
 using namespace miniwin;
 
 
-const int TAM = 25; ///< Tamaño de los bloques del juego
-const int FILAS = 20; ///< Número de filas en el tablero del juego
-const int COLUMNAS = 10; ///< Número de columnas en el tablero del juego
-const int MARGEN = 10; ///< Margen alrededor del tablero del juego
-const int ANCHO = TAM * COLUMNAS; ///< Ancho del tablero del juego
-const int ALTO = TAM * FILAS; ///< Altura del tablero del juego
-
-/** @struct Coord
- *  @brief Estructura para almacenar las coordenadas x e y.
- */
-struct Coord {
-    int x; ///< Coordenada x
-    int y; ///< Coordenada y
-};
+typedef decltype(EstadoJuego::T) TableroJuego; ///< Tablero que se pinta: sus dimensiones fijan la ventana
+const int COLUMNAS_JUEGO = TableroJuego::COLUMNAS; ///< Columnas del tablero que se pinta
+const int FILAS_JUEGO = TableroJuego::FILAS; ///< Filas del tablero que se pinta
 
-/** @struct Pieza
- *  @brief Estructura para representar una pieza del juego.
- */
-struct Pieza {
-    Coord abs; ///< Coordenadas absolutas de la pieza
-    Coord relat[3]; ///< Coordenadas relativas de la pieza
-    int color; ///< Color de la pieza
-
-    /** @brief Obtiene la posición del bloque.
-     *  @param n Índice del bloque (0 = absoluto, entre 1 y 3 = relativos)
-     *  @return Coordenadas del bloque.
-     */
-    Coord posicionBloque(int n) const {
-        if (n == 0) return abs;
-        return {abs.x + relat[n - 1].x, abs.y + relat[n - 1].y};
-    }
-};
+/**
+ * @brief Tamaño de los bloques para que el tablero quepa en la pantalla.
+ * @param columnas Columnas del tablero
+ * @param filas Filas del tablero
+ * @return int -> 25 píxeles en el tablero estándar; menos en los grandes (al menos 2)
+ */
+constexpr int tamBloque(int columnas, int filas) {
+    int t = 25;
+    if (t * filas > 900) t = 900 / filas;
+    if (t * columnas > 1600) t = 1600 / columnas;
+    return t < 2 ? 2 : t;
+}
 
-typedef int Tablero[COLUMNAS][FILAS]; ///< Tablero del juego
+const int TAM = tamBloque(COLUMNAS_JUEGO, FILAS_JUEGO); ///< Tamaño de los bloques del juego
+const int MARGEN = 10; ///< Margen alrededor del tablero del juego
+const int ANCHO = TAM * COLUMNAS_JUEGO; ///< Ancho del tablero del juego
+const int ALTO = TAM * FILAS_JUEGO; ///< Altura del tablero del juego
 
 /**
  * @brief Dibuja un cuadrado en las coordenadas dadas.
@@ -76,7 +79,7 @@ void cuadrado(int x, int y) {
  * @param P Pieza a dibujar.
  */
 void pinta_pieza(const Pieza &P) {
-    color(P.color);
+    color(P.color());
     cuadrado(P.abs.x, P.abs.y);
     for (int i = 0; i < 4; ++i) {
         Coord c = P.posicionBloque(i);
@@ -84,216 +87,46 @@ void pinta_pieza(const Pieza &P) {
     }
 }
 
-/**
- * @brief Rota una coordenada en sentido horario.
- * @param c Coordenada a rotar.
- * @return Nueva coordenada rotada en sentido horario de la entrada.
- */
-Coord rota_derecha(const Coord &c) {
-    Coord ret = {-c.y, c.x};
-    return ret;
-}
-
-/**
- * @brief Rota una pieza en sentido horario.
- * @param P Pieza a rotar.
- */
-void rota_derecha(Pieza &P) {
-    if (P.color == ROJO) return;
-    for (int i = 0; i < 3; ++i) {
-        P.relat[i] = rota_derecha(P.relat[i]);
-    }
-}
-
-/**
- * @brief Rota una coordenada en sentido antihorario.
- * @param c Coordenada a rotar.
- * @return Nueva coordenada rotada en sentido antihorario de la entrada.
- */
-Coord rota_izquierda(const Coord &c) {
-    Coord ret = {c.y, -c.x};
-    return ret;
-}
-
-/**
- * @brief Rota una pieza en sentido antihorario.
- * @param P Pieza a rotar.
- */
-void rota_izquierda(Pieza &P) {
-    if (P.color == ROJO) return;
-    for (int i = 0; i < 3; ++i) {
-        P.relat[i] = rota_izquierda(P.relat[i]);
-    }
-}
-
-/**
- * @brief Vacía el Tablero de juego.
- * @post Establece todas sus celdas a NEGRO
- * @param T Tablero
- */
-void vaciarTablero(Tablero &T) {
-    for (int i = 0; i < COLUMNAS; ++i) {
-        for (int j = 0; j < FILAS; ++j) {
-            T[i][j] = NEGRO;
-        }
-    }
-}
-
 /**
  * @brief Actualiza el tablero del juego.
  * @post Aplica color correspondiente y dibuja un cuadrado en cada celda
  * @param T Tablero del juego
  */
-void actualizaTablero(const Tablero &T) {
-    for (int i = 0; i < COLUMNAS; ++i) {
-        for (int j = 0; j < FILAS; ++j) {
-            color(T[i][j]);
+void actualizaTablero(const TableroJuego &T) {
+    for (int i = 0; i < COLUMNAS_JUEGO; ++i) {
+        for (int j = 0; j < FILAS_JUEGO; ++j) {
+            color(T.color[j][i]);
             cuadrado(i, j);
         }
     }
 }
 
 /**
- * @brief Inserta una pieza en el Tablero de juego
- * @post Coloca el color de la pieza en la posición correspondiente del Tablero.
- * @param T Tablero del juego
- * @param P Pieza a insertar
- */
-void insertaPieza(Tablero &T, const Pieza &P) {
+ * @brief Dibuja una pieza a tamaño reducido en una posición de la ventana.
+ * @param P Pieza a dibujar (se ignora su posición)
+ * @param x Coordenada x, en píxeles, del bloque central
+ * @param y Coordenada y, en píxeles, del bloque central
+ */
+void pinta_pieza_pequena(const Pieza &P, int x, int y) {
+    const int t = TAM / 2;
+    color(P.color());
     for (int i = 0; i < 4; ++i) {
-        Coord c = P.posicionBloque(i);
-        T[c.x][c.y] = P.color;
+        Coord c = P.huella().bloque[i];
+        rectangulo_lleno(x + c.x * t + 1, y + c.y * t + 1, x + c.x * t + t, y + c.y * t + t);
     }
 }
 
-/**
- * @brief Comprueba si hay colisión entre una pieza y la celda del Tablero
- * @post Recorre cada bloque de la pieza y verifica
- *        -> la posición del bloque está fuera de los límites del tablero
- *        -> la posición del bloque en el tablero no es NEGRO
- * @param T Tablero del juego
- * @param P Pieza que pueda colisionar
- * @return bool -> true: la pieza colisiona en el tablero
- *              -> false: caso contrario.
- */
-bool colisionPieza(const Tablero &T, const Pieza &P) {
-    for (int i = 0; i < 4; ++i) {
-        Coord c = P.posicionBloque(i);
-        if (c.x < 0 || c.x >= COLUMNAS || c.y < 0 || c.y >= FILAS) {
-            return true;
-        } else if (T[c.x][c.y] != NEGRO) {
-            return true;
-        }
-    }
-    return false;
-}
-
-/**
- * @brief Comprueba si una fila del Tablero esta llena.
- * @post Recorre cada celda de la fila y comprueba que esté vacía
- * @param T Tablero del juego
- * @param fila Número de la fila que se va a verificar.
- * @return bool -> true: fila llena
- *              -> false: caso contrario.
- */
-bool filaLlena(const Tablero &T, int fila) {
-    for (int i = 0; i < COLUMNAS; ++i) {
-        if (T[i][fila] == NEGRO) {
-            return false;
-        }
-    }
-    return true;
-}
-
-/**
- * @brief Quita una fila del Tablero.
- * @post Desplaza todas las filas superiores a la indicada hacia abajo
- * @post Establece todas las celdas de la fila superior a NEGRO
- * @param T Tablero del juego
- * @param fila Número de la fila que se va a quitar.
- */
-void quitarFila(Tablero &T, int fila) {
-    for (int j = fila; j > 0; --j) {
-        for (int i = 0; i < COLUMNAS; ++i) {
-            T[i][j] = T[i][j - 1];
-        }
-    }
-    for (int i = 0; i < COLUMNAS; ++i) {
-        T[i][0] = NEGRO;
-    }
-}
-
-/**
- * @brief Cuenta y Quita las filas del Tablero que están llenas.
- * @param T Tablero del juego
- * @return int -> Cantidad de filas quitadas
- */
-int cuentaFila(Tablero &T) {
-    int fila = FILAS - 1;
-    int cont = 0;
-    while (fila >= 0) {
-        if (filaLlena(T, fila)) {
-            quitarFila(T, fila);
-            ++cont;
-        } else {
-            --fila;
-        }
-    }
-    return cont;
-}
-
-/**
- * @brief Coordenadas relativas para las diferentes Piezas
- * @post Las formas de las piezas son las siguientes:
- * - Cuadrado (ROJO)
- * - S (VERDE)
- * - 2 (AZUL)
- * - L (AMARILLO)
- * - L invertida (MAGENTA)
- * - Palo (CYAN)
- * - T (BLANCO)
- * @param RELATIVOS Matriz de coordenadas relativas para las diferentes formas de piezas.
- */
-const Coord RELATIVOS[7][3] = {
-        {{1,  0},  {1, 1}, {0,  1}},
-        {{1,  0},  {0, 1}, {-1, 1}},
-        {{-1, 0},  {0, 1}, {1,  1}},
-        {{0,  -1}, {0, 1}, {1,  1}},
-        {{0,  -1}, {0, 1}, {-1, 1}},
-        {{0,  -1}, {0, 1}, {0,  2}},
-        {{-1, 0},  {0, 1}, {1,  0}}
-};
-
-/**
- * @brief Crea una nueva pieza
- * @post Crea una nueva pieza al azar según los RELATIVOS
- * @param P Pieza a crear
- */
-void pieza_nueva(Pieza &P) {
-    P.abs.x = 13;
-    P.abs.y = 3;
-
-    //Pieza al azar
-    int r = rand() % 7;
-    for (int i = 0; i < 3; ++i) {
-        P.relat[i] = RELATIVOS[r][i];
-    }
-    r++;
-    P.color = r;
-}
+const Coord VISTA_SIGUIENTE = {COLUMNAS_JUEGO + 3, 3}; ///< Posición en la que se dibuja la siguiente pieza
+const int VISTA_COLUMNAS = 4; ///< Piezas por fila en la vista reducida de las demás piezas siguientes
 
 /**
  * @brief Dibuja la interfaz del juego Tetris.
  * @post Borra el tablero, actualiza el estado del mismo junto con Información de juego
- * @param T Tablero del juego
- * @param P Pieza actual en juego
- * @param N Siguiente Pieza en el juego.
- * @param ptos Puntos actuales del jugador.
- * @param level Nivel actual del juego.
+ * @param E Estado de la partida: tablero, pieza actual, siguiente, puntos y nivel
  */
-void pintarInterfaz(const Tablero &T, const Pieza &P, const Pieza &N, int ptos, int level) {
+void pintarInterfaz(const EstadoJuego &E) {
     borra();
-    actualizaTablero(T);
+    actualizaTablero(E.T);
 
     color(BLANCO);
     linea(MARGEN + 0, MARGEN + 0, MARGEN + 0, MARGEN + ALTO);
@@ -301,14 +134,23 @@ void pintarInterfaz(const Tablero &T, const Pieza &P, const Pieza &N, int ptos,
     linea(MARGEN + ANCHO, MARGEN + 0, MARGEN + ANCHO, MARGEN + ALTO);
     linea(MARGEN + 0, MARGEN + 0, MARGEN + ANCHO, MARGEN + 0);
 
-    texto(MARGEN * 2 + TAM * COLUMNAS, MARGEN * 3, "Pieza Siguiente:");
+    texto(MARGEN * 2 + ANCHO, MARGEN * 3, "Pieza Siguiente:");
 
-    texto(MARGEN * 2 + TAM * COLUMNAS, MARGEN * 20, "Puntos: " + to_string(ptos));
+    texto(MARGEN * 2 + ANCHO, MARGEN * 20, "Puntos: " + to_string(E.ptos));
 
-    texto(MARGEN * 2 + TAM * COLUMNAS, MARGEN * 30, "Nivel: " + to_string(level));
+    texto(MARGEN * 2 + ANCHO, MARGEN * 30, "Nivel: " + to_string(E.level));
 
-    pinta_pieza(P);
+    pinta_pieza(E.P);
+    Pieza N = {VISTA_SIGUIENTE, verPieza(E.azar, 0), 0};
     pinta_pieza(N);
+
+    // Las demás piezas de la cola, en pequeño debajo del nivel
+    for (int i = 1; i < E.azar.vista; ++i) {
+        N.tipo = verPieza(E.azar, i);
+        int x = MARGEN * 2 + ANCHO + ((i - 1) % VISTA_COLUMNAS) * TAM * 2 + TAM / 2;
+        int y = MARGEN * 35 + ((i - 1) / VISTA_COLUMNAS) * TAM * 5 / 2;
+        pinta_pieza_pequena(N, x, y);
+    }
     refresca();
 }
 
@@ -318,8 +160,8 @@ void pintarInterfaz(const Tablero &T, const Pieza &P, const Pieza &N, int ptos,
  * @param mensaje string: Mensaje a mostrar al final de la partida
  */
 void finPartida(string mensaje) {
-    for (int i = 0; i < FILAS; ++i) {
-        for (int j = 0; j < COLUMNAS; ++j) {
+    for (int i = 0; i < FILAS_JUEGO; ++i) {
+        for (int j = 0; j < COLUMNAS_JUEGO; ++j) {
             color(BLANCO);
             cuadrado(j, i);
             espera(1);
@@ -328,7 +170,7 @@ void finPartida(string mensaje) {
     }
 
     color(AZUL);
-    texto(COLUMNAS * TAM / 2 - 10 - 15, FILAS * TAM / 2 - 10, mensaje);
+    texto(ANCHO / 2 - 10 - 15, ALTO / 2 - 10, mensaje);
     refresca();
 }
 
@@ -473,9 +315,13 @@ bool jugarOtraVez() {
     dibujaBotones();
     refresca();
 
-    // Espera a que el usuario haga clic en uno de los botones
+    // Espera a que el usuario haga clic en uno de los botones (dormido entre eventos)
     bool clic_realizado = false;
     while (!clic_realizado) {
+        espera_evento(-1);
+        // Aquí no se usan las teclas, pero si quedan en la cola espera_evento no duerme
+        while (tecla() != NINGUNA) {
+        }
         if (raton_boton_izq()) { // Verifica si se ha presionado el botón izquierdo del ratón
             int x = raton_x(); // Obtiene la coordenada x del clic
             int y = raton_y(); // Obtiene la coordenada y del clic
@@ -485,159 +331,451 @@ bool jugarOtraVez() {
     return clic_realizado;
 }
 /**
- * @brief Puntos necesarios para alcanzar cada nivel
- * @post Los puntos necesarios para alcanzar cada nivel son:
- * - Nivel 1: 0 puntos
- * - Nivel 2: 100 puntos
- * - Nivel 3: 300 puntos
- * - Nivel 4: 600 puntos
- * - Nivel 5: 1000 puntos
- * - Nivel 6: 1500 puntos
- * - Nivel 7: 2000 puntos
- */
-const int PUNTOS_NIVEL[7] = {0, 100, 300, 600, 1000, 1500, 2000};
+ * @brief Reproduce un fichero de sonido de forma asíncrona.
+ * @post Solo hay sonido en Windows (winmm); en otras plataformas no hace nada
+ * @param fichero Ruta del fichero .wav
+ * @param bucle true: se repite indefinidamente
+ */
+void sonido(const char *fichero, bool bucle) {
+#if defined(_WIN32)
+    PlaySoundA(fichero, NULL, SND_FILENAME | SND_ASYNC | (bucle ? SND_LOOP : 0));
+#else
+    (void) fichero;
+    (void) bucle;
+#endif
+}
 
 /**
- * @brief Velocidad de caída de la pieza en cada nivel
- * @post La velocidad de caída de las piezas para cada nivel es:
- * - Nivel 1: 30 milisegundos por posición
- * - Nivel 2: 25 milisegundos por posición
- * - Nivel 3: 20 milisegundos por posición
- * - Nivel 4: 15 milisegundos por posición
- * - Nivel 5: 10 milisegundos por posición
- * - Nivel 6: 5 milisegundos por posición
- * - Nivel 7: 1 milisegundo por posición
- */
-const int VELOCIDAD_NIVEL[7] = {30, 25, 20, 15, 10, 5, 1};
+ * @brief Traduce una tecla de miniwin a la acción del motor.
+ * @param t Tecla devuelta por tecla()
+ * @return Accion -> ARRIBA/'Z' rota a la derecha, 'X' a la izquierda, flechas mueven
+ */
+Accion accionDeTecla(int t) {
+    if (t == ARRIBA || t == int('Z')) return ROTAR_DERECHA;
+    if (t == int('X')) return ROTAR_IZQUIERDA;
+    if (t == ABAJO) return BAJAR;
+    if (t == IZQUIERDA) return MOVER_IZQUIERDA;
+    if (t == DERECHA) return MOVER_DERECHA;
+    return NADA;
+}
 
 /**
- * @brief Funcion principal y control del juego Tetris
- * @post El juego se repite hasta que el usuario haga clic en el botón "No"
- * @return bool -> true: clic en botón "No"
+ * @brief Dirección horizontal que mantiene pulsada el jugador.
+ * @return int -> -1 izquierda, 1 derecha, 0 ninguna; con las dos, la última que se pulsó
+ */
+int direccionTeclas() {
+    int izq = tecla_pulsada_ms(IZQUIERDA), der = tecla_pulsada_ms(DERECHA);
+    if (izq < 0) return der < 0 ? 0 : 1;
+    if (der < 0) return -1;
+    return izq <= der ? -1 : 1;
+}
+
+const int TECLAS_MANDO[3] = {IZQUIERDA, DERECHA, ABAJO}; ///< Teclas que cuenta TeclasMando::pulsaciones
+
+/** @struct TecladoJugador
+ *  @brief Mando de una persona y las pulsaciones ya contadas.
  */
-int main() {
-    srand(time(nullptr));
+struct TecladoJugador {
+    Mando M; ///< Repetición de las teclas mantenidas
+    int pulsaciones[3]; ///< tecla_pulsaciones de TECLAS_MANDO en el último tick
+};
 
-//Bucle Principal de Aplicacion
-JugarOtraVez:
-    //Música para Ventana de Inicio
-    PlaySound(TEXT("../music/title.wav"), NULL, SND_FILENAME | SND_ASYNC | SND_LOOP);
-    if (!jugarOtraVez()) {
+/**
+ * @brief Prepara el teclado de una partida.
+ * @post Las pulsaciones de antes de la partida (en el título) no cuentan
+ * @param J Teclado
+ * @param das Ticks hasta la primera repetición
+ * @param arr Ticks entre repeticiones
+ */
+void iniciarTeclado(TecladoJugador &J, int das, int arr) {
+    iniciarMando(J.M, das, arr);
+    for (int i = 0; i < 3; ++i) J.pulsaciones[i] = tecla_pulsaciones(TECLAS_MANDO[i]);
+}
 
+/**
+ * @brief Acción del jugador en un tick: rotaciones, pulsaciones y repetición de las mantenidas.
+ * @post Lee lo mantenido antes que las pulsaciones (ver mando.h). Las flechas
+ *       de la cola de teclas no se usan: se cuentan con tecla_pulsaciones.
+ * @param J Teclado del jugador
+ * @param t Tecla de la cola desde el último tick (NINGUNA si no hay)
+ * @param gravedad La gravedad toca en este frame
+ * @return Accion -> Acción para paso()
+ */
+Accion accionJugador(TecladoJugador &J, int t, bool gravedad) {
+    TeclasMando K;
+    Accion a = accionDeTecla(t);
+    K.rotacion = a == ROTAR_DERECHA || a == ROTAR_IZQUIERDA ? a : NADA;
+    K.direccion = direccionTeclas();
+    K.bajando = tecla_pulsada(ABAJO);
+    for (int i = 0; i < 3; ++i) {
+        int n = tecla_pulsaciones(TECLAS_MANDO[i]);
+        K.pulsaciones[i] = n - J.pulsaciones[i];
+        J.pulsaciones[i] = n;
     }
-    //Música para Juego
-    PlaySound(TEXT("../music/tetris.wav"), NULL, SND_FILENAME | SND_ASYNC | SND_LOOP);
+    return accionMando(J.M, K, gravedad);
+}
 
-    //Redimensiona la ventana de juego
-    vredimensiona(MARGEN * 20 + ANCHO, MARGEN * 2 + ALTO);
+/** @struct OpcionesPartida
+ *  @brief Opciones de la línea de órdenes que afectan a cada partida.
+ */
+struct OpcionesPartida {
+    Bot *bot; ///< Jugador automático, o nullptr si juega una persona
+    ModoAzar modo; ///< Forma de repartir las piezas
+    int vista; ///< Piezas siguientes visibles
+    string grabar; ///< Fichero donde grabar la repetición (vacío: no se graba)
+    bool reloj; ///< Muestra los ticks por segundo y el jitter del bucle
+    int das; ///< Ticks hasta que se repite una dirección mantenida
+    int arr; ///< Ticks entre repeticiones
+};
 
-    //Variables necesarias para el juego
-    Tablero T;
-    vaciarTablero(T);
+/**
+ * @brief Pinta el ritmo medido del bucle bajo la información de la partida.
+ * @param R Reloj del bucle
+ */
+void pintarReloj(const RelojFijo &R) {
+    EstadisticasReloj S = estadisticasReloj(R);
+    char linea1[64], linea2[64];
+    snprintf(linea1, sizeof(linea1), "Ticks: %.1f/s", S.hz);
+    snprintf(linea2, sizeof(linea2), "Jitter: %.1f ms (max %.1f)", S.jitterMedioMs, S.jitterMaxMs);
+    color(BLANCO);
+    texto(MARGEN * 2 + ANCHO, ALTO - MARGEN * 4, linea1);
+    texto(MARGEN * 2 + ANCHO, ALTO - MARGEN * 2, linea2);
+    refresca();
+}
 
-    Pieza P;
-    pieza_nueva(P);
-    P.abs.x = 4;
-    P.abs.y = 1;
+/**
+ * @brief Duerme hasta el siguiente tick, pero vuelve en cuanto llega una tecla.
+ * @post Sin tecla, termina con esperaTick para que el tick llegue a su instante
+ *       y cuente en el jitter
+ * @param R Reloj del bucle
+ * @return int -> Tecla pulsada, o NINGUNA si se ha llegado al tick
+ */
+int esperaTeclaOTick(RelojFijo &R) {
+    int t = tecla();
+    while (t == NINGUNA) {
+        int ms = msHastaTick(R);
+        if (ms == 0 || !espera_evento(ms)) {
+            esperaTick(R);
+            break;
+        }
+        t = tecla(); // Puede ser NINGUNA si el evento era del ratón
+    }
+    return t;
+}
+
+/**
+ * @brief Muestra el final de la partida con su sonido.
+ * @param E Estado de la partida terminada
+ */
+void mostrarFin(const EstadoJuego &E) {
+    if (E.fin == VICTORIA) {
+        sonido("../music/you_win.wav", false);
+        finPartida("YOU WIN!");
+    } else {
+        sonido("../music/game_over.wav", false);
+        finPartida("GAME OVER");
+    }
+}
+
+/**
+ * @brief Juega una partida completa.
+ * @post Avanza el motor un frame cada TICK_JUEGO_MS con paso fijo (RelojFijo): la
+ *       tecla pulsada y la repetición de las mantenidas (Mando, con DAS y ARR en
+ *       ticks) o la acción del bot se aplican en el primer frame que toca,
+ *       los frames atrasados se simulan seguidos y se repinta una vez si hay
+ *       cambios. Entre vueltas duerme hasta el siguiente tick o hasta que llega
+ *       una tecla, que se aplica enseguida adelantando un tick. Al terminar muestra
+ *       el mensaje final y espera a ESCAPE o ESPACIO; el bot solo espera 2 segundos.
+ * @post Si se pide, graba la repetición al terminar o al pulsar ESCAPE
+ * @param O Opciones de la partida
+ * @return bool -> true: la partida ha terminado y se vuelve al título
+ *              -> false: el jugador ha pulsado ESCAPE durante la partida
+ */
+bool jugarPartida(const OpcionesPartida &O) {
+    //Redimensiona la ventana de juego
+    vredimensiona(MARGEN * 20 + ANCHO, MARGEN * 2 + ALTO);
 
-    Pieza N;
-    pieza_nueva(N);
+    Bot *bot = O.bot;
+    uint64_t semilla = uint64_t(time(nullptr));
+    EstadoJuego E;
+    iniciarJuego(E, semilla, O.modo, O.vista);
+    if (bot) iniciarBot(*bot, bot->W, bot->libro);
+    TecladoJugador J;
+    iniciarTeclado(J, O.das, O.arr);
 
-    int ptos = 0;
-    int level = 1;
-    int frame = 0;
+    Grabacion G;
+    iniciarGrabacion(G, semilla, O.modo);
 
     // Dibuja la interfaz gráfica inicial del juego
-    pintarInterfaz(T, P, N, ptos, level);
+    pintarInterfaz(E);
+
+    RelojFijo reloj;
+    iniciarRelojFijo(reloj);
 
     // Obtiene la tecla presionada por el jugador
     int t = tecla();
 
-    //Bucle Principal de Juego
+    //Bucle Principal de Juego: simula los frames que tocan según el reloj
     while (t != ESCAPE) {
-        Pieza copia = P;
-
-        // Si el jugador alcanza el nivel máximo, gana el juego
-        if (level == sizeof(VELOCIDAD_NIVEL) / sizeof(VELOCIDAD_NIVEL[0])) {
-            PlaySound(TEXT("../music/you_win.wav"), NULL, SND_FILENAME | SND_ASYNC);
-            finPartida("YOU WIN!");
-            while (t != ESCAPE && t != ESPACIO) t = tecla();
-            goto JugarOtraVez; // Sale del bucle de juego y pregunta si se desea jugar otra vez
+        int cambios = 0;
+        // Una tecla que llega entre dos ticks se aplica ya, adelantando el siguiente
+        int n = ticksPendientes(reloj);
+        if (n == 0 && t != NINGUNA && adelantaTick(reloj)) n = 1;
+        for (; n > 0 && !(cambios & CAMBIO_FIN); --n) {
+            Accion a = bot ? accionBot(*bot, E) : accionJugador(J, t, tocaGravedad(E));
+            t = NINGUNA; // Cada pulsación mueve la pieza una vez
+            grabaFrame(G, E, a);
+            cambios |= paso(E, a);
         }
 
-        // Si ha pasado el tiempo necesario, la pieza cae automáticamente
-        if (t == NINGUNA && frame > VELOCIDAD_NIVEL[level - 1]) {
-            frame = 0;
-            t = ABAJO;
+        if (cambios & CAMBIO_FIN) {
+            if (!O.grabar.empty()) guardaGrabacion(G, E, O.grabar.c_str());
+            mostrarFin(E);
+            if (bot) {
+                espera(2000);
+                return tecla() != ESCAPE;
+            }
+            while (t != ESCAPE && t != ESPACIO) {
+                espera_evento(-1);
+                t = tecla();
+            }
+            return true;
         }
 
-        // Actualiza la posición de la pieza según la tecla presionada por el jugador
-        if (t == ARRIBA || t == int('Z')) {
-            rota_derecha(P);
-        } else if (t == int('X')) {
-            rota_izquierda(P);
-        } else if (t == ABAJO) {
-            P.abs.y++;
-        } else if (t == IZQUIERDA) {
-            P.abs.x--;
-        } else if (t == DERECHA) {
-            P.abs.x++;
+        // Si ha cambiado algo, se actualiza la interfaz gráfica del juego
+        if (cambios & CAMBIO_PIEZA) {
+            pintarInterfaz(E);
+            if (O.reloj) pintarReloj(reloj);
         }
 
-        // Si la pieza colisiona con el tablero, se restaura su posición original
-        if (colisionPieza(T, P)) {
-            P = copia;
-
-            // Si la colisión es hacia abajo, la pieza se inserta en el tablero
-            if (t == ABAJO) {
-                insertaPieza(T, P);
-
-                // Se cuentan y eliminan las filas llenas, y se actualizan los puntos y nivel
-                int cont = cuentaFila(T);
-                switch (cont) {
-                    case 1:
-                        ptos += 100;
-                        break;
-                    case 2:
-                        ptos += 300;
-                        break;
-                    case 3:
-                        ptos += 500;
-                        break;
-                    case 4:
-                        ptos += 800;
-                        break;
-                }
-                if (PUNTOS_NIVEL[level] <= ptos) {
-                    level++;
-                }
-
-                // Se obtiene una nueva pieza para continuar el juego
-                P = N;
-                pieza_nueva(N);
-                P.abs.x = 4;
-                P.abs.y = 1;
-
-                // Si la nueva pieza colisiona con el tablero, el jugador pierde
-                if (colisionPieza(T, P)) {
-                    PlaySound(TEXT("../music/game_over.wav"), NULL, SND_FILENAME | SND_ASYNC);
-                    finPartida("GAME OVER");
-                    while (t != ESCAPE && t != ESPACIO) t = tecla();
-                    goto JugarOtraVez; // Sale del bucle de juego y pregunta si se desea jugar otra vez
-                }
+        // Duerme hasta el siguiente frame o hasta que el jugador pulse una tecla
+        if (t == NINGUNA) t = esperaTeclaOTick(reloj);
+        else esperaTick(reloj); // Ya hay una tecla para el siguiente frame
+    }
+    if (!O.grabar.empty()) guardaGrabacion(G, E, O.grabar.c_str());
+    return false;
+}
+
+/**
+ * @brief Reproduce en pantalla una repetición grabada.
+ * @post Cada tick de TICK_JUEGO_MS avanza velocidad frames (puede ser fraccionaria);
+ *       ESCAPE termina la reproducción
+ * @param fichero Ruta de la repetición
+ * @param velocidad Multiplicador de velocidad respecto a la partida original
+ */
+void verRepeticion(const string &fichero, double velocidad) {
+    vector<unsigned char> datos;
+    Repeticion R;
+    if (!cargaFichero(fichero.c_str(), datos) || !leeRepeticion(R, datos.data(), datos.size())) {
+        mensaje("No se puede reproducir " + fichero);
+        return;
+    }
+    vredimensiona(MARGEN * 20 + ANCHO, MARGEN * 2 + ALTO);
+
+    Reproductor P;
+    iniciarReproductor(P, R);
+    pintarInterfaz(P.E);
+
+    RelojFijo reloj;
+    iniciarRelojFijo(reloj);
+    double pendiente = 0;
+    int t = tecla();
+    while (P.frame < R.final.frames && t != ESCAPE) {
+        int cambios = 0;
+        for (int n = ticksPendientes(reloj); n > 0; --n) {
+            for (pendiente += velocidad; pendiente >= 1 && P.frame < R.final.frames; pendiente -= 1) {
+                cambios |= avanzaFrame(P);
             }
         }
+        if (cambios & CAMBIO_PIEZA) pintarInterfaz(P.E);
+        t = esperaTeclaOTick(reloj);
+    }
+    if (P.E.fin != EN_JUEGO) {
+        mostrarFin(P.E);
+        espera(2000);
+    }
+}
 
-        // Si se presiona alguna tecla, se actualiza la interfaz gráfica del juego
-        if (t != NINGUNA) {
-            pintarInterfaz(T, P, N, ptos, level);
+/**
+ * @brief Comprueba si se ha pasado una opción en la línea de comandos.
+ * @param opcion Opción a buscar, por ejemplo "--bot"
+ * @return bool -> true: la opción está presente
+ */
+bool hayOpcion(const string &opcion) {
+    for (const string &a : argumentos()) {
+        if (a == opcion) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Valor de una opción de la línea de órdenes.
+ * @param opcion Opción a buscar, por ejemplo "--grabar"
+ * @param defecto Valor si la opción no aparece o no lleva valor
+ * @return string -> Valor que sigue a la opción
+ */
+string valorOpcion(const string &opcion, const string &defecto) {
+    const vector<string> &args = argumentos();
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        if (args[i] == opcion) return args[i + 1];
+    }
+    return defecto;
+}
+
+/**
+ * @brief Pinta el tablero propio de un duelo con los datos del rival.
+ * @param D Estado del duelo
+ * @param local Jugador de esta máquina
+ */
+void pintarDuelo(const EstadoDuelo &D, int local) {
+    pintarInterfaz(D.J[local]);
+    color(BLANCO);
+    texto(MARGEN * 2 + ANCHO, MARGEN * 25, "Rival: " + to_string(D.J[1 - local].ptos));
+    if (D.basura[local] > 0) {
+        color(ROJO);
+        texto(MARGEN * 2 + ANCHO, MARGEN * 28, "Basura: " + to_string(D.basura[local]));
+    }
+    refresca();
+}
+
+/**
+ * @brief Juega un duelo en red contra otra instancia del juego.
+ * @post En cada tick de TICK_JUEGO_MS recibe las acciones del rival, corrige con
+ *       rollback si no eran las predichas, avanza un frame con la tecla pulsada
+ *       (aplicada dos frames después) y envía las acciones propias. Las dos
+ *       instancias deben usar la misma semilla.
+ * @param O Opciones de la partida (bot, DAS y ARR)
+ * @param jugador Jugador de esta instancia (0 o 1)
+ */
+void jugarVersus(const OpcionesPartida &O, int jugador) {
+    vredimensiona(MARGEN * 20 + ANCHO, MARGEN * 2 + ALTO);
+    Bot *bot = O.bot;
+
+    string ip = valorOpcion("--ip", "127.0.0.1");
+    int puertoLocal = atoi(valorOpcion("--puerto-local", jugador == 0 ? "47000" : "47001").c_str());
+    int puertoRemoto = atoi(valorOpcion("--puerto-remoto", jugador == 0 ? "47001" : "47000").c_str());
+    CanalUdp C;
+    if (!abreCanal(C, uint16_t(puertoLocal), ip.c_str(), uint16_t(puertoRemoto))) {
+        mensaje("No se puede abrir el puerto " + to_string(puertoLocal));
+        return;
+    }
+    simulaRed(C, atoi(valorOpcion("--latencia", "0").c_str()), 0, atof(valorOpcion("--perdida", "0").c_str()),
+              uint64_t(time(nullptr)));
+
+    // La historia de rollback ocupa decenas de KB: mejor en el montón que en la pila
+    unique_ptr<Rollback> R(new Rollback);
+    iniciarRollback(*R, strtoull(valorOpcion("--semilla", "1").c_str(), nullptr, 10), jugador, 2, 8);
+    if (bot) iniciarBot(*bot, bot->W, bot->libro);
+    TecladoJugador J;
+    iniciarTeclado(J, O.das, O.arr);
+    unsigned char paquete[TAM_PAQUETE];
+
+    pintarDuelo(R->D, jugador);
+    RelojFijo reloj;
+    iniciarRelojFijo(reloj);
+    int t = tecla();
+    while (t != ESCAPE && !rollbackTerminado(*R)) {
+        for (int k = ticksPendientes(reloj); k > 0 && !rollbackTerminado(*R); --k) {
+            int n;
+            while ((n = recibeCanal(C, paquete, sizeof(paquete))) >= 0) recibePaquete(*R, paquete, n);
+            corrigeRollback(*R);
+            Accion a = bot ? (puedeAvanzar(*R) ? accionBot(*bot, R->D.J[jugador]) : NADA)
+                           : accionJugador(J, t, tocaGravedad(R->D.J[jugador]));
+            t = NINGUNA;
+            avanzaRollback(*R, a);
+            enviaCanal(C, paquete, creaPaquete(*R, paquete));
+            bombeaCanal(C);
         }
 
-        espera(30); // Espera 30 milisegundos entre cada iteración del bucle
-        frame++; // Incrementa el contador de frames
-        t = tecla(); // Obtiene la tecla presionada por el jugador
+        // Un rollback puede cambiar el tablero en cualquier frame: se repinta siempre
+        pintarDuelo(R->D, jugador);
+        if (t == NINGUNA) t = esperaTeclaOTick(reloj);
+        else esperaTick(reloj); // Ya hay una tecla para el siguiente frame
+    }
+    // Sigue enviando un segundo para que el rival también pueda confirmar el final
+    for (int i = 0; i < 33; ++i) {
+        int n;
+        while ((n = recibeCanal(C, paquete, sizeof(paquete))) >= 0) recibePaquete(*R, paquete, n);
+        enviaCanal(C, paquete, creaPaquete(*R, paquete));
+        bombeaCanal(C);
+        espera(30);
+    }
+    cierraCanal(C);
+    if (t == ESCAPE) return;
+
+    if (R->desincronizado) mensaje("Las dos partidas se han desincronizado en el frame " +
+                                   to_string(R->frameDesincronizado));
+    if (R->D.ganador == jugador) {
+        sonido("../music/you_win.wav", false);
+        finPartida("YOU WIN!");
+    } else {
+        sonido("../music/game_over.wav", false);
+        finPartida(R->D.ganador == EMPATE ? "EMPATE" : "YOU LOSE");
+    }
+    espera(2000);
+}
+
+/**
+ * @brief Funcion principal y control del juego Tetris
+ * @post El juego se repite hasta que el usuario haga clic en el botón "No"
+ *       o pulse ESCAPE durante una partida
+ * @post Con la opción --bot juega el bot, sin pantalla de título, partida tras partida
+ * @post Con --libro FICHERO el bot consulta ese libro de aperturas antes de buscar
+ * @post Con --bolsa las piezas salen en bolsas de 7 y con --vista N se ven N piezas siguientes
+ * @post Con --grabar FICHERO se guarda la repetición de la última partida
+ * @post Con --reloj se muestran los ticks por segundo y el jitter del bucle de juego
+ * @post Con --das N y --arr N se ajusta la repetición de las flechas mantenidas, en ticks
+ * @post Con --reproducir FICHERO [--velocidad X] solo se reproduce una repetición
+ * @post Con --versus J se juega un duelo en red como jugador J (0 o 1) contra otra
+ *       instancia; ver jugarVersus para --ip, --puerto-local, --puerto-remoto,
+ *       --semilla, --latencia y --perdida
+ */
+int main() {
+#if defined(_WIN32)
+    timeBeginPeriod(1); // Sin esto el sistema despierta al bucle en pasos de 15,6 ms
+#endif
+    string versus = valorOpcion("--versus", "");
+    string repeticion = valorOpcion("--reproducir", "");
+    if (!repeticion.empty()) {
+        verRepeticion(repeticion, atof(valorOpcion("--velocidad", "1").c_str()));
+        vcierra();
+        exit(0);
+    }
+
+    LibroAperturas libro = {};
+    string fichLibro = valorOpcion("--libro", "");
+    if (!fichLibro.empty() && !abreLibro(libro, fichLibro.c_str())) cerr << "No se pudo abrir " << fichLibro << endl;
+    Bot jugador;
+    iniciarBot(jugador, PESOS_DEFECTO, libro.mapa != nullptr ? &libro : nullptr);
+    OpcionesPartida O;
+    O.bot = hayOpcion("--bot") ? &jugador : nullptr;
+    O.modo = hayOpcion("--bolsa") ? AZAR_BOLSA : AZAR_PURO;
+    O.vista = atoi(valorOpcion("--vista", "1").c_str());
+    O.grabar = valorOpcion("--grabar", "");
+    O.reloj = hayOpcion("--reloj");
+    O.das = atoi(valorOpcion("--das", to_string(DAS_TICKS)).c_str());
+    O.arr = atoi(valorOpcion("--arr", to_string(ARR_TICKS)).c_str());
+    Bot *bot = O.bot;
+
+    if (!versus.empty()) {
+        sonido("../music/tetris.wav", true);
+        jugarVersus(O, atoi(versus.c_str()) == 1 ? 1 : 0);
+        vcierra();
+        exit(0);
     }
 
+    //Bucle Principal de Aplicacion
+    do {
+        //Música para Ventana de Inicio
+        if (!bot) {
+            sonido("../music/title.wav", true);
+            jugarOtraVez();
+        }
+
+        //Música para Juego
+        sonido("../music/tetris.wav", true);
+    } while (jugarPartida(O));
+
     vcierra(); // Cierra la ventana de juego y termina el programa
 
     exit(0);
@@ -0,0 +1,1003 @@
+/**
+ * @file torneo.cpp
+ * @brief Servidor de torneos entre bots con epoll y generador de carga
+ *
+ * Uso: torneo servir [--puerto P] [--unix RUTA] [--hilos N] [--tiempo MS] [--piezas N]
+ *                    [--semilla S] [--partidas K] [--duracion S]
+ *      torneo bots [--ip IP] [--puerto P | --unix RUTA] [--conexiones C] [--partidas K]
+ *                  [--hilos N] [--olvida N]
+ *
+ * `servir` acepta bots por TCP (puerto 47400 por defecto) y, con --unix, también
+ * por un socket Unix. Empareja las conexiones por orden de llegada: cada pareja
+ * juega un duelo en el que los dos bots reciben la misma secuencia de piezas
+ * (semilla S + número de duelo). Un hilo acepta conexiones y las reparte por
+ * parejas entre N hilos trabajadores, cada uno con su bucle epoll; miles de
+ * partidas comparten así unos pocos hilos.
+ *
+ * Protocolo de líneas de texto:
+ * - Servidor: `P <jugada> <tablero> <pieza> <siguiente>`. El tablero son 20 filas
+ *   de arriba abajo, 3 cifras hexadecimales por fila (bit c = columna c); la pieza
+ *   actual aparece en INICIO sin girar.
+ * - Bot: `C <jugada> <x> <y> <rot>`: posición de bloqueo de la pieza (abs y giros),
+ *   que debe ser alcanzable desde INICIO (se comprueba con generaMovimientos).
+ * - Servidor, al acabar el duelo: `F <gana|pierde|empate> <puntos> <puntos rival> <final>`
+ *   y cierra la conexión.
+ *
+ * Cada jugada tiene --tiempo milisegundos (100 por defecto) desde que se envía:
+ * quien no responde a tiempo, coloca una pieza ilegal o se desconecta pierde.
+ * La partida de cada bot termina al perder, al alcanzar el último nivel o tras
+ * --piezas piezas, y el duelo lo gana quien no ha perdido, después quien ha
+ * alcanzado el último nivel y después quien tiene más puntos.
+ *
+ * Cada segundo se muestra:
+ *
+ *     segundos conexiones duelos/s jugadas/s p50_us p99_us tiempo ilegales
+ *
+ * con la latencia de ida y vuelta de cada jugada medida en el servidor (desde
+ * que envía el tablero hasta que recibe la colocación).
+ *
+ * `bots` abre C conexiones (1000 por defecto) repartidas entre N hilos con epoll
+ * y las juega con mejorColocacion hasta completar K duelos entre todas; al acabar
+ * cada duelo vuelve a conectar. --olvida N deja sin responder una de cada N jugadas
+ * para probar los límites de tiempo.
+ */
+
+#include "bot.h"
+#include "movimientos.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+typedef chrono::steady_clock Reloj;
+
+/// Longitud máxima de una línea del protocolo
+const size_t MAX_LINEA = 128;
+/// Eventos de epoll leídos de una vez
+const int MAX_EVENTOS = 256;
+/// Cubetas del histograma de latencias: 16 exactas y 16 por cada potencia de 2 hasta 2^31
+const int CUBETAS = 16 + 28 * 16;
+
+static atomic<bool> parar(false);
+
+/**
+ * @brief Manejador de SIGINT y SIGTERM: pide terminar.
+ * @param s Señal
+ */
+static void alParar(int) {
+    parar = true;
+}
+
+/**
+ * @brief Cubeta de una latencia en el histograma.
+ * @post Error relativo menor del 7 %: 16 cubetas por cada potencia de 2
+ * @param us Microsegundos
+ * @return int -> Índice de la cubeta
+ */
+static int cubeta(uint32_t us) {
+    if (us < 16) return int(us);
+    int e = 31 - __builtin_clz(us);
+    return 16 + (e - 4) * 16 + int((us >> (e - 4)) & 15);
+}
+
+/**
+ * @brief Mayor latencia que cae en una cubeta.
+ * @param i Índice de la cubeta
+ * @return uint64_t -> Microsegundos
+ */
+static uint64_t valorCubeta(int i) {
+    if (i < 16) return uint64_t(i);
+    int e = (i - 16) / 16 + 4;
+    uint64_t sub = uint64_t((i - 16) % 16);
+    return ((16 + sub) << (e - 4)) + (uint64_t(1) << (e - 4)) - 1;
+}
+
+/**
+ * @brief Percentil de un histograma.
+ * @param h Recuentos por cubeta
+ * @param p Fracción (por ejemplo 0.99)
+ * @return uint64_t -> Microsegundos; 0 si el histograma está vacío
+ */
+static uint64_t percentil(const vector<uint64_t> &h, double p) {
+    uint64_t total = 0;
+    for (uint64_t n : h) total += n;
+    if (total == 0) return 0;
+    uint64_t objetivo = uint64_t(p * double(total) + 0.5), acumulado = 0;
+    if (objetivo == 0) objetivo = 1;
+    for (int i = 0; i < CUBETAS; ++i) {
+        acumulado += h[i];
+        if (acumulado >= objetivo) return valorCubeta(i);
+    }
+    return valorCubeta(CUBETAS - 1);
+}
+
+/**
+ * @brief Pone un descriptor en modo no bloqueante.
+ * @param fd Descriptor
+ * @return bool -> true: se ha cambiado
+ */
+static bool noBloqueante(int fd) {
+    int f = fcntl(fd, F_GETFL);
+    return f >= 0 && fcntl(fd, F_SETFL, f | O_NONBLOCK) == 0;
+}
+
+/**
+ * @brief Escribe todo lo posible de un búfer de salida sin bloquear.
+ * @param fd Descriptor
+ * @param salida Búfer (se quita lo escrito)
+ * @return bool -> false: la conexión ha fallado
+ */
+static bool vaciaSalida(int fd, string &salida) {
+    size_t hecho = 0;
+    while (hecho < salida.size()) {
+        ssize_t n = send(fd, salida.data() + hecho, salida.size() - hecho, MSG_NOSIGNAL);
+        if (n > 0) hecho += size_t(n);
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        else if (n < 0 && errno == EINTR) continue;
+        else return false;
+    }
+    salida.erase(0, hecho);
+    return true;
+}
+
+/**
+ * @brief Lee todo lo disponible de un descriptor sin bloquear.
+ * @param fd Descriptor
+ * @param entrada Búfer al que se añade lo leído
+ * @return bool -> false: el otro extremo ha cerrado o la conexión ha fallado
+ */
+static bool leeEntrada(int fd, string &entrada) {
+    char buf[4096];
+    for (;;) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) entrada.append(buf, size_t(n));
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        else if (n < 0 && errno == EINTR) continue;
+        else return false;
+    }
+}
+
+/**
+ * @brief Cambia los eventos vigilados de un descriptor.
+ * @param ep epoll
+ * @param fd Descriptor
+ * @param escribir true: vigilar también EPOLLOUT
+ */
+static void vigila(int ep, int fd, bool escribir) {
+    epoll_event ev = {};
+    ev.events = EPOLLIN | (escribir ? uint32_t(EPOLLOUT) : 0u);
+    ev.data.fd = fd;
+    epoll_ctl(ep, EPOLL_CTL_MOD, fd, &ev);
+}
+
+/**
+ * @brief Escribe el tablero en el formato del protocolo.
+ * @param T Ocupación del tablero
+ * @param texto Destino (3 * FILAS caracteres, sin terminador)
+ */
+static void escribeTablero(const Ocupacion &T, char *texto) {
+    static const char HEX[] = "0123456789abcdef";
+    for (int f = 0; f < FILAS; ++f) {
+        texto[3 * f] = HEX[(T.fila[f] >> 8) & 15];
+        texto[3 * f + 1] = HEX[(T.fila[f] >> 4) & 15];
+        texto[3 * f + 2] = HEX[T.fila[f] & 15];
+    }
+}
+
+/**
+ * @brief Lee un tablero en el formato del protocolo.
+ * @param texto Origen (3 * FILAS cifras hexadecimales)
+ * @param T Ocupación del tablero
+ * @return bool -> false: el texto no es un tablero válido
+ */
+static bool leeTablero(const char *texto, Ocupacion &T) {
+    for (int f = 0; f < FILAS; ++f) {
+        unsigned v = 0;
+        for (int i = 0; i < 3; ++i) {
+            char c = texto[3 * f + i];
+            int d = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+            if (d < 0) return false;
+            v = v << 4 | unsigned(d);
+        }
+        if (v > FILA_LLENA) return false;
+        T.fila[f] = Fila(v);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Servidor
+// ---------------------------------------------------------------------------
+
+/** @struct OpcionesServidor
+ *  @brief Opciones del servidor de torneos.
+ */
+struct OpcionesServidor {
+    int puerto = 47400; ///< Puerto TCP (0: sin TCP)
+    string rutaUnix; ///< Ruta del socket Unix (vacía: sin socket Unix)
+    int hilos = 2; ///< Hilos trabajadores
+    int tiempo = 100; ///< Milisegundos por jugada
+    int piezas = 1000; ///< Piezas máximas por partida
+    uint64_t semilla = 1; ///< Semilla del primer duelo
+    long partidas = 0; ///< Duelos tras los que se para (0: sin límite)
+    int duracion = 0; ///< Segundos tras los que se para (0: sin límite)
+};
+
+/** @enum FinBot
+ *  @brief Cómo ha terminado la partida de un bot.
+ */
+enum FinBot {
+    SIGUE, ///< La partida no ha terminado
+    TERMINADA, ///< GAME_OVER, VICTORIA o límite de piezas
+    FUERA_DE_TIEMPO, ///< No ha respondido a tiempo
+    ILEGAL, ///< Ha enviado una colocación no alcanzable o una línea mal formada
+    ABANDONO ///< Se ha desconectado
+};
+
+const char *const NOMBRES_FIN_BOT[] = {"sigue", "normal", "tiempo", "ilegal", "abandono"};
+
+struct Duelo;
+
+/** @struct Conexion
+ *  @brief Un bot conectado y su partida.
+ */
+struct Conexion {
+    int fd; ///< Socket
+    uint64_t serie; ///< Número de conexión, distinto para cada una
+    string entrada; ///< Datos recibidos aún sin procesar
+    string salida; ///< Datos pendientes de enviar
+    EstadoJuego E; ///< Partida
+    Duelo *duelo; ///< Duelo en el que juega (nullptr si espera pareja)
+    uint32_t jugada; ///< Número de la última jugada enviada
+    bool esperando; ///< La jugada enviada no tiene respuesta aún
+    Reloj::time_point enviada; ///< Momento en que se envió la jugada
+    FinBot fin; ///< Cómo ha terminado su partida
+    bool cerrar; ///< Cerrar en cuanto se vacíe la salida
+};
+
+/** @struct Duelo
+ *  @brief Dos bots con la misma secuencia de piezas.
+ */
+struct Duelo {
+    Conexion *lado[2]; ///< Bots (nullptr si ya se han desconectado)
+    EstadoJuego final[2]; ///< Partida de cada bot al terminar
+    FinBot fin[2]; ///< Cómo ha terminado cada bot
+    int terminados; ///< Bots que han terminado
+};
+
+/** @struct Plazo
+ *  @brief Fin del tiempo de una jugada.
+ */
+struct Plazo {
+    Reloj::time_point limite; ///< Momento en que se acaba el tiempo
+    int fd; ///< Socket de la conexión
+    uint64_t serie; ///< Conexión (por si el descriptor se ha reutilizado)
+    uint32_t jugada; ///< Jugada a la que corresponde
+};
+
+/** @struct Estadisticas
+ *  @brief Contadores de un hilo trabajador; solo los escribe ese hilo.
+ */
+struct Estadisticas {
+    atomic<uint64_t> jugadas{0}; ///< Jugadas respondidas
+    atomic<uint64_t> duelos{0}; ///< Duelos terminados
+    atomic<uint64_t> fueraDeTiempo{0}; ///< Partidas perdidas por tiempo
+    atomic<uint64_t> ilegales{0}; ///< Partidas perdidas por jugada ilegal
+    atomic<int64_t> conexiones{0}; ///< Conexiones abiertas
+    atomic<uint64_t> latencia[CUBETAS]; ///< Histograma de la ida y vuelta de las jugadas
+};
+
+/** @struct Trabajador
+ *  @brief Hilo con su propio bucle epoll y las conexiones que se le asignan.
+ */
+struct Trabajador {
+    int ep; ///< epoll del hilo
+    int aviso; ///< eventfd para avisar de conexiones nuevas
+    mutex m; ///< Protege nuevas
+    vector<int> nuevas; ///< Conexiones aceptadas pendientes de recoger
+    unordered_map<int, unique_ptr<Conexion>> conexiones; ///< Conexiones del hilo por descriptor
+    deque<Plazo> plazos; ///< Plazos de las jugadas, en orden de vencimiento
+    Conexion *sinPareja = nullptr; ///< Conexión a la espera de rival
+    vector<pair<int, uint64_t>> porEscribir; ///< Conexiones (descriptor y serie) con salida nueva que atender
+    GeneradorMovimientos G; ///< Memoria para comprobar colocaciones
+    Estadisticas est; ///< Contadores del hilo
+};
+
+static atomic<uint64_t> duelosCreados(0);
+static atomic<uint64_t> seriesCreadas(0);
+
+/**
+ * @brief Envía la siguiente jugada a un bot.
+ * @param W Trabajador
+ * @param O Opciones
+ * @param c Conexión
+ */
+static void enviaJugada(Trabajador &W, const OpcionesServidor &O, Conexion &c) {
+    char linea[MAX_LINEA];
+    char tablero[3 * FILAS + 1];
+    escribeTablero(c.E.T, tablero);
+    tablero[3 * FILAS] = 0;
+    c.jugada++;
+    int n = snprintf(linea, sizeof(linea), "P %u %s %d %d\n", c.jugada, tablero, c.E.P.tipo, verPieza(c.E.azar, 0));
+    c.salida.append(linea, size_t(n));
+    c.esperando = true;
+    c.enviada = Reloj::now();
+    W.plazos.push_back({c.enviada + chrono::milliseconds(O.tiempo), c.fd, c.serie, c.jugada});
+}
+
+/**
+ * @brief Compara el resultado de los dos bots de un duelo.
+ * @param D Duelo terminado
+ * @return int -> 0 o 1 si gana ese lado; -1 si hay empate
+ */
+static int ganadorDuelo(const Duelo &D) {
+    long puntos[2];
+    for (int j = 0; j < 2; ++j) {
+        // Perder por tiempo, ilegal o abandono va por delante de todo; luego la victoria; luego los puntos
+        puntos[j] = (D.fin[j] == TERMINADA ? 1L << 40 : 0) + (D.final[j].fin == VICTORIA ? 1L << 32 : 0) +
+                    D.final[j].ptos;
+    }
+    return puntos[0] == puntos[1] ? -1 : puntos[0] > puntos[1] ? 0 : 1;
+}
+
+/**
+ * @brief Termina la partida de un bot y, si el rival ya ha terminado, el duelo.
+ * @post Al terminar el duelo deja el resultado en la salida de los bots que siguen
+ *       conectados, los marca para cerrar y los apunta en W.porEscribir
+ * @param W Trabajador
+ * @param c Conexión
+ * @param fin Cómo ha terminado
+ */
+static void terminaPartida(Trabajador &W, Conexion &c, FinBot fin) {
+    if (c.fin != SIGUE) return;
+    c.fin = fin;
+    c.esperando = false;
+    if (fin == FUERA_DE_TIEMPO) W.est.fueraDeTiempo.fetch_add(1, memory_order_relaxed);
+    if (fin == ILEGAL) W.est.ilegales.fetch_add(1, memory_order_relaxed);
+    Duelo *D = c.duelo;
+    if (!D) {
+        c.cerrar = true;
+        return;
+    }
+    int lado = D->lado[0] == &c ? 0 : 1;
+    D->final[lado] = c.E;
+    D->fin[lado] = fin;
+    if (++D->terminados < 2) return;
+
+    int g = ganadorDuelo(*D);
+    for (int j = 0; j < 2; ++j) {
+        Conexion *x = D->lado[j];
+        if (!x) continue;
+        char linea[MAX_LINEA];
+        const char *resultado = g < 0 ? "empate" : g == j ? "gana" : "pierde";
+        int n = snprintf(linea, sizeof(linea), "F %s %d %d %s\n", resultado, D->final[j].ptos, D->final[1 - j].ptos,
+                         NOMBRES_FIN_BOT[D->fin[j]]);
+        x->salida.append(linea, size_t(n));
+        x->cerrar = true;
+        x->duelo = nullptr;
+        W.porEscribir.push_back({x->fd, x->serie});
+    }
+    delete D;
+    W.est.duelos.fetch_add(1, memory_order_relaxed);
+}
+
+/**
+ * @brief Busca la posición de bloqueo que ocupa las mismas celdas que una pieza.
+ * @param G Generador con los destinos de la pieza actual
+ * @param P Colocación pedida
+ * @return int -> Índice del destino; -1 si no es alcanzable
+ */
+static int buscaDestino(const GeneradorMovimientos &G, const Pieza &P) {
+    for (int d = 0; d < G.destinos; ++d) {
+        const Pieza &Q = G.destino[d].P;
+        int iguales = 0;
+        for (int i = 0; i < 4; ++i) {
+            Coord a = P.posicionBloque(i);
+            for (int k = 0; k < 4; ++k) {
+                Coord b = Q.posicionBloque(k);
+                if (a.x == b.x && a.y == b.y) {
+                    iguales++;
+                    break;
+                }
+            }
+        }
+        if (iguales == 4) return d;
+    }
+    return -1;
+}
+
+/**
+ * @brief Procesa una línea recibida de un bot.
+ * @param W Trabajador
+ * @param O Opciones
+ * @param c Conexión
+ * @param linea Línea sin el salto
+ */
+static void procesaLinea(Trabajador &W, const OpcionesServidor &O, Conexion &c, const string &linea) {
+    unsigned jugada;
+    int x, y, rot;
+    if (sscanf(linea.c_str(), "C %u %d %d %d", &jugada, &x, &y, &rot) != 4) {
+        terminaPartida(W, c, ILEGAL);
+        return;
+    }
+    // Una respuesta tardía a una jugada que ya ha caducado se ignora
+    if (!c.esperando || jugada != c.jugada) return;
+
+    uint64_t us = uint64_t(chrono::duration_cast<chrono::microseconds>(Reloj::now() - c.enviada).count());
+    W.est.latencia[cubeta(us > 0xFFFFFFFFu ? 0xFFFFFFFFu : uint32_t(us))].fetch_add(1, memory_order_relaxed);
+    W.est.jugadas.fetch_add(1, memory_order_relaxed);
+    c.esperando = false;
+
+    Pieza P = {{x, y}, c.E.P.tipo, rot & 3};
+    generaMovimientos(W.G, c.E.T, c.E.P);
+    int d = rot >= 0 && rot < ROTACIONES ? buscaDestino(W.G, P) : -1;
+    if (d < 0) {
+        terminaPartida(W, c, ILEGAL);
+        return;
+    }
+    colocaPieza(c.E, W.G.destino[d].P);
+    if (c.E.fin != EN_JUEGO || c.E.piezas >= O.piezas) terminaPartida(W, c, TERMINADA);
+    else enviaJugada(W, O, c);
+}
+
+/**
+ * @brief Empareja una conexión nueva o la deja esperando rival.
+ * @param W Trabajador
+ * @param O Opciones
+ * @param c Conexión nueva
+ */
+static void emparejaConexion(Trabajador &W, const OpcionesServidor &O, Conexion &c) {
+    if (!W.sinPareja) {
+        W.sinPareja = &c;
+        return;
+    }
+    Duelo *D = new Duelo();
+    D->lado[0] = W.sinPareja;
+    D->lado[1] = &c;
+    W.sinPareja = nullptr;
+    uint64_t semilla = O.semilla + duelosCreados.fetch_add(1, memory_order_relaxed);
+    for (int j = 0; j < 2; ++j) {
+        Conexion &x = *D->lado[j];
+        x.duelo = D;
+        D->fin[j] = SIGUE;
+        iniciarJuego(x.E, semilla);
+        enviaJugada(W, O, x);
+        if (!vaciaSalida(x.fd, x.salida)) x.cerrar = true;
+        vigila(W.ep, x.fd, !x.salida.empty());
+    }
+}
+
+/**
+ * @brief Cierra una conexión.
+ * @post Si estaba jugando, pierde por abandono
+ * @param W Trabajador
+ * @param c Conexión (se libera)
+ */
+static void cierraConexion(Trabajador &W, Conexion &c) {
+    if (W.sinPareja == &c) W.sinPareja = nullptr;
+    if (c.duelo) {
+        Duelo *D = c.duelo;
+        terminaPartida(W, c, ABANDONO);
+        // El duelo puede seguir con el rival: ya no hay que escribir a esta conexión
+        if (c.duelo == D) D->lado[D->lado[0] == &c ? 0 : 1] = nullptr;
+    }
+    epoll_ctl(W.ep, EPOLL_CTL_DEL, c.fd, nullptr);
+    close(c.fd);
+    W.est.conexiones.fetch_sub(1, memory_order_relaxed);
+    W.conexiones.erase(c.fd);
+}
+
+/**
+ * @brief Vacía la salida de una conexión y la cierra si ya ha terminado.
+ * @param W Trabajador
+ * @param c Conexión
+ * @return bool -> false: la conexión se ha cerrado
+ */
+static bool atiendeSalida(Trabajador &W, Conexion &c) {
+    if (!vaciaSalida(c.fd, c.salida) || (c.cerrar && c.salida.empty())) {
+        cierraConexion(W, c);
+        return false;
+    }
+    vigila(W.ep, c.fd, !c.salida.empty());
+    return true;
+}
+
+/**
+ * @brief Bucle de un hilo trabajador.
+ * @param W Trabajador
+ * @param O Opciones
+ */
+static void trabaja(Trabajador &W, const OpcionesServidor &O) {
+    epoll_event eventos[MAX_EVENTOS];
+    while (!parar) {
+        int espera = 100;
+        if (!W.plazos.empty()) {
+            auto falta = chrono::duration_cast<chrono::milliseconds>(W.plazos.front().limite - Reloj::now()).count();
+            espera = falta < 0 ? 0 : falta < espera ? int(falta) + 1 : espera;
+        }
+        int n = epoll_wait(W.ep, eventos, MAX_EVENTOS, espera);
+        for (int i = 0; i < n; ++i) {
+            int fd = eventos[i].data.fd;
+            if (fd == W.aviso) {
+                uint64_t v;
+                if (read(W.aviso, &v, sizeof(v)) < 0) continue;
+                vector<int> nuevas;
+                {
+                    lock_guard<mutex> l(W.m);
+                    nuevas.swap(W.nuevas);
+                }
+                for (int nfd : nuevas) {
+                    unique_ptr<Conexion> c(new Conexion());
+                    c->fd = nfd;
+                    c->serie = seriesCreadas.fetch_add(1, memory_order_relaxed);
+                    c->fin = SIGUE;
+                    epoll_event ev = {};
+                    ev.events = EPOLLIN;
+                    ev.data.fd = nfd;
+                    epoll_ctl(W.ep, EPOLL_CTL_ADD, nfd, &ev);
+                    W.est.conexiones.fetch_add(1, memory_order_relaxed);
+                    Conexion &ref = *c;
+                    W.conexiones[nfd] = move(c);
+                    emparejaConexion(W, O, ref);
+                }
+                continue;
+            }
+            auto it = W.conexiones.find(fd);
+            if (it == W.conexiones.end()) continue;
+            Conexion &c = *it->second;
+            if (eventos[i].events & EPOLLIN) {
+                if (!leeEntrada(fd, c.entrada)) {
+                    cierraConexion(W, c);
+                    continue;
+                }
+                size_t inicio = 0, fin;
+                while ((fin = c.entrada.find('\n', inicio)) != string::npos) {
+                    procesaLinea(W, O, c, c.entrada.substr(inicio, fin - inicio));
+                    inicio = fin + 1;
+                }
+                c.entrada.erase(0, inicio);
+                if (c.entrada.size() > MAX_LINEA) terminaPartida(W, c, ILEGAL);
+            }
+            atiendeSalida(W, c);
+        }
+
+        // Plazos vencidos: la cola está en orden porque todas las jugadas tienen el mismo tiempo
+        auto ahora = Reloj::now();
+        while (!W.plazos.empty() && W.plazos.front().limite <= ahora) {
+            Plazo p = W.plazos.front();
+            W.plazos.pop_front();
+            auto it = W.conexiones.find(p.fd);
+            if (it == W.conexiones.end()) continue;
+            Conexion &c = *it->second;
+            if (c.serie != p.serie || !c.esperando || c.jugada != p.jugada) continue;
+            terminaPartida(W, c, FUERA_DE_TIEMPO);
+            atiendeSalida(W, c);
+        }
+
+        // Un duelo terminado también deja el resultado en la conexión del rival
+        for (const pair<int, uint64_t> &p : W.porEscribir) {
+            auto it = W.conexiones.find(p.first);
+            if (it != W.conexiones.end() && it->second->serie == p.second) atiendeSalida(W, *it->second);
+        }
+        W.porEscribir.clear();
+    }
+}
+
+/**
+ * @brief Abre un socket de escucha TCP.
+ * @param puerto Puerto
+ * @return int -> Descriptor; -1 si falla
+ */
+static int escuchaTcp(int puerto) {
+    int s = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (s < 0) return -1;
+    int si = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &si, sizeof(si));
+    sockaddr_in dir = {};
+    dir.sin_family = AF_INET;
+    dir.sin_port = htons(uint16_t(puerto));
+    dir.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(s, (sockaddr *) &dir, sizeof(dir)) != 0 || listen(s, 4096) != 0) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+/**
+ * @brief Abre un socket de escucha Unix.
+ * @param ruta Ruta del socket (se reemplaza si existe)
+ * @return int -> Descriptor; -1 si falla
+ */
+static int escuchaUnix(const string &ruta) {
+    sockaddr_un dir = {};
+    if (ruta.size() >= sizeof(dir.sun_path)) return -1;
+    int s = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (s < 0) return -1;
+    dir.sun_family = AF_UNIX;
+    memcpy(dir.sun_path, ruta.c_str(), ruta.size() + 1);
+    unlink(ruta.c_str());
+    if (bind(s, (sockaddr *) &dir, sizeof(dir)) != 0 || listen(s, 4096) != 0) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+/**
+ * @brief Ejecuta el servidor de torneos.
+ * @param O Opciones
+ * @return int -> Código de salida
+ */
+static int servir(const OpcionesServidor &O) {
+    int ep = epoll_create1(0);
+    vector<int> escuchas;
+    if (O.puerto > 0) escuchas.push_back(escuchaTcp(O.puerto));
+    if (!O.rutaUnix.empty()) escuchas.push_back(escuchaUnix(O.rutaUnix));
+    for (int s : escuchas) {
+        if (s < 0) {
+            cerr << "No se puede escuchar en el puerto " << O.puerto << " o en " << O.rutaUnix << endl;
+            return 1;
+        }
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = s;
+        epoll_ctl(ep, EPOLL_CTL_ADD, s, &ev);
+    }
+
+    vector<unique_ptr<Trabajador>> W;
+    vector<thread> hilos;
+    for (int h = 0; h < O.hilos; ++h) {
+        W.emplace_back(new Trabajador());
+        Trabajador &t = *W.back();
+        t.ep = epoll_create1(0);
+        t.aviso = eventfd(0, EFD_NONBLOCK);
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = t.aviso;
+        epoll_ctl(t.ep, EPOLL_CTL_ADD, t.aviso, &ev);
+    }
+    for (int h = 0; h < O.hilos; ++h) hilos.emplace_back(trabaja, ref(*W[h]), cref(O));
+
+    auto inicio = Reloj::now(), informe = inicio;
+    uint64_t aceptadas = 0, jugadasAntes = 0, duelosAntes = 0;
+    vector<uint64_t> latenciasAntes(CUBETAS, 0);
+    epoll_event eventos[16];
+    while (!parar) {
+        int n = epoll_wait(ep, eventos, 16, 100);
+        for (int i = 0; i < n; ++i) {
+            int c;
+            while ((c = accept4(eventos[i].data.fd, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+                int si = 1;
+                setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &si, sizeof(si)); // Falla sin daño en sockets Unix
+                // Conexiones consecutivas al mismo hilo: se emparejan entre ellas
+                Trabajador &t = *W[(aceptadas++ / 2) % W.size()];
+                {
+                    lock_guard<mutex> l(t.m);
+                    t.nuevas.push_back(c);
+                }
+                uint64_t uno = 1;
+                if (write(t.aviso, &uno, sizeof(uno)) < 0) perror("eventfd");
+            }
+        }
+
+        auto ahora = Reloj::now();
+        if (ahora - informe < chrono::seconds(1)) continue;
+        uint64_t jugadas = 0, duelos = 0, tiempo = 0, ilegales = 0;
+        int64_t conexiones = 0;
+        vector<uint64_t> latencias(CUBETAS, 0), intervalo(CUBETAS);
+        for (auto &t : W) {
+            jugadas += t->est.jugadas.load(memory_order_relaxed);
+            duelos += t->est.duelos.load(memory_order_relaxed);
+            tiempo += t->est.fueraDeTiempo.load(memory_order_relaxed);
+            ilegales += t->est.ilegales.load(memory_order_relaxed);
+            conexiones += t->est.conexiones.load(memory_order_relaxed);
+            for (int k = 0; k < CUBETAS; ++k) latencias[k] += t->est.latencia[k].load(memory_order_relaxed);
+        }
+        for (int k = 0; k < CUBETAS; ++k) intervalo[k] = latencias[k] - latenciasAntes[k];
+        double s = chrono::duration<double>(ahora - informe).count();
+        printf("%.0f %lld %.0f %.0f %llu %llu %llu %llu\n", chrono::duration<double>(ahora - inicio).count(),
+               (long long) conexiones, double(duelos - duelosAntes) / s, double(jugadas - jugadasAntes) / s,
+               (unsigned long long) percentil(intervalo, 0.50), (unsigned long long) percentil(intervalo, 0.99),
+               (unsigned long long) tiempo, (unsigned long long) ilegales);
+        fflush(stdout);
+        informe = ahora;
+        jugadasAntes = jugadas;
+        duelosAntes = duelos;
+        latenciasAntes = latencias;
+        if ((O.partidas > 0 && duelos >= uint64_t(O.partidas)) ||
+            (O.duracion > 0 && ahora - inicio >= chrono::seconds(O.duracion))) {
+            parar = true;
+        }
+    }
+    for (thread &h : hilos) h.join();
+
+    uint64_t jugadas = 0, duelos = 0;
+    vector<uint64_t> latencias(CUBETAS, 0);
+    for (auto &t : W) {
+        jugadas += t->est.jugadas;
+        duelos += t->est.duelos;
+        for (int k = 0; k < CUBETAS; ++k) latencias[k] += t->est.latencia[k];
+        for (auto &c : t->conexiones) close(c.first);
+    }
+    double s = chrono::duration<double>(Reloj::now() - inicio).count();
+    printf("total: %llu duelos, %llu jugadas en %.1f s, %.0f jugadas/s, p50 %llu us, p99 %llu us\n",
+           (unsigned long long) duelos, (unsigned long long) jugadas, s, double(jugadas) / s,
+           (unsigned long long) percentil(latencias, 0.50), (unsigned long long) percentil(latencias, 0.99));
+    for (int s : escuchas) close(s);
+    if (!O.rutaUnix.empty()) unlink(O.rutaUnix.c_str());
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Generador de carga
+// ---------------------------------------------------------------------------
+
+/** @struct OpcionesBots
+ *  @brief Opciones del generador de carga.
+ */
+struct OpcionesBots {
+    string ip = "127.0.0.1"; ///< Dirección del servidor
+    int puerto = 47400; ///< Puerto TCP del servidor
+    string rutaUnix; ///< Ruta del socket Unix (si no está vacía se usa en lugar de TCP)
+    int conexiones = 1000; ///< Conexiones abiertas a la vez
+    long partidas = 1000; ///< Duelos a completar entre todas las conexiones
+    int hilos = 1; ///< Hilos del generador
+    int olvida = 0; ///< Una de cada N jugadas se deja sin responder (0: ninguna)
+};
+
+/** @struct ConexionBot
+ *  @brief Una conexión del generador de carga.
+ */
+struct ConexionBot {
+    string entrada; ///< Datos recibidos aún sin procesar
+    string salida; ///< Datos pendientes de enviar
+    bool terminada; ///< Se ha recibido el resultado del duelo
+};
+
+/** @struct ResultadosBots
+ *  @brief Contadores del generador de carga.
+ */
+struct ResultadosBots {
+    atomic<uint64_t> jugadas{0}; ///< Jugadas respondidas
+    atomic<uint64_t> ganadas{0}; ///< Partidas ganadas
+    atomic<uint64_t> perdidas{0}; ///< Partidas perdidas
+    atomic<uint64_t> empates{0}; ///< Partidas empatadas
+    atomic<uint64_t> cortadas{0}; ///< Conexiones cerradas sin resultado
+    atomic<long> restantes{0}; ///< Partidas (un lado de un duelo) aún por empezar
+};
+
+/**
+ * @brief Abre una conexión con el servidor.
+ * @param O Opciones
+ * @return int -> Descriptor no bloqueante; -1 si falla
+ */
+static int conectaBot(const OpcionesBots &O) {
+    int s;
+    if (!O.rutaUnix.empty()) {
+        sockaddr_un dir = {};
+        if (O.rutaUnix.size() >= sizeof(dir.sun_path)) return -1;
+        dir.sun_family = AF_UNIX;
+        memcpy(dir.sun_path, O.rutaUnix.c_str(), O.rutaUnix.size() + 1);
+        s = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (s >= 0 && connect(s, (sockaddr *) &dir, sizeof(dir)) != 0) {
+            close(s);
+            return -1;
+        }
+    } else {
+        sockaddr_in dir = {};
+        dir.sin_family = AF_INET;
+        dir.sin_port = htons(uint16_t(O.puerto));
+        if (inet_pton(AF_INET, O.ip.c_str(), &dir.sin_addr) != 1) return -1;
+        s = socket(AF_INET, SOCK_STREAM, 0);
+        if (s >= 0 && connect(s, (sockaddr *) &dir, sizeof(dir)) != 0) {
+            close(s);
+            return -1;
+        }
+        int si = 1;
+        if (s >= 0) setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &si, sizeof(si));
+    }
+    if (s >= 0 && !noBloqueante(s)) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+/**
+ * @brief Responde a una línea del servidor.
+ * @param O Opciones
+ * @param R Contadores
+ * @param c Conexión
+ * @param linea Línea sin el salto
+ * @param olvido Contador de jugadas para --olvida
+ */
+static void respondeLinea(const OpcionesBots &O, ResultadosBots &R, ConexionBot &c, const string &linea,
+                          long &olvido) {
+    if (linea[0] == 'F') {
+        char resultado[16];
+        if (sscanf(linea.c_str(), "F %15s", resultado) == 1) {
+            if (strcmp(resultado, "gana") == 0) R.ganadas.fetch_add(1, memory_order_relaxed);
+            else if (strcmp(resultado, "pierde") == 0) R.perdidas.fetch_add(1, memory_order_relaxed);
+            else R.empates.fetch_add(1, memory_order_relaxed);
+        }
+        c.terminada = true;
+        return;
+    }
+    unsigned jugada;
+    char tablero[3 * FILAS + 1];
+    int tipo, siguiente;
+    Ocupacion T;
+    if (sscanf(linea.c_str(), "P %u %60s %d %d", &jugada, tablero, &tipo, &siguiente) != 4 ||
+        strlen(tablero) != 3 * FILAS || !leeTablero(tablero, T) || tipo < 0 || tipo >= TIPOS_PIEZA) {
+        return;
+    }
+    if (O.olvida > 0 && ++olvido % O.olvida == 0) return;
+
+    Pieza P = {INICIO, tipo, 0};
+    Colocacion mejor = {P, 0, 0};
+    mejorColocacion(T, P, PESOS_DEFECTO, mejor); // Sin colocación legal responde INICIO y pierde
+    char respuesta[MAX_LINEA];
+    int n = snprintf(respuesta, sizeof(respuesta), "C %u %d %d %d\n", jugada, mejor.P.abs.x, mejor.P.abs.y,
+                     mejor.P.rot);
+    c.salida.append(respuesta, size_t(n));
+    R.jugadas.fetch_add(1, memory_order_relaxed);
+}
+
+/**
+ * @brief Bucle de un hilo del generador de carga.
+ * @param O Opciones
+ * @param R Contadores
+ * @param conexiones Conexiones que abre este hilo al empezar
+ */
+static void juegaBots(const OpcionesBots &O, ResultadosBots &R, int conexiones) {
+    int ep = epoll_create1(0);
+    unordered_map<int, ConexionBot> C;
+    auto abre = [&]() {
+        int fd = conectaBot(O);
+        if (fd < 0) {
+            R.cortadas.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        C[fd] = ConexionBot();
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+    };
+    for (int i = 0; i < conexiones; ++i) abre();
+
+    epoll_event eventos[MAX_EVENTOS];
+    long olvido = 0;
+    while (!C.empty() && !parar) {
+        int n = epoll_wait(ep, eventos, MAX_EVENTOS, 100);
+        for (int i = 0; i < n; ++i) {
+            int fd = eventos[i].data.fd;
+            auto it = C.find(fd);
+            if (it == C.end()) continue;
+            ConexionBot &c = it->second;
+            bool abierta = leeEntrada(fd, c.entrada);
+            size_t inicio = 0, fin;
+            while ((fin = c.entrada.find('\n', inicio)) != string::npos) {
+                if (fin > inicio) respondeLinea(O, R, c, c.entrada.substr(inicio, fin - inicio), olvido);
+                inicio = fin + 1;
+            }
+            c.entrada.erase(0, inicio);
+            abierta = abierta && vaciaSalida(fd, c.salida);
+            vigila(ep, fd, !c.salida.empty());
+            if (abierta) continue;
+
+            // El servidor cierra tras el resultado: se empieza otra partida si quedan
+            if (!c.terminada) R.cortadas.fetch_add(1, memory_order_relaxed);
+            epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+            close(fd);
+            C.erase(it);
+            if (R.restantes.fetch_sub(1, memory_order_relaxed) > 0) abre();
+        }
+    }
+    for (auto &c : C) close(c.first);
+    close(ep);
+}
+
+/**
+ * @brief Ejecuta el generador de carga.
+ * @param O Opciones
+ * @return int -> Código de salida
+ */
+static int bots(const OpcionesBots &O) {
+    ResultadosBots R;
+    long lados = 2 * O.partidas;
+    long abiertas = O.conexiones < lados ? O.conexiones : lados;
+    R.restantes = lados - abiertas;
+    auto inicio = Reloj::now();
+    vector<thread> hilos;
+    for (int h = 0; h < O.hilos; ++h) {
+        int mias = int(abiertas / O.hilos + (h < abiertas % O.hilos ? 1 : 0));
+        hilos.emplace_back(juegaBots, cref(O), ref(R), mias);
+    }
+    for (thread &h : hilos) h.join();
+    double s = chrono::duration<double>(Reloj::now() - inicio).count();
+    uint64_t jugadas = R.jugadas;
+    printf("%llu jugadas en %.1f s (%.0f jugadas/s): %llu ganadas, %llu perdidas, %llu empates, %llu cortadas\n",
+           (unsigned long long) jugadas, s, double(jugadas) / s, (unsigned long long) R.ganadas.load(),
+           (unsigned long long) R.perdidas.load(), (unsigned long long) R.empates.load(),
+           (unsigned long long) R.cortadas.load());
+    return R.cortadas > 0 ? 1 : 0;
+}
+
+/**
+ * @brief Muestra el uso del programa.
+ * @param programa Nombre del ejecutable
+ * @return int -> Código de salida
+ */
+static int uso(const char *programa) {
+    cerr << "Uso: " << programa << " servir [--puerto P] [--unix RUTA] [--hilos N] [--tiempo MS] [--piezas N]"
+         << " [--semilla S] [--partidas K] [--duracion S]" << endl
+         << "     " << programa << " bots [--ip IP] [--puerto P | --unix RUTA] [--conexiones C] [--partidas K]"
+         << " [--hilos N] [--olvida N]" << endl;
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) return uso(argv[0]);
+    signal(SIGINT, alParar);
+    signal(SIGTERM, alParar);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (strcmp(argv[1], "servir") == 0) {
+        OpcionesServidor O;
+        for (int i = 2; i < argc; ++i) {
+            bool valor = i + 1 < argc;
+            if (strcmp(argv[i], "--puerto") == 0 && valor) O.puerto = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--unix") == 0 && valor) O.rutaUnix = argv[++i];
+            else if (strcmp(argv[i], "--hilos") == 0 && valor) O.hilos = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--tiempo") == 0 && valor) O.tiempo = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--piezas") == 0 && valor) O.piezas = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--semilla") == 0 && valor) O.semilla = strtoull(argv[++i], nullptr, 10);
+            else if (strcmp(argv[i], "--partidas") == 0 && valor) O.partidas = atol(argv[++i]);
+            else if (strcmp(argv[i], "--duracion") == 0 && valor) O.duracion = atoi(argv[++i]);
+            else return uso(argv[0]);
+        }
+        if (O.hilos < 1) O.hilos = 1;
+        if (O.tiempo < 1) O.tiempo = 1;
+        return servir(O);
+    }
+    if (strcmp(argv[1], "bots") == 0) {
+        OpcionesBots O;
+        for (int i = 2; i < argc; ++i) {
+            bool valor = i + 1 < argc;
+            if (strcmp(argv[i], "--ip") == 0 && valor) O.ip = argv[++i];
+            else if (strcmp(argv[i], "--puerto") == 0 && valor) O.puerto = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--unix") == 0 && valor) O.rutaUnix = argv[++i];
+            else if (strcmp(argv[i], "--conexiones") == 0 && valor) O.conexiones = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--partidas") == 0 && valor) O.partidas = atol(argv[++i]);
+            else if (strcmp(argv[i], "--hilos") == 0 && valor) O.hilos = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--olvida") == 0 && valor) O.olvida = atoi(argv[++i]);
+            else return uso(argv[0]);
+        }
+        if (O.hilos < 1) O.hilos = 1;
+        if (O.conexiones < 1) O.conexiones = 1;
+        return bots(O);
+    }
+    return uso(argv[0]);
+}
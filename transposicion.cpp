@@ -0,0 +1,224 @@
+/**
+ * @file transposicion.cpp
+ * @brief Tabla de transposición compartida y sin cerrojos
+ *
+ * Datos de una entrada, de menos a más significativo: 32 bits del valor (float),
+ * 8 de profundidad + 1 (nunca 0 en una entrada usada), 8 de edad y 16 de jugada.
+ *
+ * @see transposicion.h
+ */
+
+#include "transposicion.h"
+#include <chrono>
+#include <cstring>
+#include <initializer_list>
+
+static_assert(sizeof(CubetaTabla) == 64, "Una cubeta debe ocupar una línea de caché");
+
+/// Entradas de la muestra con que se estima la ocupación
+const size_t MUESTRA_OCUPACION = 4096;
+
+/**
+ * @brief Contadores del hilo que llama.
+ * @post Cada hilo recibe un hueco la primera vez; a partir de HILOS_CONTADORES
+ *       hilos se comparten y las cuentas pasan a ser aproximadas
+ * @param TT Tabla
+ * @return ContadoresTabla& -> Contadores propios
+ */
+static ContadoresTabla &contadoresPropios(TablaTransposicion &TT) {
+    static std::atomic<unsigned> siguiente(0);
+    static thread_local unsigned propio = siguiente++ % HILOS_CONTADORES;
+    return TT.contadores[propio];
+}
+
+/**
+ * @brief Suma a un contador que solo escribe su hilo, sin instrucción atómica de lectura-escritura.
+ * @param c Contador
+ * @param n Cantidad
+ */
+static inline void suma(std::atomic<uint64_t> &c, uint64_t n) {
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Empaqueta una entrada en una palabra.
+ * @param E Entrada
+ * @param edad Edad de la tabla
+ * @return uint64_t -> Datos (nunca 0)
+ */
+static uint64_t empaqueta(const EntradaTabla &E, unsigned edad) {
+    uint32_t v;
+    memcpy(&v, &E.valor, sizeof(v));
+    unsigned p = unsigned(E.profundidad < 0 ? 0 : E.profundidad > 254 ? 254 : E.profundidad) + 1;
+    return uint64_t(v) | uint64_t(p) << 32 | uint64_t(edad & 0xFF) << 40 | uint64_t(E.jugada) << 48;
+}
+
+/**
+ * @brief Desempaqueta los datos de una entrada.
+ * @param d Datos
+ * @param E Entrada
+ */
+static void desempaqueta(uint64_t d, EntradaTabla &E) {
+    uint32_t v = uint32_t(d);
+    memcpy(&E.valor, &v, sizeof(v));
+    E.profundidad = int((d >> 32) & 0xFF) - 1;
+    E.jugada = uint16_t(d >> 48);
+}
+
+/**
+ * @brief Reserva la tabla y la deja vacía.
+ * @post El número de cubetas es la mayor potencia de 2 que cabe en bytes (al menos una)
+ * @param TT Tabla
+ * @param bytes Memoria para las cubetas
+ */
+void iniciarTabla(TablaTransposicion &TT, size_t bytes) {
+    size_t n = 1;
+    while (n * 2 * sizeof(CubetaTabla) <= bytes) n *= 2;
+    TT.cubetas.reset(new CubetaTabla[n]);
+    TT.mascara = n - 1;
+    limpiaTabla(TT);
+}
+
+/**
+ * @brief Vacía la tabla y pone a cero la edad y los contadores.
+ * @pre Ningún hilo la está usando
+ * @param TT Tabla
+ */
+void limpiaTabla(TablaTransposicion &TT) {
+    for (size_t i = 0; i <= TT.mascara; ++i) {
+        for (int e = 0; e < ENTRADAS_CUBETA; ++e) {
+            TT.cubetas[i].llave[e].store(0, std::memory_order_relaxed);
+            TT.cubetas[i].datos[e].store(0, std::memory_order_relaxed);
+        }
+    }
+    TT.edad.store(0);
+    for (ContadoresTabla &C : TT.contadores) {
+        for (auto *c : {&C.sondeos, &C.aciertos, &C.escrituras, &C.reemplazos, &C.muestras, &C.nsMuestras, &C.nsMaximo}) {
+            c->store(0);
+        }
+    }
+}
+
+/**
+ * @brief Avanza la edad de la tabla.
+ * @post Lo que se guarde a partir de ahora tiene preferencia sobre lo anterior
+ *       al elegir qué entrada sustituir. Se llama con cada búsqueda desde la raíz.
+ * @param TT Tabla
+ */
+void nuevaEdadTabla(TablaTransposicion &TT) {
+    TT.edad.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Busca una posición en su cubeta.
+ * @param TT Tabla
+ * @param clave Clave de la posición
+ * @return uint64_t -> Datos de la entrada; 0 si no está
+ */
+static uint64_t sondea(const TablaTransposicion &TT, uint64_t clave) {
+    const CubetaTabla &C = TT.cubetas[clave & TT.mascara];
+    for (int e = 0; e < ENTRADAS_CUBETA; ++e) {
+        uint64_t d = C.datos[e].load(std::memory_order_relaxed);
+        if (d != 0 && (C.llave[e].load(std::memory_order_relaxed) ^ d) == clave) return d;
+    }
+    return 0;
+}
+
+/**
+ * @brief Busca una posición.
+ * @param TT Tabla
+ * @param clave Clave de la posición
+ * @param E Entrada encontrada
+ * @return bool -> true: estaba en la tabla
+ */
+bool buscaTabla(TablaTransposicion &TT, uint64_t clave, EntradaTabla &E) {
+    ContadoresTabla &K = contadoresPropios(TT);
+    uint64_t n = K.sondeos.load(std::memory_order_relaxed);
+    K.sondeos.store(n + 1, std::memory_order_relaxed);
+    uint64_t d;
+    if (n % MUESTRA_SONDEO == 0) {
+        auto inicio = std::chrono::steady_clock::now();
+        d = sondea(TT, clave);
+        auto ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - inicio).count());
+        suma(K.muestras, 1);
+        suma(K.nsMuestras, ns);
+        if (ns > K.nsMaximo.load(std::memory_order_relaxed)) K.nsMaximo.store(ns, std::memory_order_relaxed);
+    } else {
+        d = sondea(TT, clave);
+    }
+    if (d == 0) return false;
+    suma(K.aciertos, 1);
+    desempaqueta(d, E);
+    return true;
+}
+
+/**
+ * @brief Guarda una posición.
+ * @post Si la posición ya está, se sustituye salvo que la guardada sea de esta
+ *       edad y más profunda. Si no, ocupa una entrada vacía o la de menos valor
+ *       de su cubeta: cada edad de antigüedad resta 4 de profundidad.
+ * @param TT Tabla
+ * @param clave Clave de la posición
+ * @param E Entrada a guardar
+ */
+void guardaTabla(TablaTransposicion &TT, uint64_t clave, const EntradaTabla &E) {
+    CubetaTabla &C = TT.cubetas[clave & TT.mascara];
+    const unsigned edad = TT.edad.load(std::memory_order_relaxed) & 0xFF;
+    int misma = -1, vacia = -1, peor = -1, valorPeor = 0;
+    for (int e = 0; e < ENTRADAS_CUBETA && misma < 0; ++e) {
+        uint64_t d = C.datos[e].load(std::memory_order_relaxed);
+        if (d == 0) {
+            if (vacia < 0) vacia = e;
+            continue;
+        }
+        int profundidad = int((d >> 32) & 0xFF) - 1;
+        int antiguedad = int((edad - unsigned(d >> 40)) & 0xFF);
+        if ((C.llave[e].load(std::memory_order_relaxed) ^ d) == clave) {
+            if (antiguedad == 0 && profundidad > E.profundidad) return;
+            misma = e;
+        }
+        int valor = profundidad - 4 * antiguedad;
+        if (peor < 0 || valor < valorPeor) {
+            peor = e;
+            valorPeor = valor;
+        }
+    }
+    int victima = misma >= 0 ? misma : vacia >= 0 ? vacia : peor;
+    uint64_t d = empaqueta(E, edad);
+    C.llave[victima].store(clave ^ d, std::memory_order_relaxed);
+    C.datos[victima].store(d, std::memory_order_relaxed);
+
+    ContadoresTabla &K = contadoresPropios(TT);
+    suma(K.escrituras, 1);
+    if (misma < 0 && vacia < 0) suma(K.reemplazos, 1);
+}
+
+/**
+ * @brief Suma los contadores de todos los hilos.
+ * @param TT Tabla
+ * @return EstadisticasTabla -> Totales, ocupación y latencias
+ */
+EstadisticasTabla estadisticasTabla(const TablaTransposicion &TT) {
+    EstadisticasTabla S = {};
+    uint64_t muestras = 0, ns = 0, maximo = 0;
+    for (const ContadoresTabla &K : TT.contadores) {
+        S.sondeos += K.sondeos.load(std::memory_order_relaxed);
+        S.aciertos += K.aciertos.load(std::memory_order_relaxed);
+        S.escrituras += K.escrituras.load(std::memory_order_relaxed);
+        S.reemplazos += K.reemplazos.load(std::memory_order_relaxed);
+        muestras += K.muestras.load(std::memory_order_relaxed);
+        ns += K.nsMuestras.load(std::memory_order_relaxed);
+        uint64_t m = K.nsMaximo.load(std::memory_order_relaxed);
+        if (m > maximo) maximo = m;
+    }
+    S.bytes = (TT.mascara + 1) * sizeof(CubetaTabla);
+    size_t mirar = TT.mascara + 1 < MUESTRA_OCUPACION ? TT.mascara + 1 : MUESTRA_OCUPACION, usadas = 0;
+    for (size_t i = 0; i < mirar; ++i) {
+        for (int e = 0; e < ENTRADAS_CUBETA; ++e) usadas += TT.cubetas[i].datos[e].load(std::memory_order_relaxed) != 0;
+    }
+    S.ocupacion = double(usadas) / double(mirar * ENTRADAS_CUBETA);
+    S.nsSondeo = muestras > 0 ? double(ns) / double(muestras) : 0;
+    S.nsMaximo = double(maximo);
+    return S;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file transposicion.h
+ * @brief Tabla de transposición compartida y sin cerrojos
+ *
+ * La búsqueda con la pieza actual y la siguiente llega al mismo tablero por
+ * caminos distintos. Esta tabla guarda el valor ya calculado de cada posición
+ * (clave Zobrist, ver claveTablero) para todos los hilos de búsqueda a la vez.
+ *
+ * Tiene tamaño fijo, en cubetas de 4 entradas que ocupan una línea de caché.
+ * Cada entrada son dos palabras atómicas: los datos y la clave XOR los datos. Un
+ * lector que ve una escritura a medias obtiene una clave que no cuadra y lo toma
+ * como un fallo, así que no hacen falta cerrojos. Al guardar en una cubeta llena
+ * se sustituye la entrada de menos valor, profundidad - 4 * antigüedad (la
+ * antigüedad son las edades de la tabla, que avanza con nuevaEdadTabla, desde
+ * que se guardó): una entrada vieja pero profunda puede sobrevivir a una nueva.
+ *
+ * Cada hilo cuenta sus sondeos, aciertos y escrituras en su propia línea de
+ * caché; uno de cada MUESTRA_SONDEO sondeos mide además su latencia.
+ */
+
+#ifndef _TRANSPOSICION_H_
+#define _TRANSPOSICION_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+const int ENTRADAS_CUBETA = 4; ///< Entradas por cubeta (64 bytes)
+const int HILOS_CONTADORES = 64; ///< Hilos con contadores propios; los demás comparten
+const int MUESTRA_SONDEO = 64; ///< Un sondeo de cada tantos mide su latencia
+
+/** @struct EntradaTabla
+ *  @brief Contenido de una entrada de la tabla.
+ */
+struct EntradaTabla {
+    float valor; ///< Valor de la posición
+    int profundidad; ///< Piezas por delante con que se calculó (0: solo la evaluación)
+    uint16_t jugada; ///< Mejor colocación, codificada por quien busca
+};
+
+/** @struct CubetaTabla
+ *  @brief Entradas que comparten índice, en una línea de caché.
+ */
+struct alignas(64) CubetaTabla {
+    std::atomic<uint64_t> llave[ENTRADAS_CUBETA]; ///< Clave XOR datos de cada entrada
+    std::atomic<uint64_t> datos[ENTRADAS_CUBETA]; ///< Datos empaquetados (0: vacía)
+};
+
+/** @struct ContadoresTabla
+ *  @brief Contadores de un hilo, en su propia línea de caché.
+ */
+struct alignas(64) ContadoresTabla {
+    std::atomic<uint64_t> sondeos; ///< Búsquedas
+    std::atomic<uint64_t> aciertos; ///< Búsquedas que encontraron la clave
+    std::atomic<uint64_t> escrituras; ///< Entradas guardadas
+    std::atomic<uint64_t> reemplazos; ///< Escrituras que expulsaron otra posición
+    std::atomic<uint64_t> muestras; ///< Sondeos medidos
+    std::atomic<uint64_t> nsMuestras; ///< Nanosegundos de los sondeos medidos
+    std::atomic<uint64_t> nsMaximo; ///< Sondeo medido más lento
+};
+
+/** @struct TablaTransposicion
+ *  @brief Tabla compartida entre hilos.
+ */
+struct TablaTransposicion {
+    std::unique_ptr<CubetaTabla[]> cubetas; ///< Cubetas (número potencia de 2)
+    size_t mascara; ///< Cubetas - 1
+    std::atomic<unsigned> edad; ///< Edad actual (se guarda en 8 bits)
+    ContadoresTabla contadores[HILOS_CONTADORES]; ///< Contadores por hilo
+};
+
+/** @struct EstadisticasTabla
+ *  @brief Suma de los contadores de todos los hilos.
+ */
+struct EstadisticasTabla {
+    uint64_t sondeos, aciertos, escrituras, reemplazos; ///< Totales
+    size_t bytes; ///< Memoria de las cubetas
+    double ocupacion; ///< Fracción de entradas usadas (muestra de las primeras cubetas)
+    double nsSondeo; ///< Latencia media de los sondeos medidos
+    double nsMaximo; ///< Latencia del sondeo medido más lento
+};
+
+void iniciarTabla(TablaTransposicion &TT, size_t bytes);
+void limpiaTabla(TablaTransposicion &TT);
+void nuevaEdadTabla(TablaTransposicion &TT);
+bool buscaTabla(TablaTransposicion &TT, uint64_t clave, EntradaTabla &E);
+void guardaTabla(TablaTransposicion &TT, uint64_t clave, const EntradaTabla &E);
+EstadisticasTabla estadisticasTabla(const TablaTransposicion &TT);
+
+#endif
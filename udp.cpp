@@ -0,0 +1,175 @@
+/**
+ * @file udp.cpp
+ * @brief Canal UDP no bloqueante con simulador de latencia y pérdidas
+ *
+ * @see udp.h
+ */
+
+#include "udp.h"
+#include "azar.h"
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int longitud_t;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef socklen_t longitud_t;
+#endif
+
+/**
+ * @brief Envía un datagrama sin pasar por el simulador.
+ * @param C Canal
+ * @param datos Contenido
+ * @param n Bytes
+ */
+static void enviaDirecto(CanalUdp &C, const unsigned char *datos, int n) {
+    sockaddr_in dir = {};
+    dir.sin_family = AF_INET;
+    dir.sin_port = htons(C.puertoRemoto);
+    dir.sin_addr.s_addr = htonl(C.ipRemota);
+    // Un envío fallido es una pérdida más: el rollback la repara
+    sendto(C.sock, (const char *) datos, n, 0, (const sockaddr *) &dir, sizeof(dir));
+    C.enviados++;
+}
+
+/**
+ * @brief Abre un socket UDP no bloqueante unido a un destino.
+ * @param C Canal
+ * @param puertoLocal Puerto propio
+ * @param ip Dirección IPv4 del destino en forma numérica (por ejemplo 127.0.0.1)
+ * @param puertoRemoto Puerto del destino
+ * @return bool -> true: el canal está abierto
+ */
+bool abreCanal(CanalUdp &C, uint16_t puertoLocal, const char *ip, uint16_t puertoRemoto) {
+    C.sock = -1;
+    C.latencia = C.variacion = 0;
+    C.perdida = 0;
+    C.azar = 1;
+    C.retenidos.clear();
+    C.enviados = C.perdidos = C.recibidos = 0;
+
+    in_addr remota;
+    if (inet_pton(AF_INET, ip, &remota) != 1) return false;
+    C.ipRemota = ntohl(remota.s_addr);
+    C.puertoRemoto = puertoRemoto;
+
+#if defined(_WIN32)
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+    intptr_t s = intptr_t(socket(AF_INET, SOCK_DGRAM, 0));
+    if (s < 0) return false;
+    sockaddr_in dir = {};
+    dir.sin_family = AF_INET;
+    dir.sin_port = htons(puertoLocal);
+    dir.sin_addr.s_addr = htonl(INADDR_ANY);
+#if defined(_WIN32)
+    u_long noBloquea = 1;
+    bool ok = bind(s, (const sockaddr *) &dir, sizeof(dir)) == 0 && ioctlsocket(s, FIONBIO, &noBloquea) == 0;
+#else
+    bool ok = bind(int(s), (const sockaddr *) &dir, sizeof(dir)) == 0 &&
+              fcntl(int(s), F_SETFL, fcntl(int(s), F_GETFL) | O_NONBLOCK) == 0;
+#endif
+    C.sock = s;
+    if (!ok) cierraCanal(C);
+    return ok;
+}
+
+/**
+ * @brief Activa el simulador de red para los envíos.
+ * @param C Canal
+ * @param latencia Milisegundos de retención de cada datagrama
+ * @param variacion Milisegundos extra aleatorios (0..variacion) por datagrama
+ * @param perdida Fracción de datagramas descartados (0..1)
+ * @param semilla Semilla del simulador
+ */
+void simulaRed(CanalUdp &C, int latencia, int variacion, double perdida, uint64_t semilla) {
+    C.latencia = latencia < 0 ? 0 : latencia;
+    C.variacion = variacion < 0 ? 0 : variacion;
+    C.perdida = perdida < 0 ? 0 : perdida > 1 ? 1 : perdida;
+    C.azar = semilla;
+}
+
+/**
+ * @brief Envía un datagrama al destino.
+ * @post Con el simulador activo puede descartarlo o retenerlo hasta bombeaCanal
+ * @param C Canal
+ * @param datos Contenido
+ * @param n Bytes
+ */
+void enviaCanal(CanalUdp &C, const unsigned char *datos, int n) {
+    if (C.perdida > 0 && double(siguienteAzar(C.azar) >> 11) * 0x1p-53 < C.perdida) {
+        C.perdidos++;
+        return;
+    }
+    if (C.latencia == 0 && C.variacion == 0) {
+        enviaDirecto(C, datos, n);
+        return;
+    }
+    int ms = C.latencia + (C.variacion > 0 ? int(siguienteAzar(C.azar) % uint64_t(C.variacion + 1)) : 0);
+    C.retenidos.push_back({std::chrono::steady_clock::now() + std::chrono::milliseconds(ms),
+                           std::vector<unsigned char>(datos, datos + n)});
+}
+
+/**
+ * @brief Envía los datagramas retenidos cuyo momento ha llegado.
+ * @param C Canal
+ */
+void bombeaCanal(CanalUdp &C) {
+    auto ahora = std::chrono::steady_clock::now();
+    size_t quedan = 0;
+    for (size_t i = 0; i < C.retenidos.size(); ++i) {
+        DatagramaRetenido &d = C.retenidos[i];
+        if (d.salida <= ahora) {
+            enviaDirecto(C, d.datos.data(), int(d.datos.size()));
+        } else {
+            if (quedan != i) C.retenidos[quedan] = std::move(d);
+            quedan++;
+        }
+    }
+    C.retenidos.resize(quedan);
+}
+
+/**
+ * @brief Recibe un datagrama del destino si hay alguno.
+ * @post Nunca se bloquea. Descarta los que llegan de otras direcciones.
+ * @param C Canal
+ * @param buf Destino
+ * @param cap Capacidad de buf
+ * @return int -> Bytes recibidos; -1 si no hay ninguno
+ */
+int recibeCanal(CanalUdp &C, unsigned char *buf, int cap) {
+    for (;;) {
+        sockaddr_in origen;
+        longitud_t largo = sizeof(origen);
+        int n = int(recvfrom(C.sock, (char *) buf, cap, 0, (sockaddr *) &origen, &largo));
+        if (n < 0) return -1;
+        if (ntohl(origen.sin_addr.s_addr) == C.ipRemota && ntohs(origen.sin_port) == C.puertoRemoto) {
+            C.recibidos++;
+            return n;
+        }
+    }
+}
+
+/**
+ * @brief Cierra el canal.
+ * @post Los datagramas retenidos se descartan
+ * @param C Canal
+ */
+void cierraCanal(CanalUdp &C) {
+    if (C.sock >= 0) {
+#if defined(_WIN32)
+        closesocket(C.sock);
+        WSACleanup();
+#else
+        close(int(C.sock));
+#endif
+    }
+    C.sock = -1;
+    C.retenidos.clear();
+}
@@ -0,0 +1,51 @@
+/**
+ * @file udp.h
+ * @brief Canal UDP no bloqueante con simulador de latencia y pérdidas
+ *
+ * Une dos puertos (normalmente en 127.0.0.1) para el duelo en red. Para
+ * probar en local, simulaRed retiene cada datagrama enviado una latencia fija
+ * más una variación aleatoria y descarta una fracción de ellos; con variación
+ * los datagramas pueden llegar desordenados, como en una red real. Los
+ * retenidos salen al llamar a bombeaCanal, una vez por tick.
+ */
+
+#ifndef _UDP_H_
+#define _UDP_H_
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/** @struct DatagramaRetenido
+ *  @brief Datagrama retenido por el simulador de red.
+ */
+struct DatagramaRetenido {
+    std::chrono::steady_clock::time_point salida; ///< Momento de enviarlo
+    std::vector<unsigned char> datos; ///< Contenido
+};
+
+/** @struct CanalUdp
+ *  @brief Socket UDP unido a un único destino.
+ */
+struct CanalUdp {
+    intptr_t sock; ///< Socket (-1 si está cerrado)
+    uint32_t ipRemota; ///< Dirección IPv4 del destino (orden de host)
+    uint16_t puertoRemoto; ///< Puerto del destino
+    int latencia; ///< Milisegundos de latencia simulada (0: sin simulador)
+    int variacion; ///< Milisegundos de variación aleatoria de la latencia
+    double perdida; ///< Fracción de datagramas descartados (0..1)
+    uint64_t azar; ///< Generador del simulador
+    std::vector<DatagramaRetenido> retenidos; ///< Datagramas pendientes de salir
+    long enviados; ///< Datagramas enviados
+    long perdidos; ///< Datagramas descartados por el simulador
+    long recibidos; ///< Datagramas recibidos del destino
+};
+
+bool abreCanal(CanalUdp &C, uint16_t puertoLocal, const char *ip, uint16_t puertoRemoto);
+void simulaRed(CanalUdp &C, int latencia, int variacion, double perdida, uint64_t semilla);
+void enviaCanal(CanalUdp &C, const unsigned char *datos, int n);
+int recibeCanal(CanalUdp &C, unsigned char *buf, int cap);
+void bombeaCanal(CanalUdp &C);
+void cierraCanal(CanalUdp &C);
+
+#endif
@@ -0,0 +1,223 @@
+/**
+ * @file versus.cpp
+ * @brief Duelo en red entre dos bots con retraso de entrada y rollback
+ *
+ * Cada jugador es un proceso (o un hilo con --local) que simula el duelo
+ * entero, lee la acción de su bot cada tick, manda sus acciones al rival por
+ * UDP y corrige con rollback cuando las del rival no son las predichas. Al
+ * terminar muestra una línea por jugador:
+ *
+ *     jugador puntos rival ganador frames correcciones resimulados media maximo
+ *     esperas sumas desincronizado tick_medio_us tick_max_us enviados perdidos suma
+ *
+ * Si los dos jugadores muestran la misma suma, han terminado en el mismo estado.
+ *
+ * Uso: versus --local [opciones]
+ *      versus --jugador J --puerto-local P --puerto-remoto Q [--ip IP] [opciones]
+ *
+ * Opciones: [--puerto P] [--semilla S] [--frames F] [--tick MS] [--retraso D]
+ *           [--rollback N] [--cada K] [--latencia MS] [--variacion MS] [--perdida X]
+ *           [--desync F]
+ *
+ * --local juega los dos jugadores en este proceso por 127.0.0.1, en los puertos
+ * P y P+1 (47000 por defecto). El bot de cada jugador pulsa una tecla cada K
+ * frames (4 por defecto), como haría una persona. --latencia, --variacion y
+ * --perdida (fracción 0..1) simulan la red en los envíos de cada jugador.
+ * --desync F altera a propósito el estado del jugador 1 en el frame F para
+ * comprobar que la desincronización se detecta.
+ */
+
+#include "bot.h"
+#include "rollback.h"
+#include "udp.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+/** @struct OpcionesVersus
+ *  @brief Opciones comunes a los dos jugadores.
+ */
+struct OpcionesVersus {
+    uint64_t semilla = 1; ///< Semilla del duelo
+    uint32_t frames = 5000; ///< Límite de frames si nadie gana antes
+    int tick = 30; ///< Milisegundos por tick
+    int retraso = 2; ///< Frames de retraso de entrada
+    int rollback = 8; ///< Máximo de frames re-simulados
+    int cada = 4; ///< Frames entre teclas del bot
+    int latencia = 0; ///< Latencia simulada en milisegundos
+    int variacion = 0; ///< Variación simulada de la latencia en milisegundos
+    double perdida = 0; ///< Fracción de paquetes perdidos
+    uint32_t desync = SIN_FRAME; ///< Frame en que se altera el estado del jugador 1
+    string ip = "127.0.0.1"; ///< Dirección del rival
+};
+
+/** @struct ResultadoVersus
+ *  @brief Resumen del duelo visto por un jugador.
+ */
+struct ResultadoVersus {
+    bool ok; ///< false: no se ha podido abrir el canal o el rival no responde
+    double tickMedio; ///< Microsegundos de cálculo medios por tick
+    double tickMaximo; ///< Microsegundos de cálculo del peor tick
+    long enviados; ///< Paquetes enviados
+    long perdidos; ///< Paquetes descartados por el simulador de red
+    uint64_t suma; ///< Suma de comprobación del estado final
+};
+
+/// Segundos sin noticias del rival tras los que se abandona
+const int SEGUNDOS_ABANDONO = 10;
+/// Ticks que se siguen enviando paquetes tras terminar, para que el rival también termine
+const int TICKS_DESPEDIDA = 30;
+
+/**
+ * @brief Juega el duelo como uno de los dos jugadores.
+ * @param O Opciones
+ * @param R Sincronización (sale con el estado final)
+ * @param jugador Jugador (0 o 1)
+ * @param puertoLocal Puerto propio
+ * @param puertoRemoto Puerto del rival
+ * @return ResultadoVersus -> Resumen del duelo
+ */
+static ResultadoVersus jugarVersus(const OpcionesVersus &O, Rollback &R, int jugador, uint16_t puertoLocal,
+                                   uint16_t puertoRemoto) {
+    ResultadoVersus res = {};
+    iniciarRollback(R, O.semilla, jugador, O.retraso, O.rollback);
+    CanalUdp C;
+    if (!abreCanal(C, puertoLocal, O.ip.c_str(), puertoRemoto)) return res;
+    if (O.latencia > 0 || O.variacion > 0 || O.perdida > 0) {
+        simulaRed(C, O.latencia, O.variacion, O.perdida, O.semilla * 2 + uint64_t(jugador) + 1);
+    }
+    unique_ptr<Bot> B(new Bot);
+    iniciarBot(*B, PESOS_DEFECTO);
+    // La tecla pulsada se aplica `retraso` frames después: el bot no decide otra antes
+    int cada = O.cada > R.retraso ? O.cada : R.retraso + 1;
+
+    unsigned char paquete[TAM_PAQUETE];
+    auto periodo = chrono::milliseconds(O.tick);
+    auto siguiente = chrono::steady_clock::now();
+    double total = 0;
+    long ticks = 0;
+    auto noticias = siguiente;
+    int despedida = -1;
+    bool alterado = false;
+    while (despedida != 0 && chrono::steady_clock::now() - noticias < chrono::seconds(SEGUNDOS_ABANDONO)) {
+        int n;
+        while ((n = recibeCanal(C, paquete, sizeof(paquete))) >= 0) {
+            if (recibePaquete(R, paquete, n)) noticias = chrono::steady_clock::now();
+        }
+
+        auto inicio = chrono::steady_clock::now();
+        corrigeRollback(R);
+        if (!alterado && jugador == 1 && R.frame >= O.desync) {
+            // También en los estados guardados desde el último confirmado, para que un rollback no lo deshaga
+            for (uint32_t f = frameConfirmado(R); f < R.frame; ++f) R.antes[f % VENTANA_ROLLBACK].J[1].ptos += 100;
+            R.D.J[1].ptos += 100;
+            alterado = true;
+        }
+        if (R.frame < O.frames) {
+            Accion a = NADA;
+            // Solo se consulta al bot si la acción se va a usar: su plan cuenta con ella
+            if (puedeAvanzar(R) && R.localHasta % uint32_t(cada) == 0) a = accionBot(*B, R.D.J[jugador]);
+            avanzaRollback(R, a);
+        }
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - inicio).count();
+        total += us;
+        if (us > res.tickMaximo) res.tickMaximo = us;
+        ticks++;
+
+        enviaCanal(C, paquete, creaPaquete(R, paquete));
+        bombeaCanal(C);
+        if (despedida > 0) despedida--;
+        else if (despedida < 0 && (rollbackTerminado(R) || frameConfirmado(R) >= O.frames)) despedida = TICKS_DESPEDIDA;
+
+        siguiente += periodo;
+        this_thread::sleep_until(siguiente);
+    }
+    res.ok = despedida == 0;
+    res.tickMedio = ticks > 0 ? total / double(ticks) : 0;
+    res.enviados = C.enviados;
+    res.perdidos = C.perdidos;
+    res.suma = sumaDuelo(R.D);
+    cierraCanal(C);
+    return res;
+}
+
+/**
+ * @brief Muestra el resumen de un jugador.
+ * @param R Sincronización al terminar
+ * @param res Resumen del duelo
+ */
+static void muestraResultado(const Rollback &R, const ResultadoVersus &res) {
+    const char *ganador = R.D.ganador == EN_CURSO ? "nadie" : R.D.ganador == EMPATE ? "empate"
+                          : R.D.ganador == R.local ? "yo" : "rival";
+    printf("%d %d %d %s %u %ld %ld %.2f %d %ld %ld %s %.1f %.1f %ld %ld %016llx%s\n", R.local, R.D.J[R.local].ptos,
+           R.D.J[1 - R.local].ptos, ganador, R.frame, R.correcciones, R.resimulados,
+           R.correcciones > 0 ? double(R.resimulados) / double(R.correcciones) : 0.0, R.maxResimulados, R.esperas,
+           R.sumasComparadas, R.desincronizado ? to_string(R.frameDesincronizado).c_str() : "no", res.tickMedio,
+           res.tickMaximo, res.enviados, res.perdidos, (unsigned long long) res.suma,
+           res.ok ? "" : " (rival perdido)");
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    OpcionesVersus O;
+    bool local = false;
+    int jugador = -1, puerto = 47000, puertoLocal = -1, puertoRemoto = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        bool valor = i + 1 < argc;
+        if (strcmp(argv[i], "--local") == 0) local = true;
+        else if (strcmp(argv[i], "--jugador") == 0 && valor) jugador = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--puerto") == 0 && valor) puerto = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--puerto-local") == 0 && valor) puertoLocal = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--puerto-remoto") == 0 && valor) puertoRemoto = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ip") == 0 && valor) O.ip = argv[++i];
+        else if (strcmp(argv[i], "--semilla") == 0 && valor) O.semilla = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--frames") == 0 && valor) O.frames = uint32_t(atol(argv[++i]));
+        else if (strcmp(argv[i], "--tick") == 0 && valor) O.tick = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--retraso") == 0 && valor) O.retraso = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rollback") == 0 && valor) O.rollback = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cada") == 0 && valor) O.cada = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--latencia") == 0 && valor) O.latencia = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--variacion") == 0 && valor) O.variacion = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--perdida") == 0 && valor) O.perdida = atof(argv[++i]);
+        else if (strcmp(argv[i], "--desync") == 0 && valor) O.desync = uint32_t(atol(argv[++i]));
+        else {
+            local = false;
+            jugador = -1;
+            break;
+        }
+    }
+    if (!local && (jugador < 0 || jugador > 1 || puertoLocal <= 0 || puertoRemoto <= 0)) {
+        cerr << "Uso: " << argv[0] << " --local | --jugador J --puerto-local P --puerto-remoto Q [--ip IP]"
+             << " [--puerto P] [--semilla S] [--frames F] [--tick MS] [--retraso D] [--rollback N] [--cada K]"
+             << " [--latencia MS] [--variacion MS] [--perdida X] [--desync F]" << endl;
+        return 1;
+    }
+    if (O.tick < 0) O.tick = 0;
+    if (O.cada < 1) O.cada = 1;
+
+    // La historia de rollback ocupa decenas de KB: mejor en el montón que en la pila
+    unique_ptr<Rollback> R0(new Rollback), R1(new Rollback);
+    ResultadoVersus res0, res1;
+    if (!local) {
+        res0 = jugarVersus(O, *R0, jugador, uint16_t(puertoLocal), uint16_t(puertoRemoto));
+        muestraResultado(*R0, res0);
+        return res0.ok ? 0 : 1;
+    }
+
+    thread otro([&] { res1 = jugarVersus(O, *R1, 1, uint16_t(puerto + 1), uint16_t(puerto)); });
+    res0 = jugarVersus(O, *R0, 0, uint16_t(puerto), uint16_t(puerto + 1));
+    otro.join();
+    muestraResultado(*R0, res0);
+    muestraResultado(*R1, res1);
+    bool iguales = res0.suma == res1.suma;
+    printf("estado final %s\n", iguales ? "identico" : "distinto");
+    return res0.ok && res1.ok && iguales ? 0 : 1;
+}